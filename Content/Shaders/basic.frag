@@ -12,14 +12,19 @@ uniform sampler2D lightmap_direct_mask;
 uniform sampler2D albedo;
 uniform sampler2D roughness_map;
 uniform sampler2D metallic_map;
-uniform float roughness_constant = 0.5;
-uniform float metallic_constant = 0;
 uniform bool use_lightmap = false;
-uniform bool use_roughness_map = false;
-uniform bool use_metallic_map = false;
-uniform vec2 base_mat_uv_scale = vec2(1, 1);
 uniform vec2 inst_mat_uv_scale = vec2(1, 1);
 
+// Per-material constants, compiled by the renderer when the material is loaded.
+// Members the material doesn't set take the renderer's defaults: roughness 0.5, metallic 0, maps unused.
+layout (std140) uniform material_params {
+    vec2 base_mat_uv_scale;
+    float roughness_constant;
+    float metallic_constant;
+    bool use_roughness_map;
+    bool use_metallic_map;
+};
+
 in VS_OUT {
     vec2 mat_tex_coords;
     vec2 lm_tex_coords;
@@ -29,20 +34,21 @@ in VS_OUT {
     vec3 cam_normal;
 } fs_in;
 
-layout (location = 0) out vec3 out_position;
-layout (location = 1) out vec3 out_normal;
+// Position and normal are encoded for the gbuffer layout in use (see the renderer's gbuffer encoding functions)
+layout (location = 0) out gbuffer_position_t out_position;
+layout (location = 1) out gbuffer_normal_t out_normal;
 layout (location = 2) out vec4 out_albedo;
 layout (location = 3) out vec2 out_roughness_metallic;
 layout (location = 4) out vec4 out_irradiance;
 
 void main()
 {
-    out_position = fs_in.cam_position;
-    out_normal = normalize(fs_in.cam_normal);
+    out_position = encode_position(fs_in.cam_position);
+    out_normal = encode_normal(normalize(fs_in.cam_normal));
 
-    // Output albedo
+    // Output albedo (alpha holds the direct light mask, when the layout stores it)
     const vec4 albedo = texture(albedo, fs_in.mat_tex_coords * base_mat_uv_scale * inst_mat_uv_scale);
-    out_albedo = albedo;
+    out_albedo = vec4(albedo.rgb, 1);
 
     // Output irradiance
     if (use_lightmap)
@@ -52,6 +58,7 @@ void main()
         irradiance += texture(lightmap_y_basis, fs_in.lm_tex_coords).rgb * dot(lm_y_basis_vec, vec3(0, 0, 1));
         irradiance += texture(lightmap_z_basis, fs_in.lm_tex_coords).rgb * dot(lm_z_basis_vec, vec3(0, 0, 1));
         out_irradiance = vec4(irradiance * albedo.rgb, texture(lightmap_direct_mask, fs_in.lm_tex_coords).r);
+        out_albedo.a = out_irradiance.a;
     }
     else
     {
@@ -5,10 +5,13 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Vertex positions are quantized to the bounds of the mesh
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+
 in vec3 v_position;
-in vec3 v_normal;
+in vec4 v_normal; // Bitangent sign is stored in 'w'
 in vec3 v_tangent;
-in int v_bitangent_sign;
 in vec2 v_mat_texcoord;
 in vec2 v_lm_texcoord;
 
@@ -28,19 +31,20 @@ void main()
 	vs_out.lm_tex_coords = v_lm_texcoord;
 
 	// Compute screen-space position, and view-space position
-	gl_Position = projection * view * model * vec4(v_position, 1);
-	vs_out.cam_position = (view * model * vec4(v_position, 1)).xyz;
+	vec3 position = position_offset + position_scale * v_position;
+	gl_Position = projection * view * model * vec4(position, 1);
+	vs_out.cam_position = (view * model * vec4(position, 1)).xyz;
 
 	// Compute tangent and normal in camera space
 	mat4 model_view = transpose(inverse(view * model));
 	vec3 tangent = normalize(vec3(model_view *	vec4(v_tangent,   0)));
-	vec3 normal = normalize(vec3(model_view *	vec4(v_normal,    0)));
+	vec3 normal = normalize(vec3(model_view *	vec4(v_normal.xyz, 0)));
 
 	// Re-orthogonalize tangent with respect to normal
 	tangent = normalize(tangent - dot(tangent, normal) * normal);
 
 	// Output TBN
 	vs_out.cam_tangent = tangent;
-	vs_out.cam_bitangent = v_bitangent_sign * cross(normal, tangent);
+	vs_out.cam_bitangent = sign(v_normal.w) * cross(normal, tangent);
 	vs_out.cam_normal = normal;
 }
\ No newline at end of file
@@ -11,5 +11,7 @@ layout (location = 4) out vec4 out_irradiance;
 
 void main()
 {
+    // Lines aren't lit by the direct light (only written in the compact layout, where albedo holds the mask)
+    out_albedo = vec4(0.f);
     out_irradiance = vec4(f_color, 0.f);
 }
@@ -14,15 +14,20 @@ uniform sampler2D albedo;
 uniform sampler2D normal_map;
 uniform sampler2D roughness_map;
 uniform sampler2D metallic_map;
-uniform float roughness_constant = 0.5;
-uniform float metallic_constant = 0;
 uniform bool use_lightmap = false;
-uniform bool use_ao_map = false;
-uniform bool use_roughness_map = false;
-uniform bool use_metallic_map = false;
-uniform vec2 base_mat_uv_scale = vec2(1, 1);
 uniform vec2 inst_mat_uv_scale = vec2(1, 1);
 
+// Per-material constants, compiled by the renderer when the material is loaded.
+// Members the material doesn't set take the renderer's defaults: roughness 0.5, metallic 0, maps unused.
+layout (std140) uniform material_params {
+    vec2 base_mat_uv_scale;
+    float roughness_constant;
+    float metallic_constant;
+    bool use_ao_map;
+    bool use_roughness_map;
+    bool use_metallic_map;
+};
+
 in VS_OUT {
     vec2 mat_tex_coords;
     vec2 lm_tex_coords;
@@ -32,8 +37,9 @@ in VS_OUT {
     vec3 cam_normal;
 } fs_in;
 
-layout (location = 0) out vec3 out_position;
-layout (location = 1) out vec3 out_normal;
+// Position and normal are encoded for the gbuffer layout in use (see the renderer's gbuffer encoding functions)
+layout (location = 0) out gbuffer_position_t out_position;
+layout (location = 1) out gbuffer_normal_t out_normal;
 layout (location = 2) out vec4 out_albedo;
 layout (location = 3) out vec2 out_roughness_metallic;
 layout (location = 4) out vec4 out_irradiance;
@@ -46,17 +52,17 @@ void main()
         normalize(fs_in.cam_bitangent),
         normalize(fs_in.cam_normal));
 
-    // Transform normal sample to range [-1, 1]
-    vec3 normal = texture(normal_map, fs_in.mat_tex_coords * base_mat_uv_scale * inst_mat_uv_scale).xyz;
-    normal = normalize(normal * 2.0f - 1.0f);
+    // Transform normal sample to range [-1, 1], and reconstruct Z (cooked normal maps only store X and Y)
+    vec2 normal_xy = texture(normal_map, fs_in.mat_tex_coords * base_mat_uv_scale * inst_mat_uv_scale).xy * 2.0f - 1.0f;
+    vec3 normal = vec3(normal_xy, sqrt(max(1.0f - dot(normal_xy, normal_xy), 0.0f)));
 
     // Output position, normal, and albedo
-    out_position = fs_in.cam_position;
-    out_normal = normalize(TBN * normal);
+    out_position = encode_position(fs_in.cam_position);
+    out_normal = encode_normal(normalize(TBN * normal));
 
-    // Output albedo
+    // Output albedo (alpha holds the direct light mask, when the layout stores it)
     const vec4 albedo = texture(albedo, fs_in.mat_tex_coords * base_mat_uv_scale * inst_mat_uv_scale);
-    out_albedo = albedo;
+    out_albedo = vec4(albedo.rgb, 1);
 
     // Get AO
     float ao = 1.0f;
@@ -73,6 +79,7 @@ void main()
         irradiance += texture(lightmap_y_basis, fs_in.lm_tex_coords).rgb * max(dot(lm_y_basis_vec, normal), 0.f);
         irradiance += texture(lightmap_z_basis, fs_in.lm_tex_coords).rgb * max(dot(lm_z_basis_vec, normal), 0.f);
         out_irradiance = vec4(ao * irradiance * albedo.rgb, texture(lightmap_direct_mask, fs_in.lm_tex_coords).r);
+        out_albedo.a = out_irradiance.a;
     }
     else
     {
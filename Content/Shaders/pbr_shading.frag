@@ -5,6 +5,7 @@ const float PI = 3.141592654f;
 const vec3 F0 = vec3(0.04f);
 
 uniform mat4 view;
+uniform mat4 inv_proj;
 
 uniform sampler2D depth_buffer;
 uniform sampler2D position_buffer;
@@ -15,6 +16,37 @@ uniform sampler2D roughness_metallic_buffer;
 uniform vec3 light_dir;
 uniform vec3 light_intensity;
 
+// Clustered point and spot lights (see 'LightClusters.h')
+struct Light
+{
+    vec3 position;
+    float radius;
+    vec3 intensity;
+    float cos_inner;
+    vec3 direction;
+    float cos_outer;
+};
+
+layout(std430, binding = 0) readonly buffer LightBuffer
+{
+    Light lights[];
+};
+
+// Offset into 'light_indices' and number of lights, for each cluster
+layout(std430, binding = 1) readonly buffer LightClusterBuffer
+{
+    uint cluster_ranges[];
+};
+
+layout(std430, binding = 2) readonly buffer LightIndexBuffer
+{
+    uint light_indices[];
+};
+
+uniform uvec3 cluster_dims;
+uniform float cluster_near;
+uniform float cluster_slice_scale;
+
 in vec2 f_texcoord;
 
 out vec4 out_color;
@@ -62,14 +94,44 @@ vec3 fresnel_schlick_roughness(float cos_theta, vec3 base_ref, float roughness)
     return base_ref + (max(vec3(1.0f - roughness), base_ref) - base_ref) * pow(1.0f - cos_theta, 5);
 }
 
+vec3 read_position(vec2 texcoord)
+{
+    return decode_position(texture(position_buffer, texcoord), texcoord, inv_proj);
+}
+
+vec3 read_normal(vec2 texcoord)
+{
+    return decode_normal(texture(normal_buffer, texcoord));
+}
+
+// Computes the outgoing radiance from a single light
+vec3 shade_light(vec3 N, vec3 V, vec3 L, vec3 radiance, vec3 albedo, vec3 kD, vec3 fresnel, float n_dot_v, float ndf_alpha, float geom_k)
+{
+    // Calculate the halfway vector
+    vec3 half_vec = normalize(V + L);
+    float n_dot_l = max(dot(N, L), 0.0f);
+
+    // Calculate normal distribution function
+    float ndf = ggx_tr_NDF(N, half_vec, ndf_alpha);
+
+    // Calculate geometric masking function
+    float gmf = smith_GMF(N, V, L, geom_k);
+
+    // Calculate BRDF
+    vec3 brdf_nom = ndf * gmf * fresnel;
+    float brdf_denom = 4 * n_dot_v * n_dot_l + 0.001f;
+    vec3 brdf = brdf_nom / brdf_denom;
+    return (kD * albedo / PI + brdf) * radiance * n_dot_l;
+}
+
 void main()
 {
     // Get a light vector in camera-space normal
     mat4 normal_to_view = transpose(inverse(view));
 
     vec3 albedo = texture(albedo_buffer, f_texcoord).rgb;
-    vec3 cam_pos = texture(position_buffer, f_texcoord).xyz;
-    vec3 cam_norm = texture(normal_buffer, f_texcoord).xyz;
+    vec3 cam_pos = read_position(f_texcoord);
+    vec3 cam_norm = read_normal(f_texcoord);
     float roughness = texture(roughness_metallic_buffer, f_texcoord).r;
     float metallic = texture(roughness_metallic_buffer, f_texcoord).g;
 
@@ -97,32 +159,50 @@ void main()
     // Do shading
     vec3 Lo = vec3(0.0f);
 
-    // Sample irradiance (includes directional occlusion in alpha component)
+    // Sample irradiance (includes directional occlusion in alpha component, or albedo's alpha in the compact layout)
     vec4 irradiance = texture(irradiance_buffer, f_texcoord);
-
-    // For each light
-        float attenutation = 1.0f;
-        vec3 radiance = light_intensity * attenutation * irradiance.a;
-
-        // Calculate light vector
-        vec3 light = normalize((normal_to_view * -vec4(light_dir, 0.f)).xyz);
-
-        // Calculate the halfway vector
-        vec3 half_vec = normalize(view + light);
-        float n_dot_l = max(dot(cam_norm, light), 0.0f);
-
-        // Calculate normal distribution function
-        float ndf = ggx_tr_NDF(cam_norm, half_vec, ndf_alpha);
-
-        // Calculate geometric masking function
-        float gmf = smith_GMF(cam_norm, view, light, geom_k);
-
-        // Calculate BRDF
-        vec3 brdf_nom = ndf * gmf * fresnel;
-        float brdf_denom = 4 * n_dot_v * n_dot_l + 0.001f;
-        vec3 brdf = brdf_nom / brdf_denom;
-        Lo += (kD * albedo / PI + brdf) * radiance * n_dot_l;
-    // end for
+#ifdef SGE_COMPACT_GBUFFER
+    irradiance.a = texture(albedo_buffer, f_texcoord).a;
+#endif
+
+    // Nothing was drawn here, so there's no surface to light
+    if (is_gbuffer_background(texture(position_buffer, f_texcoord)))
+    {
+        out_color = vec4(irradiance.rgb, 1.0f);
+        return;
+    }
+
+    // Directional light (occluded by the alpha component of irradiance)
+    vec3 light = normalize((normal_to_view * -vec4(light_dir, 0.f)).xyz);
+    Lo += shade_light(cam_norm, view, light, light_intensity * irradiance.a, albedo, kD, fresnel, n_dot_v, ndf_alpha, geom_k);
+
+    // Find the cluster this pixel falls in (the background has no lights)
+    if (cam_pos.z < 0.0f)
+    {
+        uvec2 tile = min(uvec2(f_texcoord * vec2(cluster_dims.xy)), cluster_dims.xy - 1u);
+        int slice = clamp(int(log(-cam_pos.z / cluster_near) * cluster_slice_scale), 0, int(cluster_dims.z) - 1);
+        uint cluster = (uint(slice) * cluster_dims.y + tile.y) * cluster_dims.x + tile.x;
+        uint offset = cluster_ranges[cluster * 2];
+        uint count = cluster_ranges[cluster * 2 + 1];
+
+        // For each light affecting the cluster
+        for (uint i = 0; i < count; ++i)
+        {
+            Light cluster_light = lights[light_indices[offset + i]];
+            vec3 to_light = cluster_light.position - cam_pos;
+            float dist = length(to_light);
+            vec3 L = to_light / max(dist, 0.0001f);
+
+            // Smoothly fade out to zero at the light's radius
+            float falloff = clamp(1.0f - pow(dist / cluster_light.radius, 4), 0.0f, 1.0f);
+            float attenuation = falloff * falloff / (dist * dist + 1.0f);
+
+            // Spot lights fade out towards the edge of their cone
+            attenuation *= smoothstep(cluster_light.cos_outer, cluster_light.cos_inner, dot(-L, cluster_light.direction));
+
+            Lo += shade_light(cam_norm, view, L, cluster_light.intensity * attenuation, albedo, kD, fresnel, n_dot_v, ndf_alpha, geom_k);
+        }
+    }
 
     vec3 color = Lo + irradiance.rgb;
 
@@ -2,9 +2,13 @@
 #version 430 core
 
 uniform sampler2D skybox;
-uniform vec2 base_mat_uv_scale = vec2(1, 1);
 uniform vec2 inst_mat_uv_scale = vec2(1, 1);
 
+// Per-material constants, compiled by the renderer when the material is loaded
+layout (std140) uniform material_params {
+    vec2 base_mat_uv_scale;
+};
+
 in VS_OUT {
     vec2 mat_tex_coords;
     vec2 lm_tex_coords;
@@ -14,17 +18,18 @@ in VS_OUT {
     vec3 cam_normal;
 } fs_in;
 
-layout (location = 0) out vec3 out_position;
-layout (location = 1) out vec3 out_normal;
+// Position and normal are encoded for the gbuffer layout in use (see the renderer's gbuffer encoding functions)
+layout (location = 0) out gbuffer_position_t out_position;
+layout (location = 1) out gbuffer_normal_t out_normal;
 layout (location = 2) out vec4 out_albedo;
 layout (location = 3) out vec2 out_roughness_metallic;
 layout (location = 4) out vec4 out_irradiance;
 
 void main()
 {
-    out_position = fs_in.cam_position;
-    out_normal = normalize(fs_in.cam_normal);
-    out_albedo = vec4(0, 0, 0, 1.f);
+    out_position = encode_position(fs_in.cam_position);
+    out_normal = encode_normal(normalize(fs_in.cam_normal));
+    out_albedo = vec4(0, 0, 0, 0);
     out_roughness_metallic = vec2(0, 0);
 
     // Output irradiance
@@ -223,6 +223,99 @@ namespace sge
         */
         virtual std::size_t typed_array(double* out, std::size_t size) const = 0;
 
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type int8 held by this node, without copying them.
+         * This is only possible for readers that hold the array in memory in its native representation (suitably aligned), so callers must fall back to 'typed_array' if this fails.
+         * \param out The pointer to assign the elements to. This remains valid for as long as the underlying archive is unchanged.
+         * \param out_size The value to assign the number of elements to.
+         * \return Whether the given pointer and size were assigned to.
+         */
+        virtual bool typed_array_view(const int8*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type uint8 held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const uint8*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type int16 held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const int16*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type uint16 held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const uint16*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type int32 held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const int32*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type uint32 held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const uint32*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type int64 held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const int64*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type uint64 held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const uint64*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type float held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const float*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Trys to get a pointer directly to the elements of an array of all type double held by this node, without copying them.
+         * \see typed_array_view(const int8*&, std::size_t&)
+         */
+        virtual bool typed_array_view(const double*& /*out*/, std::size_t& /*out_size*/) const
+        {
+            return false;
+        }
+
         virtual void enumerate_array_elements(FunctionView<void(std::size_t i)> enumerator) = 0;
 
         virtual bool pull_array_element(std::size_t i) = 0;
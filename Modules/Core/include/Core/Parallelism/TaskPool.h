@@ -1,16 +1,98 @@
 // TaskPool.h
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "../Functional/UFunction.h"
 
 namespace sge
 {
-    struct SGE_CORE_API TaskPool
+    /**
+     * \brief Tracks completion of a set of tasks submitted to a TaskPool.
+     * A group may be reused once 'TaskPool::wait' has returned for it.
+     */
+    struct SGE_CORE_API TaskGroup
     {
         //////////////////
         ///   Fields   ///
     public:
 
+        /**
+         * \brief The number of tasks in this group that have not finished yet (guarded by the owning pool).
+         */
+        std::size_t num_pending = 0;
+    };
+
+    /**
+     * \brief A fixed set of worker threads that run submitted tasks in FIFO order.
+     */
+    struct SGE_CORE_API TaskPool
+    {
+        using Task = UFunction<void()>;
+
+        ////////////////////////
+        ///   Constructors   ///
+    public:
+
+        /**
+         * \brief Starts the given number of worker threads. A pool with zero threads runs tasks inside 'wait'.
+         */
+        explicit TaskPool(std::size_t num_threads);
+        ~TaskPool();
+        TaskPool(const TaskPool& copy) = delete;
+        TaskPool& operator=(const TaskPool& copy) = delete;
+
+        ///////////////////
+        ///   Methods   ///
+    public:
+
+        /**
+         * \brief Returns the number of worker threads in this pool.
+         */
+        std::size_t num_threads() const;
+
+        /**
+         * \brief Queues a task to run on a worker thread, as part of the given group.
+         * \param group The group to add the task to. Must outlive the task.
+         * \param task The task to run.
+         */
+        void submit(TaskGroup& group, Task task);
+
+        /**
+         * \brief Returns whether every task in the given group has finished.
+         */
+        bool is_complete(const TaskGroup& group);
+
+        /**
+         * \brief Blocks until every task in the given group has finished.
+         * The calling thread runs queued tasks while it waits, so this is safe to call from within a task.
+         */
+        void wait(TaskGroup& group);
+
+    private:
+
+        struct QueuedTask
+        {
+            Task task;
+            TaskGroup* group;
+        };
+
+        void worker_main();
+
+        void run_task(std::unique_lock<std::mutex>& lock);
+
+        //////////////////
+        ///   Fields   ///
+    private:
 
+        std::mutex _lock;
+        std::condition_variable _task_queued;
+        std::condition_variable _task_finished;
+        std::deque<QueuedTask> _tasks;
+        std::vector<std::thread> _threads;
+        bool _stopping = false;
     };
 }
@@ -0,0 +1,105 @@
+// TaskPool.cpp
+
+#include "../../include/Core/Parallelism/TaskPool.h"
+
+namespace sge
+{
+    ////////////////////////
+    ///   Constructors   ///
+
+    TaskPool::TaskPool(std::size_t num_threads)
+    {
+        _threads.reserve(num_threads);
+        for (std::size_t i = 0; i < num_threads; ++i)
+        {
+            _threads.emplace_back(&TaskPool::worker_main, this);
+        }
+    }
+
+    TaskPool::~TaskPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ _lock };
+            _stopping = true;
+        }
+
+        _task_queued.notify_all();
+        for (auto& thread : _threads)
+        {
+            thread.join();
+        }
+    }
+
+    ///////////////////
+    ///   Methods   ///
+
+    std::size_t TaskPool::num_threads() const
+    {
+        return _threads.size();
+    }
+
+    void TaskPool::submit(TaskGroup& group, Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock{ _lock };
+            group.num_pending += 1;
+            _tasks.push_back(QueuedTask{ std::move(task), &group });
+        }
+
+        _task_queued.notify_one();
+    }
+
+    bool TaskPool::is_complete(const TaskGroup& group)
+    {
+        std::lock_guard<std::mutex> lock{ _lock };
+        return group.num_pending == 0;
+    }
+
+    void TaskPool::wait(TaskGroup& group)
+    {
+        std::unique_lock<std::mutex> lock{ _lock };
+        while (group.num_pending != 0)
+        {
+            // Help out instead of blocking, if there's work available
+            if (!_tasks.empty())
+            {
+                run_task(lock);
+                continue;
+            }
+
+            _task_finished.wait(lock);
+        }
+    }
+
+    void TaskPool::worker_main()
+    {
+        std::unique_lock<std::mutex> lock{ _lock };
+        while (true)
+        {
+            _task_queued.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+            // Drain the queue before stopping, so that no group is left waiting
+            if (_tasks.empty())
+            {
+                return;
+            }
+
+            run_task(lock);
+        }
+    }
+
+    void TaskPool::run_task(std::unique_lock<std::mutex>& lock)
+    {
+        auto queued = std::move(_tasks.front());
+        _tasks.pop_front();
+
+        // Run the task outside the lock
+        lock.unlock();
+        queued.task();
+        queued.task = nullptr;
+        lock.lock();
+
+        queued.group->num_pending -= 1;
+        _task_finished.notify_all();
+    }
+}
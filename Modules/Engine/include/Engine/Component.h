@@ -32,6 +32,18 @@ namespace sge
 
         virtual void from_archive(ArchiveReader& reader) = 0;
 
+        /**
+         * \brief Serializes all instances for a cooked scene: the instance nodes in ascending order as a packed array ("nodes"),
+         * followed by each instance in the same order ("instances").
+         */
+        virtual void to_cooked_archive(ArchiveWriter& writer) const = 0;
+
+        /**
+         * \brief Deserializes instances written by 'to_cooked_archive', replacing any existing instances.
+         * Instances of nodes that are not among the given nodes (which must be in ascending order) are skipped.
+         */
+        virtual void from_cooked_archive(ArchiveReader& reader, const NodeId* scene_nodes, std::size_t num_scene_nodes) = 0;
+
         virtual void on_end_system_frame() = 0;
 
         virtual void on_end_update_frame() = 0;
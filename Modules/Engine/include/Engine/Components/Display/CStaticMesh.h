@@ -2,6 +2,7 @@
 #pragma once
 
 #include <Resource/Resources/StaticMesh.h>
+#include <Resource/PathId.h>
 #include "../../Component.h"
 
 namespace sge
@@ -51,10 +52,20 @@ namespace sge
 
         void mesh(std::string mesh);
 
+        /**
+         * \brief Returns the interned id of the mesh path, for looking up resources without hashing the path.
+         */
+        PathId mesh_id() const;
+
         const std::string& material() const;
 
         void material(std::string material);
 
+        /**
+         * \brief Returns the interned id of the material path.
+         */
+        PathId material_id() const;
+
         LightmaskMode lightmask_mode() const;
 
         void lightmask_mode(LightmaskMode value);
@@ -88,8 +99,8 @@ namespace sge
     private:
 
         NodeId _node;
-        std::string _mesh;
-        std::string _material;
+        PathId _mesh = NULL_PATH_ID;
+        PathId _material = NULL_PATH_ID;
         LightmaskMode _lightmask_mode = LightmaskMode::NONE;
         uint32 _lightmask_group = 0;
         bool _use_lightmap = false;
@@ -1,6 +1,7 @@
 // CStaticMeshCollider.h
 #pragma once
 
+#include <Resource/PathId.h>
 #include "../../Component.h"
 
 namespace sge
@@ -30,6 +31,11 @@ namespace sge
 
         const std::string& mesh() const;
 
+        /**
+         * \brief Returns the interned id of the mesh path, for looking up colliders without hashing the path.
+         */
+        PathId mesh_id() const;
+
         bool lightmask_receiver() const;
 
         void lightmask_receiver(bool value);
@@ -41,7 +47,7 @@ namespace sge
     private:
 
         NodeId _node;
-        std::string _mesh;
+        PathId _mesh = NULL_PATH_ID;
         bool _lightmask_receiver = false;
         SharedData* _shared_data;
     };
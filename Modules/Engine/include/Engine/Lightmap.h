@@ -7,17 +7,48 @@
 
 namespace sge
 {
+    struct TaskPool;
+
     struct SGE_ENGINE_API SceneLightmap
     {
         SGE_REFLECTED_TYPE;
 
+        /**
+         * \brief The formats the radiance of a lightmap element may be stored in.
+         */
+        enum class Format : uint32
+        {
+            /**
+             * \brief Full-precision floats, in 'basis_*_radiance'.
+             */
+            RGBF32,
+
+            /**
+             * \brief Block-compressed half-floats with a full mip chain, in 'basis_*_data'. Uploaded as-is.
+             */
+            BC6H,
+
+            /**
+             * \brief Shared-exponent floats with a full mip chain, in 'basis_*_data'. Uploaded as-is, for drivers without BC6H support.
+             */
+            RGB9E5,
+        };
+
         struct LightmapElement
         {
             int32 width;
             int32 height;
+            Format format = Format::RGBF32;
             std::vector<color::RGBF32> basis_x_radiance;
             std::vector<color::RGBF32> basis_y_radiance;
             std::vector<color::RGBF32> basis_z_radiance;
+
+            /* Encoded mip chains (if 'format' isn't RGBF32), with each level stored one after the other, starting from the largest. */
+            int32 num_mips = 0;
+            std::vector<byte> basis_x_data;
+            std::vector<byte> basis_y_data;
+            std::vector<byte> basis_z_data;
+
             std::vector<byte> direct_mask;
         };
 
@@ -25,6 +56,18 @@ namespace sge
 
         void from_archive(ArchiveReader& reader);
 
+        /**
+         * \brief Encodes the radiance of every RGBF32 element into the given format, with a full mip chain, freeing the float data.
+         * \param format The format to encode into. Must not be RGBF32.
+         * \param pool If not null, elements are encoded in parallel on this pool.
+         */
+        void encode(Format format, TaskPool* pool);
+
+        /**
+         * \brief Returns the size (in bytes) of a single mip level of a basis image in the given (encoded) format.
+         */
+        static std::size_t encoded_level_size(Format format, int32 width, int32 height);
+
         //////////////////
         ///   Fields   ///
     public:
@@ -84,6 +84,33 @@ namespace sge
          */
         void from_archive(ArchiveReader& reader);
 
+        /**
+         * \brief Serializes the state of this Scene in the cooked scene format, which stores nodes, and the nodes of each component type, as packed arrays.
+         * Cooked scenes are meant to be written to a BinaryArchive next to the source scene (see 'cooked_path').
+         * \param writer The writer for the archive to serialize to.
+         * \param source_path The path to the source scene, whose size and modification time are recorded so that 'from_file' can tell when the cooked scene is out of date.
+         */
+        void to_cooked_archive(ArchiveWriter& writer, const char* source_path = nullptr) const;
+
+        /**
+         * \brief Deserializes the state of this Scene from an Archive written by 'to_cooked_archive'.
+         * \param reader The reader for the Archive to deserialize from.
+         * \return Whether the archive was a cooked scene of the current version. If not, the scene is left empty.
+         */
+        bool from_cooked_archive(ArchiveReader& reader);
+
+        /**
+         * \brief Loads the scene at the given path. If an up-to-date cooked version of the scene exists, that is loaded instead.
+         * \param path The path to the source (JSON) scene.
+         * \return Whether the scene could be loaded.
+         */
+        bool from_file(const char* path);
+
+        /**
+         * \brief Returns the path a cooked version of the given source scene is stored at.
+         */
+        static std::string cooked_path(const char* source_path);
+
         /**
          * \brief Returns the type database for this Scene.
          */
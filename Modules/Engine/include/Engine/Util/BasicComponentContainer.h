@@ -108,6 +108,101 @@ namespace sge
                 (int32)new_instances.size());
         }
 
+        void to_cooked_archive(ArchiveWriter& writer) const override
+        {
+            std::vector<NodeId::Index_t> nodes;
+            nodes.reserve(_instance_map.size());
+            for (auto instance : _instance_map)
+            {
+                nodes.push_back(instance.first.index);
+            }
+
+            writer.push_object_member("nodes");
+            writer.typed_array(nodes.data(), nodes.size());
+            writer.pop();
+
+            writer.push_object_member("instances");
+            for (auto instance : _instance_map)
+            {
+                writer.push_array_element();
+                instance.second->to_archive(writer);
+                writer.pop();
+            }
+            writer.pop();
+        }
+
+        void from_cooked_archive(ArchiveReader& reader, const NodeId* scene_nodes, std::size_t num_scene_nodes) override
+        {
+            reset();
+
+            // Get the instance nodes, in place if possible
+            const NodeId::Index_t* nodes = nullptr;
+            std::size_t num_nodes = 0;
+            std::vector<NodeId::Index_t> nodes_storage;
+            if (!reader.pull_object_member("nodes"))
+            {
+                return;
+            }
+            if (!reader.typed_array_view(nodes, num_nodes) && reader.array_size(num_nodes))
+            {
+                nodes_storage.resize(num_nodes);
+                num_nodes = reader.typed_array(nodes_storage.data(), num_nodes);
+                nodes = nodes_storage.data();
+            }
+            reader.pop();
+
+            std::vector<ENewComponent> new_instances;
+            new_instances.reserve(num_nodes);
+            _instance_nodes.reserve(num_nodes);
+
+            // Both sets of nodes are in ascending order, so they can be matched up in a single pass
+            std::size_t scene_index = 0;
+            if (!reader.pull_object_member("instances"))
+            {
+                return;
+            }
+            reader.enumerate_array_elements([&](std::size_t i)
+            {
+                if (i >= num_nodes)
+                {
+                    return;
+                }
+
+                const NodeId node{ nodes[i] };
+                while (scene_index < num_scene_nodes && scene_nodes[scene_index] < node)
+                {
+                    scene_index += 1;
+                }
+
+                // Skip instances of nodes that don't exist (or are out of order)
+                if (scene_index == num_scene_nodes || scene_nodes[scene_index] != node
+                    || (!this->_instance_nodes.empty() && !(this->_instance_nodes.back() < node)))
+                {
+                    return;
+                }
+
+                // Allocate and deserialize the instance
+                auto* const buff = this->_instance_buffer.alloc(sizeof(ComponentT));
+                auto* const instance = new(buff) ComponentT(node, _shared_data);
+                this->_instance_map.emplace_hint(this->_instance_map.end(), node, instance);
+                this->_instance_nodes.push_back(node);
+                instance->from_archive(reader);
+
+                // Create the new instance event
+                ENewComponent event;
+                event.node = node;
+                event.instance = instance;
+                new_instances.push_back(event);
+            });
+            reader.pop();
+
+            // Append all new instance events
+            _new_instance_channel.append(
+                new_instances.data(),
+                sizeof(ENewComponent),
+                (int32)new_instances.size());
+        }
+
         void on_end_system_frame() override
         {
             _shared_data.on_end_system_frame();
@@ -43,8 +43,8 @@ namespace sge
 
     void CStaticMesh::to_archive(ArchiveWriter& writer) const
     {
-        writer.object_member("mesh", _mesh);
-        writer.object_member("material", _material);
+        writer.object_member("mesh", get_interned_path(_mesh));
+        writer.object_member("material", get_interned_path(_material));
         writer.object_member("lmm", (int)_lightmask_mode);
         writer.object_member("lmg", _lightmask_group);
         writer.object_member("uselm", _use_lightmap);
@@ -54,8 +54,12 @@ namespace sge
 
     void CStaticMesh::from_archive(ArchiveReader & reader)
     {
-        reader.object_member("mesh", _mesh);
-        reader.object_member("material", _material);
+        std::string mesh = get_interned_path(_mesh);
+        std::string material = get_interned_path(_material);
+        reader.object_member("mesh", mesh);
+        reader.object_member("material", material);
+        _mesh = intern_path(mesh);
+        _material = intern_path(material);
         reader.object_member("lmg", _lightmask_group);
         reader.object_member("uselm", _use_lightmap);
         reader.object_member("lms", _lightmap_size);
@@ -68,32 +72,44 @@ namespace sge
 
     const std::string& CStaticMesh::mesh() const
     {
-        return _mesh;
+        return get_interned_path(_mesh);
     }
 
     void CStaticMesh::mesh(std::string mesh)
     {
-        if (mesh != _mesh)
+        const auto id = intern_path(mesh);
+        if (id != _mesh)
         {
-            _mesh = std::move(mesh);
+            _mesh = id;
             set_modified("mesh");
         }
     }
 
+    PathId CStaticMesh::mesh_id() const
+    {
+        return _mesh;
+    }
+
     const std::string& CStaticMesh::material() const
     {
-        return _material;
+        return get_interned_path(_material);
     }
 
     void CStaticMesh::material(std::string material)
     {
-        if (material != _material)
+        const auto id = intern_path(material);
+        if (id != _material)
         {
-            _material = std::move(material);
+            _material = id;
             set_modified("material");
         }
     }
 
+    PathId CStaticMesh::material_id() const
+    {
+        return _material;
+    }
+
     CStaticMesh::LightmaskMode CStaticMesh::lightmask_mode() const
     {
         return _lightmask_mode;
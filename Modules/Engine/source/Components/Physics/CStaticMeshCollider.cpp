@@ -32,13 +32,15 @@ namespace sge
     void CStaticMeshCollider::to_archive(ArchiveWriter& writer) const
     {
         writer.as_object();
-        writer.object_member("mesh", _mesh);
+        writer.object_member("mesh", get_interned_path(_mesh));
         writer.object_member("lr", _lightmask_receiver);
     }
 
     void CStaticMeshCollider::from_archive(ArchiveReader& reader)
     {
-        reader.object_member("mesh", _mesh);
+        std::string mesh = get_interned_path(_mesh);
+        reader.object_member("mesh", mesh);
+        _mesh = intern_path(mesh);
         reader.object_member("lr", _lightmask_receiver);
     }
 
@@ -48,6 +50,11 @@ namespace sge
     }
 
     const std::string& CStaticMeshCollider::mesh() const
+    {
+        return get_interned_path(_mesh);
+    }
+
+    PathId CStaticMeshCollider::mesh_id() const
     {
         return _mesh;
     }
@@ -65,9 +72,10 @@ namespace sge
 
     void CStaticMeshCollider::mesh(std::string value)
     {
-        if (_mesh != value)
+        const auto id = intern_path(value);
+        if (_mesh != id)
         {
-            _mesh = std::move(value);
+            _mesh = id;
             _shared_data->set_modified(_node, this, "mesh");
         }
     }
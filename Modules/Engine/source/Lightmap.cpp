@@ -1,7 +1,10 @@
 // Lightmap.cpp
 
+#include <algorithm>
 #include <Core/Reflection/ReflectionBuilder.h>
+#include <Core/Parallelism/TaskPool.h>
 #include <Resource/Misc/ImageOps.h>
+#include <Resource/Misc/TextureCompression.h>
 #include "../include/Engine/Lightmap.h"
 
 SGE_REFLECT_TYPE(sge::SceneLightmap)
@@ -10,6 +13,102 @@ SGE_REFLECT_TYPE(sge::SceneLightmap)
 
 namespace sge
 {
+    /**
+     * \brief Encodes the given float image into the given format, along with its mip chain.
+     */
+    static void encode_basis(
+        SceneLightmap::Format format,
+        const std::vector<color::RGBF32>& radiance,
+        int32 width,
+        int32 height,
+        int32 num_mips,
+        std::vector<byte>& out_data)
+    {
+        // Lay out the mip chain
+        std::size_t total_size = 0;
+        for (int32 level = 0, level_width = width, level_height = height; level < num_mips; ++level)
+        {
+            total_size += SceneLightmap::encoded_level_size(format, level_width, level_height);
+            level_width = std::max(level_width / 2, 1);
+            level_height = std::max(level_height / 2, 1);
+        }
+        out_data.assign(total_size, 0);
+
+        // Encode each level, filtering it down to get the next
+        std::vector<float> level_pixels(radiance.data()->vec(), radiance.data()->vec() + std::size_t(width) * height * 3);
+        std::vector<float> next_level_pixels;
+        std::size_t offset = 0;
+        for (int32 level = 0; level < num_mips; ++level)
+        {
+            if (format == SceneLightmap::Format::BC6H)
+            {
+                texture_compression::compress_hdr_image(level_pixels.data(), width, height, out_data.data() + offset, nullptr);
+            }
+            else
+            {
+                texture_compression::pack_rgb9e5(level_pixels.data(), std::size_t(width) * height, reinterpret_cast<uint32*>(out_data.data() + offset));
+            }
+            offset += SceneLightmap::encoded_level_size(format, width, height);
+
+            const int32 next_width = std::max(width / 2, 1);
+            const int32 next_height = std::max(height / 2, 1);
+            if (level + 1 < num_mips)
+            {
+                next_level_pixels.resize(std::size_t(next_width) * next_height * 3);
+                texture_compression::generate_hdr_mip(level_pixels.data(), width, height, next_level_pixels.data());
+                level_pixels.swap(next_level_pixels);
+            }
+            width = next_width;
+            height = next_height;
+        }
+    }
+
+    /**
+     * \brief Reads an array member directly into the given buffer, with no intermediate copy.
+     */
+    /**
+     * \brief Returns the bytes of the byte array at the reader's current node. These are viewed in place if the archive allows it (as when mapped),
+     * and otherwise copied into the given buffer.
+     */
+    static const byte* view_byte_array(
+        ArchiveReader& reader,
+        std::vector<byte>& buffer,
+        std::size_t& out_size)
+    {
+        const byte* view = nullptr;
+        if (reader.typed_array_view(view, out_size))
+        {
+            return view;
+        }
+
+        out_size = 0;
+        reader.array_size(out_size);
+        buffer.assign(out_size, 0);
+        reader.typed_array(buffer.data(), out_size);
+        return buffer.data();
+    }
+
+    static void read_basis_data(
+        ArchiveReader& reader,
+        const char* name,
+        std::vector<byte>& out_data)
+    {
+        reader.pull_object_member(name);
+        const byte* view = nullptr;
+        std::size_t size = 0;
+        if (reader.typed_array_view(view, size))
+        {
+            out_data.assign(view, view + size);
+        }
+        else
+        {
+            reader.array_size(size);
+            out_data.assign(size, 0);
+            reader.typed_array(out_data.data(), size);
+        }
+        reader.pop();
+    }
+
     void SceneLightmap::to_archive(ArchiveWriter& writer) const
     {
         writer.as_object();
@@ -37,6 +136,32 @@ namespace sge
             writer.number(height);
             writer.pop(); // "h"
 
+            // Encoded elements are stored as-is, so that they may be uploaded without decoding
+            if (element.second.format != Format::RGBF32)
+            {
+                writer.object_member("fmt", static_cast<uint32>(element.second.format));
+                writer.object_member("mips", element.second.num_mips);
+
+                writer.push_object_member("x");
+                writer.typed_array(element.second.basis_x_data.data(), element.second.basis_x_data.size());
+                writer.pop(); // "x"
+
+                writer.push_object_member("y");
+                writer.typed_array(element.second.basis_y_data.data(), element.second.basis_y_data.size());
+                writer.pop(); // "y"
+
+                writer.push_object_member("z");
+                writer.typed_array(element.second.basis_z_data.data(), element.second.basis_z_data.size());
+                writer.pop(); // "z"
+
+                writer.push_object_member("d");
+                writer.typed_array(element.second.direct_mask.data(), size);
+                writer.pop(); // "d"
+
+                writer.pop(); // node_id_str
+                continue;
+            }
+
             // Save individual components, compressed
             byte* image_buff;
             std::size_t image_buff_size;
@@ -83,16 +208,36 @@ namespace sge
             LightmapElement element;
             reader.object_member("w", element.width);
             reader.object_member("h", element.height);
+            const auto size = element.width * element.height;
+
+            // Encoded elements are read straight into their final buffers
+            uint32 format = 0;
+            if (reader.object_member("fmt", format) && format != static_cast<uint32>(Format::RGBF32))
+            {
+                element.format = static_cast<Format>(format);
+                reader.object_member("mips", element.num_mips);
+                read_basis_data(reader, "x", element.basis_x_data);
+                read_basis_data(reader, "y", element.basis_y_data);
+                read_basis_data(reader, "z", element.basis_z_data);
+
+                element.direct_mask.assign(size, 0);
+                reader.pull_object_member("d");
+                reader.typed_array(element.direct_mask.data(), size);
+                reader.pop(); // "d"
+
+                this->lightmap_elements.insert(std::make_pair(node_id, std::move(element)));
+                return;
+            }
 
             // Preallocate data
-            const auto size = element.width * element.height;
             element.basis_x_radiance.assign(size, color::RGBF32::black());
             element.basis_y_radiance.assign(size, color::RGBF32::black());
             element.basis_z_radiance.assign(size, color::RGBF32::black());
             element.direct_mask.assign(size, 0);
 
-            // Load individual components, from compressed memory
+            // Load individual components, from compressed memory (decoded in place, if the archive is mapped)
             std::vector<byte> compressed_buff;
+            const byte* compressed_data;
             std::size_t compressed_buff_size;
             float* image_buff;
             int32 image_width;
@@ -101,37 +246,31 @@ namespace sge
 
             // Load data for x component
             reader.pull_object_member("x");
-            reader.array_size(compressed_buff_size);
-            compressed_buff.assign(compressed_buff_size, 0);
-            reader.typed_array(compressed_buff.data(), compressed_buff_size);
-            reader.pop(); // "x"
+            compressed_data = view_byte_array(reader, compressed_buff, compressed_buff_size);
 
             // Construct image
-            image_ops::load_rgbf_from_memory(compressed_buff.data(), compressed_buff_size, &image_buff, &image_width, &image_height, &image_num_channels);
+            image_ops::load_rgbf_from_memory(compressed_data, compressed_buff_size, &image_buff, &image_width, &image_height, &image_num_channels);
+            reader.pop(); // "x"
             std::memcpy(element.basis_x_radiance.data(), image_buff, size * 3 * sizeof(float));
             sge::free(image_buff);
 
             // Load data for y component
             reader.pull_object_member("y");
-            reader.array_size(compressed_buff_size);
-            compressed_buff.assign(compressed_buff_size, 0);
-            reader.typed_array(compressed_buff.data(), compressed_buff_size);
-            reader.pop(); // "y"
+            compressed_data = view_byte_array(reader, compressed_buff, compressed_buff_size);
 
             // Construct image
-            image_ops::load_rgbf_from_memory(compressed_buff.data(), compressed_buff_size, &image_buff, &image_width, &image_height, &image_num_channels);
+            image_ops::load_rgbf_from_memory(compressed_data, compressed_buff_size, &image_buff, &image_width, &image_height, &image_num_channels);
+            reader.pop(); // "y"
             std::memcpy(element.basis_y_radiance.data(), image_buff, size * 3 * sizeof(float));
             sge::free(image_buff);
 
             // Load data for z component
             reader.pull_object_member("z");
-            reader.array_size(compressed_buff_size);
-            compressed_buff.assign(compressed_buff_size, 0);
-            reader.typed_array(compressed_buff.data(), compressed_buff_size);
-            reader.pop(); // "z"
+            compressed_data = view_byte_array(reader, compressed_buff, compressed_buff_size);
 
             // Construct image
-            image_ops::load_rgbf_from_memory(compressed_buff.data(), compressed_buff_size, &image_buff, &image_width, &image_height, &image_num_channels);
+            image_ops::load_rgbf_from_memory(compressed_data, compressed_buff_size, &image_buff, &image_width, &image_height, &image_num_channels);
+            reader.pop(); // "z"
             std::memcpy(element.basis_z_radiance.data(), image_buff, size * 3 * sizeof(float));
             sge::free(image_buff);
 
@@ -144,4 +283,66 @@ namespace sge
         });
         reader.pop(); // "nodes"
     }
+
+    void SceneLightmap::encode(Format format, TaskPool* pool)
+    {
+        assert(format != Format::RGBF32);
+
+        TaskGroup group;
+        for (auto& entry : lightmap_elements)
+        {
+            auto& element = entry.second;
+            if (element.format != Format::RGBF32)
+            {
+                continue;
+            }
+
+            element.format = format;
+            element.num_mips = texture_compression::num_mip_levels(element.width, element.height);
+
+            // Each basis image is independent, so encode them all at once
+            std::pair<std::vector<color::RGBF32>*, std::vector<byte>*> bases[] = {
+                { &element.basis_x_radiance, &element.basis_x_data },
+                { &element.basis_y_radiance, &element.basis_y_data },
+                { &element.basis_z_radiance, &element.basis_z_data },
+            };
+            for (const auto& basis : bases)
+            {
+                const auto encode = [format, basis, &element]()
+                {
+                    encode_basis(format, *basis.first, element.width, element.height, element.num_mips, *basis.second);
+                    std::vector<color::RGBF32>{}.swap(*basis.first);
+                };
+
+                if (pool)
+                {
+                    pool->submit(group, encode);
+                }
+                else
+                {
+                    encode();
+                }
+            }
+        }
+
+        if (pool)
+        {
+            pool->wait(group);
+        }
+    }
+
+    std::size_t SceneLightmap::encoded_level_size(Format format, int32 width, int32 height)
+    {
+        switch (format)
+        {
+        case Format::BC6H:
+            return texture_compression::compressed_size(texture_compression::BlockFormat::BC6H, width, height);
+
+        case Format::RGB9E5:
+            return std::size_t(width) * height * sizeof(uint32);
+
+        default:
+            return 0;
+        }
+    }
 }
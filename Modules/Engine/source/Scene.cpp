@@ -2,9 +2,12 @@
 
 #include <algorithm>
 #include <iostream>
+#include <sys/stat.h>
 #include <Core/Reflection/TypeDB.h>
 #include <Core/Reflection/ReflectionBuilder.h>
 #include <Core/Util/StringUtils.h>
+#include <Resource/Archives/BinaryArchive.h>
+#include <Resource/Archives/JsonArchive.h>
 #include "../include/Engine/Scene.h"
 #include "../include/Engine/SystemFrame.h"
 #include "../include/Engine/UpdatePipeline.h"
@@ -18,6 +21,61 @@ SGE_REFLECT_TYPE(sge::Scene)
 
 namespace sge
 {
+    static constexpr const char COOKED_SCENE_EXTENSION[] = ".cscene.sbin";
+
+    /* Version of the cooked scene format, increased whenever it changes so that old cooked scenes fall back to their source. */
+    static constexpr uint32 COOKED_SCENE_VERSION = 2;
+
+    /**
+     * \brief Gets the size and modification time of the source scene at the given path, which cooked scenes record to detect when they're stale.
+     * \return Whether the file exists.
+     */
+    static bool get_source_stamp(const char* path, uint64& out_size, uint64& out_mtime)
+    {
+        struct stat file_stats;
+        if (stat(path, &file_stats) < 0)
+        {
+            return false;
+        }
+
+        out_size = static_cast<uint64>(file_stats.st_size);
+        out_mtime = static_cast<uint64>(file_stats.st_mtime);
+        return true;
+    }
+
+    /**
+     * \brief Gets the typed array with the given name and size from a cooked scene, in place if the archive supports it.
+     * \param storage Storage for the array, used when it can't be viewed in place.
+     * \return Whether the array exists and has the expected size.
+     */
+    template <typename T>
+    static bool read_cooked_array(
+        ArchiveReader& reader,
+        const char* name,
+        std::size_t size,
+        const T*& out,
+        std::vector<T>& storage)
+    {
+        if (!reader.pull_object_member(name))
+        {
+            return false;
+        }
+
+        std::size_t view_size = 0;
+        if (reader.typed_array_view(out, view_size))
+        {
+            reader.pop();
+            return view_size == size;
+        }
+
+        std::size_t array_size = 0;
+        storage.resize(size);
+        const bool read = reader.array_size(array_size) && array_size == size && reader.typed_array(storage.data(), size) == size;
+        out = storage.data();
+        reader.pop();
+        return read;
+    }
+
     ////////////////////////
     ///   Constructors   ///
 
@@ -249,11 +307,13 @@ namespace sge
     {
         reset_scene();
 
+        // Members are read in the order 'to_archive' writes them, so that streaming readers can read them in one pass
+        reader.object_member("next_node_id", _scene_data.next_node_id);
+
         // Deserialize lightmap path
         reader.object_member("lightmap_data_path", _scene_data.lightmap_data_path);
 
         // Deserialize nodes
-        reader.object_member("next_node_id", _scene_data.next_node_id);
         reader.pull_object_member("nodes");
 
         // Get the number of nodes
@@ -285,8 +345,8 @@ namespace sge
             node->_transform_mod_index = (int32)this->_scene_data.system_node_local_transform_changes.size();
 
             // Deserialize node data
-            reader.object_member("root", node->_root);
             reader.object_member("name", node->_name);
+            reader.object_member("root", node->_root);
 
             // Deserialize transform data
             NodeLocalTransformMod trans;
@@ -380,6 +440,267 @@ namespace sge
         on_end_system_frame();
     }
 
+    void Scene::to_cooked_archive(ArchiveWriter& writer, const char* source_path) const
+    {
+        writer.as_object();
+        writer.object_member("cooked_scene_version", COOKED_SCENE_VERSION);
+
+        uint64 source_size = 0;
+        uint64 source_mtime = 0;
+        if (source_path && get_source_stamp(source_path, source_size, source_mtime))
+        {
+            writer.object_member("source_size", source_size);
+            writer.object_member("source_mtime", source_mtime);
+        }
+
+        writer.object_member("next_node_id", _scene_data.next_node_id);
+        writer.object_member("lightmap_data_path", _scene_data.lightmap_data_path);
+
+        // Pack nodes into arrays (in ascending order of id)
+        const auto num_nodes = _scene_data.nodes.size();
+        std::vector<NodeId::Index_t> ids;
+        std::vector<NodeId::Index_t> roots;
+        std::vector<float> lpos;
+        std::vector<float> lscale;
+        std::vector<float> lrot;
+        std::vector<uint32> name_ends;
+        std::string names;
+        ids.reserve(num_nodes);
+        roots.reserve(num_nodes);
+        lpos.reserve(num_nodes * 3);
+        lscale.reserve(num_nodes * 3);
+        lrot.reserve(num_nodes * 4);
+        name_ends.reserve(num_nodes);
+        for (const auto node : _scene_data.nodes)
+        {
+            const auto pos = node.second->get_local_position();
+            const auto scale = node.second->get_local_scale();
+            const auto rot = node.second->get_local_rotation();
+            ids.push_back(node.first.index);
+            roots.push_back(node.second->get_root().index);
+            lpos.insert(lpos.end(), { pos.x(), pos.y(), pos.z() });
+            lscale.insert(lscale.end(), { scale.x(), scale.y(), scale.z() });
+            lrot.insert(lrot.end(), { rot.x(), rot.y(), rot.z(), rot.w() });
+            names += node.second->get_name();
+            name_ends.push_back(static_cast<uint32>(names.size()));
+        }
+
+        writer.push_object_member("node_ids");
+        writer.typed_array(ids.data(), ids.size());
+        writer.pop();
+        writer.push_object_member("node_roots");
+        writer.typed_array(roots.data(), roots.size());
+        writer.pop();
+        writer.push_object_member("node_lpos");
+        writer.typed_array(lpos.data(), lpos.size());
+        writer.pop();
+        writer.push_object_member("node_lscale");
+        writer.typed_array(lscale.data(), lscale.size());
+        writer.pop();
+        writer.push_object_member("node_lrot");
+        writer.typed_array(lrot.data(), lrot.size());
+        writer.pop();
+        writer.push_object_member("node_name_ends");
+        writer.typed_array(name_ends.data(), name_ends.size());
+        writer.pop();
+        writer.object_member("node_names", names);
+
+        // Serialize all components
+        writer.push_object_member("components");
+        writer.as_object();
+        for (const auto& component_type : _scene_data.components)
+        {
+            writer.push_object_member(component_type.first->name().c_str());
+            writer.as_object();
+            component_type.second->to_cooked_archive(writer);
+            writer.pop();
+        }
+        writer.pop(); // "components"
+    }
+
+    bool Scene::from_cooked_archive(ArchiveReader& reader)
+    {
+        reset_scene();
+
+        uint32 version = 0;
+        if (!reader.object_member("cooked_scene_version", version) || version != COOKED_SCENE_VERSION)
+        {
+            return false;
+        }
+
+        reader.object_member("lightmap_data_path", _scene_data.lightmap_data_path);
+        reader.object_member("next_node_id", _scene_data.next_node_id);
+
+        // Get the number of nodes
+        std::size_t num_nodes = 0;
+        if (!reader.pull_object_member("node_ids"))
+        {
+            return false;
+        }
+        reader.array_size(num_nodes);
+        reader.pop();
+
+        // Get the node arrays
+        const NodeId::Index_t* ids = nullptr;
+        const NodeId::Index_t* roots = nullptr;
+        const float* lpos = nullptr;
+        const float* lscale = nullptr;
+        const float* lrot = nullptr;
+        const uint32* name_ends = nullptr;
+        std::vector<NodeId::Index_t> ids_storage;
+        std::vector<NodeId::Index_t> roots_storage;
+        std::vector<float> lpos_storage;
+        std::vector<float> lscale_storage;
+        std::vector<float> lrot_storage;
+        std::vector<uint32> name_ends_storage;
+        std::string names;
+        if (!read_cooked_array(reader, "node_ids", num_nodes, ids, ids_storage)
+            || !read_cooked_array(reader, "node_roots", num_nodes, roots, roots_storage)
+            || !read_cooked_array(reader, "node_lpos", num_nodes * 3, lpos, lpos_storage)
+            || !read_cooked_array(reader, "node_lscale", num_nodes * 3, lscale, lscale_storage)
+            || !read_cooked_array(reader, "node_lrot", num_nodes * 4, lrot, lrot_storage)
+            || !read_cooked_array(reader, "node_name_ends", num_nodes, name_ends, name_ends_storage)
+            || !reader.object_member("node_names", names))
+        {
+            return false;
+        }
+
+        // Load all nodes
+        std::vector<NodeId> node_ids;
+        std::vector<Node*> nodes;
+        node_ids.reserve(num_nodes);
+        nodes.reserve(num_nodes);
+        _scene_data.system_node_local_transform_changes.reserve(num_nodes);
+        _scene_data.system_new_nodes.reserve(num_nodes);
+        _scene_data.update_modified_nodes.reserve(num_nodes);
+        uint32 name_start = 0;
+        for (std::size_t i = 0; i < num_nodes; ++i)
+        {
+            // Validate the Id (ids are in ascending order, so the map can be filled from the back)
+            const NodeId id{ ids[i] };
+            const auto name_end = std::max(name_start, std::min(name_ends[i], static_cast<uint32>(names.size())));
+            if (id.is_null() || id.index >= _scene_data.next_node_id.index || (!node_ids.empty() && !(node_ids.back() < id)))
+            {
+                std::cout << "Error: Invalid node Id" << std::endl;
+                name_start = name_end;
+                continue;
+            }
+
+            // Allocate the node
+            void* buff = _scene_data.node_buffer.alloc(sizeof(Node));
+            auto* node = new (buff) Node();
+
+            // Initialize it
+            node->_id = id;
+            node->_scene = this;
+            node->_mod_state = Node::NEW | Node::TRANSFORM_PENDING;
+            node->_transform_mod_index = (int32)_scene_data.system_node_local_transform_changes.size();
+            node->_root = NodeId{ roots[i] };
+            node->_name.assign(names, name_start, name_end - name_start);
+            name_start = name_end;
+
+            NodeLocalTransformMod trans;
+            trans.node = node;
+            trans.local_pos = Vec3{ lpos[i * 3], lpos[i * 3 + 1], lpos[i * 3 + 2] };
+            trans.local_scale = Vec3{ lscale[i * 3], lscale[i * 3 + 1], lscale[i * 3 + 2] };
+            trans.local_rot = Quat{ lrot[i * 4], lrot[i * 4 + 1], lrot[i * 4 + 2], lrot[i * 4 + 3] };
+            _scene_data.system_node_local_transform_changes.push_back(trans);
+
+            // Insert it into the scene
+            _scene_data.nodes.emplace_hint(_scene_data.nodes.end(), id, node);
+            _scene_data.system_new_nodes.push_back(node);
+            _scene_data.update_modified_nodes.push_back(node);
+            node_ids.push_back(id);
+            nodes.push_back(node);
+        }
+
+        // Fix-up parent-child relationships
+        for (auto* node : nodes)
+        {
+            if (node->_root.is_null())
+            {
+                _scene_data.root_nodes.push_back(node->_id);
+                continue;
+            }
+
+            // Search for the parent
+            const auto iter = std::lower_bound(node_ids.begin(), node_ids.end(), node->_root);
+            if (iter == node_ids.end() || *iter != node->_root)
+            {
+                node->_root = NodeId::null_id();
+                continue;
+            }
+
+            // Add the node as a child of the parent
+            nodes[iter - node_ids.begin()]->_child_nodes.push_back(node->_id);
+        }
+
+        // Initialize hierarchy depth
+        initialize_hierarchy_depths();
+
+        // Deserialize all components (which only creates instances for nodes that exist, so they don't need to be validated afterwards)
+        if (reader.pull_object_member("components"))
+        {
+            reader.enumerate_object_members([&](const char* name)
+            {
+                auto type = get_component_type(name);
+                if (!type)
+                {
+                    return;
+                }
+
+                auto storage_iter = _scene_data.components.find(type);
+                storage_iter->second->from_cooked_archive(reader, node_ids.data(), node_ids.size());
+            });
+            reader.pop(); // "components"
+        }
+
+        // Apply changes to scene (generate events and matrices)
+        on_end_system_frame();
+        return true;
+    }
+
+    bool Scene::from_file(const char* path)
+    {
+        // Prefer the cooked scene, unless the source has changed since it was cooked
+        uint64 source_size = 0;
+        uint64 source_mtime = 0;
+        BinaryArchive cooked;
+        if (get_source_stamp(path, source_size, source_mtime) &&
+            cooked.map_file(cooked_path(path).c_str(), BinaryArchive::MapAccess::SEQUENTIAL))
+        {
+            auto* reader = cooked.read_root();
+            uint64 cooked_source_size = 0;
+            uint64 cooked_source_mtime = 0;
+            const bool current =
+                reader->object_member("source_size", cooked_source_size) && cooked_source_size == source_size &&
+                reader->object_member("source_mtime", cooked_source_mtime) && cooked_source_mtime == source_mtime;
+            const bool loaded = current && from_cooked_archive(*reader);
+            reader->pop();
+
+            if (loaded)
+            {
+                return true;
+            }
+        }
+
+        // Otherwise parse the source scene in one pass
+        auto* reader = JsonArchive::stream_from_file(path);
+        if (!reader)
+        {
+            return false;
+        }
+
+        from_archive(*reader);
+        reader->pop();
+        return true;
+    }
+
+    std::string Scene::cooked_path(const char* source_path)
+    {
+        return std::string{ source_path } + COOKED_SCENE_EXTENSION;
+    }
+
     TypeDB& Scene::get_type_db()
     {
         return *_type_db;
@@ -8,10 +8,66 @@
 
 namespace sge
 {
+    struct TaskPool;
+
     class SGE_RESOURCE_API BinaryArchive final : public Archive
     {
         SGE_REFLECTED_TYPE;
 
+    public:
+
+        /**
+         * \brief How a mapped archive is expected to be read, passed on to the OS as a paging hint.
+         */
+        enum class MapAccess
+        {
+            /**
+             * \brief The archive is read front to back (as when deserializing the whole thing), so pages may be read ahead aggressively and dropped once passed.
+             */
+            SEQUENTIAL,
+
+            /**
+             * \brief Only parts of the archive are read, in no particular order.
+             */
+            RANDOM,
+        };
+
+        /**
+         * \brief The versions of the binary archive format.
+         */
+        enum class Version : uint32
+        {
+            /**
+             * \brief Member names are stored inline, and sizes as fixed 32-bit values. Archives are built up in this version in memory.
+             */
+            V1 = 1,
+
+            /**
+             * \brief Member names are stored once in a string table, sizes and integers are varints, and typed array elements are aligned
+             * (so that they may be viewed in place when mapped). Large typed arrays may be compressed (see 'set_file_compression').
+             */
+            V2 = 2,
+        };
+
+        ////////////////////////
+        ///   Constructors   ///
+    public:
+
+        BinaryArchive() = default;
+
+        /**
+         * \brief Copies the contents of the given archive. If the given archive is mapped, its contents are copied into this archive's buffer.
+         */
+        BinaryArchive(const BinaryArchive& copy);
+
+        BinaryArchive(BinaryArchive&& move);
+
+        ~BinaryArchive() override;
+
+        BinaryArchive& operator=(const BinaryArchive& copy);
+
+        BinaryArchive& operator=(BinaryArchive&& move);
+
         ///////////////////
         ///   Methods   ///
     public:
@@ -24,15 +80,86 @@ namespace sge
 
         bool from_file(const char* path) override;
 
+        /**
+         * \brief Trys to map the given file into memory read-only, instead of reading it into this archive's buffer.
+         * Readers read directly from the mapping, so only the pages that are actually touched are ever read from disk,
+         * and arrays may be viewed in place with 'ArchiveReader::typed_array_view'. The mapping is released when this archive is destroyed,
+         * written to, or loaded again, so readers (and any views they handed out) must not outlive that.
+         * \param path The path to the file to map. Must have the '.sbin' extension, like 'from_file'.
+         * \param access How the archive will be read.
+         * \return Whether the operation succeeded.
+         */
+        bool map_file(const char* path, MapAccess access = MapAccess::SEQUENTIAL);
+
+        /**
+         * \brief Returns whether this archive's contents are mapped from a file, rather than held in its buffer.
+         */
+        bool is_mapped() const;
+
+        /**
+         * \brief Returns the contents of this archive, whether mapped or held in its buffer.
+         */
+        const byte* data() const;
+
+        /**
+         * \brief Returns the size (in bytes) of the contents of this archive.
+         */
+        std::size_t size() const;
+
+        /**
+         * \brief Returns the version of the format this archive's contents are in.
+         */
+        Version version() const;
+
+        /**
+         * \brief Sets the version of the format 'to_file' writes in (the latest version by default).
+         */
+        void set_file_version(Version version);
+
+        /**
+         * \brief Sets whether 'to_file' compresses large typed arrays, such as vertex data and lightmaps (off by default).
+         * Arrays are compressed in independent chunks with a fast LZ codec, and can't be viewed in place. Only version 2 archives are compressed.
+         */
+        void set_file_compression(bool compress);
+
+        /**
+         * \brief Sets the task pool that readers of this archive decompress the chunks of compressed arrays on in parallel (none by default).
+         * The pool must outlive any readers created after this is set.
+         */
+        void set_task_pool(TaskPool* pool);
+
+        /**
+         * \brief Encodes the contents of this archive in the given version of the format.
+         * \param version The version to encode in.
+         * \param out The buffer to write the encoded archive to (replacing its contents).
+         * \param compress Whether to compress large typed arrays (only supported by version 2).
+         */
+        void encode(Version version, std::vector<byte>& out, bool compress = false) const;
+
+        /**
+         * \brief Returns the buffer of this archive. This is empty while the archive is mapped.
+         */
         const std::vector<byte>& buffer() const
         {
             return _buffer;
         }
 
+    private:
+
+        void unmap();
+
         //////////////////
         ///   Fields   ///
     private:
 
         std::vector<byte> _buffer;
+
+        /* The mapped contents of the file, if any. */
+        const byte* _mapped_data = nullptr;
+        std::size_t _mapped_size = 0;
+
+        Version _file_version = Version::V2;
+        bool _file_compression = false;
+        TaskPool* _task_pool = nullptr;
     };
 }
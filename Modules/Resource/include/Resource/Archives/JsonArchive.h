@@ -36,6 +36,34 @@ namespace sge
 
         void from_string(const char* str);
 
+        /**
+         * \brief Returns a writer that writes JSON straight to the file at the given path as values are written, without building a document first.
+         * Nodes are written in the order they're pushed, and values can't be replaced once they're written. The file is finished when the root is popped.
+         * \return The writer for the root node, or null if the file could not be opened.
+         */
+        static ArchiveWriter* stream_to_file(const char* path);
+
+        /**
+         * \brief Returns a writer that writes JSON to the given string as values are written (see 'stream_to_file'). The string is assigned when the root is popped.
+         */
+        static ArchiveWriter* stream_to_string(std::string& out);
+
+        /**
+         * \brief Returns a reader that parses the JSON file at the given path in a single pass as values are read, without building a document first.
+         * This supports the subset of the ArchiveReader interface that can be used in one pass:
+         *  - Object members are cheapest to pull in the order they appear. Members read past while pulling another are kept (in a document) in case they're pulled later.
+         *  - An object or array can't be read again once it's been enumerated (or its node has been popped).
+         *  - Array elements can only be pulled in increasing order, and typed arrays are read from where the last read left off.
+         *  - 'object_size' and 'array_size' aren't known ahead of time, and always fail.
+         * \return The reader for the root node, or null if the file could not be opened.
+         */
+        static ArchiveReader* stream_from_file(const char* path);
+
+        /**
+         * \brief Returns a reader that parses the given JSON string in a single pass (see 'stream_from_file'). The string must outlive the reader.
+         */
+        static ArchiveReader* stream_from_string(const char* str);
+
         //////////////////
         ///   Fields   ///
     private:
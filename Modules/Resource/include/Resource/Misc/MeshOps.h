@@ -0,0 +1,150 @@
+// MeshOps.h
+#pragma once
+
+#include <Core/Math/Vec3.h>
+#include <Core/Math/IVec2.h>
+#include <Core/Math/IVec3.h>
+#include "../build.h"
+
+namespace sge
+{
+    namespace mesh_ops
+    {
+        /**
+         * \brief The size of the FIFO post-transform cache simulated when measuring and ordering triangles.
+         */
+        static constexpr std::size_t VERTEX_CACHE_SIZE = 16;
+
+        /**
+         * \brief How much worse than its optimal ACMR a cluster may get when splitting it up for overdraw ordering.
+         */
+        static constexpr float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+
+        /**
+         * \brief A single vertex of the interleaved, quantized vertex stream consumed by the renderer (24 bytes).
+         */
+        struct PackedVertex
+        {
+            /**
+             * \brief Position within the mesh bounds, as unsigned normalized 16-bit coordinates. The last component is padding.
+             */
+            uint16 position[4];
+
+            /**
+             * \brief Normal as signed normalized 10:10:10:2 (GL_INT_2_10_10_10_REV), with the bitangent sign in the 2-bit component.
+             */
+            uint32 normal;
+
+            /**
+             * \brief Tangent as signed normalized 10:10:10:2.
+             */
+            uint32 tangent;
+
+            UHalfVec2 material_uv;
+            UHalfVec2 lightmap_uv;
+        };
+
+        /**
+         * \brief Computes the average number of vertex cache misses per triangle for the given element buffer.
+         * \param elements The triangle elements.
+         * \param num_elements The number of elements.
+         * \param num_verts The number of vertices referenced by the elements.
+         * \param cache_size The number of entries in the simulated FIFO cache.
+         */
+        SGE_RESOURCE_API float compute_acmr(
+            const uint32* elements,
+            std::size_t num_elements,
+            std::size_t num_verts,
+            std::size_t cache_size);
+
+        /**
+         * \brief Reorders triangles to improve post-transform vertex cache hits (Forsyth's linear-speed algorithm).
+         * \param elements The triangle elements to reorder in place.
+         * \param num_elements The number of elements.
+         * \param num_verts The number of vertices referenced by the elements.
+         */
+        SGE_RESOURCE_API void optimize_vertex_cache(
+            uint32* elements,
+            std::size_t num_elements,
+            std::size_t num_verts);
+
+        /**
+         * \brief Reorders clusters of triangles so that outward-facing clusters are drawn first, reducing overdraw.
+         * Clusters are split at cache restarts, so this should be run after 'optimize_vertex_cache', and keeps its ACMR within 'threshold'.
+         * \param elements The triangle elements to reorder in place.
+         * \param num_elements The number of elements.
+         * \param positions The vertex positions.
+         * \param num_verts The number of vertices.
+         * \param threshold How much the ACMR of each cluster may degrade.
+         */
+        SGE_RESOURCE_API void optimize_overdraw(
+            uint32* elements,
+            std::size_t num_elements,
+            const Vec3* positions,
+            std::size_t num_verts,
+            float threshold);
+
+        /**
+         * \brief Simplifies a triangle list by collapsing edges onto existing vertices, in order of least quadric error.
+         * Vertices sharing a position but not attributes (such as along UV or lightmap seams) only move along the seam,
+         * open borders only move along the border, and vertices on the border between triangle groups never move.
+         * The relative order of the remaining triangles is preserved.
+         * \param elements The triangle elements to simplify.
+         * \param num_elements The number of elements.
+         * \param groups The group (material) of each triangle, or null if there is only one.
+         * \param positions The vertex positions.
+         * \param num_verts The number of vertices.
+         * \param target_num_elements The number of elements to stop at.
+         * \param max_error The largest distance a collapse may move the surface by.
+         * \param out_elements Receives the simplified elements. Must have room for 'num_elements' elements.
+         * \param out_groups Receives the group of each remaining triangle (may be null). Must have room for 'num_elements / 3' entries.
+         * \param out_error Receives the largest error introduced.
+         * \return The number of elements in the simplified triangle list.
+         */
+        SGE_RESOURCE_API std::size_t simplify(
+            const uint32* elements,
+            std::size_t num_elements,
+            const uint32* groups,
+            const Vec3* positions,
+            std::size_t num_verts,
+            std::size_t target_num_elements,
+            float max_error,
+            uint32* out_elements,
+            uint32* out_groups,
+            float* out_error);
+
+        /**
+         * \brief Computes a vertex remap table that orders vertices by first use in the element buffer, and rewrites the elements to match.
+         * \param elements The triangle elements to rewrite in place.
+         * \param num_elements The number of elements.
+         * \param num_verts The number of vertices.
+         * \param out_remap Receives the new index of each vertex, or ~0 for unreferenced vertices. Must have 'num_verts' entries.
+         * \return The number of referenced vertices.
+         */
+        SGE_RESOURCE_API std::size_t optimize_vertex_fetch(
+            uint32* elements,
+            std::size_t num_elements,
+            std::size_t num_verts,
+            uint32* out_remap);
+
+        /**
+         * \brief Packs the given vertex attributes into the interleaved, quantized vertex format.
+         * Positions are quantized relative to their bounds, and are reconstructed as 'offset + scale * position'.
+         * \param num_verts The number of vertices.
+         * \param out_position_offset Receives the position of the minimum corner of the bounds.
+         * \param out_position_scale Receives the extent of the bounds.
+         * \param out_verts The vertices to pack into. Must have 'num_verts' entries.
+         */
+        SGE_RESOURCE_API void pack_vertices(
+            std::size_t num_verts,
+            const Vec3* positions,
+            const HalfVec3* normals,
+            const HalfVec3* tangents,
+            const int8* bitangent_signs,
+            const UHalfVec2* material_uv,
+            const UHalfVec2* lightmap_uv,
+            Vec3* out_position_offset,
+            Vec3* out_position_scale,
+            PackedVertex* out_verts);
+    }
+}
@@ -0,0 +1,193 @@
+// TextureCompression.h
+#pragma once
+
+#include "../build.h"
+
+namespace sge
+{
+    struct TaskPool;
+
+    namespace texture_compression
+    {
+        /**
+         * \brief The block-compressed formats textures may be cooked into. Each encodes 4x4 blocks of pixels.
+         */
+        enum class BlockFormat : uint32
+        {
+            /**
+             * \brief Opaque RGB, at 4 bits per pixel.
+             */
+            BC1,
+
+            /**
+             * \brief RGB with a separately interpolated alpha channel, at 8 bits per pixel.
+             */
+            BC3,
+
+            /**
+             * \brief Two independent channels (red and green), at 8 bits per pixel. Used for tangent-space normal maps.
+             */
+            BC5,
+
+            /**
+             * \brief RGBA with higher precision endpoints and interpolation than BC1/BC3, at 8 bits per pixel.
+             */
+            BC7,
+
+            /**
+             * \brief Unsigned half-float RGB, at 8 bits per pixel. Encoded from float images with 'compress_hdr_image'.
+             */
+            BC6H,
+        };
+
+        /**
+         * \brief How pixels are averaged together when generating mip levels.
+         */
+        enum class MipFilter
+        {
+            /**
+             * \brief Channels are averaged as-is.
+             */
+            LINEAR,
+
+            /**
+             * \brief Color channels are converted from sRGB to linear before averaging, and back afterwards. Alpha is averaged as-is.
+             */
+            S_RGB,
+
+            /**
+             * \brief Pixels are unit vectors encoded in RGB, which are averaged and renormalized.
+             */
+            NORMAL,
+        };
+
+        /**
+         * \brief Returns the size (in bytes) of a single 4x4 block in the given format.
+         */
+        SGE_RESOURCE_API std::size_t block_size(
+            BlockFormat format);
+
+        /**
+         * \brief Returns the size (in bytes) of an image of the given size in the given format.
+         * Images whose size isn't a multiple of 4 are padded out to whole blocks.
+         */
+        SGE_RESOURCE_API std::size_t compressed_size(
+            BlockFormat format,
+            int32 width,
+            int32 height);
+
+        /**
+         * \brief Returns the number of levels in a full mip chain (down to 1x1) for an image of the given size.
+         */
+        SGE_RESOURCE_API int32 num_mip_levels(
+            int32 width,
+            int32 height);
+
+        /**
+         * \brief Generates the next mip level of the given RGBA8 image, with a 2x2 box filter.
+         * \param image The image to filter.
+         * \param width The width of the image (pixels).
+         * \param height The height of the image (pixels).
+         * \param filter How pixels are averaged together.
+         * \param out_mip The image to write the mip level to. Must hold max(width / 2, 1) * max(height / 2, 1) pixels.
+         */
+        SGE_RESOURCE_API void generate_mip(
+            const byte* image,
+            int32 width,
+            int32 height,
+            MipFilter filter,
+            byte* out_mip);
+
+        /**
+         * \brief Generates the next mip level of the given RGB float image, with a 2x2 box filter.
+         * \param image The image to filter.
+         * \param width The width of the image (pixels).
+         * \param height The height of the image (pixels).
+         * \param out_mip The image to write the mip level to. Must hold max(width / 2, 1) * max(height / 2, 1) pixels.
+         */
+        SGE_RESOURCE_API void generate_hdr_mip(
+            const float* image,
+            int32 width,
+            int32 height,
+            float* out_mip);
+
+        /**
+         * \brief Encodes a single 4x4 block of RGBA8 pixels (64 bytes, in row order) as BC1, ignoring alpha.
+         */
+        SGE_RESOURCE_API void encode_bc1_block(
+            const byte* block,
+            byte* out);
+
+        /**
+         * \brief Encodes a single 4x4 block of RGBA8 pixels (64 bytes, in row order) as BC3.
+         */
+        SGE_RESOURCE_API void encode_bc3_block(
+            const byte* block,
+            byte* out);
+
+        /**
+         * \brief Encodes the red and green channels of a single 4x4 block of RGBA8 pixels (64 bytes, in row order) as BC5.
+         */
+        SGE_RESOURCE_API void encode_bc5_block(
+            const byte* block,
+            byte* out);
+
+        /**
+         * \brief Encodes a single 4x4 block of RGBA8 pixels (64 bytes, in row order) as BC7.
+         * Only mode 6 (a single pair of RGBA endpoints with 16 interpolation steps) is used.
+         */
+        SGE_RESOURCE_API void encode_bc7_block(
+            const byte* block,
+            byte* out);
+
+        /**
+         * \brief Encodes a single 4x4 block of RGB float pixels (48 floats, in row order) as unsigned BC6H.
+         * Negative values are clamped to zero, and values above the largest half-float to it.
+         * Only mode 11 (a single pair of 10-bit endpoints with 16 interpolation steps) is used.
+         */
+        SGE_RESOURCE_API void encode_bc6h_block(
+            const float* block,
+            byte* out);
+
+        /**
+         * \brief Block-compresses the given RGBA8 image.
+         * \param format The format to compress the image into.
+         * \param image The image to compress.
+         * \param width The width of the image (pixels).
+         * \param height The height of the image (pixels).
+         * \param out The buffer to write blocks to. Must hold 'compressed_size(format, width, height)' bytes.
+         * \param pool If not null, rows of blocks are encoded in parallel on this pool.
+         */
+        SGE_RESOURCE_API void compress_image(
+            BlockFormat format,
+            const byte* image,
+            int32 width,
+            int32 height,
+            byte* out,
+            TaskPool* pool);
+
+        /**
+         * \brief Block-compresses the given RGB float image as BC6H.
+         * \param image The image to compress.
+         * \param width The width of the image (pixels).
+         * \param height The height of the image (pixels).
+         * \param out The buffer to write blocks to. Must hold 'compressed_size(BlockFormat::BC6H, width, height)' bytes.
+         * \param pool If not null, rows of blocks are encoded in parallel on this pool.
+         */
+        SGE_RESOURCE_API void compress_hdr_image(
+            const float* image,
+            int32 width,
+            int32 height,
+            byte* out,
+            TaskPool* pool);
+
+        /**
+         * \brief Packs RGB float pixels into the shared-exponent RGB9E5 format (as read by GL_UNSIGNED_INT_5_9_9_9_REV).
+         * Negative values are clamped to zero.
+         */
+        SGE_RESOURCE_API void pack_rgb9e5(
+            const float* image,
+            std::size_t num_pixels,
+            uint32* out);
+    }
+}
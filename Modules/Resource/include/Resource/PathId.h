@@ -0,0 +1,38 @@
+// PathId.h
+#pragma once
+
+#include <string>
+#include "build.h"
+
+namespace sge
+{
+    /**
+     * \brief A compact id for a resource path, interned in a global table. Ids are dense (numbered from zero in the order paths are first interned),
+     * so they may be used to index arrays of resources. The empty path always has id 'NULL_PATH_ID'.
+     * This is the only id resources are referred to by; 'ResourceId' adds the resource's type to it.
+     */
+    using PathId = uint32;
+    static constexpr PathId NULL_PATH_ID = 0;
+
+    /**
+     * \brief Returns the id of the given path, adding it to the table if it isn't already. Thread-safe.
+     * The table holds at most 4194304 paths; interning more is a fatal error, and aborts the program.
+     */
+    SGE_RESOURCE_API PathId intern_path(
+        const std::string& path);
+
+    SGE_RESOURCE_API PathId intern_path(
+        const char* path);
+
+    /**
+     * \brief Returns the path with the given id. The returned string stays valid (and unchanged) for the life of the program.
+     * Thread-safe, and never locks, so it may be called freely on hot paths.
+     */
+    SGE_RESOURCE_API const std::string& get_interned_path(
+        PathId id);
+
+    /**
+     * \brief Returns the number of paths interned so far. Every id handed out is less than this.
+     */
+    SGE_RESOURCE_API std::size_t num_interned_paths();
+}
@@ -0,0 +1,235 @@
+// ResourceCache.h
+#pragma once
+
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "build.h"
+
+namespace sge
+{
+    /**
+     * \brief Memory use and activity of a single category of resources in a 'ResourceCache'.
+     */
+    struct ResourceCacheStats
+    {
+        /**
+         * \brief Bytes of resident resources in this category, and how many of those bytes aren't referenced by anything.
+         */
+        std::size_t resident_bytes = 0;
+        std::size_t unreferenced_bytes = 0;
+
+        /**
+         * \brief The number of bytes eviction keeps this category under (unlimited if zero). Referenced resources are never evicted, so this may be exceeded.
+         */
+        std::size_t budget_bytes = 0;
+
+        std::size_t num_resident = 0;
+
+        /**
+         * \brief The number of requests for resources that were already resident or loading, and for resources that had to be loaded.
+         */
+        std::size_t num_hits = 0;
+        std::size_t num_misses = 0;
+
+        std::size_t num_evicted = 0;
+
+        /**
+         * \brief Total time taken to load resources, from when they were first requested until they became resident.
+         */
+        double load_ms = 0;
+    };
+
+    /**
+     * \brief Tracks the size, references and use of resources owned elsewhere, and chooses which to evict to keep each category of resource under its budget.
+     * Only unreferenced resources are evicted, least recently used first. Not thread-safe.
+     */
+    template <typename KeyT, typename HashT = std::hash<KeyT>>
+    struct ResourceCache
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry
+        {
+            std::size_t category = 0;
+            std::size_t size = 0;
+            uint32 num_refs = 0;
+            bool resident = false;
+            Clock::time_point request_time;
+
+            /* This entry's position in the list of unreferenced resources (only valid while 'num_refs' is zero). */
+            typename std::list<KeyT>::iterator unreferenced_pos;
+        };
+
+        ////////////////////////
+        ///   Constructors   ///
+    public:
+
+        explicit ResourceCache(std::size_t num_categories)
+            : _stats(num_categories)
+        {
+        }
+
+        ///////////////////
+        ///   Methods   ///
+    public:
+
+        /**
+         * \brief Sets the number of bytes the given category is kept under when evicting (unlimited if zero).
+         */
+        void set_budget(std::size_t category, std::size_t budget_bytes)
+        {
+            _stats[category].budget_bytes = budget_bytes;
+        }
+
+        const ResourceCacheStats& stats(std::size_t category) const
+        {
+            return _stats[category];
+        }
+
+        /**
+         * \brief Records a request for the given resource. If it isn't already tracked, it's added as loading (and unreferenced).
+         * \return Whether the resource was already tracked.
+         */
+        bool request(const KeyT& key, std::size_t category)
+        {
+            const auto iter = _entries.find(key);
+            if (iter != _entries.end())
+            {
+                _stats[iter->second.category].num_hits += 1;
+                touch(iter->second);
+                return true;
+            }
+
+            Entry entry;
+            entry.category = category;
+            entry.request_time = Clock::now();
+            entry.unreferenced_pos = _unreferenced.insert(_unreferenced.end(), key);
+            _entries.insert(std::make_pair(key, entry));
+            _stats[category].num_misses += 1;
+            return false;
+        }
+
+        /**
+         * \brief Records that the given requested resource has finished loading, and how many bytes it uses.
+         */
+        void set_resident(const KeyT& key, std::size_t size)
+        {
+            const auto iter = _entries.find(key);
+            if (iter == _entries.end() || iter->second.resident)
+            {
+                return;
+            }
+
+            auto& entry = iter->second;
+            auto& stats = _stats[entry.category];
+            entry.resident = true;
+            entry.size = size;
+            stats.resident_bytes += size;
+            stats.unreferenced_bytes += entry.num_refs == 0 ? size : 0;
+            stats.num_resident += 1;
+            stats.load_ms += std::chrono::duration<double, std::milli>(Clock::now() - entry.request_time).count();
+        }
+
+        /**
+         * \brief Adds a reference to the given requested resource, which prevents it from being evicted.
+         */
+        void add_ref(const KeyT& key)
+        {
+            const auto iter = _entries.find(key);
+            assert(iter != _entries.end());
+            if (iter == _entries.end())
+            {
+                return;
+            }
+
+            auto& entry = iter->second;
+            if (entry.num_refs++ == 0)
+            {
+                _unreferenced.erase(entry.unreferenced_pos);
+                _stats[entry.category].unreferenced_bytes -= entry.resident ? entry.size : 0;
+            }
+        }
+
+        /**
+         * \brief Removes a reference added with 'add_ref'. Once a resource has no references it may be evicted, after any resource that became unreferenced before it.
+         */
+        void release(const KeyT& key)
+        {
+            const auto iter = _entries.find(key);
+            if (iter == _entries.end() || iter->second.num_refs == 0)
+            {
+                return;
+            }
+
+            auto& entry = iter->second;
+            if (--entry.num_refs == 0)
+            {
+                entry.unreferenced_pos = _unreferenced.insert(_unreferenced.end(), key);
+                _stats[entry.category].unreferenced_bytes += entry.resident ? entry.size : 0;
+            }
+        }
+
+        /**
+         * \brief Evicts unreferenced resident resources, least recently used first, from each category that's over its budget until it fits.
+         * \param evictFn Called with the key and size of each resource evicted, which must free it. It may release references to other resources.
+         * \return The number of resources evicted.
+         */
+        template <typename EvictFnT>
+        std::size_t evict(EvictFnT&& evictFn)
+        {
+            std::size_t num_evicted = 0;
+            for (auto iter = _unreferenced.begin(); iter != _unreferenced.end();)
+            {
+                const auto entry_iter = _entries.find(*iter);
+                const auto& entry = entry_iter->second;
+                auto& stats = _stats[entry.category];
+                if (!entry.resident || stats.budget_bytes == 0 || stats.resident_bytes <= stats.budget_bytes)
+                {
+                    ++iter;
+                    continue;
+                }
+
+                stats.resident_bytes -= entry.size;
+                stats.unreferenced_bytes -= entry.size;
+                stats.num_resident -= 1;
+                stats.num_evicted += 1;
+                num_evicted += 1;
+
+                // Resources released while evicting this one are added to the end of the list (after this one), so they're considered in this pass too
+                const KeyT key = *iter;
+                const auto size = entry.size;
+                _entries.erase(entry_iter);
+                evictFn(key, size);
+                iter = _unreferenced.erase(iter);
+            }
+
+            return num_evicted;
+        }
+
+    private:
+
+        void touch(Entry& entry)
+        {
+            // Move unreferenced resources to the most recently used end
+            if (entry.num_refs == 0)
+            {
+                _unreferenced.splice(_unreferenced.end(), _unreferenced, entry.unreferenced_pos);
+            }
+        }
+
+        //////////////////
+        ///   Fields   ///
+    private:
+
+        std::unordered_map<KeyT, Entry, HashT> _entries;
+
+        /* Unreferenced resources, least recently used first. */
+        std::list<KeyT> _unreferenced;
+
+        std::vector<ResourceCacheStats> _stats;
+    };
+}
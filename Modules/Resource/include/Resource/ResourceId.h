@@ -1,25 +1,32 @@
 // ResourceId.h
 #pragma once
 
-#include <Core/Reflection/ReflectionBuilder.h>
-#include <Core/Containers/FixedString.h>
-#include "build.h"
+#include "PathId.h"
 
 namespace sge
 {
+    /**
+     * \brief The interned path of a resource of type 'T'. This is a 'PathId' (so it's as cheap to copy and compare), which also carries the resource's type.
+     */
     template <typename T>
-    struct SGE_RESOURCE_API ResourceId
+    struct ResourceId
     {
-        SGE_REFLECTED_TYPE;
-
-        using PackageName = FixedString<8>;
-        using ResourceName = FixedString<32>;
-
         ////////////////////////
         ///   Constructors   ///
     public:
 
         ResourceId()
+            : _path(NULL_PATH_ID)
+        {
+        }
+
+        explicit ResourceId(PathId path)
+            : _path(path)
+        {
+        }
+
+        explicit ResourceId(const std::string& uri)
+            : _path(intern_path(uri))
         {
         }
 
@@ -27,26 +34,35 @@ namespace sge
         ///   Methods   ///
     public:
 
-        /*void uri(std::string uri)
+        PathId path_id() const
         {
-            _uri = std::move(uri);
+            return _path;
         }
 
         const std::string& uri() const
         {
-            return _uri;
+            return get_interned_path(_path);
         }
 
         bool is_null() const
         {
-            return _uri.empty();
+            return _path == NULL_PATH_ID;
         }
-*/
+
+        friend bool operator==(const ResourceId& lhs, const ResourceId& rhs)
+        {
+            return lhs._path == rhs._path;
+        }
+
+        friend bool operator!=(const ResourceId& lhs, const ResourceId& rhs)
+        {
+            return lhs._path != rhs._path;
+        }
+
         //////////////////
         ///   Fields   ///
     private:
 
-        PackageName _package;
-        ResourceName _identifier;
+        PathId _path;
     };
 }
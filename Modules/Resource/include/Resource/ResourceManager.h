@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <functional>
 #include <Core/Reflection/Any.h>
+#include <Core/Reflection/TypeInfo.h>
 #include "build.h"
 #include "ResourceId.h"
 
@@ -87,6 +88,10 @@ namespace sge
                 &init);
         }
 
+        /**
+         * \brief Creates a resource, whose value is constructed by the given write function.
+         * Resources aren't loaded asynchronously yet, so the function runs on the calling thread, and 'cbQueue' is unused.
+         */
         NewResourceResult async_new_resource(
             const std::string& uri,
             const TypeInfo& type,
@@ -179,7 +184,7 @@ namespace sge
 
     private:
 
-        Resource* get_resource(const std::string& uri);
+        Resource* get_resource(PathId id);
 
         //////////////////
         ///   Fields   ///
@@ -187,6 +192,7 @@ namespace sge
 
         std::atomic<AsyncToken> _next_async_token;
         std::mutex _resources_lock;
-        std::unordered_map<std::string, Resource*> _resources;
+        /* Resources by the interned id of their uri. */
+        std::unordered_map<PathId, Resource*> _resources;
     };
 }
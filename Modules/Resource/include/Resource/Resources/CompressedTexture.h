@@ -0,0 +1,94 @@
+// CompressedTexture.h
+#pragma once
+
+#include <vector>
+#include "../Misc/TextureCompression.h"
+#include "Texture.h"
+
+namespace sge
+{
+    class ArchiveReader;
+
+    /**
+     * \brief A texture cooked offline into a block-compressed format, with a full mip chain.
+     * Cooked textures are stored next to their source image (see 'cooked_path'), and used in place of it when present.
+     */
+    struct SGE_RESOURCE_API CompressedTexture
+    {
+        SGE_REFLECTED_TYPE;
+
+        /**
+         * \brief The location of a single mip level within the texture's data.
+         */
+        struct Mip
+        {
+            int32 width = 0;
+            int32 height = 0;
+            std::size_t offset = 0;
+            std::size_t size = 0;
+        };
+
+        ////////////////////////
+        ///   Constructors   ///
+    public:
+
+        CompressedTexture();
+
+        ///////////////////
+        ///   Methods   ///
+    public:
+
+        void to_archive(ArchiveWriter& writer) const;
+
+        void from_archive(ArchiveReader& reader);
+
+        bool from_file(const char* path);
+
+        bool to_file(const char* path) const;
+
+        /**
+         * \brief Replaces this texture with the given source texture, mipmapped down to 1x1 and block-compressed.
+         * \param source The texture to cook.
+         * \param format The format to compress into. BC5 textures are treated as tangent-space normal maps, and are always linear.
+         * \param pool If not null, blocks are encoded in parallel on this pool.
+         */
+        void cook(const Texture& source, texture_compression::BlockFormat format, TaskPool* pool);
+
+        /**
+         * \brief Returns the path a cooked version of the given source image is stored at.
+         */
+        static std::string cooked_path(const char* source_path);
+
+        /**
+         * \brief Returns the format to cook the given texture into, unless it's a normal map: BC1 for opaque textures, and BC7 for textures with alpha.
+         */
+        static texture_compression::BlockFormat default_format(const Texture& source);
+
+        texture_compression::BlockFormat format() const;
+
+        Texture::ColorSpace color_space() const;
+
+        /**
+         * \brief Returns the number of mip levels in this texture (zero if it's empty).
+         */
+        std::size_t num_mips() const;
+
+        const Mip& mip(std::size_t level) const;
+
+        /**
+         * \brief Returns the blocks of every mip level, one after the other, starting from the largest.
+         */
+        const byte* data() const;
+
+        std::size_t data_size() const;
+
+        //////////////////
+        ///   Fields   ///
+    private:
+
+        texture_compression::BlockFormat _format;
+        Texture::ColorSpace _color_space;
+        std::vector<Mip> _mips;
+        std::vector<byte> _data;
+    };
+}
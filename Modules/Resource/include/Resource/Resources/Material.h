@@ -37,8 +37,22 @@ namespace sge
         ///   Methods   ///
     public:
 
+        /**
+         * \brief Loads the material from the given file, which may be a JSON source material or a cooked material ('.sbin').
+         */
         bool from_file(const char* path);
 
+        /**
+         * \brief Writes the material to the given file, as a cooked material if the path ends in '.sbin' (and as JSON otherwise).
+         */
+        bool to_file(const char* path) const;
+
+        /**
+         * \brief Returns the path a cooked version of the given source material is stored at.
+         * Cooked materials are used in place of their source material when present.
+         */
+        static std::string cooked_path(const char* source_path);
+
         void to_archive(ArchiveWriter& writer) const;
 
         void from_archive(ArchiveReader& reader);
@@ -9,6 +9,8 @@
 
 namespace sge
 {
+    struct TaskPool;
+
     struct SGE_RESOURCE_API StaticMesh
     {
         SGE_REFLECTED_TYPE;
@@ -38,6 +40,45 @@ namespace sge
             uint32 _num_elem_indices = 0;
         };
 
+        /**
+         * \brief A simplified version of the mesh, sharing its vertices.
+         * Elements are grouped by material, in the same order as the mesh's materials.
+         */
+        struct SGE_RESOURCE_API Lod
+        {
+            friend StaticMesh;
+
+            ///////////////////
+            ///   Methods   ///
+        public:
+
+            void to_archive(ArchiveWriter& writer) const;
+
+            void from_archive(ArchiveReader& reader);
+
+            /**
+             * \brief The largest distance (in mesh space) this LOD's surface may be from the full detail mesh.
+             */
+            float error() const;
+
+            std::size_t num_triangle_elements() const;
+
+            const uint32* triangle_elements() const;
+
+            /**
+             * \brief The number of elements belonging to each material (or a single entry, if the mesh has no materials).
+             */
+            const std::vector<uint32>& material_elem_counts() const;
+
+            //////////////////
+            ///   Fields   ///
+        private:
+
+            float _error = 0.f;
+            std::vector<uint32> _triangle_elements;
+            std::vector<uint32> _material_elem_counts;
+        };
+
         ////////////////////////
         ///   Constructors   ///
     public:
@@ -54,6 +95,34 @@ namespace sge
 
         bool from_file(const char* path);
 
+        /**
+         * \brief Loads the mesh from the given file, decompressing its vertex and index arrays on the given pool in parallel (if not null).
+         */
+        bool from_file(const char* path, TaskPool* pool);
+
+        /**
+         * \brief Writes the mesh to the given file, with its vertex and index arrays compressed.
+         */
+        bool to_file(const char* path) const;
+
+        /**
+         * \brief Returns the path a cooked version of the given source mesh (with LODs generated, and optimized) is stored at.
+         * Cooked meshes are used in place of their source mesh when present.
+         */
+        static std::string cooked_path(const char* source_path);
+
+        /**
+         * \brief Reorders triangles within each material for vertex cache efficiency and overdraw,
+         * then reorders vertices by first use (removing unreferenced vertices).
+         */
+        void optimize();
+
+        /**
+         * \brief Replaces this mesh's LODs with up to 'max_lods' successively simplified versions of it.
+         * Each LOD has about half the triangles of the previous one, and generation stops once simplification stops making progress.
+         */
+        void generate_lods(std::size_t max_lods);
+
         std::size_t num_verts() const;
 
         const Vec3* vertex_positions() const;
@@ -78,6 +147,10 @@ namespace sge
 
         const Material* materials() const;
 
+        std::size_t num_lods() const;
+
+        const Lod* lods() const;
+
         //////////////////
         ///   Fields   ///
     private:
@@ -90,5 +163,6 @@ namespace sge
         std::vector<UHalfVec2> _lightmap_uv;
         std::vector<uint32> _triangle_elements;
         std::vector<Material> _materials;
+        std::vector<Lod> _lods;
     };
 }
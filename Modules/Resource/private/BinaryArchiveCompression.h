@@ -0,0 +1,397 @@
+// BinaryArchiveCompression.h
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "BinaryArchiveNode.h"
+
+namespace sge
+{
+    /* Compressed blocks always end with at least this many literal bytes, and matches may not start within 'BAN_LZ_MATCH_LIMIT' bytes of the end. */
+    static constexpr std::size_t BAN_LZ_LAST_LITERALS = 5;
+    static constexpr std::size_t BAN_LZ_MATCH_LIMIT = 12;
+
+    /* The shortest match that is encoded (shorter ones are written as literals). */
+    static constexpr std::size_t BAN_LZ_MIN_MATCH = 4;
+
+    /* The farthest back a match may be. */
+    static constexpr std::size_t BAN_LZ_MAX_OFFSET = 65535;
+
+    /* The number of bits in the hashes of the compressor's match table. */
+    static constexpr uint32 BAN_LZ_HASH_BITS = 12;
+
+    inline uint32 binary_archive_lz_read32(const byte* in)
+    {
+        uint32 value;
+        std::memcpy(&value, in, sizeof(uint32));
+        return value;
+    }
+
+    /* Writes a length that didn't fit in its 4 bits of a sequence token, as a run of 255s and a final byte. */
+    inline byte* binary_archive_lz_write_length(byte* out, std::size_t len)
+    {
+        for (; len >= 255; len -= 255)
+        {
+            *out++ = 255;
+        }
+        *out++ = static_cast<byte>(len);
+        return out;
+    }
+
+    /* Writes a sequence of literals, followed by a match (if 'match_len' is not 0). Returns null if it doesn't fit before 'out_end'. */
+    inline byte* binary_archive_lz_write_sequence(
+        byte* out,
+        byte* const out_end,
+        const byte* literals,
+        std::size_t num_literals,
+        std::size_t offset,
+        std::size_t match_len)
+    {
+        const auto worst_case = 1 + num_literals / 255 + 1 + num_literals + 2 + match_len / 255 + 1;
+        if (static_cast<std::size_t>(out_end - out) < worst_case)
+        {
+            return nullptr;
+        }
+
+        byte* const token = out++;
+        *token = static_cast<byte>(std::min<std::size_t>(num_literals, 15) << 4);
+        if (num_literals >= 15)
+        {
+            out = binary_archive_lz_write_length(out, num_literals - 15);
+        }
+        std::memcpy(out, literals, num_literals);
+        out += num_literals;
+
+        // The last sequence is only literals
+        if (match_len == 0)
+        {
+            return out;
+        }
+
+        *out++ = static_cast<byte>(offset & 0xFF);
+        *out++ = static_cast<byte>(offset >> 8);
+        const auto len = match_len - BAN_LZ_MIN_MATCH;
+        *token |= static_cast<byte>(std::min<std::size_t>(len, 15));
+        if (len >= 15)
+        {
+            out = binary_archive_lz_write_length(out, len - 15);
+        }
+
+        return out;
+    }
+
+    /* Compresses the given bytes as an LZ4 block (sequences of literals and back-references, with no framing).
+     * Returns the size of the compressed block, or 0 if it doesn't fit in the given capacity. */
+    inline std::size_t binary_archive_lz_compress(
+        const byte* in,
+        std::size_t in_size,
+        byte* out,
+        std::size_t out_capacity)
+    {
+        byte* const out_start = out;
+        byte* const out_end = out + out_capacity;
+        const byte* const in_end = in + in_size;
+        const byte* anchor = in;
+
+        if (in_size > BAN_LZ_MATCH_LIMIT)
+        {
+            // The position (from 'in') of the last occurrence of each hashed 4-byte sequence
+            std::unique_ptr<uint32[]> table{ new uint32[std::size_t{ 1 } << BAN_LZ_HASH_BITS]() };
+            const byte* const match_limit = in_end - BAN_LZ_MATCH_LIMIT;
+            const byte* const extend_limit = in_end - BAN_LZ_LAST_LITERALS;
+
+            const byte* pos = in + 1;
+            while (pos < match_limit)
+            {
+                const auto sequence = binary_archive_lz_read32(pos);
+                const auto hash = (sequence * 2654435761u) >> (32 - BAN_LZ_HASH_BITS);
+                const byte* match = in + table[hash];
+                table[hash] = static_cast<uint32>(pos - in);
+
+                if (match >= pos || static_cast<std::size_t>(pos - match) > BAN_LZ_MAX_OFFSET || binary_archive_lz_read32(match) != sequence)
+                {
+                    // Skip ahead faster the longer it's been since the last match, since the data is probably incompressible
+                    pos += 1 + ((pos - anchor) >> 6);
+                    continue;
+                }
+
+                // Extend the match backwards over literals, and forwards as far as it goes
+                while (pos > anchor && match > in && pos[-1] == match[-1])
+                {
+                    --pos;
+                    --match;
+                }
+                std::size_t match_len = BAN_LZ_MIN_MATCH;
+                while (pos + match_len < extend_limit && pos[match_len] == match[match_len])
+                {
+                    ++match_len;
+                }
+
+                out = binary_archive_lz_write_sequence(out, out_end, anchor, static_cast<std::size_t>(pos - anchor), static_cast<std::size_t>(pos - match), match_len);
+                if (!out)
+                {
+                    return 0;
+                }
+
+                pos += match_len;
+                anchor = pos;
+            }
+        }
+
+        out = binary_archive_lz_write_sequence(out, out_end, anchor, static_cast<std::size_t>(in_end - anchor), 0, 0);
+        return out ? static_cast<std::size_t>(out - out_start) : 0;
+    }
+
+    /* Decompresses an LZ4 block into exactly 'out_size' bytes. Returns false if the block is malformed, or doesn't decompress to that size. */
+    inline bool binary_archive_lz_decompress(
+        const byte* in,
+        std::size_t in_size,
+        byte* out,
+        std::size_t out_size)
+    {
+        const byte* const in_end = in + in_size;
+        byte* const out_start = out;
+        byte* const out_end = out + out_size;
+
+        while (in < in_end)
+        {
+            const byte token = *in++;
+
+            // Copy the literals
+            std::size_t num_literals = token >> 4;
+            if (num_literals == 15)
+            {
+                byte b;
+                do
+                {
+                    if (in == in_end)
+                    {
+                        return false;
+                    }
+                    b = *in++;
+                    num_literals += b;
+                } while (b == 255);
+            }
+            if (num_literals > static_cast<std::size_t>(in_end - in) || num_literals > static_cast<std::size_t>(out_end - out))
+            {
+                return false;
+            }
+            std::memcpy(out, in, num_literals);
+            in += num_literals;
+            out += num_literals;
+
+            // The last sequence has no match
+            if (in == in_end)
+            {
+                break;
+            }
+
+            // Copy the match
+            if (in_end - in < 2)
+            {
+                return false;
+            }
+            const std::size_t offset = in[0] | (static_cast<std::size_t>(in[1]) << 8);
+            in += 2;
+            if (offset == 0 || offset > static_cast<std::size_t>(out - out_start))
+            {
+                return false;
+            }
+
+            std::size_t match_len = token & 0x0F;
+            if (match_len == 15)
+            {
+                byte b;
+                do
+                {
+                    if (in == in_end)
+                    {
+                        return false;
+                    }
+                    b = *in++;
+                    match_len += b;
+                } while (b == 255);
+            }
+            match_len += BAN_LZ_MIN_MATCH;
+            if (match_len > static_cast<std::size_t>(out_end - out))
+            {
+                return false;
+            }
+
+            // Matches may overlap what they're copying (repeating it), in which case they must be copied forwards a byte at a time
+            const byte* match = out - offset;
+            if (offset >= match_len)
+            {
+                std::memcpy(out, match, match_len);
+                out += match_len;
+            }
+            else
+            {
+                for (std::size_t i = 0; i < match_len; ++i)
+                {
+                    *out++ = *match++;
+                }
+            }
+        }
+
+        return out == out_end;
+    }
+
+    /* Groups the bytes of the given elements by their position within each element (all first bytes, then all second bytes, and so on).
+     * The high bytes of floats and small integers vary much less than the low bytes, so this leaves long runs for the compressor to find. */
+    inline void binary_archive_shuffle(const byte* in, byte* out, std::size_t num_elements, std::size_t element_size)
+    {
+        for (std::size_t b = 0; b < element_size; ++b)
+        {
+            for (std::size_t i = 0; i < num_elements; ++i)
+            {
+                out[b * num_elements + i] = in[i * element_size + b];
+            }
+        }
+    }
+
+    inline void binary_archive_unshuffle(const byte* in, byte* out, std::size_t num_elements, std::size_t element_size)
+    {
+        for (std::size_t b = 0; b < element_size; ++b)
+        {
+            for (std::size_t i = 0; i < num_elements; ++i)
+            {
+                out[i * element_size + b] = in[b * num_elements + i];
+            }
+        }
+    }
+
+    /* Replaces each element with its difference from the previous one (wrapping around), so that runs of nearby integers (such as indices) become small. */
+    template <typename T>
+    void binary_archive_delta_encode(byte* elements, std::size_t num_elements)
+    {
+        T prev = 0;
+        for (std::size_t i = 0; i < num_elements; ++i)
+        {
+            T value;
+            std::memcpy(&value, elements + i * sizeof(T), sizeof(T));
+            const T delta = static_cast<T>(value - prev);
+            std::memcpy(elements + i * sizeof(T), &delta, sizeof(T));
+            prev = value;
+        }
+    }
+
+    template <typename T>
+    void binary_archive_delta_decode(byte* elements, std::size_t num_elements)
+    {
+        T prev = 0;
+        for (std::size_t i = 0; i < num_elements; ++i)
+        {
+            T value;
+            std::memcpy(&value, elements + i * sizeof(T), sizeof(T));
+            prev = static_cast<T>(prev + value);
+            std::memcpy(elements + i * sizeof(T), &prev, sizeof(T));
+        }
+    }
+
+    inline void binary_archive_delta(byte* elements, std::size_t num_elements, std::size_t element_size, bool decode)
+    {
+        switch (element_size)
+        {
+        case 2:
+            decode ? binary_archive_delta_decode<uint16>(elements, num_elements) : binary_archive_delta_encode<uint16>(elements, num_elements);
+            break;
+
+        case 4:
+            decode ? binary_archive_delta_decode<uint32>(elements, num_elements) : binary_archive_delta_encode<uint32>(elements, num_elements);
+            break;
+
+        case 8:
+            decode ? binary_archive_delta_decode<uint64>(elements, num_elements) : binary_archive_delta_encode<uint64>(elements, num_elements);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    /* Filters and compresses a chunk of elements, appending it to the given buffer. If it doesn't get any smaller, it's appended uncompressed.
+     * Returns the size of the appended chunk. */
+    inline std::size_t binary_archive_encode_chunk(
+        const byte* elements,
+        std::size_t num_elements,
+        std::size_t element_size,
+        BinaryArchiveFilter filter,
+        std::vector<byte>& out)
+    {
+        const auto size = num_elements * element_size;
+        const byte* in = elements;
+
+        std::unique_ptr<byte[]> filtered;
+        if (filter != BAF_NONE)
+        {
+            std::unique_ptr<byte[]> delta;
+            if (filter == BAF_DELTA_SHUFFLE)
+            {
+                delta.reset(new byte[size]);
+                std::memcpy(delta.get(), elements, size);
+                binary_archive_delta(delta.get(), num_elements, element_size, false);
+                in = delta.get();
+            }
+
+            filtered.reset(new byte[size]);
+            binary_archive_shuffle(in, filtered.get(), num_elements, element_size);
+            in = filtered.get();
+        }
+
+        // Compressed chunks must be smaller than the uncompressed chunk, so that the reader can tell them apart
+        const auto start = out.size();
+        out.resize(start + size);
+        auto compressed_size = size > 1 ? binary_archive_lz_compress(in, size, out.data() + start, size - 1) : 0;
+        if (compressed_size == 0)
+        {
+            std::memcpy(out.data() + start, in, size);
+            compressed_size = size;
+        }
+
+        out.resize(start + compressed_size);
+        return compressed_size;
+    }
+
+    /* Decompresses and unfilters a chunk written by 'binary_archive_encode_chunk'. Returns false if the chunk is malformed. */
+    inline bool binary_archive_decode_chunk(
+        const byte* chunk,
+        std::size_t chunk_size,
+        byte* out_elements,
+        std::size_t num_elements,
+        std::size_t element_size,
+        BinaryArchiveFilter filter)
+    {
+        const auto size = num_elements * element_size;
+        // Filtered chunks are decompressed to a temporary buffer, then unfiltered into the output
+        std::unique_ptr<byte[]> filtered;
+        byte* decompressed = out_elements;
+        if (filter != BAF_NONE)
+        {
+            filtered.reset(new byte[size]);
+            decompressed = filtered.get();
+        }
+
+        if (chunk_size == size)
+        {
+            std::memcpy(decompressed, chunk, size);
+        }
+        else if (chunk_size > size || !binary_archive_lz_decompress(chunk, chunk_size, decompressed, size))
+        {
+            return false;
+        }
+
+        if (filter != BAF_NONE)
+        {
+            binary_archive_unshuffle(decompressed, out_elements, num_elements, element_size);
+            if (filter == BAF_DELTA_SHUFFLE)
+            {
+                binary_archive_delta(out_elements, num_elements, element_size, true);
+            }
+        }
+
+        return true;
+    }
+}
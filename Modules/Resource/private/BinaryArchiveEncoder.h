@@ -0,0 +1,448 @@
+// BinaryArchiveEncoder.h
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "BinaryArchiveReader.h"
+#include "BinaryArchiveCompression.h"
+
+namespace sge
+{
+    /**
+     * \brief Encodes an archive (read in any version) in version 2 of the binary archive format.
+     *
+     * Version 2 archives start with 'BAN_V2_MAGIC', followed by the string table: the number of strings (as a varint) and each NUL-terminated string.
+     * The root node follows. Nodes are laid out as in version 1, except that:
+     *  - Sizes, and 16 to 64-bit integers, are varints (signed integers are zigzag-encoded first).
+     *  - Member names are varint indices into the string table. The most common names get the smallest indices.
+     *  - Generic arrays and objects store their span (as a varint) from just after the span to the end of the node.
+     *  - Typed array elements are aligned to their size, relative to the start of the archive.
+     *  - If compression is enabled, typed arrays of at least 'BAN_COMPRESS_MIN_SIZE' bytes may be written as 'BAN_COMPRESSED_ARRAY' nodes instead.
+     */
+    class BinaryArchiveEncoder
+    {
+        ////////////////////////
+        ///   Constructors   ///
+    public:
+
+        BinaryArchiveEncoder(std::vector<byte>& out, bool compress_arrays = false)
+            : out(&out),
+            compress_arrays(compress_arrays)
+        {
+        }
+
+        ///////////////////
+        ///   Methods   ///
+    public:
+
+        /**
+         * \brief Encodes the archive at the reader's current node to the end of the output buffer, which must be empty (so that elements are aligned).
+         */
+        void encode(BinaryArchiveReader& reader)
+        {
+            assert(out->empty());
+
+            // Gather member names, and give the most common ones the smallest indices
+            std::vector<std::pair<std::string, std::size_t>> names;
+            gather_names(reader, names);
+            std::stable_sort(names.begin(), names.end(), [](const std::pair<std::string, std::size_t>& lhs, const std::pair<std::string, std::size_t>& rhs)
+            {
+                return lhs.second > rhs.second;
+            });
+
+            // Write the header and string table
+            out->insert(out->end(), BAN_V2_MAGIC, BAN_V2_MAGIC + sizeof(BAN_V2_MAGIC));
+            append_varint(names.size());
+            for (std::size_t i = 0; i < names.size(); ++i)
+            {
+                string_indices[names[i].first] = static_cast<uint32>(i);
+                out->insert(out->end(), names[i].first.c_str(), names[i].first.c_str() + names[i].first.size() + 1);
+            }
+
+            encode_node(reader);
+        }
+
+    private:
+
+        void gather_names(BinaryArchiveReader& reader, std::vector<std::pair<std::string, std::size_t>>& names)
+        {
+            if (reader.is_object())
+            {
+                reader.enumerate_object_members([this, &reader, &names](const char* name)
+                {
+                    const auto iter = gathered_names.find(name);
+                    if (iter == gathered_names.end())
+                    {
+                        gathered_names[name] = names.size();
+                        names.push_back(std::make_pair(std::string{ name }, std::size_t{ 1 }));
+                    }
+                    else
+                    {
+                        names[iter->second].second += 1;
+                    }
+
+                    this->gather_names(reader, names);
+                });
+            }
+            else if (reader.cursor.node_type == BAN_ARRAY_GENERIC)
+            {
+                reader.enumerate_array_elements([this, &reader, &names](std::size_t /*i*/)
+                {
+                    this->gather_names(reader, names);
+                });
+            }
+        }
+
+        void encode_node(BinaryArchiveReader& reader)
+        {
+            const auto type = reader.cursor.node_type;
+            out->push_back(type);
+
+            switch (type)
+            {
+            case BAN_NULL:
+                return;
+
+            case BAN_BOOLEAN:
+            case BAN_INT8:
+            case BAN_UINT8:
+                out->push_back(*reader.cursor.node_value);
+                return;
+
+            case BAN_INT16:
+                encode_signed<int16>(reader);
+                return;
+
+            case BAN_UINT16:
+                encode_unsigned<uint16>(reader);
+                return;
+
+            case BAN_INT32:
+                encode_signed<int32>(reader);
+                return;
+
+            case BAN_UINT32:
+                encode_unsigned<uint32>(reader);
+                return;
+
+            case BAN_INT64:
+                encode_signed<int64>(reader);
+                return;
+
+            case BAN_UINT64:
+                encode_unsigned<uint64>(reader);
+                return;
+
+            case BAN_FLOAT:
+                out->insert(out->end(), reader.cursor.node_value, reader.cursor.node_value + sizeof(float));
+                return;
+
+            case BAN_DOUBLE:
+                out->insert(out->end(), reader.cursor.node_value, reader.cursor.node_value + sizeof(double));
+                return;
+
+            case BAN_STRING:
+            {
+                std::size_t len = 0;
+                reader.string_size(len);
+                append_varint(len);
+                const auto start = out->size();
+                out->resize(start + len);
+                reader.string(reinterpret_cast<char*>(out->data() + start), len);
+                return;
+            }
+
+            case BAN_ARRAY_GENERIC:
+            case BAN_OBJECT:
+            case BAN_INDEXED_OBJECT:
+                encode_container(reader);
+                return;
+
+            default:
+                if (!compress_arrays || !encode_compressed_array(reader))
+                {
+                    encode_typed_array(reader);
+                }
+                return;
+            }
+        }
+
+        template <typename T>
+        void encode_signed(BinaryArchiveReader& reader)
+        {
+            T value = 0;
+            reader.number(value);
+            append_varint(binary_archive_zigzag_encode(value));
+        }
+
+        template <typename T>
+        void encode_unsigned(BinaryArchiveReader& reader)
+        {
+            T value = 0;
+            reader.number(value);
+            append_varint(value);
+        }
+
+        void encode_typed_array(BinaryArchiveReader& reader)
+        {
+            const auto type = reader.cursor.node_type;
+            const auto element_size = binary_archive_element_size(type);
+            assert(element_size != 0);
+
+            std::size_t size = 0;
+            reader.array_size(size);
+            append_varint(size);
+
+            // Pad out to the element alignment
+            out->resize(out->size() + (element_size - out->size() % element_size) % element_size, 0);
+
+            // Copy the elements in
+            const auto start = out->size();
+            out->resize(start + size * element_size);
+            read_elements(reader, out->data() + start, size);
+        }
+
+        /**
+         * \brief Tries to write the reader's current typed array compressed in chunks, in place of the node type indicator that's just been written.
+         * Returns false (without writing anything) if the array is too small, or doesn't compress well enough.
+         */
+        bool encode_compressed_array(BinaryArchiveReader& reader)
+        {
+            const auto type = reader.cursor.node_type;
+            const auto element_size = binary_archive_element_size(type);
+            std::size_t size = 0;
+            reader.array_size(size);
+            if (size * element_size < BAN_COMPRESS_MIN_SIZE)
+            {
+                return false;
+            }
+
+            std::vector<byte> elements(size * element_size);
+            read_elements(reader, elements.data(), size);
+
+            // Shuffle multi-byte elements. Integers may also benefit from delta encoding (as indices do), so the first chunk is tried both ways.
+            const auto chunk_elements = BAN_COMPRESS_CHUNK_SIZE / element_size;
+            std::vector<byte> chunks;
+            BinaryArchiveFilter filter = BAF_NONE;
+            if (element_size > 1)
+            {
+                filter = BAF_SHUFFLE;
+                if (type != BAN_ARRAY_FLOAT && type != BAN_ARRAY_DOUBLE)
+                {
+                    const auto count = std::min(chunk_elements, size);
+                    const auto shuffled_size = binary_archive_encode_chunk(elements.data(), count, element_size, BAF_SHUFFLE, chunks);
+                    const auto delta_size = binary_archive_encode_chunk(elements.data(), count, element_size, BAF_DELTA_SHUFFLE, chunks);
+                    filter = delta_size < shuffled_size ? BAF_DELTA_SHUFFLE : BAF_SHUFFLE;
+                    chunks.clear();
+                }
+            }
+
+            // Compress each chunk
+            std::vector<std::size_t> chunk_sizes;
+            for (std::size_t first = 0; first < size; first += chunk_elements)
+            {
+                const auto count = std::min(chunk_elements, size - first);
+                chunk_sizes.push_back(binary_archive_encode_chunk(elements.data() + first * element_size, count, element_size, filter, chunks));
+            }
+
+            if (chunks.size() > elements.size() - elements.size() / BAN_COMPRESS_MIN_SAVINGS_DIVISOR)
+            {
+                return false;
+            }
+
+            // Write the header. The span covers the filter, chunk size, chunk sizes, and chunks.
+            std::size_t span = 1 + binary_archive_varint_size(chunk_elements) + chunks.size();
+            for (const auto chunk_size : chunk_sizes)
+            {
+                span += binary_archive_varint_size(chunk_size);
+            }
+
+            out->back() = BAN_COMPRESSED_ARRAY;
+            out->push_back(type);
+            append_varint(size);
+            append_varint(span);
+            out->push_back(filter);
+            append_varint(chunk_elements);
+            for (const auto chunk_size : chunk_sizes)
+            {
+                append_varint(chunk_size);
+            }
+            out->insert(out->end(), chunks.begin(), chunks.end());
+            return true;
+        }
+
+        // Reads the elements of the reader's current typed array into the given buffer (booleans are one byte each in the archive, but not necessarily in memory).
+        static void read_elements(BinaryArchiveReader& reader, byte* elements, std::size_t size)
+        {
+            switch (reader.cursor.node_type)
+            {
+            case BAN_ARRAY_BOOLEAN:
+            {
+                std::unique_ptr<bool[]> values{ new bool[size] };
+                reader.typed_array(values.get(), size);
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    elements[i] = values[i] ? BAN_TRUE : BAN_FALSE;
+                }
+                break;
+            }
+
+            case BAN_ARRAY_INT8:
+                reader.typed_array(reinterpret_cast<int8*>(elements), size);
+                break;
+
+            case BAN_ARRAY_UINT8:
+                reader.typed_array(reinterpret_cast<uint8*>(elements), size);
+                break;
+
+            case BAN_ARRAY_INT16:
+                reader.typed_array(reinterpret_cast<int16*>(elements), size);
+                break;
+
+            case BAN_ARRAY_UINT16:
+                reader.typed_array(reinterpret_cast<uint16*>(elements), size);
+                break;
+
+            case BAN_ARRAY_INT32:
+                reader.typed_array(reinterpret_cast<int32*>(elements), size);
+                break;
+
+            case BAN_ARRAY_UINT32:
+                reader.typed_array(reinterpret_cast<uint32*>(elements), size);
+                break;
+
+            case BAN_ARRAY_INT64:
+                reader.typed_array(reinterpret_cast<int64*>(elements), size);
+                break;
+
+            case BAN_ARRAY_UINT64:
+                reader.typed_array(reinterpret_cast<uint64*>(elements), size);
+                break;
+
+            case BAN_ARRAY_FLOAT:
+                reader.typed_array(reinterpret_cast<float*>(elements), size);
+                break;
+
+            case BAN_ARRAY_DOUBLE:
+                reader.typed_array(reinterpret_cast<double*>(elements), size);
+                break;
+
+            default:
+                assert(false);
+            }
+        }
+
+        void encode_container(BinaryArchiveReader& reader)
+        {
+            const auto node_start = out->size() - 1;
+            const bool is_object = reader.is_object();
+            std::size_t size = 0;
+            if (is_object)
+            {
+                reader.object_size(size);
+            }
+            else
+            {
+                reader.array_size(size);
+            }
+            append_varint(size);
+            const auto span_start = out->size();
+
+            // The span isn't known until the contents are written, and moving the contents afterwards would break the alignment of typed arrays within them.
+            // So space is reserved for the span based on the size of the source node, and if that turns out to be too small the contents are written again.
+            const auto source_size = reader.node_value_size();
+            std::size_t span_size = binary_archive_varint_size(static_cast<uint64>(source_size) * 4 + 64);
+            while (true)
+            {
+                out->resize(span_start + span_size, 0);
+                std::vector<BinaryArchiveIndexEntry> index;
+                if (is_object)
+                {
+                    encode_members(reader, node_start, index);
+                }
+                else
+                {
+                    reader.enumerate_array_elements([this, &reader](std::size_t /*i*/)
+                    {
+                        this->encode_node(reader);
+                    });
+                }
+
+                // Objects with enough members get a member index, as in version 1
+                if (index.size() >= BAN_INDEX_MIN_MEMBERS)
+                {
+                    std::stable_sort(index.begin(), index.end(), [](const BinaryArchiveIndexEntry& lhs, const BinaryArchiveIndexEntry& rhs)
+                    {
+                        return lhs.hash < rhs.hash;
+                    });
+
+                    for (const auto& entry : index)
+                    {
+                        append_raw(entry.hash);
+                        append_raw(entry.offset);
+                    }
+                    (*out)[node_start] = BAN_INDEXED_OBJECT;
+                }
+                else if (is_object)
+                {
+                    (*out)[node_start] = BAN_OBJECT;
+                }
+
+                const auto span = out->size() - span_start - span_size;
+                if (binary_archive_varint_size(span) <= span_size)
+                {
+                    binary_archive_write_varint(out->data() + span_start, span, span_size);
+                    return;
+                }
+
+                span_size = BAN_MAX_VARINT_SIZE;
+                out->resize(span_start);
+            }
+        }
+
+        void encode_members(BinaryArchiveReader& reader, std::size_t node_start, std::vector<BinaryArchiveIndexEntry>& index)
+        {
+            reader.enumerate_object_members([this, &reader, node_start, &index](const char* name)
+            {
+                BinaryArchiveIndexEntry entry;
+                entry.hash = binary_archive_member_hash(name);
+                entry.offset = static_cast<BinaryArchiveSize_t>(out->size() - node_start);
+                index.push_back(entry);
+
+                this->append_varint(this->string_indices[name]);
+                this->encode_node(reader);
+            });
+        }
+
+        void append_varint(uint64 value)
+        {
+            byte bytes[BAN_MAX_VARINT_SIZE];
+            const auto size = binary_archive_write_varint(bytes, value);
+            out->insert(out->end(), bytes, bytes + size);
+        }
+
+        template <typename T>
+        void append_raw(const T& value)
+        {
+            const byte* addr = reinterpret_cast<const byte*>(&value);
+            out->insert(out->end(), addr, addr + sizeof(T));
+        }
+
+        //////////////////
+        ///   Fields   ///
+    private:
+
+        std::vector<byte>* out;
+
+        /* Whether large typed arrays are compressed. */
+        bool compress_arrays;
+
+        /* The index of each name in the list of names being gathered. */
+        std::unordered_map<std::string, std::size_t> gathered_names;
+
+        /* The index of each name in the string table. */
+        std::unordered_map<std::string, uint32> string_indices;
+    };
+}
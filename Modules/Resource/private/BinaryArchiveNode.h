@@ -17,6 +17,113 @@ namespace sge
     /* Constant value used for 'false'. */
     static constexpr BinaryArchiveBool_t BAN_FALSE = 0;
 
+    /* The first bytes of a version 2 archive. Version 1 archives start directly with the root node's type indicator, which never matches this. */
+    static constexpr byte BAN_V2_MAGIC[4] = { 'S', 'G', 'B', '2' };
+
+    /* The largest number of bytes a varint may take up (enough for any 64-bit value). */
+    static constexpr std::size_t BAN_MAX_VARINT_SIZE = 10;
+
+    /* Objects with at least this many members are written with a member index, so that members may be found without scanning the others. */
+    static constexpr BinaryArchiveSize_t BAN_INDEX_MIN_MEMBERS = 8;
+
+    /* Typed arrays of at least this many bytes are compressed, when compression is enabled for version 2 archives. */
+    static constexpr std::size_t BAN_COMPRESS_MIN_SIZE = 16 * 1024;
+
+    /* The uncompressed size (in bytes) of each chunk of a compressed array. Chunks are compressed independently, so they may be decompressed in parallel. */
+    static constexpr std::size_t BAN_COMPRESS_CHUNK_SIZE = 64 * 1024;
+
+    /* Compressed arrays that don't come out at least this much smaller (as a fraction of their uncompressed size) are written uncompressed. */
+    static constexpr std::size_t BAN_COMPRESS_MIN_SAVINGS_DIVISOR = 8;
+
+    /* Filters applied to each chunk of a compressed array before compressing it. */
+    enum BinaryArchiveFilter : byte
+    {
+        /* The elements are compressed as they are. */
+        BAF_NONE,
+
+        /* The bytes of the elements are grouped by their position within each element (see 'binary_archive_shuffle'). */
+        BAF_SHUFFLE,
+
+        /* Each element is replaced by its difference from the previous one, and then the bytes are shuffled. */
+        BAF_DELTA_SHUFFLE,
+    };
+
+    /* An entry in an indexed object's member index. Entries are sorted by hash, and offsets are from the object's node type indicator to the member's name. */
+    struct BinaryArchiveIndexEntry
+    {
+        uint32 hash;
+        BinaryArchiveSize_t offset;
+    };
+
+    /* Hashes a member name for the member index (32-bit FNV-1a). */
+    inline uint32 binary_archive_member_hash(const char* name)
+    {
+        uint32 hash = 2166136261u;
+        for (; *name != 0; ++name)
+        {
+            hash = (hash ^ static_cast<byte>(*name)) * 16777619u;
+        }
+
+        return hash;
+    }
+
+    /* Reads an unsigned LEB128 varint (7 bits per byte, least significant group first), advancing the given pointer past it. */
+    inline uint64 binary_archive_read_varint(const byte*& buffer)
+    {
+        uint64 value = 0;
+        for (uint32 shift = 0; ; shift += 7)
+        {
+            const byte b = *buffer++;
+            value |= static_cast<uint64>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+    }
+
+    /* Returns the number of bytes the given value takes up as a varint. */
+    inline std::size_t binary_archive_varint_size(uint64 value)
+    {
+        std::size_t size = 1;
+        for (; value >= 0x80; value >>= 7)
+        {
+            size += 1;
+        }
+
+        return size;
+    }
+
+    /* Writes the given value as a varint to the given buffer, padded with redundant continuation bytes to take up at least 'min_size' bytes.
+     * Returns the number of bytes written. */
+    inline std::size_t binary_archive_write_varint(byte* out, uint64 value, std::size_t min_size = 1)
+    {
+        std::size_t size = 0;
+        do
+        {
+            out[size] = static_cast<byte>(value & 0x7F);
+            value >>= 7;
+            size += 1;
+            if (value != 0 || size < min_size)
+            {
+                out[size - 1] |= 0x80;
+            }
+        } while (value != 0 || size < min_size);
+
+        return size;
+    }
+
+    /* Maps signed integers to unsigned ones such that values near zero (positive or negative) stay small as varints. */
+    inline uint64 binary_archive_zigzag_encode(int64 value)
+    {
+        return (static_cast<uint64>(value) << 1) ^ static_cast<uint64>(value >> 63);
+    }
+
+    inline int64 binary_archive_zigzag_decode(uint64 value)
+    {
+        return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+    }
+
     /* Indicates which node type the cursor is pointed at. */
     enum BinaryArchiveNode : byte
     {
@@ -46,5 +153,56 @@ namespace sge
         BAN_ARRAY_DOUBLE,
         BAN_ARRAY_GENERIC,
         BAN_OBJECT,
+
+        /* An object with its members followed by a member index, of one 'BinaryArchiveIndexEntry' per member. The span includes the index. */
+        BAN_INDEXED_OBJECT,
+
+        /* A typed array compressed in independent chunks (version 2 only). Followed by the node type of the array, its size and span (as for generic arrays),
+         * the 'BinaryArchiveFilter' applied to each chunk, the number of elements in each chunk (all but the last are full), the size of each compressed chunk,
+         * and then the chunks. Chunks that are as large as their uncompressed elements are stored uncompressed. */
+        BAN_COMPRESSED_ARRAY,
     };
+
+    /* Returns the node type of the elements of the given typed array type (or 'BAN_NULL', if it's not a typed array). */
+    inline BinaryArchiveNode binary_archive_element_type(BinaryArchiveNode array_type)
+    {
+        if (array_type < BAN_ARRAY_BOOLEAN || array_type > BAN_ARRAY_DOUBLE)
+        {
+            return BAN_NULL;
+        }
+
+        return static_cast<BinaryArchiveNode>(array_type - BAN_ARRAY_BOOLEAN + BAN_BOOLEAN);
+    }
+
+    /* Returns the size of each element of the given typed array type (or 0, if it's not a typed array).
+     * In version 2 archives, elements are also aligned to this. */
+    inline std::size_t binary_archive_element_size(BinaryArchiveNode array_type)
+    {
+        switch (array_type)
+        {
+        case BAN_ARRAY_BOOLEAN:
+            return sizeof(BinaryArchiveBool_t);
+
+        case BAN_ARRAY_INT8:
+        case BAN_ARRAY_UINT8:
+            return 1;
+
+        case BAN_ARRAY_INT16:
+        case BAN_ARRAY_UINT16:
+            return 2;
+
+        case BAN_ARRAY_INT32:
+        case BAN_ARRAY_UINT32:
+        case BAN_ARRAY_FLOAT:
+            return 4;
+
+        case BAN_ARRAY_INT64:
+        case BAN_ARRAY_UINT64:
+        case BAN_ARRAY_DOUBLE:
+            return 8;
+
+        default:
+            return 0;
+        }
+    }
 }
@@ -2,12 +2,17 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <stack>
 #include <vector>
 #include <algorithm>
+#include <type_traits>
+#include <unordered_map>
 #include <Core/IO/ArchiveReader.h>
+#include <Core/Parallelism/TaskPool.h>
 #include "BinaryArchiveNode.h"
+#include "BinaryArchiveCompression.h"
 
 namespace sge
 {
@@ -20,17 +25,56 @@ namespace sge
             BinaryArchiveNode node_type;
 
             bool in_enumeration;
+
+            /* Whether the value is stored at its full size, rather than as a varint. Always true in version 1 archives, and for elements of typed arrays. */
+            bool fixed_width;
+
+            /* Whether the node is a typed array compressed in chunks ('BAN_COMPRESSED_ARRAY'). If so, 'node_type' is the type of the array. */
+            bool compressed;
         };
 
         ////////////////////////
         ///   Constructors   ///
     public:
 
-        BinaryArchiveReader(const std::vector<byte>& buffer)
-        {
-            cursor.node_value = buffer.data() + 1;
-            cursor.node_type = static_cast<BinaryArchiveNode>(buffer.front());
+        /**
+         * \brief Reads the archive in the given memory, which may be a buffer or a mapped file. It must outlive this reader.
+         * Both version 1 and version 2 archives are supported.
+         * If a task pool is given, the chunks of large compressed arrays are decompressed on it in parallel. It must outlive this reader.
+         */
+        BinaryArchiveReader(const byte* data, std::size_t size, TaskPool* pool = nullptr)
+            : base(data),
+            pool(pool)
+        {
+            const byte* root = data;
+            if (size >= sizeof(BAN_V2_MAGIC) && std::memcmp(data, BAN_V2_MAGIC, sizeof(BAN_V2_MAGIC)) == 0)
+            {
+                // Read the string table
+                version = 2;
+                root += sizeof(BAN_V2_MAGIC);
+                const auto num_strings = static_cast<std::size_t>(binary_archive_read_varint(root));
+                strings.reserve(num_strings);
+                for (std::size_t i = 0; i < num_strings; ++i)
+                {
+                    const char* str = reinterpret_cast<const char*>(root);
+                    strings.push_back(str);
+                    root += std::strlen(str) + 1;
+                }
+            }
+
+            // An empty archive just holds null
+            if (root == data + size)
+            {
+                cursor.node_value = root;
+                cursor.node_type = BAN_NULL;
+                cursor.compressed = false;
+            }
+            else
+            {
+                enter_node(root);
+            }
             cursor.in_enumeration = false;
+            cursor.fixed_width = version == 1;
         }
 
         //////////////////
@@ -138,32 +182,33 @@ namespace sge
 
         bool string_size(std::size_t& out) const override
         {
-            BinaryArchiveSize_t size = 0;
-            if (impl_value(BAN_STRING, size))
+            if (!is_string())
             {
-                out = static_cast<BinaryArchiveSize_t>(size);
-                return true;
+                return false;
             }
 
-            return false;
+            const byte* value = cursor.node_value;
+            out = read_size(value);
+            return true;
         }
 
         std::size_t string(char* out, std::size_t len) const override
         {
-            std::size_t str_len;
-            if (!string_size(str_len))
+            if (!is_string())
             {
                 return 0;
             }
 
+            const byte* value = cursor.node_value;
+            const std::size_t str_len = read_size(value);
             const std::size_t copy_len = std::min(str_len, len);
-            std::memcpy(out, cursor.node_value + sizeof(BinaryArchiveSize_t), copy_len);
+            std::memcpy(out, value, copy_len);
             return copy_len;
         }
 
         bool is_array() const override
         {
-            return (cursor.node_type >= BAN_ARRAY_INT8 && cursor.node_type <= BAN_ARRAY_FLOAT) || cursor.node_type == BAN_ARRAY_GENERIC;
+            return (cursor.node_type >= BAN_ARRAY_BOOLEAN && cursor.node_type <= BAN_ARRAY_DOUBLE) || cursor.node_type == BAN_ARRAY_GENERIC;
         }
 
         bool array_size(std::size_t& out) const override
@@ -173,8 +218,8 @@ namespace sge
                 return false;
             }
 
-            const auto size = buffer_read<BinaryArchiveSize_t>(cursor.node_value);
-            out = static_cast<std::size_t>(size);
+            const byte* value = cursor.node_value;
+            out = read_size(value);
             return true;
         }
 
@@ -186,12 +231,10 @@ namespace sge
             }
 
             // Get the array size and the amount to read
-            const auto size = static_cast<std::size_t>(buffer_read<BinaryArchiveSize_t>(cursor.node_value));
+            std::size_t size = 0;
+            const auto arr = reinterpret_cast<const BinaryArchiveBool_t*>(typed_array_elements(size));
             const auto read_size = std::min(size, out_size);
 
-            // Create the array pointer
-            const auto arr = reinterpret_cast<const BinaryArchiveBool_t*>(cursor.node_value);
-
             // Copy the data
             for (std::size_t i = 0; i < read_size; ++i)
             {
@@ -251,6 +294,56 @@ namespace sge
             return impl_typed_array(BAN_ARRAY_DOUBLE, out, size);
         }
 
+        bool typed_array_view(const int8*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_INT8, out, out_size);
+        }
+
+        bool typed_array_view(const uint8*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_UINT8, out, out_size);
+        }
+
+        bool typed_array_view(const int16*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_INT16, out, out_size);
+        }
+
+        bool typed_array_view(const uint16*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_UINT16, out, out_size);
+        }
+
+        bool typed_array_view(const int32*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_INT32, out, out_size);
+        }
+
+        bool typed_array_view(const uint32*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_UINT32, out, out_size);
+        }
+
+        bool typed_array_view(const int64*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_INT64, out, out_size);
+        }
+
+        bool typed_array_view(const uint64*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_UINT64, out, out_size);
+        }
+
+        bool typed_array_view(const float*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_FLOAT, out, out_size);
+        }
+
+        bool typed_array_view(const double*& out, std::size_t& out_size) const override
+        {
+            return impl_typed_array_view(BAN_ARRAY_DOUBLE, out, out_size);
+        }
+
         void enumerate_array_elements(FunctionView<void(std::size_t i)> enumerator) override
         {
             // Get the size of the array
@@ -263,23 +356,23 @@ namespace sge
             // If it's a typed array, handle that seperately
             if (cursor.node_type != BAN_ARRAY_GENERIC)
             {
-                enumerate_typed_array_elements(size, enumerator);
+                enumerate_typed_array_elements(enumerator);
                 return;
             }
 
             // Back up the cursor
             const auto cursor_backup = cursor;
 
-            // Move the cursor forward to account for size and span
-            cursor.node_value += sizeof(BinaryArchiveSize_t) * 2;
+            // Move the cursor forward to the first element
+            cursor.node_value = container_elements(size);
             cursor.in_enumeration = true;
+            cursor.fixed_width = version == 1;
 
             // Loop through elements
             for (std::size_t i = 0; i < size; ++i)
             {
                 // Get the node type and advance the cursor past the indicator
-                cursor.node_type = static_cast<BinaryArchiveNode>(*cursor.node_value);
-                cursor.node_value += 1;
+                enter_node(cursor.node_value);
 
                 // Call the enumerator function
                 enumerator(i);
@@ -292,79 +385,22 @@ namespace sge
             cursor = cursor_backup;
         }
 
-        void enumerate_typed_array_elements(std::size_t size, FunctionView<void(std::size_t i)> enumerator)
+        void enumerate_typed_array_elements(FunctionView<void(std::size_t i)> enumerator)
         {
             // Back up the cursor
             const auto cursor_backup = cursor;
 
-            // Move the cursor forward to account for size
-            cursor.node_value += sizeof(BinaryArchiveSize_t);
-            cursor.in_enumeration = true;
-
             // Amount to advance the cursor by each enumeration
-            std::size_t advance = 0;
-
-            // Figure out which node to mark as the node type
-            switch (cursor.node_type)
-            {
-            case BAN_ARRAY_BOOLEAN:
-                cursor.node_type = BAN_BOOLEAN;
-                advance = sizeof(BinaryArchiveBool_t);
-                break;
-
-            case BAN_ARRAY_INT8:
-                cursor.node_type = BAN_INT8;
-                advance = sizeof(int8);
-                break;
-
-            case BAN_ARRAY_UINT8:
-                cursor.node_type = BAN_UINT8;
-                advance = sizeof(uint8);
-                break;
-
-            case BAN_ARRAY_INT16:
-                cursor.node_type = BAN_INT16;
-                advance = sizeof(int16);
-                break;
-
-            case BAN_ARRAY_UINT16:
-                cursor.node_type = BAN_UINT16;
-                advance = sizeof(uint16);
-                break;
-
-            case BAN_ARRAY_INT32:
-                cursor.node_type = BAN_INT32;
-                advance = sizeof(int32);
-                break;
-
-            case BAN_ARRAY_UINT32:
-                cursor.node_type = BAN_UINT32;
-                advance = sizeof(uint32);
-                break;
-
-            case BAN_ARRAY_INT64:
-                cursor.node_type = BAN_INT64;
-                advance = sizeof(int64);
-                break;
-
-            case BAN_ARRAY_UINT64:
-                cursor.node_type = BAN_UINT64;
-                advance = sizeof(uint64);
-                break;
-
-            case BAN_ARRAY_FLOAT:
-                cursor.node_type = BAN_FLOAT;
-                advance = sizeof(float);
-                break;
-
-            case BAN_ARRAY_DOUBLE:
-                cursor.node_type = BAN_DOUBLE;
-                advance = sizeof(double);
-                break;
+            const std::size_t advance = binary_archive_element_size(cursor.node_type);
+            assert(advance != 0);
 
-            default:
-                assert(false);
-            }
+            // Move the cursor forward to the first element, and mark elements as their own node type
+            std::size_t size = 0;
+            cursor.node_value = typed_array_elements(size);
+            cursor.node_type = binary_archive_element_type(cursor.node_type);
+            cursor.in_enumeration = true;
+            cursor.fixed_width = true;
+            cursor.compressed = false;
 
             // For each element
             for (std::size_t i = 0; i < size; ++i)
@@ -401,84 +437,38 @@ namespace sge
             if (cursor.node_type == BAN_ARRAY_GENERIC)
             {
                 // Move the cursor forward to the first element
-                cursor.node_type = static_cast<BinaryArchiveNode>(cursor.node_value[sizeof(BinaryArchiveSize_t) * 2]);
-                cursor.node_value += sizeof(BinaryArchiveSize_t) * 2 + 1;
+                enter_node(container_elements(size));
+                cursor.fixed_width = version == 1;
 
                 // For each step until the index
                 for (; i > 0; --i)
                 {
                     // Advance the cursor
-                    const auto advance = get_cursor_advancement();
-                    cursor.node_type = static_cast<BinaryArchiveNode>(cursor.node_value[advance]);
-                    cursor.node_value += advance + 1;
+                    enter_node(cursor.node_value + get_cursor_advancement());
                 }
 
                 return true;
             }
 
-            // Move the cursor past the size object
-            cursor.node_value += sizeof(BinaryArchiveSize_t);
-
             // Handle typed arrays
-            switch (cursor.node_type)
+            const auto element_size = binary_archive_element_size(cursor.node_type);
+            if (element_size == 0)
             {
-            case BAN_ARRAY_BOOLEAN:
-                cursor.node_value += sizeof(BinaryArchiveBool_t) * i;
-                cursor.node_type = BAN_BOOLEAN;
-                break;
-
-            case BAN_ARRAY_INT8:
-                cursor.node_value += sizeof(int8) * i;
-                cursor.node_type = BAN_INT8;
-                break;
-
-            case BAN_ARRAY_UINT8:
-                cursor.node_value += sizeof(uint8) * i;
-                cursor.node_type = BAN_UINT8;
-                break;
-
-            case BAN_ARRAY_INT16:
-                cursor.node_value += sizeof(int16) * i;
-                cursor.node_type = BAN_INT16;
-                break;
-
-            case BAN_ARRAY_UINT16:
-                cursor.node_value += sizeof(uint16) * i;
-                cursor.node_type = BAN_UINT16;
-                break;
-
-            case BAN_ARRAY_INT32:
-                cursor.node_value += sizeof(int32) * i;
-                cursor.node_type = BAN_INT32;
-                break;
-
-            case BAN_ARRAY_UINT32:
-                cursor.node_value += sizeof(uint32) * i;
-                cursor.node_type = BAN_UINT32;
-                break;
-
-            case BAN_ARRAY_INT64:
-                cursor.node_value += sizeof(int64) * i;
-                cursor.node_type = BAN_INT64;
-                break;
-
-            case BAN_ARRAY_UINT64:
-                cursor.node_value += sizeof(uint64) * i;
-                cursor.node_type = BAN_UINT64;
-                break;
-
-            default:
                 assert(false);
                 pop();
                 return false;
             }
 
+            cursor.node_value = typed_array_elements(size) + element_size * i;
+            cursor.node_type = binary_archive_element_type(cursor.node_type);
+            cursor.fixed_width = true;
+            cursor.compressed = false;
             return true;
         }
 
         bool is_object() const override
         {
-            return cursor.node_type == BAN_OBJECT;
+            return cursor.node_type == BAN_OBJECT || cursor.node_type == BAN_INDEXED_OBJECT;
         }
 
         bool object_size(std::size_t& out) const override
@@ -489,7 +479,8 @@ namespace sge
             }
 
             // Get the size from the archive
-            out = static_cast<std::size_t>(buffer_read<BinaryArchiveSize_t>(cursor.node_value));
+            const byte* value = cursor.node_value;
+            out = read_size(value);
             return true;
         }
 
@@ -505,20 +496,19 @@ namespace sge
             // Back up the cursor
             const auto cursor_back_up = cursor;
             cursor.in_enumeration = true;
+            cursor.fixed_width = version == 1;
 
             // Advance the cursor to the first element
-            cursor.node_value += sizeof(BinaryArchiveSize_t) * 2;
+            cursor.node_value = container_elements(size);
 
             // Enumerate over members
             for (std::size_t i = 0; i < size; ++i)
             {
                 // Get the name
-                const char* name = reinterpret_cast<const char*>(cursor.node_value);
-                cursor.node_value += std::strlen(name) + 1;
+                const char* name = read_member_name(cursor.node_value);
 
                 // Get the type
-                cursor.node_type = static_cast<BinaryArchiveNode>(*cursor.node_value);
-                cursor.node_value += 1;
+                enter_node(cursor.node_value);
 
                 // Call the enumerator
                 enumerator(name);
@@ -540,23 +530,28 @@ namespace sge
                 return false;
             }
 
+            // Use the member index, if the object has one
+            if (cursor.node_type == BAN_INDEXED_OBJECT)
+            {
+                return pull_indexed_object_member(name, size);
+            }
+
             // Back up the cursor
             auto cursor_backup = cursor;
             cursor.in_enumeration = false;
+            cursor.fixed_width = version == 1;
 
             // Advance the cursor to the first element
-            cursor.node_value += sizeof(BinaryArchiveSize_t) * 2;
+            cursor.node_value = container_elements(size);
 
             // Enumerate over members
             for (std::size_t i = 0; i < size; ++i)
             {
                 // Get the member's name name
-                const char* mem_name = reinterpret_cast<const char*>(cursor.node_value);
-                cursor.node_value += std::strlen(mem_name) + 1;
+                const char* mem_name = read_member_name(cursor.node_value);
 
                 // Get the type
-                cursor.node_type = static_cast<BinaryArchiveNode>(*cursor.node_value);
-                cursor.node_value += 1;
+                enter_node(cursor.node_value);
 
                 // See if this is the node we're looking for
                 if (std::strcmp(name, mem_name) == 0)
@@ -575,18 +570,171 @@ namespace sge
             return false;
         }
 
+        /**
+         * \brief Returns the size (in bytes) of the current node's value, not including its type indicator.
+         */
+        std::size_t node_value_size() const
+        {
+            return get_cursor_advancement();
+        }
+
     private:
 
+        // Points the cursor at the node with the given type indicator. Compressed arrays are given the type of the array they hold.
+        void enter_node(const byte* indicator)
+        {
+            cursor.node_type = static_cast<BinaryArchiveNode>(indicator[0]);
+            cursor.node_value = indicator + 1;
+            cursor.compressed = false;
+
+            if (cursor.node_type == BAN_COMPRESSED_ARRAY)
+            {
+                cursor.node_type = static_cast<BinaryArchiveNode>(indicator[1]);
+                cursor.node_value = indicator + 2;
+                cursor.compressed = true;
+            }
+        }
+
+        bool pull_indexed_object_member(const char* name, std::size_t size)
+        {
+            // The index is at the end of the object
+            const byte* const node_start = cursor.node_value - 1;
+            const byte* const index = cursor.node_value + get_cursor_advancement() - size * sizeof(BinaryArchiveIndexEntry);
+
+            // Binary search for the first entry with the name's hash
+            const auto hash = binary_archive_member_hash(name);
+            std::size_t first = 0;
+            std::size_t count = size;
+            while (count > 0)
+            {
+                const auto step = count / 2;
+                if (buffer_read<uint32>(index + (first + step) * sizeof(BinaryArchiveIndexEntry)) < hash)
+                {
+                    first += step + 1;
+                    count -= step + 1;
+                }
+                else
+                {
+                    count = step;
+                }
+            }
+
+            // Check each member with the same hash
+            for (; first < size; ++first)
+            {
+                const byte* const entry = index + first * sizeof(BinaryArchiveIndexEntry);
+                if (buffer_read<uint32>(entry) != hash)
+                {
+                    break;
+                }
+
+                const byte* member = node_start + buffer_read<BinaryArchiveSize_t>(entry + sizeof(uint32));
+                const char* const mem_name = read_member_name(member);
+                if (std::strcmp(name, mem_name) != 0)
+                {
+                    continue;
+                }
+
+                // Push the cursor onto the stack, and move to the member
+                cursor_stack.push(cursor);
+                enter_node(member);
+                cursor.in_enumeration = false;
+                cursor.fixed_width = version == 1;
+                return true;
+            }
+
+            return false;
+        }
+
+        // Reads a size (inline in version 1, a varint in version 2), and advances the given pointer past it.
+        std::size_t read_size(const byte*& value) const
+        {
+            if (version == 1)
+            {
+                const auto size = buffer_read<BinaryArchiveSize_t>(value);
+                value += sizeof(BinaryArchiveSize_t);
+                return static_cast<std::size_t>(size);
+            }
+
+            return static_cast<std::size_t>(binary_archive_read_varint(value));
+        }
+
+        // Reads a member name (inline in version 1, an index into the string table in version 2), and advances the given pointer past it.
+        const char* read_member_name(const byte*& value) const
+        {
+            if (version == 1)
+            {
+                const char* name = reinterpret_cast<const char*>(value);
+                value += std::strlen(name) + 1;
+                return name;
+            }
+
+            const auto index = static_cast<std::size_t>(binary_archive_read_varint(value));
+            assert(index < strings.size());
+            return strings[index];
+        }
+
+        // Gets the size of the current generic array or object, and returns a pointer to its first element.
+        const byte* container_elements(std::size_t& out_size) const
+        {
+            const byte* value = cursor.node_value;
+            out_size = read_size(value);
+            read_size(value); // span
+            return value;
+        }
+
+        // Gets the size of the current typed array, and returns a pointer to its first element.
+        // Compressed arrays are decompressed in full the first time, and kept for as long as this reader exists.
+        const byte* typed_array_elements(std::size_t& out_size) const
+        {
+            const byte* value = cursor.node_value;
+            out_size = read_size(value);
+
+            if (cursor.compressed)
+            {
+                auto& elements = decompressed_arrays[cursor.node_value];
+                if (elements.empty() && out_size != 0)
+                {
+                    elements.resize(out_size * binary_archive_element_size(cursor.node_type));
+                    if (!decompress_array(elements.data(), out_size))
+                    {
+                        std::fill(elements.begin(), elements.end(), byte{ 0 });
+                    }
+                }
+
+                return elements.data();
+            }
+
+            // Version 2 aligns elements (relative to the start of the archive) to their size
+            if (version != 1)
+            {
+                const auto align = binary_archive_element_size(cursor.node_type);
+                const auto offset = static_cast<std::size_t>(value - base);
+                value += (align - offset % align) % align;
+            }
+
+            return value;
+        }
+
         template <typename T>
         bool impl_value(BinaryArchiveNode required_type, T& out) const
         {
-            if (cursor.node_type == required_type)
+            if (cursor.node_type != required_type)
+            {
+                return false;
+            }
+
+            // Single bytes and floating point values are always stored at full size
+            if (cursor.fixed_width || sizeof(T) == 1 || std::is_floating_point<T>::value)
             {
                 out = buffer_read<T>(cursor.node_value);
                 return true;
             }
 
-            return false;
+            const byte* value = cursor.node_value;
+            const auto varint = binary_archive_read_varint(value);
+            out = std::is_signed<T>::value ? static_cast<T>(binary_archive_zigzag_decode(varint)) : static_cast<T>(varint);
+            return true;
         }
 
         template <typename T>
@@ -597,76 +745,144 @@ namespace sge
                 return 0;
             }
 
+            // Compressed arrays are decompressed straight to the output
+            if (cursor.compressed)
+            {
+                std::size_t size = 0;
+                array_size(size);
+                const auto read_size = std::min(size, out_size);
+                return decompress_array(reinterpret_cast<byte*>(out), read_size) ? read_size : 0;
+            }
+
             // Get the array size and the amount to read
-            const auto size = static_cast<std::size_t>(buffer_read<BinaryArchiveSize_t>(cursor.node_value));
+            std::size_t size = 0;
+            const auto* const elements = typed_array_elements(size);
             const auto read_size = std::min(size, out_size);
 
             // Copy the data
-            std::memcpy(out, cursor.node_value + sizeof(BinaryArchiveSize_t), read_size * sizeof(T));
+            std::memcpy(out, elements, read_size * sizeof(T));
             return read_size;
         }
 
+        template <typename T>
+        bool impl_typed_array_view(BinaryArchiveNode required_type, const T*& out, std::size_t& out_size) const
+        {
+            // Compressed elements only exist in place once decompressed, and that's not for as long as the archive exists
+            if (cursor.node_type != required_type || cursor.compressed)
+            {
+                return false;
+            }
+
+            // Elements can only be handed out in place if they're aligned for their type
+            std::size_t size = 0;
+            const auto* const elements = typed_array_elements(size);
+            if (reinterpret_cast<std::uintptr_t>(elements) % alignof(T) != 0)
+            {
+                return false;
+            }
+
+            out = reinterpret_cast<const T*>(elements);
+            out_size = size;
+            return true;
+        }
+
         template <typename T>
         static T buffer_read(const byte* buffer)
         {
-            return *reinterpret_cast<const T*>(buffer);
+            T value;
+            std::memcpy(&value, buffer, sizeof(T));
+            return value;
         }
 
-        // Figure out how much to advance the cursor by.
-        // (NOTE: This does not account for indicators, because the cursor has already advanced passed the current indicator)
-        std::size_t get_cursor_advancement() const
+        // Decompresses the first 'out_size' elements of the current compressed array to the given buffer. Returns false if the array is malformed.
+        bool decompress_array(byte* out, std::size_t out_size) const
         {
-            // If this node is a generic array or object
-            if (cursor.node_type == BAN_ARRAY_GENERIC || cursor.node_type == BAN_OBJECT)
+            const auto element_size = binary_archive_element_size(cursor.node_type);
+            const byte* value = cursor.node_value;
+            const auto size = read_size(value);
+            read_size(value); // span
+            const auto filter = static_cast<BinaryArchiveFilter>(*value++);
+            const auto chunk_elements = read_size(value);
+            if (chunk_elements == 0 || element_size == 0 || out_size > size)
             {
-                // Get the span (includes indicator byte, which we've passed)
-                return static_cast<std::size_t>(buffer_read<BinaryArchiveSize_t>(cursor.node_value + sizeof(BinaryArchiveSize_t))) - 1;
+                return size == 0;
             }
-            // If the node contains an array
-            else if (is_array())
+
+            // Find each chunk
+            const auto num_chunks = (size + chunk_elements - 1) / chunk_elements;
+            std::vector<std::size_t> chunk_sizes(num_chunks);
+            for (auto& chunk_size : chunk_sizes)
             {
-                // Get the length
-                const std::size_t len = static_cast<std::size_t>(buffer_read<BinaryArchiveSize_t>(cursor.node_value));
+                chunk_size = read_size(value);
+            }
+            std::vector<const byte*> chunks(num_chunks);
+            for (std::size_t i = 0; i < num_chunks; ++i)
+            {
+                chunks[i] = value;
+                value += chunk_sizes[i];
+            }
 
-                switch (cursor.node_type)
+            // Decompress each chunk that holds any of the elements being read, straight to the output unless it's only partly read
+            const auto num_read_chunks = (out_size + chunk_elements - 1) / chunk_elements;
+            std::vector<byte> succeeded(num_read_chunks, 0);
+            const auto decompress_chunk = [&](std::size_t i)
+            {
+                const auto first = i * chunk_elements;
+                const auto count = std::min(chunk_elements, size - first);
+                if (first + count <= out_size)
                 {
-                case BAN_ARRAY_BOOLEAN:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(BinaryArchiveBool_t) * len;
-
-                case BAN_ARRAY_INT8:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(int8) * len;
-
-                case BAN_ARRAY_UINT8:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(uint8) * len;
-
-                case BAN_ARRAY_INT16:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(int16) * len;
-
-                case BAN_ARRAY_UINT16:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(uint16) * len;
-
-                case BAN_ARRAY_INT32:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(int32) * len;
-
-                case BAN_ARRAY_UINT32:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(uint32) * len;
-
-                case BAN_ARRAY_INT64:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(int64) * len;
+                    succeeded[i] = binary_archive_decode_chunk(chunks[i], chunk_sizes[i], out + first * element_size, count, element_size, filter);
+                    return;
+                }
 
-                case BAN_ARRAY_UINT64:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(uint64) * len;
+                std::unique_ptr<byte[]> elements{ new byte[count * element_size] };
+                succeeded[i] = binary_archive_decode_chunk(chunks[i], chunk_sizes[i], elements.get(), count, element_size, filter);
+                std::memcpy(out + first * element_size, elements.get(), (out_size - first) * element_size);
+            };
 
-                case BAN_ARRAY_FLOAT:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(float) * len;
+            // The reading thread decompresses the first chunk itself, while the pool gets the rest
+            if (pool && num_read_chunks > 1)
+            {
+                TaskGroup group;
+                for (std::size_t i = 1; i < num_read_chunks; ++i)
+                {
+                    pool->submit(group, [&decompress_chunk, i]() {
+                        decompress_chunk(i);
+                    });
+                }
+                decompress_chunk(0);
+                pool->wait(group);
+            }
+            else
+            {
+                for (std::size_t i = 0; i < num_read_chunks; ++i)
+                {
+                    decompress_chunk(i);
+                }
+            }
 
-                case BAN_ARRAY_DOUBLE:
-                    return sizeof(BinaryArchiveSize_t) + sizeof(double) * len;
+            return std::find(succeeded.begin(), succeeded.end(), byte{ 0 }) == succeeded.end();
+        }
 
-                default:
-                    assert(false);
-                    return 0;
-                }
+        // Figure out how much to advance the cursor by.
+        // (NOTE: This does not account for indicators, because the cursor has already advanced passed the current indicator)
+        std::size_t get_cursor_advancement() const
+        {
+            // If this node is a generic array, object, or compressed array
+            if (cursor.node_type == BAN_ARRAY_GENERIC || is_object() || cursor.compressed)
+            {
+                // Version 1 spans include the indicator byte (which we've passed), version 2 spans start after the span itself
+                const byte* value = cursor.node_value;
+                read_size(value);
+                const auto span = read_size(value);
+                return version == 1 ? span - 1 : static_cast<std::size_t>(value - cursor.node_value) + span;
+            }
+            // If the node contains a typed array
+            else if (is_array())
+            {
+                std::size_t size = 0;
+                const auto* const elements = typed_array_elements(size);
+                return static_cast<std::size_t>(elements - cursor.node_value) + binary_archive_element_size(cursor.node_type) * size;
             }
 
             // Handle value types
@@ -685,22 +901,22 @@ namespace sge
                 return sizeof(uint8);
 
             case BAN_INT16:
-                return sizeof(int16);
+                return impl_number_advancement(sizeof(int16));
 
             case BAN_UINT16:
-                return sizeof(uint16);
+                return impl_number_advancement(sizeof(uint16));
 
             case BAN_INT32:
-                return sizeof(int32);
+                return impl_number_advancement(sizeof(int32));
 
             case BAN_UINT32:
-                return sizeof(uint32);
+                return impl_number_advancement(sizeof(uint32));
 
             case BAN_INT64:
-                return sizeof(int64);
+                return impl_number_advancement(sizeof(int64));
 
             case BAN_UINT64:
-                return sizeof(uint64);
+                return impl_number_advancement(sizeof(uint64));
 
             case BAN_FLOAT:
                 return sizeof(float);
@@ -709,7 +925,11 @@ namespace sge
                 return sizeof(double);
 
             case BAN_STRING:
-                return sizeof(BinaryArchiveSize_t) + static_cast<std::size_t>(buffer_read<BinaryArchiveSize_t>(cursor.node_value));
+            {
+                const byte* value = cursor.node_value;
+                const auto len = read_size(value);
+                return static_cast<std::size_t>(value - cursor.node_value) + len;
+            }
 
             default:
                 assert(false);
@@ -717,11 +937,36 @@ namespace sge
             }
         }
 
+        std::size_t impl_number_advancement(std::size_t size) const
+        {
+            if (cursor.fixed_width)
+            {
+                return size;
+            }
+
+            const byte* value = cursor.node_value;
+            binary_archive_read_varint(value);
+            return static_cast<std::size_t>(value - cursor.node_value);
+        }
+
         //////////////////
         ///   Fields   ///
     public:
 
         Cursor cursor;
         std::stack<Cursor> cursor_stack;
+
+        /* The start of the archive, and the version of the format it's in. */
+        const byte* base;
+        uint32 version = 1;
+
+        /* The member names of a version 2 archive. */
+        std::vector<const char*> strings;
+
+        /* The pool to decompress compressed arrays on, if any. */
+        TaskPool* pool;
+
+        /* Compressed arrays that have been decompressed to be enumerated or pulled from, by the location of their values. */
+        mutable std::unordered_map<const byte*, std::vector<byte>> decompressed_arrays;
     };
 }
@@ -1,6 +1,7 @@
 // BinaryArchiveWriter.h
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <vector>
@@ -36,8 +37,14 @@ namespace sge
 
         void pop() override
         {
+            // If this node is an object, it may need a member index
+            if (current_node.node_type == BAN_OBJECT)
+            {
+                write_member_index();
+            }
+
             // If this node is a generic array or object, we need to set the span
-            if (current_node.node_type == BAN_ARRAY_GENERIC || current_node.node_type == BAN_OBJECT)
+            if (current_node.node_type == BAN_ARRAY_GENERIC || current_node.node_type == BAN_OBJECT || current_node.node_type == BAN_INDEXED_OBJECT)
             {
                 const auto span = static_cast<BinaryArchiveSize_t>(buffer->size() - current_node.offset);
                 *reinterpret_cast<BinaryArchiveSize_t*>(buffer->data() + current_node.offset + 1 + sizeof(BinaryArchiveSize_t)) = span;
@@ -241,6 +248,7 @@ namespace sge
                 current_node.node_type = BAN_OBJECT;
                 buffer_append(BinaryArchiveSize_t{ 0 });
                 buffer_append(BinaryArchiveSize_t{ 0 });
+                member_index_stack.push(std::vector<BinaryArchiveIndexEntry>{});
             }
         }
 
@@ -252,6 +260,12 @@ namespace sge
             // Increment the member count
             *reinterpret_cast<BinaryArchiveSize_t*>(buffer->data() + current_node.offset + 1) += 1;
 
+            // Add the member to the object's index
+            BinaryArchiveIndexEntry entry;
+            entry.hash = binary_archive_member_hash(name);
+            entry.offset = static_cast<BinaryArchiveSize_t>(buffer->size() - current_node.offset);
+            member_index_stack.top().push_back(entry);
+
             // Push the current node onto the stack as a parent
             node_stack.push(current_node);
 
@@ -285,6 +299,34 @@ namespace sge
             buffer->insert(buffer->end(), reinterpret_cast<const byte*>(arr), reinterpret_cast<const byte*>(arr + size));
         }
 
+        // Appends the member index to the current object, if it has enough members to be worth it.
+        void write_member_index()
+        {
+            auto entries = std::move(member_index_stack.top());
+            member_index_stack.pop();
+
+            if (entries.size() < BAN_INDEX_MIN_MEMBERS)
+            {
+                return;
+            }
+
+            // Sort the entries by hash, keeping members with the same hash in the order they were written
+            std::stable_sort(entries.begin(), entries.end(), [](const BinaryArchiveIndexEntry& lhs, const BinaryArchiveIndexEntry& rhs)
+            {
+                return lhs.hash < rhs.hash;
+            });
+
+            buffer->reserve(buffer->size() + entries.size() * sizeof(BinaryArchiveIndexEntry));
+            for (const auto& entry : entries)
+            {
+                buffer_append(entry.hash);
+                buffer_append(entry.offset);
+            }
+
+            (*buffer)[current_node.offset] = BAN_INDEXED_OBJECT;
+            current_node.node_type = BAN_INDEXED_OBJECT;
+        }
+
         template <typename T>
         void buffer_append(const T& value)
         {
@@ -307,6 +349,7 @@ namespace sge
 
         Cursor current_node;
         std::stack<Cursor> node_stack;
+        std::stack<std::vector<BinaryArchiveIndexEntry>> member_index_stack;
         std::vector<byte>* buffer;
     };
 }
@@ -0,0 +1,904 @@
+// JsonStreamReader.h
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <rapidjson/reader.h>
+#include "JsonArchiveReader.h"
+
+namespace sge
+{
+    /**
+     * \brief Reads JSON from a rapidjson input stream in a single pass as values are read, pulling one token at a time from rapidjson's SAX reader.
+     * 'SourceT' owns the input stream (as 'stream'). See 'JsonArchive::stream_from_file' for the parts of the ArchiveReader interface this supports.
+     */
+    template <class SourceT>
+    class JsonStreamReader final : public ArchiveReader
+    {
+        enum class TokenType
+        {
+            /* The end of the input, or a parse error. */
+            NONE,
+            VALUE,
+            KEY,
+            START_OBJECT,
+            END_OBJECT,
+            START_ARRAY,
+            END_ARRAY,
+        };
+
+        enum class NodeState
+        {
+            /* The current token is the start of this node. */
+            UNREAD,
+
+            /* This node is an object or array that has been opened, and the current token is its next member or element (or its end). */
+            ENTERED,
+
+            /* All of this node has been read, and the current token is past it. */
+            DONE,
+        };
+
+        struct Node
+        {
+            NodeState state = NodeState::UNREAD;
+            bool is_object = false;
+
+            /* The index of the next element, if this node is an array. */
+            std::size_t next_index = 0;
+
+            /* Members of this object that were read past while looking for another member. */
+            std::unique_ptr<rapidjson::Document> skipped_members;
+        };
+
+        struct TokenHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, TokenHandler>
+        {
+            bool Null()
+            {
+                reader->_token_type = TokenType::VALUE;
+                reader->_token_value.SetNull();
+                return true;
+            }
+
+            bool Bool(bool value)
+            {
+                reader->_token_type = TokenType::VALUE;
+                reader->_token_value.SetBool(value);
+                return true;
+            }
+
+            bool Int(int value)
+            {
+                reader->_token_type = TokenType::VALUE;
+                reader->_token_value.SetInt(value);
+                return true;
+            }
+
+            bool Uint(unsigned value)
+            {
+                reader->_token_type = TokenType::VALUE;
+                reader->_token_value.SetUint(value);
+                return true;
+            }
+
+            bool Int64(int64_t value)
+            {
+                reader->_token_type = TokenType::VALUE;
+                reader->_token_value.SetInt64(value);
+                return true;
+            }
+
+            bool Uint64(uint64_t value)
+            {
+                reader->_token_type = TokenType::VALUE;
+                reader->_token_value.SetUint64(value);
+                return true;
+            }
+
+            bool Double(double value)
+            {
+                reader->_token_type = TokenType::VALUE;
+                reader->_token_value.SetDouble(value);
+                return true;
+            }
+
+            bool String(const char* str, rapidjson::SizeType len, bool /*copy*/)
+            {
+                // The string is only valid for the duration of the call
+                reader->_token_type = TokenType::VALUE;
+                reader->_token_string.assign(str, len);
+                reader->_token_value.SetString(rapidjson::StringRef(reader->_token_string.c_str(), len));
+                return true;
+            }
+
+            bool Key(const char* str, rapidjson::SizeType len, bool /*copy*/)
+            {
+                reader->_token_type = TokenType::KEY;
+                reader->_token_string.assign(str, len);
+                return true;
+            }
+
+            bool StartObject()
+            {
+                reader->_token_type = TokenType::START_OBJECT;
+                return true;
+            }
+
+            bool EndObject(rapidjson::SizeType /*num_members*/)
+            {
+                reader->_token_type = TokenType::END_OBJECT;
+                return true;
+            }
+
+            bool StartArray()
+            {
+                reader->_token_type = TokenType::START_ARRAY;
+                return true;
+            }
+
+            bool EndArray(rapidjson::SizeType /*num_elements*/)
+            {
+                reader->_token_type = TokenType::END_ARRAY;
+                return true;
+            }
+
+            JsonStreamReader* reader;
+        };
+
+        ////////////////////////
+        ///   Constructors   ///
+    public:
+
+        JsonStreamReader(std::unique_ptr<SourceT> source)
+            : _source(std::move(source))
+        {
+            _handler.reader = this;
+            _parser.IterativeParseInit();
+            _nodes.emplace_back();
+            advance();
+        }
+
+        ///////////////////
+        ///   Methods   ///
+    public:
+
+        void pop() override
+        {
+            if (_skipped_reader)
+            {
+                // Popping the node the skipped member reader was created for destroys it
+                _skipped_reader->pop();
+                if (_skipped_depth == 0)
+                {
+                    _skipped_reader = nullptr;
+                }
+                else
+                {
+                    _skipped_depth -= 1;
+                }
+                return;
+            }
+
+            // If we've reached the end of this stack (there's no need to read the rest of the input)
+            if (_nodes.size() == 1)
+            {
+                delete this;
+                return;
+            }
+
+            finish_head();
+            _nodes.pop_back();
+        }
+
+        bool null() const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->null();
+            }
+
+            return is_value() && _token_value.IsNull();
+        }
+
+        bool is_boolean() const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->is_boolean();
+            }
+
+            return is_value() && _token_value.IsBool();
+        }
+
+        bool boolean(bool& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->boolean(out);
+            }
+
+            return impl_value<bool, &rapidjson::Value::IsBool, &rapidjson::Value::GetBool>(out);
+        }
+
+        bool is_number() const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->is_number();
+            }
+
+            return is_value() && _token_value.IsNumber();
+        }
+
+        bool number(int8& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<int, &rapidjson::Value::IsInt, &rapidjson::Value::GetInt>(out);
+        }
+
+        bool number(uint8& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<unsigned int, &rapidjson::Value::IsUint, &rapidjson::Value::GetUint>(out);
+        }
+
+        bool number(int16& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<int, &rapidjson::Value::IsInt, &rapidjson::Value::GetInt>(out);
+        }
+
+        bool number(uint16& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<unsigned int, &rapidjson::Value::IsUint, &rapidjson::Value::GetUint>(out);
+        }
+
+        bool number(int32& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<int, &rapidjson::Value::IsInt, &rapidjson::Value::GetInt>(out);
+        }
+
+        bool number(uint32& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<unsigned int, &rapidjson::Value::IsUint, &rapidjson::Value::GetUint>(out);
+        }
+
+        bool number(int64& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<int64_t, &rapidjson::Value::IsInt64, &rapidjson::Value::GetInt64>(out);
+        }
+
+        bool number(uint64& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<uint64_t, &rapidjson::Value::IsUint64, &rapidjson::Value::GetUint64>(out);
+        }
+
+        bool number(float& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<double, &rapidjson::Value::IsDouble, &rapidjson::Value::GetDouble>(out);
+        }
+
+        bool number(double& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->number(out);
+            }
+
+            return impl_value<double, &rapidjson::Value::IsDouble, &rapidjson::Value::GetDouble>(out);
+        }
+
+        bool is_string() const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->is_string();
+            }
+
+            return is_value() && _token_value.IsString();
+        }
+
+        bool string_size(std::size_t& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->string_size(out);
+            }
+
+            if (!is_string())
+            {
+                return false;
+            }
+
+            out = _token_string.size();
+            return true;
+        }
+
+        std::size_t string(char* out, std::size_t len) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->string(out, len);
+            }
+
+            if (!is_string())
+            {
+                return 0;
+            }
+
+            // Copy the string
+            const std::size_t copy_length = std::min(len, _token_string.size());
+            std::memcpy(out, _token_string.data(), copy_length);
+            return copy_length;
+        }
+
+        bool is_array() const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->is_array();
+            }
+
+            const auto& node = _nodes.back();
+            return node.state == NodeState::UNREAD ? _token_type == TokenType::START_ARRAY : !node.is_object;
+        }
+
+        bool array_size(std::size_t& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->array_size(out);
+            }
+
+            // Not known until the whole array has been read
+            return false;
+        }
+
+        std::size_t typed_array(bool* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<bool, &rapidjson::Value::IsBool, &rapidjson::Value::GetBool>(out, size);
+        }
+
+        std::size_t typed_array(int8* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<int, &rapidjson::Value::IsInt, &rapidjson::Value::GetInt>(out, size);
+        }
+
+        std::size_t typed_array(uint8* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<unsigned int, &rapidjson::Value::IsUint, &rapidjson::Value::GetUint>(out, size);
+        }
+
+        std::size_t typed_array(int16* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<int, &rapidjson::Value::IsInt, &rapidjson::Value::GetInt>(out, size);
+        }
+
+        std::size_t typed_array(uint16* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<unsigned int, &rapidjson::Value::IsUint, &rapidjson::Value::GetUint>(out, size);
+        }
+
+        std::size_t typed_array(int32* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<int, &rapidjson::Value::IsInt, &rapidjson::Value::GetInt>(out, size);
+        }
+
+        std::size_t typed_array(uint32* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<unsigned int, &rapidjson::Value::IsUint, &rapidjson::Value::GetUint>(out, size);
+        }
+
+        std::size_t typed_array(int64* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<int64_t, &rapidjson::Value::IsInt64, &rapidjson::Value::GetInt64>(out, size);
+        }
+
+        std::size_t typed_array(uint64* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<uint64_t, &rapidjson::Value::IsUint64, &rapidjson::Value::GetUint64>(out, size);
+        }
+
+        std::size_t typed_array(float* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<double, &rapidjson::Value::IsDouble, &rapidjson::Value::GetDouble>(out, size);
+        }
+
+        std::size_t typed_array(double* out, std::size_t size) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->typed_array(out, size);
+            }
+
+            return impl_typed_array<double, &rapidjson::Value::IsDouble, &rapidjson::Value::GetDouble>(out, size);
+        }
+
+        bool is_object() const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->is_object();
+            }
+
+            const auto& node = _nodes.back();
+            return node.state == NodeState::UNREAD ? _token_type == TokenType::START_OBJECT : node.is_object;
+        }
+
+        bool object_size(std::size_t& out) const override
+        {
+            if (_skipped_reader)
+            {
+                return _skipped_reader->object_size(out);
+            }
+
+            // Not known until the whole object has been read
+            return false;
+        }
+
+        void enumerate_object_members(FunctionView<void(const char* name)> enumerator) override
+        {
+            if (_skipped_reader)
+            {
+                _skipped_reader->enumerate_object_members(enumerator);
+                return;
+            }
+
+            if (!enter(true))
+            {
+                return;
+            }
+
+            // Members that were read past while pulling others come first
+            const auto index = _nodes.size() - 1;
+            if (_nodes[index].skipped_members)
+            {
+                auto& skipped = *_nodes[index].skipped_members;
+                for (auto iter = skipped.MemberBegin(); iter != skipped.MemberEnd(); ++iter)
+                {
+                    _skipped_reader = new JsonArchiveReader{ iter->value };
+                    _skipped_depth = 0;
+                    enumerator(iter->name.GetString());
+                    pop();
+                }
+            }
+
+            // Read the rest of the object
+            std::string name;
+            while (_nodes[index].state == NodeState::ENTERED && _token_type == TokenType::KEY)
+            {
+                name = _token_string;
+                advance();
+
+                _nodes.emplace_back();
+                enumerator(name.c_str());
+                finish_head();
+                _nodes.pop_back();
+            }
+
+            finish_head();
+        }
+
+        bool pull_object_member(const char* name) override
+        {
+            if (_skipped_reader)
+            {
+                if (!_skipped_reader->pull_object_member(name))
+                {
+                    return false;
+                }
+
+                _skipped_depth += 1;
+                return true;
+            }
+
+            if (!enter(true))
+            {
+                return false;
+            }
+
+            // See if it's been read past already
+            auto& node = _nodes.back();
+            if (node.skipped_members)
+            {
+                const auto iter = node.skipped_members->FindMember(name);
+                if (iter != node.skipped_members->MemberEnd())
+                {
+                    _skipped_reader = new JsonArchiveReader{ iter->value };
+                    _skipped_depth = 0;
+                    return true;
+                }
+            }
+
+            // Search the rest of the object
+            while (node.state == NodeState::ENTERED && _token_type == TokenType::KEY)
+            {
+                if (_token_string == name)
+                {
+                    advance();
+                    _nodes.emplace_back();
+                    return true;
+                }
+
+                // Keep this member, in case it's pulled later
+                if (!node.skipped_members)
+                {
+                    node.skipped_members = std::make_unique<rapidjson::Document>();
+                    node.skipped_members->SetObject();
+                }
+
+                auto& allocator = node.skipped_members->GetAllocator();
+                rapidjson::Value member_name{ _token_string.c_str(), static_cast<rapidjson::SizeType>(_token_string.size()), allocator };
+                advance();
+
+                rapidjson::Value member_value;
+                read_value(member_value, allocator);
+                node.skipped_members->AddMember(member_name, member_value, allocator);
+            }
+
+            finish_head();
+            return false;
+        }
+
+        void enumerate_array_elements(FunctionView<void(std::size_t i)> enumerator) override
+        {
+            if (_skipped_reader)
+            {
+                _skipped_reader->enumerate_array_elements(enumerator);
+                return;
+            }
+
+            if (!enter(false))
+            {
+                return;
+            }
+
+            const auto index = _nodes.size() - 1;
+            while (_nodes[index].state == NodeState::ENTERED && is_element())
+            {
+                const auto i = _nodes[index].next_index;
+                _nodes[index].next_index += 1;
+
+                _nodes.emplace_back();
+                enumerator(i);
+                finish_head();
+                _nodes.pop_back();
+            }
+
+            finish_head();
+        }
+
+        bool pull_array_element(std::size_t i) override
+        {
+            if (_skipped_reader)
+            {
+                if (!_skipped_reader->pull_array_element(i))
+                {
+                    return false;
+                }
+
+                _skipped_depth += 1;
+                return true;
+            }
+
+            // Elements can't be read out of order
+            if (!enter(false) || i < _nodes.back().next_index)
+            {
+                return false;
+            }
+
+            auto& node = _nodes.back();
+            while (node.state == NodeState::ENTERED && is_element())
+            {
+                node.next_index += 1;
+                if (node.next_index == i + 1)
+                {
+                    _nodes.emplace_back();
+                    return true;
+                }
+
+                skip_value();
+            }
+
+            finish_head();
+            return false;
+        }
+
+    private:
+
+        void advance() const
+        {
+            _token_type = TokenType::NONE;
+            if (!_parser.IterativeParseComplete())
+            {
+                _parser.IterativeParseNext<rapidjson::kParseDefaultFlags>(_source->stream, _handler);
+            }
+        }
+
+        bool is_value() const
+        {
+            return _nodes.back().state == NodeState::UNREAD && _token_type == TokenType::VALUE;
+        }
+
+        bool is_element() const
+        {
+            return _token_type != TokenType::END_ARRAY && _token_type != TokenType::NONE;
+        }
+
+        /**
+         * \brief Opens the head node as an object or array, if it hasn't been already. Returns whether the head node is that kind of node.
+         */
+        bool enter(bool object) const
+        {
+            auto& node = _nodes.back();
+            if (node.state != NodeState::UNREAD)
+            {
+                return node.is_object == object;
+            }
+
+            if (_token_type != (object ? TokenType::START_OBJECT : TokenType::START_ARRAY))
+            {
+                return false;
+            }
+
+            node.state = NodeState::ENTERED;
+            node.is_object = object;
+            advance();
+            return true;
+        }
+
+        /**
+         * \brief Reads past whatever's left of the head node.
+         */
+        void finish_head() const
+        {
+            auto& node = _nodes.back();
+            if (node.state == NodeState::UNREAD)
+            {
+                skip_value();
+            }
+            else if (node.state == NodeState::ENTERED)
+            {
+                const auto end = node.is_object ? TokenType::END_OBJECT : TokenType::END_ARRAY;
+                while (_token_type != end && _token_type != TokenType::NONE)
+                {
+                    if (_token_type == TokenType::KEY)
+                    {
+                        advance();
+                    }
+                    skip_value();
+                }
+                advance();
+            }
+
+            node.state = NodeState::DONE;
+        }
+
+        /**
+         * \brief Reads past the value starting at the current token.
+         */
+        void skip_value() const
+        {
+            std::size_t depth = 0;
+            do
+            {
+                if (_token_type == TokenType::START_OBJECT || _token_type == TokenType::START_ARRAY)
+                {
+                    depth += 1;
+                }
+                else if (_token_type == TokenType::END_OBJECT || _token_type == TokenType::END_ARRAY)
+                {
+                    depth -= 1;
+                }
+                else if (_token_type == TokenType::NONE)
+                {
+                    return;
+                }
+
+                advance();
+            } while (depth != 0);
+        }
+
+        /**
+         * \brief Reads the value starting at the current token into a document value.
+         */
+        void read_value(rapidjson::Value& out, rapidjson::Document::AllocatorType& allocator) const
+        {
+            switch (_token_type)
+            {
+            case TokenType::VALUE:
+                if (_token_value.IsString())
+                {
+                    out.SetString(_token_string.c_str(), static_cast<rapidjson::SizeType>(_token_string.size()), allocator);
+                }
+                else
+                {
+                    out.CopyFrom(_token_value, allocator);
+                }
+                advance();
+                return;
+
+            case TokenType::START_OBJECT:
+                out.SetObject();
+                advance();
+                while (_token_type == TokenType::KEY)
+                {
+                    rapidjson::Value name{ _token_string.c_str(), static_cast<rapidjson::SizeType>(_token_string.size()), allocator };
+                    advance();
+
+                    rapidjson::Value value;
+                    read_value(value, allocator);
+                    out.AddMember(name, value, allocator);
+                }
+                advance();
+                return;
+
+            case TokenType::START_ARRAY:
+                out.SetArray();
+                advance();
+                while (is_element())
+                {
+                    rapidjson::Value value;
+                    read_value(value, allocator);
+                    out.PushBack(value, allocator);
+                }
+                advance();
+                return;
+
+            default:
+                out.SetNull();
+                return;
+            }
+        }
+
+        template <typename RetT, bool(rapidjson::Value::*CheckerFn)() const, RetT(rapidjson::Value::*GetterFn)() const, typename T>
+        bool impl_value(T& out) const
+        {
+            if (!is_value() || !(_token_value.*CheckerFn)())
+            {
+                return false;
+            }
+
+            out = static_cast<T>((_token_value.*GetterFn)());
+            return true;
+        }
+
+        template <typename RetT, bool(rapidjson::Value::*CheckerFn)() const, RetT(rapidjson::Value::*GetterFn)() const, typename T>
+        std::size_t impl_typed_array(T* const out, std::size_t const size) const
+        {
+            if (!enter(false))
+            {
+                return 0;
+            }
+
+            // Read elements from where the last read left off, stopping at the first element of a different type
+            auto& node = _nodes.back();
+            std::size_t index = 0;
+            while (node.state == NodeState::ENTERED && index < size && _token_type == TokenType::VALUE && (_token_value.*CheckerFn)())
+            {
+                out[index] = static_cast<T>((_token_value.*GetterFn)());
+                index += 1;
+                node.next_index += 1;
+                advance();
+            }
+
+            if (node.state == NodeState::ENTERED && _token_type == TokenType::END_ARRAY)
+            {
+                finish_head();
+            }
+
+            return index;
+        }
+
+        //////////////////
+        ///   Fields   ///
+    private:
+
+        std::unique_ptr<SourceT> _source;
+
+        /* Reading is logically const, but advances the parser. */
+        mutable rapidjson::Reader _parser;
+        mutable TokenHandler _handler;
+        mutable TokenType _token_type = TokenType::NONE;
+        mutable rapidjson::Value _token_value;
+        mutable std::string _token_string;
+        mutable std::vector<Node> _nodes;
+
+        /* A reader for the member being read, if it was read past and kept earlier. */
+        JsonArchiveReader* _skipped_reader = nullptr;
+        std::size_t _skipped_depth = 0;
+    };
+}
@@ -0,0 +1,353 @@
+// JsonStreamWriter.h
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <rapidjson/writer.h>
+#include <Core/IO/ArchiveWriter.h>
+
+namespace sge
+{
+    /**
+     * \brief Writes JSON straight to a rapidjson output stream as values are written, without building a document.
+     * 'TargetT' owns the output stream (as 'stream'), and finishes it when destroyed.
+     */
+    template <class TargetT>
+    class JsonStreamWriter final : public ArchiveWriter
+    {
+        enum class NodeState
+        {
+            /* Nothing has been written to this node yet. */
+            EMPTY,
+
+            /* A value has been written to this node. */
+            VALUE,
+
+            /* This node is an object, and members may be pushed onto it. */
+            OBJECT,
+
+            /* This node is an array, and elements may be pushed onto it. */
+            ARRAY,
+
+            /* This node can't be written, because its parent already holds a different kind of value. */
+            DISCARDED,
+        };
+
+        ////////////////////////
+        ///   Constructors   ///
+    public:
+
+        JsonStreamWriter(std::unique_ptr<TargetT> target)
+            : _target(std::move(target)),
+            _writer(_target->stream)
+        {
+            _nodes.push_back(NodeState::EMPTY);
+        }
+
+        ///////////////////
+        ///   Methods   ///
+    public:
+
+        void pop() override
+        {
+            // Close the head node
+            switch (_nodes.back())
+            {
+            case NodeState::EMPTY:
+                _writer.Null();
+                break;
+
+            case NodeState::OBJECT:
+                _writer.EndObject();
+                break;
+
+            case NodeState::ARRAY:
+                _writer.EndArray();
+                break;
+
+            default:
+                break;
+            }
+
+            // If we've reached the end of this stack
+            _nodes.pop_back();
+            if (_nodes.empty())
+            {
+                delete this;
+            }
+        }
+
+        void null() override
+        {
+            if (begin_value())
+            {
+                _writer.Null();
+            }
+        }
+
+        void boolean(bool value) override
+        {
+            if (begin_value())
+            {
+                write_element(value);
+            }
+        }
+
+        void number(int8 value) override
+        {
+            impl_number(value);
+        }
+
+        void number(uint8 value) override
+        {
+            impl_number(value);
+        }
+
+        void number(int16 value) override
+        {
+            impl_number(value);
+        }
+
+        void number(uint16 value) override
+        {
+            impl_number(value);
+        }
+
+        void number(int32 value) override
+        {
+            impl_number(value);
+        }
+
+        void number(uint32 value) override
+        {
+            impl_number(value);
+        }
+
+        void number(int64 value) override
+        {
+            impl_number(value);
+        }
+
+        void number(uint64 value) override
+        {
+            impl_number(value);
+        }
+
+        void number(float value) override
+        {
+            impl_number(value);
+        }
+
+        void number(double value) override
+        {
+            impl_number(value);
+        }
+
+        void string(const char* str, std::size_t len) override
+        {
+            if (begin_value())
+            {
+                _writer.String(str, static_cast<rapidjson::SizeType>(len));
+            }
+        }
+
+        void typed_array(const bool* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const int8* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const uint8* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const int16* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const uint16* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const int32* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const uint32* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const int64* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const uint64* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const float* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void typed_array(const double* array, std::size_t size) override
+        {
+            impl_typed_array(array, size);
+        }
+
+        void as_object() override
+        {
+            if (_nodes.back() == NodeState::EMPTY)
+            {
+                _writer.StartObject();
+                _nodes.back() = NodeState::OBJECT;
+            }
+        }
+
+        void push_object_member(const char* name) override
+        {
+            // Set this node as an object, if it isn't already
+            as_object();
+            if (_nodes.back() != NodeState::OBJECT)
+            {
+                _nodes.push_back(NodeState::DISCARDED);
+                return;
+            }
+
+            _writer.Key(name);
+            _nodes.push_back(NodeState::EMPTY);
+        }
+
+        void push_array_element() override
+        {
+            // Set this node as an array, if it isn't already
+            if (_nodes.back() == NodeState::EMPTY)
+            {
+                _writer.StartArray();
+                _nodes.back() = NodeState::ARRAY;
+            }
+            if (_nodes.back() != NodeState::ARRAY)
+            {
+                _nodes.push_back(NodeState::DISCARDED);
+                return;
+            }
+
+            _nodes.push_back(NodeState::EMPTY);
+        }
+
+    private:
+
+        /**
+         * \brief Returns whether a value may be written to the head node (values can't be replaced once they're written), and marks it as written.
+         */
+        bool begin_value()
+        {
+            if (_nodes.back() != NodeState::EMPTY)
+            {
+                return false;
+            }
+
+            _nodes.back() = NodeState::VALUE;
+            return true;
+        }
+
+        template <typename T>
+        void impl_number(T value)
+        {
+            if (begin_value())
+            {
+                write_element(value);
+            }
+        }
+
+        template <typename T>
+        void impl_typed_array(const T* array, std::size_t size)
+        {
+            if (!begin_value())
+            {
+                return;
+            }
+
+            _writer.StartArray();
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                write_element(array[i]);
+            }
+            _writer.EndArray(static_cast<rapidjson::SizeType>(size));
+        }
+
+        void write_element(bool value)
+        {
+            _writer.Bool(value);
+        }
+
+        void write_element(int8 value)
+        {
+            _writer.Int(value);
+        }
+
+        void write_element(uint8 value)
+        {
+            _writer.Uint(value);
+        }
+
+        void write_element(int16 value)
+        {
+            _writer.Int(value);
+        }
+
+        void write_element(uint16 value)
+        {
+            _writer.Uint(value);
+        }
+
+        void write_element(int32 value)
+        {
+            _writer.Int(value);
+        }
+
+        void write_element(uint32 value)
+        {
+            _writer.Uint(value);
+        }
+
+        void write_element(int64 value)
+        {
+            _writer.Int64(value);
+        }
+
+        void write_element(uint64 value)
+        {
+            _writer.Uint64(value);
+        }
+
+        void write_element(float value)
+        {
+            _writer.Double(value);
+        }
+
+        void write_element(double value)
+        {
+            _writer.Double(value);
+        }
+
+        //////////////////
+        ///   Fields   ///
+    private:
+
+        std::unique_ptr<TargetT> _target;
+        rapidjson::Writer<decltype(TargetT::stream)> _writer;
+        std::vector<NodeState> _nodes;
+    };
+}
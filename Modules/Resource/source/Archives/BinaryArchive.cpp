@@ -1,25 +1,252 @@
 // BinaryArchive.cpp
 
 #include <sys/stat.h>
+#include <Core/env.h>
+#if defined SGE_OS_WINDOWS
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
 #include <Core/Util/StringUtils.h>
 #include <Core/Reflection/ReflectionBuilder.h>
 #include "../../include/Resource/Archives/BinaryArchive.h"
 #include "../../include/Resource/Interfaces/IFromFile.h"
 #include "../../private/BinaryArchiveReader.h"
 #include "../../private/BinaryArchiveWriter.h"
+#include "../../private/BinaryArchiveEncoder.h"
 
 SGE_REFLECT_TYPE(sge::BinaryArchive)
 .implements<IFromFile>();
 
 namespace sge
 {
+    template <typename T>
+    static void copy_value(BinaryArchiveReader& reader, ArchiveWriter& writer)
+    {
+        T value = 0;
+        reader.number(value);
+        writer.number(value);
+    }
+
+    template <typename T>
+    static void copy_typed_array(BinaryArchiveReader& reader, ArchiveWriter& writer)
+    {
+        std::size_t size = 0;
+        reader.array_size(size);
+        std::unique_ptr<T[]> values{ new T[size] };
+        reader.typed_array(values.get(), size);
+        writer.typed_array(values.get(), size);
+    }
+
+    /**
+     * \brief Copies the node at the reader's current node to the writer's current node.
+     * Empty generic arrays can't be expressed through 'ArchiveWriter', so they become null.
+     */
+    static void copy_node(BinaryArchiveReader& reader, ArchiveWriter& writer)
+    {
+        switch (reader.cursor.node_type)
+        {
+        case BAN_NULL:
+            writer.null();
+            break;
+
+        case BAN_BOOLEAN:
+        {
+            bool value = false;
+            reader.boolean(value);
+            writer.boolean(value);
+            break;
+        }
+
+        case BAN_INT8:
+            copy_value<int8>(reader, writer);
+            break;
+
+        case BAN_UINT8:
+            copy_value<uint8>(reader, writer);
+            break;
+
+        case BAN_INT16:
+            copy_value<int16>(reader, writer);
+            break;
+
+        case BAN_UINT16:
+            copy_value<uint16>(reader, writer);
+            break;
+
+        case BAN_INT32:
+            copy_value<int32>(reader, writer);
+            break;
+
+        case BAN_UINT32:
+            copy_value<uint32>(reader, writer);
+            break;
+
+        case BAN_INT64:
+            copy_value<int64>(reader, writer);
+            break;
+
+        case BAN_UINT64:
+            copy_value<uint64>(reader, writer);
+            break;
+
+        case BAN_FLOAT:
+            copy_value<float>(reader, writer);
+            break;
+
+        case BAN_DOUBLE:
+            copy_value<double>(reader, writer);
+            break;
+
+        case BAN_STRING:
+        {
+            std::size_t len = 0;
+            reader.string_size(len);
+            std::string value(len, '\0');
+            reader.string(&value[0], len);
+            writer.string(value.c_str(), len);
+            break;
+        }
+
+        case BAN_ARRAY_BOOLEAN:
+            copy_typed_array<bool>(reader, writer);
+            break;
+
+        case BAN_ARRAY_INT8:
+            copy_typed_array<int8>(reader, writer);
+            break;
+
+        case BAN_ARRAY_UINT8:
+            copy_typed_array<uint8>(reader, writer);
+            break;
+
+        case BAN_ARRAY_INT16:
+            copy_typed_array<int16>(reader, writer);
+            break;
+
+        case BAN_ARRAY_UINT16:
+            copy_typed_array<uint16>(reader, writer);
+            break;
+
+        case BAN_ARRAY_INT32:
+            copy_typed_array<int32>(reader, writer);
+            break;
+
+        case BAN_ARRAY_UINT32:
+            copy_typed_array<uint32>(reader, writer);
+            break;
+
+        case BAN_ARRAY_INT64:
+            copy_typed_array<int64>(reader, writer);
+            break;
+
+        case BAN_ARRAY_UINT64:
+            copy_typed_array<uint64>(reader, writer);
+            break;
+
+        case BAN_ARRAY_FLOAT:
+            copy_typed_array<float>(reader, writer);
+            break;
+
+        case BAN_ARRAY_DOUBLE:
+            copy_typed_array<double>(reader, writer);
+            break;
+
+        case BAN_ARRAY_GENERIC:
+            reader.enumerate_array_elements([&reader, &writer](std::size_t /*i*/)
+            {
+                writer.push_array_element();
+                copy_node(reader, writer);
+                writer.pop();
+            });
+            break;
+
+        case BAN_OBJECT:
+        case BAN_INDEXED_OBJECT:
+            writer.as_object();
+            reader.enumerate_object_members([&reader, &writer](const char* name)
+            {
+                writer.push_object_member(name);
+                copy_node(reader, writer);
+                writer.pop();
+            });
+            break;
+
+        default:
+            assert(false);
+        }
+    }
+
+    BinaryArchive::BinaryArchive(const BinaryArchive& copy)
+        : _buffer(copy.data(), copy.data() + copy.size()),
+        _file_version(copy._file_version),
+        _file_compression(copy._file_compression),
+        _task_pool(copy._task_pool)
+    {
+    }
+
+    BinaryArchive::BinaryArchive(BinaryArchive&& move)
+        : _buffer(std::move(move._buffer)),
+        _mapped_data(move._mapped_data),
+        _mapped_size(move._mapped_size),
+        _file_version(move._file_version),
+        _file_compression(move._file_compression),
+        _task_pool(move._task_pool)
+    {
+        move._mapped_data = nullptr;
+        move._mapped_size = 0;
+    }
+
+    BinaryArchive::~BinaryArchive()
+    {
+        unmap();
+    }
+
+    BinaryArchive& BinaryArchive::operator=(const BinaryArchive& copy)
+    {
+        if (this != &copy)
+        {
+            std::vector<byte> buffer(copy.data(), copy.data() + copy.size());
+            unmap();
+            _buffer = std::move(buffer);
+            _file_version = copy._file_version;
+            _file_compression = copy._file_compression;
+            _task_pool = copy._task_pool;
+        }
+
+        return *this;
+    }
+
+    BinaryArchive& BinaryArchive::operator=(BinaryArchive&& move)
+    {
+        if (this != &move)
+        {
+            unmap();
+            _buffer = std::move(move._buffer);
+            _mapped_data = move._mapped_data;
+            _mapped_size = move._mapped_size;
+            _file_version = move._file_version;
+            _file_compression = move._file_compression;
+            _task_pool = move._task_pool;
+            move._mapped_data = nullptr;
+            move._mapped_size = 0;
+        }
+
+        return *this;
+    }
+
     ArchiveReader* BinaryArchive::read_root() const
     {
-        return new BinaryArchiveReader(_buffer);
+        return new BinaryArchiveReader(data(), size(), _task_pool);
     }
 
     ArchiveWriter* BinaryArchive::write_root()
     {
+        unmap();
         _buffer.clear();
         return new BinaryArchiveWriter(_buffer);
     }
@@ -33,8 +260,17 @@ namespace sge
             return false;
         }
 
-        // Write the contents to the file
-        fwrite(_buffer.data(), 1, _buffer.size(), file);
+        // Write the contents to the file, encoding (or compressing) them first if need be
+        if (version() == _file_version && !_file_compression)
+        {
+            fwrite(data(), 1, size(), file);
+        }
+        else
+        {
+            std::vector<byte> encoded;
+            encode(_file_version, encoded, _file_compression);
+            fwrite(encoded.data(), 1, encoded.size(), file);
+        }
 
         // Close it
         return fclose(file) == 0;
@@ -49,6 +285,7 @@ namespace sge
         }
 
         // Clear the buffer
+        unmap();
         _buffer.clear();
 
         // Get the size of the file
@@ -73,4 +310,173 @@ namespace sge
         fclose(file);
         return true;
     }
+
+    bool BinaryArchive::map_file(const char* path, MapAccess access)
+    {
+        // Make sure the file has the correct extension
+        if (!string_ends_with(path, ".sbin"))
+        {
+            return false;
+        }
+
+        // Release whatever was loaded before
+        unmap();
+        _buffer.clear();
+
+#if defined SGE_OS_WINDOWS
+        // Open the file
+        const DWORD flags = access == MapAccess::SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+        const HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        // Get the size of the file (empty files can't be mapped)
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        // Map the whole file. The view keeps the file and mapping object alive, so their handles can be closed right away.
+        const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+        {
+            return false;
+        }
+
+        const void* const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view)
+        {
+            return false;
+        }
+
+        _mapped_data = static_cast<const byte*>(view);
+        _mapped_size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+        // Open the file
+        const int file = open(path, O_RDONLY);
+        if (file < 0)
+        {
+            return false;
+        }
+
+        // Get the size of the file (empty files can't be mapped)
+        struct stat file_stats;
+        if (fstat(file, &file_stats) < 0 || file_stats.st_size == 0)
+        {
+            close(file);
+            return false;
+        }
+
+        // Map the whole file. The mapping keeps the file alive, so it can be closed right away.
+        void* const view = mmap(nullptr, static_cast<std::size_t>(file_stats.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (view == MAP_FAILED)
+        {
+            return false;
+        }
+
+        // Tell the kernel how the archive will be read. Sequential reads also start reading ahead now, rather than on the first fault.
+        if (access == MapAccess::SEQUENTIAL)
+        {
+            madvise(view, static_cast<std::size_t>(file_stats.st_size), MADV_SEQUENTIAL);
+            madvise(view, static_cast<std::size_t>(file_stats.st_size), MADV_WILLNEED);
+        }
+        else
+        {
+            madvise(view, static_cast<std::size_t>(file_stats.st_size), MADV_RANDOM);
+        }
+
+        _mapped_data = static_cast<const byte*>(view);
+        _mapped_size = static_cast<std::size_t>(file_stats.st_size);
+#endif
+
+        return true;
+    }
+
+    BinaryArchive::Version BinaryArchive::version() const
+    {
+        if (size() >= sizeof(BAN_V2_MAGIC) && std::memcmp(data(), BAN_V2_MAGIC, sizeof(BAN_V2_MAGIC)) == 0)
+        {
+            return Version::V2;
+        }
+
+        return Version::V1;
+    }
+
+    void BinaryArchive::set_file_version(Version version)
+    {
+        _file_version = version;
+    }
+
+    void BinaryArchive::set_file_compression(bool compress)
+    {
+        _file_compression = compress;
+    }
+
+    void BinaryArchive::set_task_pool(TaskPool* pool)
+    {
+        _task_pool = pool;
+    }
+
+    void BinaryArchive::encode(Version version, std::vector<byte>& out, bool compress) const
+    {
+        out.clear();
+        if (this->version() == version && !(compress && version == Version::V2))
+        {
+            out.assign(data(), data() + size());
+            return;
+        }
+
+        // The reader is only used for its root node, so it's never popped (which would delete it)
+        BinaryArchiveReader reader{ data(), size(), _task_pool };
+        if (version == Version::V2)
+        {
+            BinaryArchiveEncoder encoder{ out, compress };
+            encoder.encode(reader);
+        }
+        else
+        {
+            auto* writer = new BinaryArchiveWriter(out);
+            copy_node(reader, *writer);
+            writer->pop();
+        }
+    }
+
+    bool BinaryArchive::is_mapped() const
+    {
+        return _mapped_data != nullptr;
+    }
+
+    const byte* BinaryArchive::data() const
+    {
+        return _mapped_data ? _mapped_data : _buffer.data();
+    }
+
+    std::size_t BinaryArchive::size() const
+    {
+        return _mapped_data ? _mapped_size : _buffer.size();
+    }
+
+    void BinaryArchive::unmap()
+    {
+        if (!_mapped_data)
+        {
+            return;
+        }
+
+#if defined SGE_OS_WINDOWS
+        UnmapViewOfFile(_mapped_data);
+#else
+        munmap(const_cast<byte*>(_mapped_data), _mapped_size);
+#endif
+
+        _mapped_data = nullptr;
+        _mapped_size = 0;
+    }
 }
@@ -11,6 +11,8 @@
 #include "../../include/Resource/Archives/JsonArchive.h"
 #include "../../private/JsonArchiveWriter.h"
 #include "../../private/JsonArchiveReader.h"
+#include "../../private/JsonStreamWriter.h"
+#include "../../private/JsonStreamReader.h"
 
 SGE_REFLECT_TYPE(sge::JsonArchive)
 .implements<IToString>()
@@ -23,6 +25,66 @@ namespace sge
         rapidjson::Document doc;
     };
 
+    struct JsonFileTarget
+    {
+        JsonFileTarget(std::FILE* file)
+            : file(file),
+            stream(file, buffer, sizeof(buffer))
+        {
+        }
+        ~JsonFileTarget()
+        {
+            stream.Flush();
+            std::fclose(file);
+        }
+
+        std::FILE* file;
+        char buffer[65536];
+        rapidjson::FileWriteStream stream;
+    };
+
+    struct JsonStringTarget
+    {
+        JsonStringTarget(std::string& out)
+            : out(&out)
+        {
+        }
+        ~JsonStringTarget()
+        {
+            out->assign(stream.GetString(), stream.GetSize());
+        }
+
+        std::string* out;
+        rapidjson::StringBuffer stream;
+    };
+
+    struct JsonFileSource
+    {
+        JsonFileSource(std::FILE* file)
+            : file(file),
+            stream(file, buffer, sizeof(buffer))
+        {
+        }
+        ~JsonFileSource()
+        {
+            std::fclose(file);
+        }
+
+        std::FILE* file;
+        char buffer[65536];
+        rapidjson::FileReadStream stream;
+    };
+
+    struct JsonStringSource
+    {
+        JsonStringSource(const char* str)
+            : stream(str)
+        {
+        }
+
+        rapidjson::StringStream stream;
+    };
+
     JsonArchive::JsonArchive()
     {
         _data = std::make_unique<JsonArchive::Data>();
@@ -96,4 +158,42 @@ namespace sge
     {
         _data->doc.Parse(str);
     }
+
+    ArchiveWriter* JsonArchive::stream_to_file(const char* path)
+    {
+        std::FILE* file = std::fopen(path, "wb");
+        if (!file)
+        {
+            return nullptr;
+        }
+
+        return new JsonStreamWriter<JsonFileTarget>{ std::make_unique<JsonFileTarget>(file) };
+    }
+
+    ArchiveWriter* JsonArchive::stream_to_string(std::string& out)
+    {
+        return new JsonStreamWriter<JsonStringTarget>{ std::make_unique<JsonStringTarget>(out) };
+    }
+
+    ArchiveReader* JsonArchive::stream_from_file(const char* path)
+    {
+        // Make sure the file has the correct extension
+        if (!string_ends_with(path, ".json"))
+        {
+            return nullptr;
+        }
+
+        std::FILE* file = std::fopen(path, "rb");
+        if (!file)
+        {
+            return nullptr;
+        }
+
+        return new JsonStreamReader<JsonFileSource>{ std::make_unique<JsonFileSource>(file) };
+    }
+
+    ArchiveReader* JsonArchive::stream_from_string(const char* str)
+    {
+        return new JsonStreamReader<JsonStringSource>{ std::make_unique<JsonStringSource>(str) };
+    }
 }
@@ -0,0 +1,1047 @@
+// MeshOps.cpp
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "../../include/Resource/Misc/MeshOps.h"
+
+namespace sge
+{
+    /* The size of the LRU cache modelled by the vertex cache optimizer's scoring function. */
+    static constexpr std::size_t FORSYTH_CACHE_SIZE = 32;
+
+    static constexpr std::size_t NO_TRIANGLE = ~std::size_t{ 0 };
+
+    static float forsyth_vertex_score(
+        std::size_t cache_pos,
+        uint32 num_live_tris)
+    {
+        // Vertices with no triangles left to emit shouldn't attract anything
+        if (num_live_tris == 0)
+        {
+            return -1.f;
+        }
+
+        float score = 0.f;
+        if (cache_pos < 3)
+        {
+            // The triangle that was just emitted, give these a fixed score so that strips aren't favoured
+            score = 0.75f;
+        }
+        else if (cache_pos < FORSYTH_CACHE_SIZE)
+        {
+            const float scaler = 1.f / (FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.f - (cache_pos - 3) * scaler, 1.5f);
+        }
+
+        // Prefer vertices with few triangles left, so that they don't get stranded
+        score += 2.f / std::sqrt(static_cast<float>(num_live_tris));
+        return score;
+    }
+
+    /**
+     * \brief Simulates drawing a triangle through a FIFO cache.
+     * \return The number of vertices that missed the cache.
+     */
+    static uint32 update_fifo_cache(
+        const uint32* tri,
+        std::size_t cache_size,
+        uint32* timestamps,
+        uint32& timestamp)
+    {
+        uint32 misses = 0;
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            const auto vert = tri[i];
+            if (timestamp - timestamps[vert] > cache_size)
+            {
+                timestamps[vert] = timestamp++;
+                misses += 1;
+            }
+        }
+
+        return misses;
+    }
+
+    static uint32 pack_snorm_10_10_10_2(
+        float x,
+        float y,
+        float z,
+        int32 w)
+    {
+        const auto pack_10 = [](float value) -> uint32
+        {
+            value = std::min(std::max(value, -1.f), 1.f);
+            return static_cast<uint32>(static_cast<int32>(std::round(value * 511.f))) & 0x3FF;
+        };
+
+        return pack_10(x) | (pack_10(y) << 10) | (pack_10(z) << 20) | ((static_cast<uint32>(w) & 0x3) << 30);
+    }
+
+    /* How strongly borders and seams are held in place, relative to surface error. */
+    static constexpr float SIMPLIFY_BORDER_WEIGHT = 10.f;
+
+    enum : byte
+    {
+        /* Interior vertex with a single set of attributes, may collapse in any direction. */
+        SIMPLIFY_VERTEX_MANIFOLD,
+
+        /* Vertex on an open border, may only collapse along the border. */
+        SIMPLIFY_VERTEX_BORDER,
+
+        /* Vertex on an attribute seam (two wedges), may only collapse along the seam. */
+        SIMPLIFY_VERTEX_SEAM,
+
+        /* Vertex on a group border, a seam corner or non-manifold geometry, may not collapse. */
+        SIMPLIFY_VERTEX_LOCKED
+    };
+
+    struct PositionKey
+    {
+        uint32 bits[3];
+
+        static PositionKey from(const Vec3& pos)
+        {
+            PositionKey key;
+            std::memcpy(key.bits, pos.vec(), sizeof(key.bits));
+            return key;
+        }
+
+        friend bool operator==(const PositionKey& lhs, const PositionKey& rhs)
+        {
+            return lhs.bits[0] == rhs.bits[0] && lhs.bits[1] == rhs.bits[1] && lhs.bits[2] == rhs.bits[2];
+        }
+    };
+
+    struct PositionKeyHash
+    {
+        std::size_t operator()(const PositionKey& key) const
+        {
+            return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+        }
+    };
+
+    struct SimplifyEdge
+    {
+        uint32 num_tris = 0;
+
+        /* The vertices of the first triangle found on this edge. */
+        uint64 wedges = 0;
+        uint32 group = 0;
+
+        /* Whether triangles on either side of this edge use different vertices for it. */
+        bool seam = false;
+
+        /* Whether triangles on either side of this edge are in different groups. */
+        bool group_border = false;
+    };
+
+    struct SimplifyCollapse
+    {
+        uint32 vert;
+        uint32 target;
+        float error;
+    };
+
+    /**
+     * \brief Symmetric 4x4 matrix measuring the weighted squared distance to a set of planes.
+     */
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0, c = 0;
+        double weight = 0;
+
+        static Quadric from_plane(const Vec3& normal, float dist, float weight)
+        {
+            const double x = normal.x(), y = normal.y(), z = normal.z(), d = dist, w = weight;
+
+            Quadric result;
+            result.a00 = x * x * w;
+            result.a11 = y * y * w;
+            result.a22 = z * z * w;
+            result.a01 = x * y * w;
+            result.a02 = x * z * w;
+            result.a12 = y * z * w;
+            result.b0 = x * d * w;
+            result.b1 = y * d * w;
+            result.b2 = z * d * w;
+            result.c = d * d * w;
+            result.weight = w;
+            return result;
+        }
+
+        float error(const Vec3& pos) const
+        {
+            const double x = pos.x(), y = pos.y(), z = pos.z();
+            const double r =
+                a00 * x * x + a11 * y * y + a22 * z * z +
+                2 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                2 * (b0 * x + b1 * y + b2 * z) +
+                c;
+
+            return weight > 0 ? static_cast<float>(std::abs(r) / weight) : 0.f;
+        }
+
+        Quadric& operator+=(const Quadric& rhs)
+        {
+            a00 += rhs.a00; a11 += rhs.a11; a22 += rhs.a22;
+            a01 += rhs.a01; a02 += rhs.a02; a12 += rhs.a12;
+            b0 += rhs.b0; b1 += rhs.b1; b2 += rhs.b2;
+            c += rhs.c;
+            weight += rhs.weight;
+            return *this;
+        }
+    };
+
+    static uint64 edge_key(
+        uint32 a,
+        uint32 b)
+    {
+        return a < b ? (uint64{ a } << 32) | b : (uint64{ b } << 32) | a;
+    }
+
+    static std::size_t count_wedges(
+        const uint32* next_wedge,
+        uint32 vert)
+    {
+        std::size_t count = 0;
+        auto wedge = vert;
+        do
+        {
+            count += 1;
+            wedge = next_wedge[wedge];
+        } while (wedge != vert);
+
+        return count;
+    }
+
+    static bool can_collapse(
+        const byte* kinds,
+        const uint32* chain,
+        uint32 vert,
+        uint32 target)
+    {
+        switch (kinds[vert])
+        {
+        case SIMPLIFY_VERTEX_MANIFOLD:
+            return true;
+
+        case SIMPLIFY_VERTEX_BORDER:
+        case SIMPLIFY_VERTEX_SEAM:
+            return chain[vert * 2] == target || chain[vert * 2 + 1] == target;
+
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * \brief Moves the neighbours of a border or seam vertex along its border or seam, once it has collapsed into 'target'.
+     */
+    static void update_chain(
+        uint32* chain,
+        uint32 vert,
+        uint32 target)
+    {
+        const auto other = chain[vert * 2] == target ? chain[vert * 2 + 1] : chain[vert * 2];
+        if (other == ~uint32{ 0 })
+        {
+            return;
+        }
+
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            if (chain[target * 2 + i] == vert)
+            {
+                chain[target * 2 + i] = other;
+            }
+            if (chain[other * 2 + i] == vert)
+            {
+                chain[other * 2 + i] = target;
+            }
+        }
+    }
+
+    /**
+     * \brief Returns whether moving 'vert' onto 'target' would flip any of the given triangles.
+     */
+    static bool has_triangle_flip(
+        const uint32* indices,
+        const uint32* canonical,
+        const Vec3* positions,
+        const uint32* adj_begin,
+        const uint32* adj_end,
+        uint32 vert,
+        uint32 target)
+    {
+        for (auto* adj = adj_begin; adj != adj_end; ++adj)
+        {
+            const uint32 tri[3] = { canonical[indices[*adj * 3]], canonical[indices[*adj * 3 + 1]], canonical[indices[*adj * 3 + 2]] };
+            if (tri[0] == target || tri[1] == target || tri[2] == target)
+            {
+                // This triangle will become degenerate
+                continue;
+            }
+
+            Vec3 before[3];
+            Vec3 after[3];
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                before[i] = positions[tri[i]];
+                after[i] = tri[i] == vert ? positions[target] : before[i];
+            }
+
+            const auto normal_before = Vec3::cross(before[1] - before[0], before[2] - before[0]);
+            const auto normal_after = Vec3::cross(after[1] - after[0], after[2] - after[0]);
+            if (Vec3::dot(normal_before, normal_after) <= 0.f)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    float mesh_ops::compute_acmr(
+        const uint32* elements,
+        std::size_t num_elements,
+        std::size_t num_verts,
+        std::size_t cache_size)
+    {
+        const auto num_tris = num_elements / 3;
+        if (num_tris == 0)
+        {
+            return 0.f;
+        }
+
+        std::vector<uint32> timestamps(num_verts, 0);
+        uint32 timestamp = static_cast<uint32>(cache_size) + 1;
+        std::size_t misses = 0;
+        for (std::size_t i = 0; i < num_tris; ++i)
+        {
+            misses += update_fifo_cache(elements + i * 3, cache_size, timestamps.data(), timestamp);
+        }
+
+        return static_cast<float>(misses) / num_tris;
+    }
+
+    void mesh_ops::optimize_vertex_cache(
+        uint32* elements,
+        std::size_t num_elements,
+        std::size_t num_verts)
+    {
+        const auto num_tris = num_elements / 3;
+        if (num_tris == 0)
+        {
+            return;
+        }
+
+        // Build the list of triangles using each vertex
+        std::vector<uint32> num_live_tris(num_verts, 0);
+        for (std::size_t i = 0; i < num_tris * 3; ++i)
+        {
+            num_live_tris[elements[i]] += 1;
+        }
+
+        std::vector<uint32> adjacency_start(num_verts + 1, 0);
+        for (std::size_t i = 0; i < num_verts; ++i)
+        {
+            adjacency_start[i + 1] = adjacency_start[i] + num_live_tris[i];
+        }
+
+        std::vector<uint32> adjacency(num_tris * 3);
+        {
+            std::vector<uint32> adjacency_end(adjacency_start.begin(), adjacency_start.end() - 1);
+            for (std::size_t i = 0; i < num_tris * 3; ++i)
+            {
+                adjacency[adjacency_end[elements[i]]++] = static_cast<uint32>(i / 3);
+            }
+        }
+
+        // Compute initial scores
+        std::vector<float> vert_scores(num_verts);
+        for (std::size_t i = 0; i < num_verts; ++i)
+        {
+            vert_scores[i] = forsyth_vertex_score(FORSYTH_CACHE_SIZE, num_live_tris[i]);
+        }
+
+        std::vector<float> tri_scores(num_tris);
+        std::size_t best_tri = 0;
+        for (std::size_t i = 0; i < num_tris; ++i)
+        {
+            const auto* tri = elements + i * 3;
+            tri_scores[i] = vert_scores[tri[0]] + vert_scores[tri[1]] + vert_scores[tri[2]];
+            if (tri_scores[i] > tri_scores[best_tri])
+            {
+                best_tri = i;
+            }
+        }
+
+        std::vector<bool> emitted(num_tris, false);
+        std::vector<uint32> result;
+        result.reserve(num_tris * 3);
+
+        uint32 cache[FORSYTH_CACHE_SIZE + 3];
+        uint32 new_cache[FORSYTH_CACHE_SIZE + 3];
+        std::size_t cache_count = 0;
+        std::size_t input_cursor = 0;
+
+        for (std::size_t n = 0; n < num_tris; ++n)
+        {
+            // If nothing in the cache has triangles left, continue from the next triangle in input order
+            if (best_tri == NO_TRIANGLE)
+            {
+                while (emitted[input_cursor])
+                {
+                    input_cursor += 1;
+                }
+
+                best_tri = input_cursor;
+            }
+
+            // Emit the triangle
+            const auto* tri = elements + best_tri * 3;
+            emitted[best_tri] = true;
+            result.insert(result.end(), tri, tri + 3);
+
+            // Remove it from the adjacency of its vertices
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                const auto vert = tri[i];
+                auto* const adj_begin = adjacency.data() + adjacency_start[vert];
+                auto* const adj_end = adj_begin + num_live_tris[vert];
+                auto* const iter = std::find(adj_begin, adj_end, static_cast<uint32>(best_tri));
+                if (iter != adj_end)
+                {
+                    *iter = *(adj_end - 1);
+                    num_live_tris[vert] -= 1;
+                }
+            }
+
+            // Move the triangle's vertices to the front of the cache
+            std::size_t new_cache_count = 0;
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                if (std::find(new_cache, new_cache + new_cache_count, tri[i]) == new_cache + new_cache_count)
+                {
+                    new_cache[new_cache_count++] = tri[i];
+                }
+            }
+            for (std::size_t i = 0; i < cache_count; ++i)
+            {
+                if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+                {
+                    new_cache[new_cache_count++] = cache[i];
+                }
+            }
+
+            // Update the scores of every vertex that was touched (including those that fell out of the cache)
+            for (std::size_t i = 0; i < new_cache_count; ++i)
+            {
+                const auto vert = new_cache[i];
+                vert_scores[vert] = forsyth_vertex_score(i, num_live_tris[vert]);
+            }
+
+            // Rescore their triangles, and pick the best one
+            best_tri = NO_TRIANGLE;
+            float best_score = 0.f;
+            for (std::size_t i = 0; i < new_cache_count; ++i)
+            {
+                const auto vert = new_cache[i];
+                const auto* const adj_begin = adjacency.data() + adjacency_start[vert];
+                for (std::size_t j = 0; j < num_live_tris[vert]; ++j)
+                {
+                    const auto tri_index = adj_begin[j];
+                    const auto* adj_tri = elements + tri_index * 3;
+                    const auto score = vert_scores[adj_tri[0]] + vert_scores[adj_tri[1]] + vert_scores[adj_tri[2]];
+                    tri_scores[tri_index] = score;
+
+                    if (best_tri == NO_TRIANGLE || score > best_score)
+                    {
+                        best_tri = tri_index;
+                        best_score = score;
+                    }
+                }
+            }
+
+            cache_count = std::min(new_cache_count, FORSYTH_CACHE_SIZE);
+            std::copy(new_cache, new_cache + cache_count, cache);
+        }
+
+        std::copy(result.begin(), result.end(), elements);
+    }
+
+    void mesh_ops::optimize_overdraw(
+        uint32* elements,
+        std::size_t num_elements,
+        const Vec3* positions,
+        std::size_t num_verts,
+        float threshold)
+    {
+        const auto num_tris = num_elements / 3;
+        if (num_tris == 0)
+        {
+            return;
+        }
+
+        std::vector<uint32> timestamps(num_verts, 0);
+        uint32 timestamp = VERTEX_CACHE_SIZE + 1;
+        const auto flush_cache = [&timestamp]() { timestamp += VERTEX_CACHE_SIZE + 1; };
+
+        // Split the triangles wherever the cache effectively restarts (all three vertices miss), these are usually separate patches
+        std::vector<std::size_t> patches;
+        for (std::size_t i = 0; i < num_tris; ++i)
+        {
+            const auto misses = update_fifo_cache(elements + i * 3, VERTEX_CACHE_SIZE, timestamps.data(), timestamp);
+            if (i == 0 || misses == 3)
+            {
+                patches.push_back(i);
+            }
+        }
+
+        // Split patches further, as long as each piece stays within the threshold of the patch's ACMR
+        std::vector<std::size_t> clusters;
+        for (std::size_t p = 0; p < patches.size(); ++p)
+        {
+            const auto start = patches[p];
+            const auto end = p + 1 < patches.size() ? patches[p + 1] : num_tris;
+
+            flush_cache();
+            uint32 patch_misses = 0;
+            for (std::size_t i = start; i < end; ++i)
+            {
+                patch_misses += update_fifo_cache(elements + i * 3, VERTEX_CACHE_SIZE, timestamps.data(), timestamp);
+            }
+            const float patch_threshold = threshold * patch_misses / (end - start);
+
+            clusters.push_back(start);
+            flush_cache();
+            uint32 running_misses = 0;
+            uint32 running_tris = 0;
+            for (std::size_t i = start; i < end; ++i)
+            {
+                running_misses += update_fifo_cache(elements + i * 3, VERTEX_CACHE_SIZE, timestamps.data(), timestamp);
+                running_tris += 1;
+
+                if (static_cast<float>(running_misses) / running_tris <= patch_threshold)
+                {
+                    clusters.push_back(i + 1);
+                    flush_cache();
+                    running_misses = 0;
+                    running_tris = 0;
+                }
+            }
+
+            // The last split may have landed exactly on the end of the patch
+            if (clusters.back() == end)
+            {
+                clusters.pop_back();
+            }
+        }
+
+        // Compute the area-weighted centroid and normal of each cluster, and of the whole range
+        std::vector<Vec3> cluster_centroids(clusters.size(), Vec3::zero());
+        std::vector<Vec3> cluster_normals(clusters.size(), Vec3::zero());
+        Vec3 mesh_centroid = Vec3::zero();
+        float mesh_area = 0.f;
+        for (std::size_t c = 0; c < clusters.size(); ++c)
+        {
+            const auto start = clusters[c];
+            const auto end = c + 1 < clusters.size() ? clusters[c + 1] : num_tris;
+
+            float cluster_area = 0.f;
+            for (std::size_t i = start; i < end; ++i)
+            {
+                const auto& a = positions[elements[i * 3 + 0]];
+                const auto& b = positions[elements[i * 3 + 1]];
+                const auto& c_pos = positions[elements[i * 3 + 2]];
+                const auto normal = Vec3::cross(b - a, c_pos - a);
+                const auto area = normal.length();
+
+                cluster_centroids[c] += (a + b + c_pos) * (area / 3.f);
+                cluster_normals[c] += normal;
+                cluster_area += area;
+            }
+
+            mesh_centroid += cluster_centroids[c];
+            mesh_area += cluster_area;
+            cluster_centroids[c] = cluster_area > 0.f ? cluster_centroids[c] / cluster_area : Vec3::zero();
+        }
+        mesh_centroid = mesh_area > 0.f ? mesh_centroid / mesh_area : Vec3::zero();
+
+        // Draw clusters that face away from the center first, since they're the most likely to occlude the rest
+        std::vector<float> sort_keys(clusters.size());
+        std::vector<std::size_t> cluster_order(clusters.size());
+        for (std::size_t c = 0; c < clusters.size(); ++c)
+        {
+            sort_keys[c] = Vec3::dot(cluster_centroids[c] - mesh_centroid, cluster_normals[c].normalized());
+            cluster_order[c] = c;
+        }
+        std::stable_sort(cluster_order.begin(), cluster_order.end(), [&sort_keys](std::size_t lhs, std::size_t rhs)
+        {
+            return sort_keys[lhs] > sort_keys[rhs];
+        });
+
+        std::vector<uint32> result;
+        result.reserve(num_tris * 3);
+        for (const auto c : cluster_order)
+        {
+            const auto start = clusters[c];
+            const auto end = c + 1 < clusters.size() ? clusters[c + 1] : num_tris;
+            result.insert(result.end(), elements + start * 3, elements + end * 3);
+        }
+
+        std::copy(result.begin(), result.end(), elements);
+    }
+
+    std::size_t mesh_ops::simplify(
+        const uint32* elements,
+        std::size_t num_elements,
+        const uint32* groups,
+        const Vec3* positions,
+        std::size_t num_verts,
+        std::size_t target_num_elements,
+        float max_error,
+        uint32* out_elements,
+        uint32* out_groups,
+        float* out_error)
+    {
+        std::vector<uint32> indices(elements, elements + num_elements / 3 * 3);
+        std::vector<uint32> tri_groups(num_elements / 3, 0);
+        if (groups)
+        {
+            std::copy(groups, groups + tri_groups.size(), tri_groups.begin());
+        }
+
+        // Find vertices that share a position ("wedges"), and link them together
+        std::vector<uint32> canonical(num_verts);
+        std::vector<uint32> next_wedge(num_verts);
+        {
+            std::unordered_map<PositionKey, uint32, PositionKeyHash> first_at_position;
+            first_at_position.reserve(num_verts);
+            for (uint32 i = 0; i < num_verts; ++i)
+            {
+                const auto iter = first_at_position.insert(std::make_pair(PositionKey::from(positions[i]), i)).first;
+                const auto first = iter->second;
+                canonical[i] = first;
+                next_wedge[i] = i;
+                if (first != i)
+                {
+                    next_wedge[i] = next_wedge[first];
+                    next_wedge[first] = i;
+                }
+            }
+        }
+
+        // Classify edges between positions
+        std::unordered_map<uint64, SimplifyEdge> edges;
+        edges.reserve(indices.size());
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            const auto tri = i / 3;
+            const auto a = indices[i];
+            const auto b = indices[tri * 3 + (i + 1) % 3];
+            const auto ca = canonical[a];
+            const auto cb = canonical[b];
+            if (ca == cb)
+            {
+                continue;
+            }
+
+            auto& edge = edges[edge_key(ca, cb)];
+            if (edge.num_tris == 0)
+            {
+                edge.wedges = edge_key(a, b);
+                edge.group = tri_groups[tri];
+            }
+            else
+            {
+                edge.seam |= edge.wedges != edge_key(a, b);
+                edge.group_border |= edge.group != tri_groups[tri];
+            }
+            edge.num_tris += 1;
+        }
+
+        // Classify vertices from their edges
+        std::vector<byte> kinds(num_verts, SIMPLIFY_VERTEX_MANIFOLD);
+        std::vector<uint32> num_border_edges(num_verts, 0);
+        std::vector<uint32> num_seam_edges(num_verts, 0);
+        std::vector<uint32> chain(num_verts * 2, ~uint32{ 0 });
+        for (const auto& entry : edges)
+        {
+            const uint32 ends[2] = { static_cast<uint32>(entry.first >> 32), static_cast<uint32>(entry.first) };
+            const auto& edge = entry.second;
+            for (std::size_t e = 0; e < 2; ++e)
+            {
+                const auto vert = ends[e];
+                const auto other = ends[1 - e];
+                if (edge.num_tris > 2 || edge.group_border)
+                {
+                    kinds[vert] = SIMPLIFY_VERTEX_LOCKED;
+                    continue;
+                }
+
+                auto* count = edge.num_tris == 1 ? &num_border_edges[vert] : edge.seam ? &num_seam_edges[vert] : nullptr;
+                if (count)
+                {
+                    if (*count < 2)
+                    {
+                        chain[vert * 2 + *count] = other;
+                    }
+                    *count += 1;
+                }
+            }
+        }
+
+        for (uint32 i = 0; i < num_verts; ++i)
+        {
+            if (canonical[i] != i || kinds[i] == SIMPLIFY_VERTEX_LOCKED)
+            {
+                continue;
+            }
+
+            const auto num_wedges = count_wedges(next_wedge.data(), i);
+            if (num_wedges == 1 && num_border_edges[i] == 0)
+            {
+                kinds[i] = SIMPLIFY_VERTEX_MANIFOLD;
+            }
+            else if (num_wedges == 1 && num_border_edges[i] == 2)
+            {
+                kinds[i] = SIMPLIFY_VERTEX_BORDER;
+            }
+            else if (num_wedges == 2 && num_seam_edges[i] == 2 && num_border_edges[i] == 0)
+            {
+                kinds[i] = SIMPLIFY_VERTEX_SEAM;
+            }
+            else
+            {
+                kinds[i] = SIMPLIFY_VERTEX_LOCKED;
+            }
+        }
+
+        // Accumulate the error quadrics of each position from its triangles, and from planes perpendicular to borders and seams
+        std::vector<Quadric> quadrics(num_verts);
+        for (std::size_t tri = 0; tri < indices.size() / 3; ++tri)
+        {
+            const uint32 verts[3] = { canonical[indices[tri * 3]], canonical[indices[tri * 3 + 1]], canonical[indices[tri * 3 + 2]] };
+            const auto normal = Vec3::cross(positions[verts[1]] - positions[verts[0]], positions[verts[2]] - positions[verts[0]]);
+            const auto area = normal.length();
+            if (area == 0.f)
+            {
+                continue;
+            }
+
+            const auto unit_normal = normal / area;
+            const auto plane = Quadric::from_plane(unit_normal, -Vec3::dot(unit_normal, positions[verts[0]]), area);
+            for (std::size_t e = 0; e < 3; ++e)
+            {
+                quadrics[verts[e]] += plane;
+
+                const auto a = verts[e];
+                const auto b = verts[(e + 1) % 3];
+                const auto iter = edges.find(edge_key(a, b));
+                if (iter == edges.end() || (iter->second.num_tris != 1 && !iter->second.seam && !iter->second.group_border))
+                {
+                    continue;
+                }
+
+                const auto edge_dir = positions[b] - positions[a];
+                const auto length = edge_dir.length();
+                const auto edge_normal = Vec3::cross(edge_dir, unit_normal).normalized();
+                const auto edge_plane = Quadric::from_plane(edge_normal, -Vec3::dot(edge_normal, positions[a]), length * length * SIMPLIFY_BORDER_WEIGHT);
+                quadrics[a] += edge_plane;
+                quadrics[b] += edge_plane;
+            }
+        }
+
+        // Collapse edges in passes, in order of increasing error
+        const auto max_error_sq = max_error * max_error;
+        float result_error_sq = 0.f;
+        std::vector<uint32> wedge_remap(num_verts);
+        std::vector<bool> collapse_locked(num_verts);
+        std::vector<uint32> adjacency_start(num_verts + 1);
+        std::vector<uint32> adjacency;
+        std::vector<SimplifyCollapse> collapses;
+
+        while (indices.size() > target_num_elements)
+        {
+            const auto num_tris = indices.size() / 3;
+
+            // Build the triangles adjacent to each position
+            std::fill(adjacency_start.begin(), adjacency_start.end(), 0);
+            for (const auto index : indices)
+            {
+                adjacency_start[canonical[index] + 1] += 1;
+            }
+            for (std::size_t i = 0; i < num_verts; ++i)
+            {
+                adjacency_start[i + 1] += adjacency_start[i];
+            }
+            adjacency.resize(indices.size());
+            {
+                std::vector<uint32> adjacency_end(adjacency_start.begin(), adjacency_start.end() - 1);
+                for (std::size_t i = 0; i < indices.size(); ++i)
+                {
+                    adjacency[adjacency_end[canonical[indices[i]]]++] = static_cast<uint32>(i / 3);
+                }
+            }
+
+            // Find the cheapest valid direction to collapse each edge in
+            collapses.clear();
+            for (std::size_t i = 0; i < indices.size(); ++i)
+            {
+                const auto a = canonical[indices[i]];
+                const auto b = canonical[indices[i / 3 * 3 + (i + 1) % 3]];
+                if (a == b)
+                {
+                    continue;
+                }
+
+                SimplifyCollapse collapse;
+                collapse.error = -1.f;
+                if (can_collapse(kinds.data(), chain.data(), a, b))
+                {
+                    collapse.vert = a;
+                    collapse.target = b;
+                    collapse.error = quadrics[a].error(positions[b]);
+                }
+                if (can_collapse(kinds.data(), chain.data(), b, a))
+                {
+                    const auto error = quadrics[b].error(positions[a]);
+                    if (collapse.error < 0.f || error < collapse.error)
+                    {
+                        collapse.vert = b;
+                        collapse.target = a;
+                        collapse.error = error;
+                    }
+                }
+
+                if (collapse.error >= 0.f && collapse.error <= max_error_sq)
+                {
+                    collapses.push_back(collapse);
+                }
+            }
+
+            if (collapses.empty())
+            {
+                break;
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const SimplifyCollapse& lhs, const SimplifyCollapse& rhs)
+            {
+                return lhs.error < rhs.error;
+            });
+
+            // Perform as many collapses as possible without neighbourhoods overlapping, until the target is reached
+            for (uint32 i = 0; i < num_verts; ++i)
+            {
+                wedge_remap[i] = i;
+            }
+            std::fill(collapse_locked.begin(), collapse_locked.end(), false);
+
+            const auto tri_goal = (indices.size() - target_num_elements + 2) / 3;
+            std::size_t num_removed_tris = 0;
+            std::size_t num_collapses = 0;
+            for (const auto& collapse : collapses)
+            {
+                if (num_removed_tris >= tri_goal)
+                {
+                    break;
+                }
+
+                const auto vert = collapse.vert;
+                const auto target = collapse.target;
+                if (collapse_locked[vert] || collapse_locked[target])
+                {
+                    continue;
+                }
+
+                const auto* const adj_begin = adjacency.data() + adjacency_start[vert];
+                const auto* const adj_end = adjacency.data() + adjacency_start[vert + 1];
+                if (has_triangle_flip(indices.data(), canonical.data(), positions, adj_begin, adj_end, vert, target))
+                {
+                    continue;
+                }
+
+                // Each wedge moves to the wedge of the target on the same side of any seam
+                bool valid = true;
+                uint32 wedge = vert;
+                do
+                {
+                    uint32 wedge_target = ~uint32{ 0 };
+                    for (auto* adj = adj_begin; adj != adj_end && wedge_target == ~uint32{ 0 }; ++adj)
+                    {
+                        const auto* tri = indices.data() + *adj * 3;
+                        if (tri[0] != wedge && tri[1] != wedge && tri[2] != wedge)
+                        {
+                            continue;
+                        }
+
+                        for (std::size_t e = 0; e < 3; ++e)
+                        {
+                            if (canonical[tri[e]] == target)
+                            {
+                                wedge_target = tri[e];
+                            }
+                        }
+                    }
+
+                    if (wedge_target == ~uint32{ 0 })
+                    {
+                        valid = false;
+                        break;
+                    }
+
+                    wedge_remap[wedge] = wedge_target;
+                    wedge = next_wedge[wedge];
+                } while (wedge != vert);
+
+                if (!valid)
+                {
+                    wedge = vert;
+                    do
+                    {
+                        wedge_remap[wedge] = wedge;
+                        wedge = next_wedge[wedge];
+                    } while (wedge != vert);
+                    continue;
+                }
+
+                // Lock the neighbourhood, since its triangles are about to change
+                for (auto* adj = adj_begin; adj != adj_end; ++adj)
+                {
+                    const auto* tri = indices.data() + *adj * 3;
+                    collapse_locked[canonical[tri[0]]] = true;
+                    collapse_locked[canonical[tri[1]]] = true;
+                    collapse_locked[canonical[tri[2]]] = true;
+                }
+
+                // Fold the collapsed position into the target
+                quadrics[target] += quadrics[vert];
+                update_chain(chain.data(), vert, target);
+                result_error_sq = std::max(result_error_sq, collapse.error);
+                num_removed_tris += kinds[vert] == SIMPLIFY_VERTEX_BORDER ? 1 : 2;
+                num_collapses += 1;
+            }
+
+            if (num_collapses == 0)
+            {
+                break;
+            }
+
+            // Apply the collapses, and remove triangles that became degenerate
+            std::size_t write = 0;
+            for (std::size_t tri = 0; tri < num_tris; ++tri)
+            {
+                const auto a = wedge_remap[indices[tri * 3 + 0]];
+                const auto b = wedge_remap[indices[tri * 3 + 1]];
+                const auto c = wedge_remap[indices[tri * 3 + 2]];
+                if (canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[c] == canonical[a])
+                {
+                    continue;
+                }
+
+                indices[write * 3 + 0] = a;
+                indices[write * 3 + 1] = b;
+                indices[write * 3 + 2] = c;
+                tri_groups[write] = tri_groups[tri];
+                write += 1;
+            }
+            indices.resize(write * 3);
+            tri_groups.resize(write);
+        }
+
+        std::copy(indices.begin(), indices.end(), out_elements);
+        if (out_groups)
+        {
+            std::copy(tri_groups.begin(), tri_groups.end(), out_groups);
+        }
+        if (out_error)
+        {
+            *out_error = std::sqrt(result_error_sq);
+        }
+
+        return indices.size();
+    }
+
+    std::size_t mesh_ops::optimize_vertex_fetch(
+        uint32* elements,
+        std::size_t num_elements,
+        std::size_t num_verts,
+        uint32* out_remap)
+    {
+        std::fill(out_remap, out_remap + num_verts, ~uint32{ 0 });
+
+        uint32 next_vert = 0;
+        for (std::size_t i = 0; i < num_elements; ++i)
+        {
+            auto& remapped = out_remap[elements[i]];
+            if (remapped == ~uint32{ 0 })
+            {
+                remapped = next_vert++;
+            }
+
+            elements[i] = remapped;
+        }
+
+        return next_vert;
+    }
+
+    void mesh_ops::pack_vertices(
+        std::size_t num_verts,
+        const Vec3* positions,
+        const HalfVec3* normals,
+        const HalfVec3* tangents,
+        const int8* bitangent_signs,
+        const UHalfVec2* material_uv,
+        const UHalfVec2* lightmap_uv,
+        Vec3* out_position_offset,
+        Vec3* out_position_scale,
+        PackedVertex* out_verts)
+    {
+        // Compute the bounds of the mesh
+        Vec3 min = num_verts != 0 ? positions[0] : Vec3::zero();
+        Vec3 max = min;
+        for (std::size_t i = 1; i < num_verts; ++i)
+        {
+            const auto& pos = positions[i];
+            min = Vec3{ std::min(min.x(), pos.x()), std::min(min.y(), pos.y()), std::min(min.z(), pos.z()) };
+            max = Vec3{ std::max(max.x(), pos.x()), std::max(max.y(), pos.y()), std::max(max.z(), pos.z()) };
+        }
+
+        const auto extent = max - min;
+        const Vec3 inv_extent{
+            extent.x() > 0.f ? 1.f / extent.x() : 0.f,
+            extent.y() > 0.f ? 1.f / extent.y() : 0.f,
+            extent.z() > 0.f ? 1.f / extent.z() : 0.f };
+        *out_position_offset = min;
+        *out_position_scale = extent;
+
+        const auto quantize = [](float value) -> uint16
+        {
+            return static_cast<uint16>(std::min(std::max(value, 0.f), 1.f) * 65535.f + 0.5f);
+        };
+
+        for (std::size_t i = 0; i < num_verts; ++i)
+        {
+            auto& out = out_verts[i];
+
+            const auto pos = (positions[i] - min) * inv_extent;
+            out.position[0] = quantize(pos.x());
+            out.position[1] = quantize(pos.y());
+            out.position[2] = quantize(pos.z());
+            out.position[3] = 0;
+
+            const auto& normal = normals[i];
+            const auto& tangent = tangents[i];
+            out.normal = pack_snorm_10_10_10_2(normal.norm_f32_x(), normal.norm_f32_y(), normal.norm_f32_z(), bitangent_signs[i] < 0 ? -1 : 1);
+            out.tangent = pack_snorm_10_10_10_2(tangent.norm_f32_x(), tangent.norm_f32_y(), tangent.norm_f32_z(), 0);
+
+            out.material_uv = material_uv[i];
+            out.lightmap_uv = lightmap_uv[i];
+        }
+    }
+}
@@ -0,0 +1,1152 @@
+// TextureCompression.cpp
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <Core/Parallelism/TaskPool.h>
+#include "../../include/Resource/Misc/TextureCompression.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SGE_TEXTURE_COMPRESSION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace sge
+{
+    namespace texture_compression
+    {
+        /* The number of rows of blocks encoded by each task when compressing in parallel. */
+        static constexpr int32 ROWS_PER_TASK = 8;
+
+        /* The number of power iterations used to find the principal axis of a block's colors. */
+        static constexpr int NUM_POWER_ITERATIONS = 8;
+
+        /* BC7 interpolation weights (out of 64) for 4-bit indices. */
+        static constexpr uint32 BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        /* BC1 weights of the first endpoint, for each index. */
+        static constexpr float BC1_WEIGHTS[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+
+        using EncodeBlockFn = void(const byte* block, byte* out);
+
+        static const float* srgb_to_linear_table()
+        {
+            static const auto table = []() {
+                std::array<float, 256> result;
+                for (std::size_t i = 0; i < result.size(); ++i)
+                {
+                    const float c = i / 255.f;
+                    result[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                return result;
+            }();
+
+            return table.data();
+        }
+
+        static float linear_to_srgb(float c)
+        {
+            return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+        }
+
+        static byte to_unorm8(float c)
+        {
+            return static_cast<byte>(std::min(std::max(c * 255.f + 0.5f, 0.f), 255.f));
+        }
+
+        /**
+         * \brief Copies the given block out of the image, clamping to the edges of images whose size isn't a multiple of 4.
+         */
+        static void extract_block(
+            const byte* const image,
+            const int32 width,
+            const int32 height,
+            const int32 block_x,
+            const int32 block_y,
+            byte* const out_block)
+        {
+            for (int32 y = 0; y < 4; ++y)
+            {
+                const int32 image_y = std::min(block_y * 4 + y, height - 1);
+                for (int32 x = 0; x < 4; ++x)
+                {
+                    const int32 image_x = std::min(block_x * 4 + x, width - 1);
+                    std::memcpy(out_block + (y * 4 + x) * 4, image + (std::size_t(image_y) * width + image_x) * 4, 4);
+                }
+            }
+        }
+
+        static void load_block(
+            const byte* const block,
+            float (&out_pixels)[16][4])
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    out_pixels[i][c] = block[i * 4 + c];
+                }
+            }
+        }
+
+        /**
+         * \brief Finds endpoints for the first 'num_channels' channels of the given pixels, along their principal axis.
+         * Endpoints are clamped to [0, max_value].
+         */
+        static void fit_endpoints(
+            const float (&pixels)[16][4],
+            const int num_channels,
+            const float max_value,
+            float* const out_lo,
+            float* const out_hi)
+        {
+            // Find the mean and covariance of the pixels
+            float mean[4] = {};
+            for (const auto& pixel : pixels)
+            {
+                for (int c = 0; c < num_channels; ++c)
+                {
+                    mean[c] += pixel[c] / 16.f;
+                }
+            }
+
+            float cov[4][4] = {};
+            for (const auto& pixel : pixels)
+            {
+                for (int i = 0; i < num_channels; ++i)
+                {
+                    for (int j = 0; j < num_channels; ++j)
+                    {
+                        cov[i][j] += (pixel[i] - mean[i]) * (pixel[j] - mean[j]);
+                    }
+                }
+            }
+
+            // Power iteration, starting from the diagonal of the bounding box
+            float axis[4] = {};
+            for (int c = 0; c < num_channels; ++c)
+            {
+                float lo = max_value, hi = 0.f;
+                for (const auto& pixel : pixels)
+                {
+                    lo = std::min(lo, pixel[c]);
+                    hi = std::max(hi, pixel[c]);
+                }
+                axis[c] = hi - lo;
+            }
+
+            for (int iter = 0; iter < NUM_POWER_ITERATIONS; ++iter)
+            {
+                float next[4] = {};
+                float length = 0.f;
+                for (int i = 0; i < num_channels; ++i)
+                {
+                    for (int j = 0; j < num_channels; ++j)
+                    {
+                        next[i] += cov[i][j] * axis[j];
+                    }
+                    length = std::max(length, std::abs(next[i]));
+                }
+
+                if (length < FLT_EPSILON)
+                {
+                    break;
+                }
+
+                for (int c = 0; c < num_channels; ++c)
+                {
+                    axis[c] = next[c] / length;
+                }
+            }
+
+            float axis_length_sq = 0.f;
+            for (int c = 0; c < num_channels; ++c)
+            {
+                axis_length_sq += axis[c] * axis[c];
+            }
+
+            // If every pixel is the same, both endpoints are the mean
+            if (axis_length_sq < FLT_EPSILON)
+            {
+                for (int c = 0; c < num_channels; ++c)
+                {
+                    out_lo[c] = mean[c];
+                    out_hi[c] = mean[c];
+                }
+                return;
+            }
+
+            // Project the pixels onto the axis, to find the extents along it
+            float t_min = FLT_MAX, t_max = -FLT_MAX;
+            for (const auto& pixel : pixels)
+            {
+                float t = 0.f;
+                for (int c = 0; c < num_channels; ++c)
+                {
+                    t += (pixel[c] - mean[c]) * axis[c];
+                }
+                t_min = std::min(t_min, t);
+                t_max = std::max(t_max, t);
+            }
+
+            for (int c = 0; c < num_channels; ++c)
+            {
+                out_lo[c] = std::min(std::max(mean[c] + axis[c] * t_min / axis_length_sq, 0.f), max_value);
+                out_hi[c] = std::min(std::max(mean[c] + axis[c] * t_max / axis_length_sq, 0.f), max_value);
+            }
+        }
+
+        /**
+         * \brief Finds the palette entry nearest to the given pixel.
+         * \param palette The palette, as 'num_channels' rows of 'num_entries' values. 'num_entries' must be a multiple of 4.
+         * \param out_error The squared distance from the pixel to the entry.
+         */
+        static uint32 nearest_entry(
+            const float* const palette,
+            const int num_entries,
+            const int num_channels,
+            const float* const pixel,
+            float& out_error)
+        {
+#if SGE_TEXTURE_COMPRESSION_SSE2
+            // Test four entries at a time, keeping the best of each lane
+            __m128 best_error = _mm_set1_ps(FLT_MAX);
+            __m128i best_index = _mm_setzero_si128();
+            __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+            const __m128i four = _mm_set1_epi32(4);
+
+            for (int i = 0; i < num_entries; i += 4)
+            {
+                __m128 error = _mm_setzero_ps();
+                for (int c = 0; c < num_channels; ++c)
+                {
+                    const __m128 d = _mm_sub_ps(_mm_loadu_ps(palette + c * num_entries + i), _mm_set1_ps(pixel[c]));
+                    error = _mm_add_ps(error, _mm_mul_ps(d, d));
+                }
+
+                const __m128i better = _mm_castps_si128(_mm_cmplt_ps(error, best_error));
+                best_error = _mm_min_ps(error, best_error);
+                best_index = _mm_or_si128(_mm_and_si128(better, index), _mm_andnot_si128(better, best_index));
+                index = _mm_add_epi32(index, four);
+            }
+
+            alignas(16) float lane_errors[4];
+            alignas(16) int32 lane_indices[4];
+            _mm_store_ps(lane_errors, best_error);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lane_indices), best_index);
+
+            int best_lane = 0;
+            for (int lane = 1; lane < 4; ++lane)
+            {
+                if (lane_errors[lane] < lane_errors[best_lane])
+                {
+                    best_lane = lane;
+                }
+            }
+
+            out_error = lane_errors[best_lane];
+            return static_cast<uint32>(lane_indices[best_lane]);
+#else
+            uint32 best_index = 0;
+            out_error = FLT_MAX;
+            for (int i = 0; i < num_entries; ++i)
+            {
+                float error = 0.f;
+                for (int c = 0; c < num_channels; ++c)
+                {
+                    const float d = palette[c * num_entries + i] - pixel[c];
+                    error += d * d;
+                }
+
+                if (error < out_error)
+                {
+                    out_error = error;
+                    best_index = static_cast<uint32>(i);
+                }
+            }
+
+            return best_index;
+#endif
+        }
+
+        /**
+         * \brief Solves for the pair of endpoints that best reproduce the pixels with the given weights, by least squares.
+         * \param weights The weight of the first endpoint for each pixel (the second gets 1 - weight).
+         * \return Whether a solution was found (it isn't if every weight is the same).
+         */
+        static bool solve_endpoints(
+            const float (&pixels)[16][4],
+            const float (&weights)[16],
+            const int num_channels,
+            const float max_value,
+            float* const out_a,
+            float* const out_b)
+        {
+            float aa = 0.f, bb = 0.f, ab = 0.f;
+            float ax[4] = {}, bx[4] = {};
+            for (int i = 0; i < 16; ++i)
+            {
+                const float a = weights[i];
+                const float b = 1.f - a;
+                aa += a * a;
+                bb += b * b;
+                ab += a * b;
+                for (int c = 0; c < num_channels; ++c)
+                {
+                    ax[c] += a * pixels[i][c];
+                    bx[c] += b * pixels[i][c];
+                }
+            }
+
+            const float det = aa * bb - ab * ab;
+            if (std::abs(det) < FLT_EPSILON)
+            {
+                return false;
+            }
+
+            for (int c = 0; c < num_channels; ++c)
+            {
+                out_a[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / det, 0.f), max_value);
+                out_b[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / det, 0.f), max_value);
+            }
+
+            return true;
+        }
+
+        ///////////////
+        ///   BC1   ///
+
+        static uint16 to_565(const float* const color)
+        {
+            const auto r = static_cast<uint16>(std::min(color[0] * 31.f / 255.f + 0.5f, 31.f));
+            const auto g = static_cast<uint16>(std::min(color[1] * 63.f / 255.f + 0.5f, 63.f));
+            const auto b = static_cast<uint16>(std::min(color[2] * 31.f / 255.f + 0.5f, 31.f));
+            return static_cast<uint16>((r << 11) | (g << 5) | b);
+        }
+
+        static void from_565(const uint16 value, float* const out_color)
+        {
+            const uint32 r = (value >> 11) & 31;
+            const uint32 g = (value >> 5) & 63;
+            const uint32 b = value & 31;
+            out_color[0] = static_cast<float>((r << 3) | (r >> 2));
+            out_color[1] = static_cast<float>((g << 2) | (g >> 4));
+            out_color[2] = static_cast<float>((b << 3) | (b >> 2));
+        }
+
+        /**
+         * \brief Orders the given endpoints for four-color mode, and finds the nearest palette entry for each pixel.
+         * \return The total squared error of the block.
+         */
+        static float fit_bc1_indices(
+            const float (&pixels)[16][4],
+            uint16& c0,
+            uint16& c1,
+            uint32& out_indices)
+        {
+            // Four-color mode requires the first endpoint to be greater
+            if (c0 < c1)
+            {
+                std::swap(c0, c1);
+            }
+
+            float e0[3], e1[3];
+            from_565(c0, e0);
+            from_565(c1, e1);
+
+            float palette[3 * 4];
+            for (int c = 0; c < 3; ++c)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    palette[c * 4 + i] = e0[c] * BC1_WEIGHTS[i] + e1[c] * (1.f - BC1_WEIGHTS[i]);
+                }
+            }
+
+            // With equal endpoints, only index 0 is guaranteed to decode to them
+            const int num_entries = c0 == c1 ? 1 : 4;
+            if (num_entries == 1)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    for (int i = 1; i < 4; ++i)
+                    {
+                        palette[c * 4 + i] = FLT_MAX;
+                    }
+                }
+            }
+
+            float total_error = 0.f;
+            out_indices = 0;
+            for (int i = 0; i < 16; ++i)
+            {
+                float error;
+                const auto index = nearest_entry(palette, 4, 3, pixels[i], error);
+                out_indices |= index << (i * 2);
+                total_error += error;
+            }
+
+            return total_error;
+        }
+
+        static void encode_bc1_color(
+            const float (&pixels)[16][4],
+            byte* const out)
+        {
+            float lo[3], hi[3];
+            fit_endpoints(pixels, 3, 255.f, lo, hi);
+
+            uint16 c0 = to_565(hi);
+            uint16 c1 = to_565(lo);
+            uint32 indices;
+            float error = fit_bc1_indices(pixels, c0, c1, indices);
+
+            // Refine the endpoints for the chosen indices, and keep them if they're better
+            float weights[16];
+            for (int i = 0; i < 16; ++i)
+            {
+                weights[i] = BC1_WEIGHTS[(indices >> (i * 2)) & 3];
+            }
+
+            float a[3], b[3];
+            if (solve_endpoints(pixels, weights, 3, 255.f, a, b))
+            {
+                uint16 refined_c0 = to_565(a);
+                uint16 refined_c1 = to_565(b);
+                uint32 refined_indices;
+                const float refined_error = fit_bc1_indices(pixels, refined_c0, refined_c1, refined_indices);
+                if (refined_error < error)
+                {
+                    c0 = refined_c0;
+                    c1 = refined_c1;
+                    indices = refined_indices;
+                    error = refined_error;
+                }
+            }
+
+            out[0] = static_cast<byte>(c0 & 0xFF);
+            out[1] = static_cast<byte>(c0 >> 8);
+            out[2] = static_cast<byte>(c1 & 0xFF);
+            out[3] = static_cast<byte>(c1 >> 8);
+            for (int i = 0; i < 4; ++i)
+            {
+                out[4 + i] = static_cast<byte>(indices >> (i * 8));
+            }
+        }
+
+        ///////////////
+        ///   BC4   ///
+
+        /**
+         * \brief Encodes a single channel of the given pixels as a BC4 block (as used by BC3 alpha and BC5).
+         */
+        static void encode_bc4_channel(
+            const float (&pixels)[16][4],
+            const int channel,
+            byte* const out)
+        {
+            float lo = 255.f, hi = 0.f;
+            for (const auto& pixel : pixels)
+            {
+                lo = std::min(lo, pixel[channel]);
+                hi = std::max(hi, pixel[channel]);
+            }
+
+            // Eight-value mode requires the first endpoint to be greater
+            const auto a0 = static_cast<byte>(hi);
+            const auto a1 = static_cast<byte>(lo);
+            out[0] = a0;
+            out[1] = a1;
+
+            uint64 bits = 0;
+            if (a0 != a1)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    // Find the nearest step from the second endpoint, and map it to its index
+                    const auto step = static_cast<int>((pixels[i][channel] - a1) * 7.f / (a0 - a1) + 0.5f);
+                    const uint64 index = step >= 7 ? 0 : step <= 0 ? 1 : 8 - step;
+                    bits |= index << (i * 3);
+                }
+            }
+
+            for (int i = 0; i < 6; ++i)
+            {
+                out[2 + i] = static_cast<byte>(bits >> (i * 8));
+            }
+        }
+
+        ///////////////
+        ///   BC7   ///
+
+        struct Bc7Endpoint
+        {
+            /* 7-bit value of each channel, and the shared low bit. */
+            uint32 value[4];
+            uint32 p_bit;
+        };
+
+        static Bc7Endpoint quantize_bc7_endpoint(const float* const color)
+        {
+            Bc7Endpoint best = {};
+            float best_error = FLT_MAX;
+
+            // Try both values of the shared bit, and keep whichever is closer
+            for (uint32 p_bit = 0; p_bit < 2; ++p_bit)
+            {
+                Bc7Endpoint endpoint;
+                endpoint.p_bit = p_bit;
+                float error = 0.f;
+                for (int c = 0; c < 4; ++c)
+                {
+                    const float value = std::floor((color[c] - p_bit) / 2.f + 0.5f);
+                    endpoint.value[c] = static_cast<uint32>(std::min(std::max(value, 0.f), 127.f));
+                    const float d = static_cast<float>((endpoint.value[c] << 1) | p_bit) - color[c];
+                    error += d * d;
+                }
+
+                if (error < best_error)
+                {
+                    best = endpoint;
+                    best_error = error;
+                }
+            }
+
+            return best;
+        }
+
+        static float fit_bc7_indices(
+            const float (&pixels)[16][4],
+            const Bc7Endpoint& e0,
+            const Bc7Endpoint& e1,
+            uint32 (&out_indices)[16])
+        {
+            float palette[4 * 16];
+            for (int c = 0; c < 4; ++c)
+            {
+                const uint32 v0 = (e0.value[c] << 1) | e0.p_bit;
+                const uint32 v1 = (e1.value[c] << 1) | e1.p_bit;
+                for (int i = 0; i < 16; ++i)
+                {
+                    const auto w = BC7_WEIGHTS_4[i];
+                    palette[c * 16 + i] = static_cast<float>(((64 - w) * v0 + w * v1 + 32) >> 6);
+                }
+            }
+
+            float total_error = 0.f;
+            for (int i = 0; i < 16; ++i)
+            {
+                float error;
+                out_indices[i] = nearest_entry(palette, 16, 4, pixels[i], error);
+                total_error += error;
+            }
+
+            return total_error;
+        }
+
+        /**
+         * \brief Writes bits into a block, starting from the least significant bit of the first byte.
+         */
+        struct BlockWriter
+        {
+            byte* out;
+            uint32 bit = 0;
+
+            void write(const uint32 value, const uint32 num_bits)
+            {
+                for (uint32 i = 0; i < num_bits; ++i, ++bit)
+                {
+                    out[bit / 8] |= static_cast<byte>(((value >> i) & 1) << (bit % 8));
+                }
+            }
+        };
+
+        ////////////////
+        ///   BC6H   ///
+
+        /* Bits of precision of mode 11's endpoints. */
+        static constexpr uint32 BC6H_ENDPOINT_BITS = 10;
+
+        /* The largest value BC6H interpolates in (before it's scaled back down to half-float bits). */
+        static constexpr float BC6H_MAX_VALUE = 65535.f;
+
+        /**
+         * \brief Converts a non-negative float to the bits of the nearest half-float, clamped to the largest finite half-float.
+         */
+        static uint32 float_to_half_bits(const float value)
+        {
+            // Also catches NaN
+            if (!(value > 0.f))
+            {
+                return 0;
+            }
+
+            if (value >= 65504.f)
+            {
+                return 0x7BFF;
+            }
+
+            uint32 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            const int32 exponent = static_cast<int32>((bits >> 23) & 0xFF) - 127 + 15;
+            uint32 mantissa = bits & 0x7FFFFF;
+
+            // Values too small for a normal half-float become subnormal
+            if (exponent <= 0)
+            {
+                if (exponent < -10)
+                {
+                    return 0;
+                }
+
+                mantissa |= 0x800000;
+                const auto shift = static_cast<uint32>(14 - exponent);
+                return (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1);
+            }
+
+            // Rounding may carry into the exponent, which still gives the nearest value
+            const uint32 half = (static_cast<uint32>(exponent) << 10) | (mantissa >> 13);
+            return std::min(half + ((mantissa >> 12) & 1), 0x7BFFu);
+        }
+
+        /**
+         * \brief Returns the value BC6H should interpolate in, to decode to the given half-float bits.
+         * The decoder scales interpolated values by 31/64 to get the final half-float bits.
+         */
+        static float half_bits_to_bc6h_value(const uint32 half)
+        {
+            return std::min(half * 64.f / 31.f, BC6H_MAX_VALUE);
+        }
+
+        static uint32 quantize_bc6h_endpoint(const float value)
+        {
+            // Inverse of the decoder's unquantization, '((q << 16) + 0x8000) >> bits'
+            const float q = std::floor(value / (1 << (16 - BC6H_ENDPOINT_BITS)) + 0.5f);
+            return static_cast<uint32>(std::min(std::max(q, 0.f), float((1 << BC6H_ENDPOINT_BITS) - 1)));
+        }
+
+        static uint32 unquantize_bc6h_endpoint(const uint32 q)
+        {
+            if (q == 0)
+            {
+                return 0;
+            }
+
+            if (q == (1u << BC6H_ENDPOINT_BITS) - 1)
+            {
+                return 0xFFFF;
+            }
+
+            return ((q << 16) + 0x8000) >> BC6H_ENDPOINT_BITS;
+        }
+
+        static float fit_bc6h_indices(
+            const float (&pixels)[16][4],
+            const uint32 (&e0)[3],
+            const uint32 (&e1)[3],
+            uint32 (&out_indices)[16])
+        {
+            float palette[3 * 16];
+            for (int c = 0; c < 3; ++c)
+            {
+                const auto v0 = unquantize_bc6h_endpoint(e0[c]);
+                const auto v1 = unquantize_bc6h_endpoint(e1[c]);
+                for (int i = 0; i < 16; ++i)
+                {
+                    const auto w = BC7_WEIGHTS_4[i];
+                    palette[c * 16 + i] = static_cast<float>(((64 - w) * v0 + w * v1 + 32) >> 6);
+                }
+            }
+
+            float total_error = 0.f;
+            for (int i = 0; i < 16; ++i)
+            {
+                float error;
+                out_indices[i] = nearest_entry(palette, 16, 3, pixels[i], error);
+                total_error += error;
+            }
+
+            return total_error;
+        }
+
+        /**
+         * \brief Runs the given function over rows of blocks, spread across the given pool if there is one.
+         */
+        template <typename EncodeRowsFn>
+        static void encode_rows_in_parallel(
+            const int32 num_rows,
+            TaskPool* const pool,
+            const EncodeRowsFn& encode_rows)
+        {
+            if (!pool || num_rows <= ROWS_PER_TASK)
+            {
+                encode_rows(0, num_rows);
+                return;
+            }
+
+            TaskGroup group;
+            for (int32 start_row = 0; start_row < num_rows; start_row += ROWS_PER_TASK)
+            {
+                const int32 end_row = std::min(start_row + ROWS_PER_TASK, num_rows);
+                pool->submit(group, [&encode_rows, start_row, end_row]() {
+                    encode_rows(start_row, end_row);
+                });
+            }
+            pool->wait(group);
+        }
+
+        ///////////////////
+        ///   Methods   ///
+
+        std::size_t block_size(
+            const BlockFormat format)
+        {
+            return format == BlockFormat::BC1 ? 8 : 16;
+        }
+
+        std::size_t compressed_size(
+            const BlockFormat format,
+            const int32 width,
+            const int32 height)
+        {
+            return std::size_t((width + 3) / 4) * std::size_t((height + 3) / 4) * block_size(format);
+        }
+
+        int32 num_mip_levels(
+            int32 width,
+            int32 height)
+        {
+            int32 num_levels = 1;
+            while (width > 1 || height > 1)
+            {
+                width = std::max(width / 2, 1);
+                height = std::max(height / 2, 1);
+                ++num_levels;
+            }
+
+            return num_levels;
+        }
+
+        void generate_mip(
+            const byte* const image,
+            const int32 width,
+            const int32 height,
+            const MipFilter filter,
+            byte* const out_mip)
+        {
+            const auto* const to_linear = srgb_to_linear_table();
+            const int32 mip_width = std::max(width / 2, 1);
+            const int32 mip_height = std::max(height / 2, 1);
+
+            for (int32 y = 0; y < mip_height; ++y)
+            {
+                const int32 y0 = std::min(y * 2, height - 1);
+                const int32 y1 = std::min(y * 2 + 1, height - 1);
+                for (int32 x = 0; x < mip_width; ++x)
+                {
+                    const int32 x0 = std::min(x * 2, width - 1);
+                    const int32 x1 = std::min(x * 2 + 1, width - 1);
+                    const byte* const samples[4] = {
+                        image + (std::size_t(y0) * width + x0) * 4,
+                        image + (std::size_t(y0) * width + x1) * 4,
+                        image + (std::size_t(y1) * width + x0) * 4,
+                        image + (std::size_t(y1) * width + x1) * 4 };
+
+                    float sum[4] = {};
+                    for (const auto* sample : samples)
+                    {
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            switch (filter)
+                            {
+                            case MipFilter::S_RGB:
+                                sum[c] += c < 3 ? to_linear[sample[c]] : sample[c] / 255.f;
+                                break;
+
+                            case MipFilter::NORMAL:
+                                sum[c] += c < 3 ? sample[c] / 127.5f - 1.f : sample[c] / 255.f;
+                                break;
+
+                            default:
+                                sum[c] += sample[c] / 255.f;
+                                break;
+                            }
+                        }
+                    }
+
+                    auto* const out = out_mip + (std::size_t(y) * mip_width + x) * 4;
+                    switch (filter)
+                    {
+                    case MipFilter::S_RGB:
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            out[c] = to_unorm8(linear_to_srgb(sum[c] / 4.f));
+                        }
+                        break;
+
+                    case MipFilter::NORMAL:
+                    {
+                        const float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                        const float scale = length > FLT_EPSILON ? 1.f / length : 0.f;
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            out[c] = to_unorm8(sum[c] * scale * 0.5f + 0.5f);
+                        }
+                        break;
+                    }
+
+                    default:
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            out[c] = to_unorm8(sum[c] / 4.f);
+                        }
+                        break;
+                    }
+
+                    out[3] = to_unorm8(sum[3] / 4.f);
+                }
+            }
+        }
+
+        void generate_hdr_mip(
+            const float* const image,
+            const int32 width,
+            const int32 height,
+            float* const out_mip)
+        {
+            const int32 mip_width = std::max(width / 2, 1);
+            const int32 mip_height = std::max(height / 2, 1);
+
+            for (int32 y = 0; y < mip_height; ++y)
+            {
+                const int32 y0 = std::min(y * 2, height - 1);
+                const int32 y1 = std::min(y * 2 + 1, height - 1);
+                for (int32 x = 0; x < mip_width; ++x)
+                {
+                    const int32 x0 = std::min(x * 2, width - 1);
+                    const int32 x1 = std::min(x * 2 + 1, width - 1);
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        out_mip[(std::size_t(y) * mip_width + x) * 3 + c] = 0.25f * (
+                            image[(std::size_t(y0) * width + x0) * 3 + c] +
+                            image[(std::size_t(y0) * width + x1) * 3 + c] +
+                            image[(std::size_t(y1) * width + x0) * 3 + c] +
+                            image[(std::size_t(y1) * width + x1) * 3 + c]);
+                    }
+                }
+            }
+        }
+
+        void encode_bc1_block(
+            const byte* const block,
+            byte* const out)
+        {
+            float pixels[16][4];
+            load_block(block, pixels);
+            encode_bc1_color(pixels, out);
+        }
+
+        void encode_bc3_block(
+            const byte* const block,
+            byte* const out)
+        {
+            float pixels[16][4];
+            load_block(block, pixels);
+            encode_bc4_channel(pixels, 3, out);
+            encode_bc1_color(pixels, out + 8);
+        }
+
+        void encode_bc5_block(
+            const byte* const block,
+            byte* const out)
+        {
+            float pixels[16][4];
+            load_block(block, pixels);
+            encode_bc4_channel(pixels, 0, out);
+            encode_bc4_channel(pixels, 1, out + 8);
+        }
+
+        void encode_bc7_block(
+            const byte* const block,
+            byte* const out)
+        {
+            float pixels[16][4];
+            load_block(block, pixels);
+
+            float lo[4], hi[4];
+            fit_endpoints(pixels, 4, 255.f, lo, hi);
+
+            auto e0 = quantize_bc7_endpoint(lo);
+            auto e1 = quantize_bc7_endpoint(hi);
+            uint32 indices[16];
+            float error = fit_bc7_indices(pixels, e0, e1, indices);
+
+            // Refine the endpoints for the chosen indices, and keep them if they're better
+            float weights[16];
+            for (int i = 0; i < 16; ++i)
+            {
+                weights[i] = 1.f - BC7_WEIGHTS_4[indices[i]] / 64.f;
+            }
+
+            float a[4], b[4];
+            if (solve_endpoints(pixels, weights, 4, 255.f, a, b))
+            {
+                const auto refined_e0 = quantize_bc7_endpoint(a);
+                const auto refined_e1 = quantize_bc7_endpoint(b);
+                uint32 refined_indices[16];
+                const float refined_error = fit_bc7_indices(pixels, refined_e0, refined_e1, refined_indices);
+                if (refined_error < error)
+                {
+                    e0 = refined_e0;
+                    e1 = refined_e1;
+                    std::copy(refined_indices, refined_indices + 16, indices);
+                    error = refined_error;
+                }
+            }
+
+            // The anchor (first) index has an implicit high bit of zero, so swap the endpoints if it's set
+            if (indices[0] & 8)
+            {
+                std::swap(e0, e1);
+                for (auto& index : indices)
+                {
+                    index = 15 - index;
+                }
+            }
+
+            std::memset(out, 0, 16);
+            BlockWriter writer{ out };
+            writer.write(1 << 6, 7);
+            for (int c = 0; c < 4; ++c)
+            {
+                writer.write(e0.value[c], 7);
+                writer.write(e1.value[c], 7);
+            }
+            writer.write(e0.p_bit, 1);
+            writer.write(e1.p_bit, 1);
+            writer.write(indices[0], 3);
+            for (int i = 1; i < 16; ++i)
+            {
+                writer.write(indices[i], 4);
+            }
+        }
+
+        void encode_bc6h_block(
+            const float* const block,
+            byte* const out)
+        {
+            // Work in the space the decoder interpolates in, which is roughly logarithmic in the decoded value
+            float pixels[16][4] = {};
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    pixels[i][c] = half_bits_to_bc6h_value(float_to_half_bits(block[i * 3 + c]));
+                }
+            }
+
+            float lo[3], hi[3];
+            fit_endpoints(pixels, 3, BC6H_MAX_VALUE, lo, hi);
+
+            uint32 e0[3], e1[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                e0[c] = quantize_bc6h_endpoint(lo[c]);
+                e1[c] = quantize_bc6h_endpoint(hi[c]);
+            }
+
+            uint32 indices[16];
+            float error = fit_bc6h_indices(pixels, e0, e1, indices);
+
+            // Refine the endpoints for the chosen indices, and keep them if they're better
+            float weights[16];
+            for (int i = 0; i < 16; ++i)
+            {
+                weights[i] = 1.f - BC7_WEIGHTS_4[indices[i]] / 64.f;
+            }
+
+            float a[3], b[3];
+            if (solve_endpoints(pixels, weights, 3, BC6H_MAX_VALUE, a, b))
+            {
+                uint32 refined_e0[3], refined_e1[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    refined_e0[c] = quantize_bc6h_endpoint(a[c]);
+                    refined_e1[c] = quantize_bc6h_endpoint(b[c]);
+                }
+
+                uint32 refined_indices[16];
+                const float refined_error = fit_bc6h_indices(pixels, refined_e0, refined_e1, refined_indices);
+                if (refined_error < error)
+                {
+                    std::copy(refined_e0, refined_e0 + 3, e0);
+                    std::copy(refined_e1, refined_e1 + 3, e1);
+                    std::copy(refined_indices, refined_indices + 16, indices);
+                    error = refined_error;
+                }
+            }
+
+            // The anchor (first) index has an implicit high bit of zero, so swap the endpoints if it's set
+            if (indices[0] & 8)
+            {
+                std::swap(e0, e1);
+                for (auto& index : indices)
+                {
+                    index = 15 - index;
+                }
+            }
+
+            std::memset(out, 0, 16);
+            BlockWriter writer{ out };
+            writer.write(0x03, 5);
+            for (int c = 0; c < 3; ++c)
+            {
+                writer.write(e0[c], BC6H_ENDPOINT_BITS);
+            }
+            for (int c = 0; c < 3; ++c)
+            {
+                writer.write(e1[c], BC6H_ENDPOINT_BITS);
+            }
+            writer.write(indices[0], 3);
+            for (int i = 1; i < 16; ++i)
+            {
+                writer.write(indices[i], 4);
+            }
+        }
+
+        void compress_image(
+            const BlockFormat format,
+            const byte* const image,
+            const int32 width,
+            const int32 height,
+            byte* const out,
+            TaskPool* const pool)
+        {
+            EncodeBlockFn* encode_block;
+            switch (format)
+            {
+            case BlockFormat::BC1:
+                encode_block = &encode_bc1_block;
+                break;
+
+            case BlockFormat::BC3:
+                encode_block = &encode_bc3_block;
+                break;
+
+            case BlockFormat::BC5:
+                encode_block = &encode_bc5_block;
+                break;
+
+            case BlockFormat::BC7:
+                encode_block = &encode_bc7_block;
+                break;
+
+            default:
+                assert(false);
+                return;
+            }
+
+            const int32 blocks_x = (width + 3) / 4;
+            const int32 blocks_y = (height + 3) / 4;
+            const auto stride = block_size(format);
+            const auto encode_rows = [=](int32 start_row, int32 end_row)
+            {
+                byte block[64];
+                for (int32 block_y = start_row; block_y < end_row; ++block_y)
+                {
+                    for (int32 block_x = 0; block_x < blocks_x; ++block_x)
+                    {
+                        extract_block(image, width, height, block_x, block_y, block);
+                        encode_block(block, out + (std::size_t(block_y) * blocks_x + block_x) * stride);
+                    }
+                }
+            };
+
+            encode_rows_in_parallel(blocks_y, pool, encode_rows);
+        }
+
+        void compress_hdr_image(
+            const float* const image,
+            const int32 width,
+            const int32 height,
+            byte* const out,
+            TaskPool* const pool)
+        {
+            const int32 blocks_x = (width + 3) / 4;
+            const int32 blocks_y = (height + 3) / 4;
+            const auto stride = block_size(BlockFormat::BC6H);
+            const auto encode_rows = [=](int32 start_row, int32 end_row)
+            {
+                float block[16 * 3];
+                for (int32 block_y = start_row; block_y < end_row; ++block_y)
+                {
+                    for (int32 block_x = 0; block_x < blocks_x; ++block_x)
+                    {
+                        // Copy the block out, clamping to the edges of the image
+                        for (int32 y = 0; y < 4; ++y)
+                        {
+                            const int32 image_y = std::min(block_y * 4 + y, height - 1);
+                            for (int32 x = 0; x < 4; ++x)
+                            {
+                                const int32 image_x = std::min(block_x * 4 + x, width - 1);
+                                std::memcpy(block + (y * 4 + x) * 3, image + (std::size_t(image_y) * width + image_x) * 3, sizeof(float) * 3);
+                            }
+                        }
+
+                        encode_bc6h_block(block, out + (std::size_t(block_y) * blocks_x + block_x) * stride);
+                    }
+                }
+            };
+
+            encode_rows_in_parallel(blocks_y, pool, encode_rows);
+        }
+
+        void pack_rgb9e5(
+            const float* const image,
+            const std::size_t num_pixels,
+            uint32* const out)
+        {
+            // See EXT_texture_shared_exponent
+            constexpr int32 MANTISSA_BITS = 9;
+            constexpr int32 EXPONENT_BIAS = 15;
+            constexpr int32 MAX_EXPONENT = 31;
+            const float max_value = float((1 << MANTISSA_BITS) - 1) / (1 << MANTISSA_BITS) * float(1 << (MAX_EXPONENT - EXPONENT_BIAS));
+
+            for (std::size_t i = 0; i < num_pixels; ++i)
+            {
+                float rgb[3];
+                float max_channel = 0.f;
+                for (int c = 0; c < 3; ++c)
+                {
+                    // Also catches NaN
+                    const float value = image[i * 3 + c];
+                    rgb[c] = value > 0.f ? std::min(value, max_value) : 0.f;
+                    max_channel = std::max(max_channel, rgb[c]);
+                }
+
+                int32 exponent = 0;
+                if (max_channel > 0.f)
+                {
+                    exponent = std::max(-EXPONENT_BIAS - 1, static_cast<int32>(std::floor(std::log2(max_channel)))) + 1 + EXPONENT_BIAS;
+                    if (std::floor(max_channel / std::ldexp(1.f, exponent - EXPONENT_BIAS - MANTISSA_BITS) + 0.5f) == (1 << MANTISSA_BITS))
+                    {
+                        exponent += 1;
+                    }
+                }
+
+                const float scale = std::ldexp(1.f, exponent - EXPONENT_BIAS - MANTISSA_BITS);
+                uint32 packed = static_cast<uint32>(exponent) << 27;
+                for (int c = 0; c < 3; ++c)
+                {
+                    const auto mantissa = static_cast<uint32>(std::floor(rgb[c] / scale + 0.5f));
+                    packed |= std::min(mantissa, (1u << MANTISSA_BITS) - 1) << (c * MANTISSA_BITS);
+                }
+
+                out[i] = packed;
+            }
+        }
+    }
+}
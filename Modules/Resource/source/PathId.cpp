@@ -0,0 +1,109 @@
+// PathId.cpp
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include "../include/Resource/PathId.h"
+
+namespace sge
+{
+    /* Paths are stored in fixed-size chunks, which are never moved or freed, so they may be read without locking. */
+    static constexpr std::size_t PATH_CHUNK_SIZE = 1024;
+    static constexpr std::size_t MAX_PATH_CHUNKS = 4096;
+
+    struct InternedPathTable
+    {
+        InternedPathTable()
+            : num_paths(1)
+        {
+            for (auto& chunk : chunks)
+            {
+                chunk.store(nullptr, std::memory_order_relaxed);
+            }
+
+            // The first chunk holds the empty path
+            chunks[0].store(new std::string[PATH_CHUNK_SIZE], std::memory_order_release);
+            ids.insert(std::make_pair(std::string{}, NULL_PATH_ID));
+        }
+        ~InternedPathTable()
+        {
+            for (auto& chunk : chunks)
+            {
+                delete[] chunk.load(std::memory_order_relaxed);
+            }
+        }
+
+        /* Paths indexed by id, in chunks of 'PATH_CHUNK_SIZE'. Paths are written before 'num_paths' is increased to include them, and never change after. */
+        std::atomic<std::string*> chunks[MAX_PATH_CHUNKS];
+        std::atomic<std::size_t> num_paths;
+
+        /* Guards 'ids', and adding paths. */
+        std::mutex lock;
+        std::unordered_map<std::string, PathId> ids;
+    };
+
+    static InternedPathTable& path_table()
+    {
+        static InternedPathTable table;
+        return table;
+    }
+
+    PathId intern_path(
+        const std::string& path)
+    {
+        auto& table = path_table();
+        std::lock_guard<std::mutex> lock{ table.lock };
+
+        const auto iter = table.ids.find(path);
+        if (iter != table.ids.end())
+        {
+            return iter->second;
+        }
+
+        // Ids index a fixed chunk directory, so there's no way to continue once it's full
+        const auto index = table.num_paths.load(std::memory_order_relaxed);
+        const auto chunk_index = index / PATH_CHUNK_SIZE;
+        if (chunk_index >= MAX_PATH_CHUNKS)
+        {
+            std::cerr << "Error: Can't intern path '" << path << "', the limit of " << PATH_CHUNK_SIZE * MAX_PATH_CHUNKS << " paths has been reached" << std::endl;
+            std::abort();
+        }
+
+        // Allocate a new chunk if the last one is full
+        auto* chunk = table.chunks[chunk_index].load(std::memory_order_relaxed);
+        if (!chunk)
+        {
+            chunk = new std::string[PATH_CHUNK_SIZE];
+            table.chunks[chunk_index].store(chunk, std::memory_order_release);
+        }
+
+        // Write the path before publishing its id
+        const auto id = static_cast<PathId>(index);
+        chunk[index % PATH_CHUNK_SIZE] = path;
+        table.ids.insert(std::make_pair(path, id));
+        table.num_paths.store(index + 1, std::memory_order_release);
+        return id;
+    }
+
+    PathId intern_path(
+        const char* path)
+    {
+        return intern_path(std::string{ path });
+    }
+
+    const std::string& get_interned_path(
+        PathId id)
+    {
+        auto& table = path_table();
+        assert(id < table.num_paths.load(std::memory_order_acquire));
+        return table.chunks[id / PATH_CHUNK_SIZE].load(std::memory_order_acquire)[id % PATH_CHUNK_SIZE];
+    }
+
+    std::size_t num_interned_paths()
+    {
+        return path_table().num_paths.load(std::memory_order_acquire);
+    }
+}
@@ -39,6 +39,12 @@ namespace sge
             return new (buffer) Resource{ type };
         }
 
+        static void destroy_resource_object(Resource* resource)
+        {
+            resource->~Resource();
+            sge::free(resource);
+        }
+
         ///////////////////
         ///   Methods   ///
     public:
@@ -84,11 +90,13 @@ namespace sge
         void* init) -> NewResourceResult
     {
         // Lock the resources map, and look up the uri
+        const auto id = intern_path(uri);
         _resources_lock.lock();
 
-        auto iter = _resources.find(uri);
+        auto iter = _resources.find(id);
         if (iter != _resources.end())
         {
+            _resources_lock.unlock();
             return NewResourceResult::ERROR_RESOURCE_EXISTS;
         }
 
@@ -99,19 +107,21 @@ namespace sge
         resource->version_last_modified = Resource::VERSION_INITIALIZED;
 
         // Add it to the resource map
-        _resources.insert(std::make_pair(std::move(uri), resource));
-        return NewResourceResult::SUCCESS; // TODO: Make this actually work
+        _resources.insert(std::make_pair(id, resource));
+        _resources_lock.unlock();
+        return NewResourceResult::SUCCESS;
     }
 
     auto ResourceManager::async_new_resource(
         const std::string& uri,
         const TypeInfo& type,
         CallbackQueue& /*cbQueue*/,
-        std::function<WriteCallbackFn> /*writeFn*/) -> NewResourceResult
+        std::function<WriteCallbackFn> writeFn) -> NewResourceResult
     {
         // Lock the resource map, and look up the resource
+        const auto id = intern_path(uri);
         _resources_lock.lock();
-        auto iter = _resources.find(uri);
+        auto iter = _resources.find(id);
 
         // Make sure the resource doesn't already exist
         if (iter != _resources.end())
@@ -120,19 +130,23 @@ namespace sge
             return NewResourceResult::ERROR_RESOURCE_EXISTS;
         }
 
-        // Initialize the resource object
-        auto* resource = Resource::create_resource_object(type);
-        //resource->callback_lock.lock();
-
-        // Add it to the resource map
-        _resources.insert(std::make_pair(uri, resource));
         _resources_lock.unlock();
 
-        // Add this callback to the writers callback
-        //resource->write_callbacks.push_back(std::move(writeFn));
+        // Construct the resource with the write callback (there are no loader threads, so this runs on the calling thread)
+        auto* resource = Resource::create_resource_object(type);
+        writeFn(resource->object());
+        resource->version = Resource::VERSION_INITIALIZED;
+        resource->version_last_modified = Resource::VERSION_INITIALIZED;
 
-        // Unlock the resource's callbacks
-        //resource->callback_lock.unlock();
+        // Add it to the resource map, unless it was created while the write callback ran
+        _resources_lock.lock();
+        if (!_resources.insert(std::make_pair(id, resource)).second)
+        {
+            _resources_lock.unlock();
+            Resource::destroy_resource_object(resource);
+            return NewResourceResult::ERROR_RESOURCE_EXISTS;
+        }
+        _resources_lock.unlock();
 
         return NewResourceResult::SUCCESS;
     }
@@ -170,9 +184,9 @@ namespace sge
     //  return AccessResourceResult::SUCCESS;
     //}
 
-    ResourceManager::Resource* ResourceManager::get_resource(const std::string& uri)
+    ResourceManager::Resource* ResourceManager::get_resource(PathId id)
     {
-        auto iter = _resources.find(uri);
+        auto iter = _resources.find(id);
         return iter == _resources.end() ? nullptr : iter->second;
     }
 }
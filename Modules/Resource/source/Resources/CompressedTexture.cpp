@@ -0,0 +1,256 @@
+// CompressedTexture.cpp
+
+#include <algorithm>
+#include <cstring>
+#include <Core/Reflection/ReflectionBuilder.h>
+#include <Core/Interfaces/IToArchive.h>
+#include <Core/Interfaces/IFromArchive.h>
+#include "../../include/Resource/Resources/CompressedTexture.h"
+#include "../../include/Resource/Interfaces/IFromFile.h"
+#include "../../include/Resource/Archives/BinaryArchive.h"
+
+SGE_REFLECT_TYPE(sge::CompressedTexture)
+.flags(TF_SCRIPT_NOCONSTRUCT)
+.implements<IToArchive>()
+.implements<IFromArchive>()
+.implements<IFromFile>();
+
+namespace sge
+{
+    /* Extension appended to a source image's path to get the path of its cooked version (binary archives must end in ".sbin"). */
+    static constexpr const char COOKED_TEXTURE_EXTENSION[] = ".ctex.sbin";
+
+    CompressedTexture::CompressedTexture()
+        : _format(texture_compression::BlockFormat::BC1),
+        _color_space(Texture::ColorSpace::S_RGB)
+    {
+    }
+
+    void CompressedTexture::to_archive(ArchiveWriter& writer) const
+    {
+        const int32 width = _mips.empty() ? 0 : _mips.front().width;
+        const int32 height = _mips.empty() ? 0 : _mips.front().height;
+
+        writer.object_member("fmt", static_cast<uint32>(_format));
+        writer.object_member("clsp", static_cast<uint32>(_color_space));
+        writer.object_member("wdth", width);
+        writer.object_member("hght", height);
+        writer.object_member("nmip", static_cast<uint32>(_mips.size()));
+
+        writer.push_object_member("data");
+        writer.typed_array(_data.data(), _data.size());
+        writer.pop();
+    }
+
+    void CompressedTexture::from_archive(ArchiveReader& reader)
+    {
+        uint32 format = 0;
+        uint32 color_space = 0;
+        int32 width = 0;
+        int32 height = 0;
+        uint32 num_mips = 0;
+        _mips.clear();
+        _data.clear();
+
+        reader.enumerate_object_members([&](const char* mem_name)
+        {
+            if (std::strcmp(mem_name, "fmt") == 0)
+            {
+                reader.number(format);
+            }
+            else if (std::strcmp(mem_name, "clsp") == 0)
+            {
+                reader.number(color_space);
+            }
+            else if (std::strcmp(mem_name, "wdth") == 0)
+            {
+                reader.number(width);
+            }
+            else if (std::strcmp(mem_name, "hght") == 0)
+            {
+                reader.number(height);
+            }
+            else if (std::strcmp(mem_name, "nmip") == 0)
+            {
+                reader.number(num_mips);
+            }
+            else if (std::strcmp(mem_name, "data") == 0)
+            {
+                // Copy the blocks straight out of the archive, if it can hand them out in place
+                const byte* view = nullptr;
+                std::size_t size = 0;
+                if (reader.typed_array_view(view, size))
+                {
+                    this->_data.assign(view, view + size);
+                    return;
+                }
+
+                const auto got_size = reader.array_size(size);
+                assert(got_size);
+
+                this->_data.assign(size, 0);
+                const auto read_size = reader.typed_array(this->_data.data(), size);
+                assert(read_size == size);
+            }
+        });
+
+        _format = static_cast<texture_compression::BlockFormat>(format);
+        _color_space = static_cast<Texture::ColorSpace>(color_space);
+
+        // Lay out the mip chain, and make sure the data covers it
+        std::size_t offset = 0;
+        for (uint32 level = 0; level < num_mips && width > 0 && height > 0; ++level)
+        {
+            Mip mip;
+            mip.width = width;
+            mip.height = height;
+            mip.offset = offset;
+            mip.size = texture_compression::compressed_size(_format, width, height);
+            _mips.push_back(mip);
+
+            offset += mip.size;
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+
+        if (offset != _data.size())
+        {
+            _mips.clear();
+            _data.clear();
+        }
+    }
+
+    bool CompressedTexture::from_file(const char* path)
+    {
+        BinaryArchive bin;
+        if (!bin.map_file(path))
+        {
+            return false;
+        }
+
+        auto* reader = bin.read_root();
+        from_archive(*reader);
+        reader->pop();
+        return !_mips.empty();
+    }
+
+    bool CompressedTexture::to_file(const char* path) const
+    {
+        BinaryArchive bin;
+        auto* writer = bin.write_root();
+        to_archive(*writer);
+        writer->pop();
+        return bin.to_file(path);
+    }
+
+    void CompressedTexture::cook(const Texture& source, texture_compression::BlockFormat format, TaskPool* pool)
+    {
+        using namespace texture_compression;
+
+        _format = format;
+        _color_space = format == BlockFormat::BC5 ? Texture::ColorSpace::RGB : source.color_space();
+        _mips.clear();
+        _data.clear();
+
+        int32 width = static_cast<int32>(source.image.get_width());
+        int32 height = static_cast<int32>(source.image.get_height());
+        if (width == 0 || height == 0)
+        {
+            return;
+        }
+
+        MipFilter filter = MipFilter::LINEAR;
+        if (format == BlockFormat::BC5)
+        {
+            filter = MipFilter::NORMAL;
+        }
+        else if (_color_space == Texture::ColorSpace::S_RGB)
+        {
+            filter = MipFilter::S_RGB;
+        }
+
+        // Lay out the mip chain
+        const auto num_levels = num_mip_levels(width, height);
+        std::size_t offset = 0;
+        for (int32 level = 0, level_width = width, level_height = height; level < num_levels; ++level)
+        {
+            Mip mip;
+            mip.width = level_width;
+            mip.height = level_height;
+            mip.offset = offset;
+            mip.size = compressed_size(format, level_width, level_height);
+            _mips.push_back(mip);
+
+            offset += mip.size;
+            level_width = std::max(level_width / 2, 1);
+            level_height = std::max(level_height / 2, 1);
+        }
+        _data.assign(offset, 0);
+
+        // Compress each level, filtering it down to get the next
+        const auto* const bitmap = source.image.get_bitmap();
+        std::vector<byte> level_pixels(bitmap, bitmap + std::size_t(width) * height * 4);
+        std::vector<byte> next_level_pixels;
+        for (const auto& mip : _mips)
+        {
+            compress_image(format, level_pixels.data(), mip.width, mip.height, _data.data() + mip.offset, pool);
+
+            if (mip.width > 1 || mip.height > 1)
+            {
+                next_level_pixels.resize(std::size_t(std::max(mip.width / 2, 1)) * std::max(mip.height / 2, 1) * 4);
+                generate_mip(level_pixels.data(), mip.width, mip.height, filter, next_level_pixels.data());
+                level_pixels.swap(next_level_pixels);
+            }
+        }
+    }
+
+    std::string CompressedTexture::cooked_path(const char* source_path)
+    {
+        return std::string{ source_path } + COOKED_TEXTURE_EXTENSION;
+    }
+
+    texture_compression::BlockFormat CompressedTexture::default_format(const Texture& source)
+    {
+        const auto* const bitmap = source.image.get_bitmap();
+        const std::size_t num_pixels = std::size_t(source.image.get_width()) * source.image.get_height();
+        for (std::size_t i = 0; i < num_pixels; ++i)
+        {
+            if (bitmap[i * 4 + 3] != 255)
+            {
+                return texture_compression::BlockFormat::BC7;
+            }
+        }
+
+        return texture_compression::BlockFormat::BC1;
+    }
+
+    texture_compression::BlockFormat CompressedTexture::format() const
+    {
+        return _format;
+    }
+
+    Texture::ColorSpace CompressedTexture::color_space() const
+    {
+        return _color_space;
+    }
+
+    std::size_t CompressedTexture::num_mips() const
+    {
+        return _mips.size();
+    }
+
+    const CompressedTexture::Mip& CompressedTexture::mip(std::size_t level) const
+    {
+        return _mips[level];
+    }
+
+    const byte* CompressedTexture::data() const
+    {
+        return _data.data();
+    }
+
+    std::size_t CompressedTexture::data_size() const
+    {
+        return _data.size();
+    }
+}
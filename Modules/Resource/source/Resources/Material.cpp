@@ -1,6 +1,8 @@
 // Material.cpp
 
 #include <Core/Reflection/ReflectionBuilder.h>
+#include <Core/Util/StringUtils.h>
+#include "../../include/Resource/Archives/BinaryArchive.h"
 #include "../../include/Resource/Archives/JsonArchive.h"
 #include "../../include/Resource/Interfaces/IFromFile.h"
 #include "../../include/Resource/Resources/Material.h"
@@ -13,6 +15,9 @@ SGE_REFLECT_TYPE(sge::Material)
 
 namespace sge
 {
+    /* Extension appended to a source material's path to get the path of its cooked version. */
+    static constexpr const char COOKED_MATERIAL_EXTENSION[] = ".cmat.sbin";
+
     void Material::ParamTable::to_archive(ArchiveWriter& writer) const
     {
         for (const auto& param : bool_params)
@@ -114,6 +119,18 @@ namespace sge
 
     bool Material::from_file(const char* path)
     {
+        if (string_ends_with(path, ".sbin"))
+        {
+            BinaryArchive archive;
+            if (!archive.map_file(path))
+            {
+                return false;
+            }
+
+            archive.deserialize_root(*this);
+            return true;
+        }
+
         JsonArchive archive;
         if (!archive.from_file(path))
         {
@@ -124,6 +141,25 @@ namespace sge
         return true;
     }
 
+    bool Material::to_file(const char* path) const
+    {
+        if (string_ends_with(path, ".sbin"))
+        {
+            BinaryArchive archive;
+            archive.serialize_root(*this);
+            return archive.to_file(path);
+        }
+
+        JsonArchive archive;
+        archive.serialize_root(*this);
+        return archive.to_file(path);
+    }
+
+    std::string Material::cooked_path(const char* source_path)
+    {
+        return std::string{ source_path } + COOKED_MATERIAL_EXTENSION;
+    }
+
     void Material::to_archive(ArchiveWriter& writer) const
     {
         writer.object_member("vertex_shader", _vertex_shader);
@@ -1,10 +1,12 @@
 // StaticMesh.cpp
 
+#include <algorithm>
 #include <fstream>
 #include <Core/Reflection/ReflectionBuilder.h>
 #include "../../include/Resource/Resources/StaticMesh.h"
 #include "../../include/Resource/Interfaces/IFromFile.h"
 #include "../../include/Resource/Archives/BinaryArchive.h"
+#include "../../include/Resource/Misc/MeshOps.h"
 
 SGE_REFLECT_TYPE(sge::StaticMesh)
 .flags(TF_SCRIPT_NOCONSTRUCT)
@@ -14,6 +16,72 @@ SGE_REFLECT_TYPE(sge::StaticMesh)
 
 namespace sge
 {
+    /* Extension appended to a source mesh's path to get the path of its cooked version. */
+    static constexpr const char COOKED_MESH_EXTENSION[] = ".cmesh.sbin";
+
+    /* The fraction of the previous LOD's triangles each LOD aims for. */
+    static constexpr float LOD_TRIANGLE_RATIO = 0.5f;
+
+    /* LOD generation stops once a LOD keeps more than this fraction of the previous LOD's triangles. */
+    static constexpr float LOD_MIN_REDUCTION = 0.9f;
+
+    /* The largest error a single LOD may introduce, relative to the diagonal of the mesh bounds. */
+    static constexpr float LOD_MAX_RELATIVE_ERROR = 0.05f;
+
+    /**
+     * \brief Reads the typed array at the reader's current node into the given vector, with each 'components' elements of the array making up one value.
+     * If the reader can hand out the array in place (as from a mapped archive), values are copied straight out of it rather than zero-filled and then overwritten.
+     * \return The number of array elements read.
+     */
+    template <typename E, typename T>
+    static std::size_t read_typed_array(
+        ArchiveReader& reader,
+        std::vector<T>& out,
+        std::size_t components,
+        const T& zero)
+    {
+        const E* view = nullptr;
+        std::size_t size = 0;
+        if (reader.typed_array_view(view, size))
+        {
+            const auto* const first = reinterpret_cast<const T*>(view);
+            out.assign(first, first + size / components);
+            return size;
+        }
+
+        if (!reader.array_size(size))
+        {
+            out.clear();
+            return 0;
+        }
+
+        out.assign(size / components, zero);
+        return reader.typed_array(reinterpret_cast<E*>(out.data()), size);
+    }
+
+    template <typename T>
+    static void remap_vertex_array(
+        std::vector<T>& verts,
+        const uint32* remap,
+        std::size_t new_num_verts)
+    {
+        if (verts.empty())
+        {
+            return;
+        }
+
+        std::vector<T> result(new_num_verts, verts.front());
+        for (std::size_t i = 0; i < verts.size(); ++i)
+        {
+            if (remap[i] != ~uint32{ 0 })
+            {
+                result[remap[i]] = verts[i];
+            }
+        }
+
+        verts = std::move(result);
+    }
+
     void StaticMesh::Material::to_archive(ArchiveWriter& writer) const
     {
         writer.object_member("path", _path);
@@ -59,6 +127,78 @@ namespace sge
         return _num_elem_indices;
     }
 
+    void StaticMesh::Lod::to_archive(ArchiveWriter& writer) const
+    {
+        writer.object_member("err", _error);
+
+        writer.push_object_member("elem");
+        writer.typed_array(_triangle_elements.data(), _triangle_elements.size());
+        writer.pop();
+
+        writer.push_object_member("mcnt");
+        writer.typed_array(_material_elem_counts.data(), _material_elem_counts.size());
+        writer.pop();
+    }
+
+    void StaticMesh::Lod::from_archive(ArchiveReader& reader)
+    {
+        _error = 0.f;
+        _triangle_elements.clear();
+        _material_elem_counts.clear();
+
+        reader.enumerate_object_members([this, &reader](const char* mem_name)
+        {
+            if (std::strcmp(mem_name, "err") == 0)
+            {
+                reader.number(this->_error);
+            }
+            else if (std::strcmp(mem_name, "elem") == 0)
+            {
+                std::size_t size = 0;
+                const auto got_size = reader.array_size(size);
+                assert(got_size);
+
+                const auto read_size = read_typed_array<uint32>(reader, this->_triangle_elements, 1, uint32(0));
+                assert(read_size == size);
+            }
+            else if (std::strcmp(mem_name, "mcnt") == 0)
+            {
+                std::size_t size = 0;
+                const auto got_size = reader.array_size(size);
+                assert(got_size);
+
+                this->_material_elem_counts.assign(size, 0);
+                const auto read_size = reader.typed_array(this->_material_elem_counts.data(), size);
+                assert(read_size == size);
+            }
+        });
+    }
+
+    float StaticMesh::Lod::error() const
+    {
+        return _error;
+    }
+
+    std::size_t StaticMesh::Lod::num_triangle_elements() const
+    {
+        return _triangle_elements.size();
+    }
+
+    const uint32* StaticMesh::Lod::triangle_elements() const
+    {
+        if (_triangle_elements.empty())
+        {
+            return nullptr;
+        }
+
+        return _triangle_elements.data();
+    }
+
+    const std::vector<uint32>& StaticMesh::Lod::material_elem_counts() const
+    {
+        return _material_elem_counts;
+    }
+
     StaticMesh::StaticMesh()
     {
     }
@@ -112,6 +252,19 @@ namespace sge
             writer.pop();
         }
         writer.pop();
+
+        // Write LODs
+        if (!_lods.empty())
+        {
+            writer.push_object_member("lods");
+            for (const auto& lod : _lods)
+            {
+                writer.push_array_element();
+                lod.to_archive(writer);
+                writer.pop();
+            }
+            writer.pop();
+        }
     }
 
     void StaticMesh::from_archive(ArchiveReader& reader)
@@ -124,6 +277,7 @@ namespace sge
         _lightmap_uv.clear();
         _triangle_elements.clear();
         _materials.clear();
+        _lods.clear();
 
         std::size_t num_verts = 0;
         reader.enumerate_object_members([this, &reader, &num_verts](const char* mem_name)
@@ -137,8 +291,7 @@ namespace sge
                 num_verts = size / 3;
 
                 // Get vertex positions array
-                this->_vertex_positions.assign(size / 3, Vec3::zero());
-                const auto read_size = reader.typed_array(this->_vertex_positions.data()->vec(), size);
+                const auto read_size = read_typed_array<float>(reader, this->_vertex_positions, 3, Vec3::zero());
                 assert(read_size == size);
             }
             else if (std::strcmp(mem_name, "vnor") == 0)
@@ -150,8 +303,7 @@ namespace sge
                 num_verts = size / 3;
 
                 // Get vertex normals array
-                this->_vertex_normals.assign(size / 3, HalfVec3::zero());
-                const auto read_size = reader.typed_array(this->_vertex_normals.data()->vec(), size);
+                const auto read_size = read_typed_array<int16>(reader, this->_vertex_normals, 3, HalfVec3::zero());
                 assert(read_size == size);
             }
             else if (std::strcmp(mem_name, "vtan") == 0)
@@ -163,8 +315,7 @@ namespace sge
                 num_verts = size / 3;
 
                 // Get vertex tangents
-                this->_vertex_tangents.assign(size / 3, HalfVec3::zero());
-                const auto read_size = reader.typed_array(this->_vertex_tangents.data()->vec(), size);
+                const auto read_size = read_typed_array<int16>(reader, this->_vertex_tangents, 3, HalfVec3::zero());
                 assert(read_size == size);
             }
             else if (std::strcmp(mem_name, "vbts") == 0)
@@ -176,8 +327,7 @@ namespace sge
                 num_verts = size;
 
                 // Get vertex bitangent signs
-                this->_bitangent_signs.assign(size, 0);
-                const auto read_size = reader.typed_array(this->_bitangent_signs.data(), size);
+                const auto read_size = read_typed_array<int8>(reader, this->_bitangent_signs, 1, int8(0));
                 assert(read_size == size);
             }
             else if (std::strcmp(mem_name, "mtuv") == 0)
@@ -189,8 +339,7 @@ namespace sge
                 num_verts = size / 2;
 
                 // Get uvs
-                this->_material_uv.assign(size / 2, UHalfVec2::zero());
-                const auto read_size = reader.typed_array(this->_material_uv.data()->vec(), size);
+                const auto read_size = read_typed_array<uint16>(reader, this->_material_uv, 2, UHalfVec2::zero());
                 assert(read_size == size);
             }
             else if (std::strcmp(mem_name, "lmuv") == 0)
@@ -202,8 +351,7 @@ namespace sge
                 num_verts = size / 2;
 
                 // Get uvs
-                this->_lightmap_uv.assign(size / 2, UHalfVec2::zero());
-                const auto read_size = reader.typed_array(this->_lightmap_uv.data()->vec(), size);
+                const auto read_size = read_typed_array<uint16>(reader, this->_lightmap_uv, 2, UHalfVec2::zero());
                 assert(read_size == size);
             }
             else if (std::strcmp(mem_name, "elem") == 0)
@@ -214,8 +362,7 @@ namespace sge
                 assert(got_size);
 
                 // Get elements
-                this->_triangle_elements.assign(size, 0);
-                const auto read_size = reader.typed_array(this->_triangle_elements.data(), size);
+                const auto read_size = read_typed_array<uint32>(reader, this->_triangle_elements, 1, uint32(0));
                 assert(read_size == size);
             }
             else if (std::strcmp(mem_name, "mats") == 0)
@@ -236,16 +383,36 @@ namespace sge
                     this->_materials.push_back(std::move(mat));
                 });
             }
+            else if (std::strcmp(mem_name, "lods") == 0)
+            {
+                std::size_t size = 0;
+                const auto got_size = reader.array_size(size);
+                assert(got_size);
+
+                this->_lods.reserve(size);
+                reader.enumerate_array_elements([this, &reader](std::size_t /*i*/)
+                {
+                    Lod lod;
+                    lod.from_archive(reader);
+                    this->_lods.push_back(std::move(lod));
+                });
+            }
         });
     }
 
     bool StaticMesh::from_file(const char* path)
+    {
+        return from_file(path, nullptr);
+    }
+
+    bool StaticMesh::from_file(const char* path, TaskPool* pool)
     {
         BinaryArchive bin;
-        if (!bin.from_file(path))
+        if (!bin.map_file(path))
         {
             return false;
         }
+        bin.set_task_pool(pool);
 
         auto* reader = bin.read_root();
         from_archive(*reader);
@@ -253,6 +420,164 @@ namespace sge
         return true;
     }
 
+    bool StaticMesh::to_file(const char* path) const
+    {
+        BinaryArchive bin;
+        auto* writer = bin.write_root();
+        to_archive(*writer);
+        writer->pop();
+        bin.set_file_compression(true);
+        return bin.to_file(path);
+    }
+
+    std::string StaticMesh::cooked_path(const char* source_path)
+    {
+        return std::string{ source_path } + COOKED_MESH_EXTENSION;
+    }
+
+    void StaticMesh::optimize()
+    {
+        const auto num_verts = _vertex_positions.size();
+        const auto optimize_range = [this, num_verts](std::size_t start, std::size_t count)
+        {
+            start = std::min(start, _triangle_elements.size());
+            count = std::min(count, _triangle_elements.size() - start);
+
+            auto* const elements = _triangle_elements.data() + start;
+            mesh_ops::optimize_vertex_cache(elements, count, num_verts);
+            mesh_ops::optimize_overdraw(elements, count, _vertex_positions.data(), num_verts, mesh_ops::OVERDRAW_ACMR_THRESHOLD);
+        };
+
+        // Triangles are only reordered within each material, so that material ranges stay intact
+        if (_materials.empty())
+        {
+            optimize_range(0, _triangle_elements.size());
+        }
+        for (const auto& mat : _materials)
+        {
+            optimize_range(mat.start_elem_index(), mat.num_elem_indices());
+        }
+
+        // LODs are drawn from a distance, so only optimize them for the vertex cache
+        for (auto& lod : _lods)
+        {
+            std::size_t start = 0;
+            for (const auto count : lod._material_elem_counts)
+            {
+                mesh_ops::optimize_vertex_cache(lod._triangle_elements.data() + start, count, num_verts);
+                start += count;
+            }
+        }
+
+        // Reorder vertices to match. LODs only reference vertices of the full detail mesh, so they don't affect the order.
+        std::vector<uint32> remap(num_verts);
+        const auto new_num_verts = mesh_ops::optimize_vertex_fetch(_triangle_elements.data(), _triangle_elements.size(), num_verts, remap.data());
+        for (auto& lod : _lods)
+        {
+            for (auto& elem : lod._triangle_elements)
+            {
+                elem = remap[elem];
+            }
+        }
+        remap_vertex_array(_vertex_positions, remap.data(), new_num_verts);
+        remap_vertex_array(_vertex_normals, remap.data(), new_num_verts);
+        remap_vertex_array(_vertex_tangents, remap.data(), new_num_verts);
+        remap_vertex_array(_bitangent_signs, remap.data(), new_num_verts);
+        remap_vertex_array(_material_uv, remap.data(), new_num_verts);
+        remap_vertex_array(_lightmap_uv, remap.data(), new_num_verts);
+    }
+
+    void StaticMesh::generate_lods(std::size_t max_lods)
+    {
+        _lods.clear();
+        const auto num_verts = _vertex_positions.size();
+        if (num_verts == 0 || _triangle_elements.empty())
+        {
+            return;
+        }
+
+        // Gather triangles in material order, tagging each with its material
+        std::vector<uint32> elements;
+        std::vector<uint32> groups;
+        const auto add_range = [this, &elements, &groups](std::size_t start, std::size_t count, uint32 group)
+        {
+            start = std::min(start, _triangle_elements.size());
+            count = std::min(count, _triangle_elements.size() - start) / 3 * 3;
+
+            elements.insert(elements.end(), _triangle_elements.begin() + start, _triangle_elements.begin() + start + count);
+            groups.insert(groups.end(), count / 3, group);
+        };
+
+        if (_materials.empty())
+        {
+            add_range(0, _triangle_elements.size(), 0);
+        }
+        for (std::size_t i = 0; i < _materials.size(); ++i)
+        {
+            add_range(_materials[i].start_elem_index(), _materials[i].num_elem_indices(), static_cast<uint32>(i));
+        }
+
+        // Compute the error bound from the mesh bounds
+        auto min = _vertex_positions.front();
+        auto max = _vertex_positions.front();
+        for (const auto& pos : _vertex_positions)
+        {
+            min = Vec3{ std::min(min.x(), pos.x()), std::min(min.y(), pos.y()), std::min(min.z(), pos.z()) };
+            max = Vec3{ std::max(max.x(), pos.x()), std::max(max.y(), pos.y()), std::max(max.z(), pos.z()) };
+        }
+        const auto max_error = (max - min).length() * LOD_MAX_RELATIVE_ERROR;
+
+        // Each LOD is simplified from the previous one
+        const auto num_groups = std::max<std::size_t>(_materials.size(), 1);
+        std::vector<uint32> out_elements(elements.size());
+        std::vector<uint32> out_groups(groups.size());
+        float total_error = 0.f;
+        while (_lods.size() < max_lods)
+        {
+            const auto target = static_cast<std::size_t>(elements.size() / 3 * LOD_TRIANGLE_RATIO) * 3;
+            float error = 0.f;
+            const auto num_elements = mesh_ops::simplify(
+                elements.data(),
+                elements.size(),
+                groups.data(),
+                _vertex_positions.data(),
+                num_verts,
+                target,
+                max_error,
+                out_elements.data(),
+                out_groups.data(),
+                &error);
+
+            if (num_elements == 0 || num_elements > elements.size() * LOD_MIN_REDUCTION)
+            {
+                break;
+            }
+
+            elements.assign(out_elements.begin(), out_elements.begin() + num_elements);
+            groups.assign(out_groups.begin(), out_groups.begin() + num_elements / 3);
+            total_error += error;
+
+            Lod lod;
+            lod._error = total_error;
+            lod._triangle_elements = elements;
+            lod._material_elem_counts.assign(num_groups, 0);
+            for (const auto group : groups)
+            {
+                lod._material_elem_counts[group] += 3;
+            }
+
+            // Simplification preserves triangle order, so each material's elements are still contiguous
+            std::size_t start = 0;
+            for (const auto count : lod._material_elem_counts)
+            {
+                mesh_ops::optimize_vertex_cache(lod._triangle_elements.data() + start, count, num_verts);
+                start += count;
+            }
+
+            _lods.push_back(std::move(lod));
+        }
+    }
+
     std::size_t StaticMesh::num_verts() const
     {
         return _vertex_positions.size();
@@ -347,4 +672,14 @@ namespace sge
     {
         return _materials.data();
     }
+
+    std::size_t StaticMesh::num_lods() const
+    {
+        return _lods.size();
+    }
+
+    const StaticMesh::Lod* StaticMesh::lods() const
+    {
+        return _lods.data();
+    }
 }
@@ -227,9 +227,7 @@ int main(int argc, char* argv[])
 	std::string scene_path;
 	if (config_reader->object_member("scene", scene_path))
 	{
-		sge::JsonArchive scene_archive;
-		scene_archive.from_file(scene_path.c_str());
-		scene_archive.deserialize_root(scene);
+		scene.from_file(scene_path.c_str());
 	}
 
     // Store the last time we printed out frame time
@@ -267,10 +265,8 @@ int main(int argc, char* argv[])
 			renderSystem.reset();
 			change_level_system.reset();
 
-			// Load new scene
-			sge::JsonArchive scene_archive;
-			scene_archive.from_file(change_level_target.c_str());
-			scene_archive.deserialize_root(scene);
+			// Load new scene (cooked, if it's been cooked)
+			scene.from_file(change_level_target.c_str());
 		}
 
 		glfwSwapBuffers(window);
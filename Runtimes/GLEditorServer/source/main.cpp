@@ -121,9 +121,13 @@ int main(int argc, char* argv[])
 	std::string scene_path;
 	if (config_reader->object_member("scene", scene_path))
 	{
-		sge::JsonArchive scene_archive;
-		scene_archive.from_file(scene_path.c_str());
-		scene_archive.deserialize_root(scene);
+		// The editor always loads the source scene, since cooked scenes may be out of date
+		auto* scene_reader = sge::JsonArchive::stream_from_file(scene_path.c_str());
+		if (scene_reader)
+		{
+			scene.from_archive(*scene_reader);
+			scene_reader->pop();
+		}
 	}
 
 	// Loop until the user closes the window
@@ -0,0 +1,520 @@
+// main.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <Core/Math/Quat.h>
+#include <Core/Reflection/TypeDB.h>
+#include <Resource/Archives/JsonArchive.h>
+#include <Engine/Scene.h>
+#include <Engine/SystemFrame.h>
+#include <Engine/UpdatePipeline.h>
+#include <Engine/Components/Display/CCamera.h>
+#include <Engine/Systems/AnimationSystem.h>
+#include <GLRender/GLRenderSystem.h>
+#include <GLRender/Config.h>
+
+/**
+ * \brief A point on the scripted camera path. The camera moves linearly between points, looking at 'target'.
+ */
+struct CameraKey
+{
+	float time = 0.f;
+	sge::Vec3 position;
+	sge::Vec3 target;
+};
+
+/**
+ * \brief The offscreen framebuffer the render system draws its final image into, in place of a window's framebuffer.
+ */
+struct OffscreenTarget
+{
+	GLuint framebuffer = 0;
+	GLuint color_buffer = 0;
+	GLuint depth_stencil_buffer = 0;
+};
+
+static bool has_extension(
+	const char* extensions,
+	const char* name)
+{
+	if (!extensions)
+	{
+		return false;
+	}
+
+	const auto name_len = std::strlen(name);
+	for (const char* ext = std::strstr(extensions, name); ext; ext = std::strstr(ext + name_len, name))
+	{
+		// Make sure this isn't just a prefix of another extension
+		if ((ext == extensions || ext[-1] == ' ') && (ext[name_len] == ' ' || ext[name_len] == '\0'))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * \brief Creates an OpenGL 4.3 core context without a window, and makes it current.
+ * Uses Mesa's surfaceless platform when available (which works with the software rasterizer), otherwise the default display,
+ * and a 1x1 pbuffer when surfaceless contexts aren't supported. All rendering goes to an offscreen framebuffer either way.
+ */
+static bool create_headless_context(
+	EGLDisplay& out_display,
+	EGLContext& out_context)
+{
+	out_display = EGL_NO_DISPLAY;
+	const char* const client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	const auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (get_platform_display && has_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+	{
+		out_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+#endif
+
+	if (out_display == EGL_NO_DISPLAY)
+	{
+		out_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if (out_display == EGL_NO_DISPLAY || !eglInitialize(out_display, &major, &minor))
+	{
+		std::cerr << "Could not initialize EGL." << std::endl;
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cerr << "EGL implementation does not support desktop OpenGL." << std::endl;
+		return false;
+	}
+
+	// Choose a config (only pbuffer support matters, since nothing is presented)
+	const bool surfaceless = has_extension(eglQueryString(out_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE };
+	EGLConfig config;
+	EGLint num_configs = 0;
+	if (!eglChooseConfig(out_display, config_attribs, &config, 1, &num_configs) || num_configs == 0)
+	{
+		std::cerr << "Could not find a suitable EGL config." << std::endl;
+		return false;
+	}
+
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE };
+	out_context = eglCreateContext(out_display, config, EGL_NO_CONTEXT, context_attribs);
+	if (out_context == EGL_NO_CONTEXT)
+	{
+		std::cerr << "Could not create an OpenGL 4.3 core context." << std::endl;
+		return false;
+	}
+
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!surfaceless)
+	{
+		const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surface = eglCreatePbufferSurface(out_display, config, pbuffer_attribs);
+	}
+
+	if (!eglMakeCurrent(out_display, surface, surface, out_context))
+	{
+		std::cerr << "Could not make the OpenGL context current." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+static OffscreenTarget create_offscreen_target(
+	int width,
+	int height)
+{
+	OffscreenTarget target;
+	glGenFramebuffers(1, &target.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+
+	glGenRenderbuffers(1, &target.color_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, target.color_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.color_buffer);
+
+	glGenRenderbuffers(1, &target.depth_stencil_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, target.depth_stencil_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target.depth_stencil_buffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Could not create the offscreen framebuffer." << std::endl;
+	}
+
+	return target;
+}
+
+/**
+ * \brief Writes the contents of the given framebuffer to a binary PPM file.
+ */
+static void dump_frame(
+	GLuint framebuffer,
+	int width,
+	int height,
+	const std::string& path)
+{
+	std::vector<unsigned char> pixels(static_cast<std::size_t>(width) * height * 3);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	std::ofstream file{ path, std::ios::binary };
+	file << "P6\n" << width << " " << height << "\n255\n";
+
+	// GL rows go bottom to top
+	for (int y = height - 1; y >= 0; --y)
+	{
+		file.write(reinterpret_cast<const char*>(pixels.data() + static_cast<std::size_t>(y) * width * 3), width * 3);
+	}
+}
+
+static void read_camera_path(
+	sge::ArchiveReader& reader,
+	std::vector<CameraKey>& out_path)
+{
+	reader.enumerate_array_elements([&reader, &out_path](std::size_t /*i*/)
+	{
+		CameraKey key;
+		reader.object_member("time", key.time);
+		reader.object_member("position", key.position);
+		reader.object_member("target", key.target);
+		out_path.push_back(key);
+	});
+
+	std::stable_sort(out_path.begin(), out_path.end(), [](const CameraKey& lhs, const CameraKey& rhs) {
+		return lhs.time < rhs.time;
+	});
+}
+
+/**
+ * \brief Moves the given camera node to its position on the path at the given time.
+ * The path is relative to the camera's parent, if it has one.
+ */
+static void apply_camera_path(
+	const std::vector<CameraKey>& path,
+	float time,
+	sge::Node& camera_node)
+{
+	if (path.empty())
+	{
+		return;
+	}
+
+	// Find the segment containing this time
+	std::size_t next = 0;
+	while (next < path.size() && path[next].time <= time)
+	{
+		++next;
+	}
+
+	const auto& a = path[next == 0 ? 0 : next - 1];
+	const auto& b = path[next == path.size() ? path.size() - 1 : next];
+	const float span = b.time - a.time;
+	const float t = span > 0.f ? std::min(std::max((time - a.time) / span, 0.f), 1.f) : 0.f;
+	const auto position = a.position + (b.position - a.position) * t;
+	const auto target = a.target + (b.target - a.target) * t;
+
+	// Cameras look down -Z, so turn about Y and then tilt about X to face the target
+	const auto dir = (target - position).normalized();
+	const auto yaw = std::atan2(-dir.x(), -dir.z());
+	const auto pitch = std::asin(std::min(std::max(dir.y(), -1.f), 1.f));
+
+	camera_node.set_local_position(position);
+	camera_node.set_local_rotation(sge::Quat{ sge::Vec3::up(), sge::Angle{ yaw } } * sge::Quat{ sge::Vec3::right(), sge::Angle{ pitch } });
+}
+
+static double percentile(
+	std::vector<double> values,
+	double p)
+{
+	if (values.empty())
+	{
+		return 0.0;
+	}
+
+	std::sort(values.begin(), values.end());
+	const auto index = static_cast<std::size_t>(std::ceil(p * values.size())) - 1;
+	return values[std::min(index, values.size() - 1)];
+}
+
+static void print_summary(
+	const char* name,
+	const std::vector<double>& values)
+{
+	double total = 0.0;
+	for (auto value : values)
+	{
+		total += value;
+	}
+
+	const double mean = values.empty() ? 0.0 : total / values.size();
+	std::printf("%-8s mean %8.3fms  median %8.3fms  p95 %8.3fms  max %8.3fms\n",
+		name,
+		mean,
+		percentile(values, 0.5),
+		percentile(values, 0.95),
+		percentile(values, 1.0));
+}
+
+int main(int argc, char* argv[])
+{
+	// Make sure we have a config file
+	if (argc != 2)
+	{
+		std::cerr << "Usage: GLHeadless <config.json>" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	sge::JsonArchive config;
+	if (!config.from_file(argv[1]))
+	{
+		std::cerr << "Could not load config file '" << argv[1] << "'." << std::endl;
+		return EXIT_FAILURE;
+	}
+	auto* config_reader = config.read_root();
+
+	// Read capture settings
+	int warmup_frames = 30;
+	int num_frames = 300;
+	float frame_time = 0.016f;
+	std::string dump_frames_dir;
+	std::string timings_csv;
+	std::vector<CameraKey> camera_path;
+	config_reader->object_member("warmup_frames", warmup_frames);
+	config_reader->object_member("num_frames", num_frames);
+	config_reader->object_member("frame_time", frame_time);
+	config_reader->object_member("dump_frames_dir", dump_frames_dir);
+	config_reader->object_member("timings_csv", timings_csv);
+	if (config_reader->pull_object_member("camera_path"))
+	{
+		read_camera_path(*config_reader, camera_path);
+		config_reader->pop();
+	}
+
+	// Create the context
+	EGLDisplay display;
+	EGLContext context;
+	if (!create_headless_context(display, context))
+	{
+		return EXIT_FAILURE;
+	}
+
+	glewExperimental = GL_TRUE;
+	glewInit();
+	glGetError(); // Without a GLX display, GLEW reports an error after loading core entry points; pop it off the stack.
+
+	// Create a render config
+	sge::gl_render::Config render_config;
+	render_config.viewport_width = 1280;
+	render_config.viewport_height = 720;
+	if (!config_reader->object_member("gl_render", render_config))
+	{
+		std::cerr << "Could not load render config from the config file." << std::endl;
+		return EXIT_FAILURE;
+	}
+	config_reader->object_member("viewport_width", render_config.viewport_width);
+	config_reader->object_member("viewport_height", render_config.viewport_height);
+	const int width = render_config.viewport_width;
+	const int height = render_config.viewport_height;
+
+	// The render system presents to whichever framebuffer is bound when it's created
+	const auto target = create_offscreen_target(width, height);
+	glViewport(0, 0, width, height);
+
+	// Create a type database
+	sge::TypeDB type_db;
+	type_db.new_type<sge::Vec3>();
+	type_db.new_type<sge::Quat>();
+	type_db.new_type<float>();
+
+	// Create a scene
+	sge::Scene scene{ type_db };
+	sge::register_builtin_components(scene);
+
+	// Create a pipeline
+	sge::UpdatePipeline pipeline;
+
+	sge::gl_render::GLRenderSystem render_system{ render_config };
+	render_system.pipeline_register(pipeline);
+	render_system.initialize_subscriptions(scene);
+
+	sge::AnimationSystem anim_system;
+	anim_system.register_pipeline(pipeline);
+
+	// Load the pipeline config
+	if (config_reader->pull_object_member("update_pipeline"))
+	{
+		pipeline.configure_pipeline(*config_reader);
+		config_reader->pop();
+	}
+	else
+	{
+		std::cerr << "Engine update pipeline not specified." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Load the scene
+	std::string scene_path;
+	if (config_reader->object_member("scene", scene_path))
+	{
+		scene.from_file(scene_path.c_str());
+	}
+
+	// Find the camera the path drives
+	sge::Node* camera_node = nullptr;
+	{
+		auto* const cam_component = scene.get_component_container(sge::CPerspectiveCamera::type_info);
+		sge::NodeId cam_node_id;
+		std::size_t num_cameras = 0;
+		cam_component->get_instance_nodes(0, 1, &num_cameras, &cam_node_id);
+		if (num_cameras != 0)
+		{
+			scene.get_nodes(&cam_node_id, 1, &camera_node);
+		}
+		else
+		{
+			std::cerr << "Warning: The scene has no camera, so nothing will be rendered." << std::endl;
+		}
+	}
+
+	// Timestamp queries at the start and end of each frame, double-buffered so reading one frame's results doesn't stall the next
+	GLuint timestamp_queries[2][2];
+	glGenQueries(4, &timestamp_queries[0][0]);
+
+	std::vector<double> cpu_ms;
+	std::vector<double> gpu_ms;
+	sge::gl_render::RenderFrameStats pass_totals;
+	cpu_ms.reserve(num_frames);
+	gpu_ms.reserve(num_frames);
+
+	const int total_frames = warmup_frames + num_frames;
+	for (int frame = 0; frame < total_frames; ++frame)
+	{
+		if (camera_node)
+		{
+			apply_camera_path(camera_path, frame * frame_time, *camera_node);
+		}
+
+		// Update the scene (which renders it)
+		auto* const queries = timestamp_queries[frame % 2];
+		glQueryCounter(queries[0], GL_TIMESTAMP);
+		const auto start = std::chrono::high_resolution_clock::now();
+		scene.update(pipeline, frame_time);
+		const auto end = std::chrono::high_resolution_clock::now();
+		glQueryCounter(queries[1], GL_TIMESTAMP);
+
+		// Collect the previous frame's GPU time, now that this frame has been submitted behind it
+		const int measured_frame = frame - warmup_frames;
+		if (frame > warmup_frames)
+		{
+			auto* const prev_queries = timestamp_queries[(frame - 1) % 2];
+			GLuint64 prev_start = 0, prev_end = 0;
+			glGetQueryObjectui64v(prev_queries[0], GL_QUERY_RESULT, &prev_start);
+			glGetQueryObjectui64v(prev_queries[1], GL_QUERY_RESULT, &prev_end);
+			gpu_ms.push_back((prev_end - prev_start) / 1000000.0);
+		}
+
+		if (measured_frame >= 0)
+		{
+			cpu_ms.push_back(std::chrono::duration<double, std::milli>{ end - start }.count());
+
+			// Accumulate per-pass costs (these lag a couple of frames behind, which doesn't matter for averages)
+			const auto pass_stats = render_system.render_stats();
+			for (std::size_t pass = 0; pass < sge::gl_render::RenderPass::NUM_PASSES; ++pass)
+			{
+				auto& total = pass_totals.passes[pass];
+				total.gpu_ms += pass_stats.passes[pass].gpu_ms;
+				total.cpu_ms += pass_stats.passes[pass].cpu_ms;
+				total.num_draw_calls += pass_stats.passes[pass].num_draw_calls;
+				total.num_triangles += pass_stats.passes[pass].num_triangles;
+				total.num_state_changes += pass_stats.passes[pass].num_state_changes;
+			}
+
+			if (!dump_frames_dir.empty())
+			{
+				char name[32];
+				std::snprintf(name, sizeof(name), "/frame_%05d.ppm", measured_frame);
+				dump_frame(target.framebuffer, width, height, dump_frames_dir + name);
+			}
+		}
+	}
+
+	// Collect the last frame's GPU time
+	if (num_frames > 0)
+	{
+		auto* const last_queries = timestamp_queries[(total_frames - 1) % 2];
+		GLuint64 last_start = 0, last_end = 0;
+		glGetQueryObjectui64v(last_queries[0], GL_QUERY_RESULT, &last_start);
+		glGetQueryObjectui64v(last_queries[1], GL_QUERY_RESULT, &last_end);
+		gpu_ms.push_back((last_end - last_start) / 1000000.0);
+	}
+
+	// Print the summary
+	std::printf("%s: %d frames at %dx%d (after %d warmup frames)\n", glGetString(GL_RENDERER), num_frames, width, height, warmup_frames);
+	print_summary("CPU", cpu_ms);
+	print_summary("GPU", gpu_ms);
+
+	if (num_frames > 0)
+	{
+		std::printf("Per-pass averages:\n");
+		for (std::size_t pass = 0; pass < sge::gl_render::RenderPass::NUM_PASSES; ++pass)
+		{
+			const auto& total = pass_totals.passes[pass];
+			std::printf("  %-16s gpu %8.3fms  cpu %8.3fms  draws %7.1f  tris %10.1f  state changes %7.1f\n",
+				sge::gl_render::render_pass_name(pass),
+				total.gpu_ms / num_frames,
+				total.cpu_ms / num_frames,
+				static_cast<double>(total.num_draw_calls) / num_frames,
+				static_cast<double>(total.num_triangles) / num_frames,
+				static_cast<double>(total.num_state_changes) / num_frames);
+		}
+
+		const auto residency = render_system.texture_residency_stats();
+		std::printf("Texture memory: %.1fMB streamed (of %.1fMB with every level resident, mip bias %u), %.1fMB not streamed\n",
+			residency.resident_bytes / (1024.0 * 1024.0),
+			residency.full_bytes / (1024.0 * 1024.0),
+			static_cast<unsigned>(residency.mip_bias),
+			residency.unmanaged_bytes / (1024.0 * 1024.0));
+	}
+
+	if (!timings_csv.empty())
+	{
+		std::ofstream csv{ timings_csv };
+		csv << "frame,cpu_ms,gpu_ms\n";
+		for (std::size_t i = 0; i < cpu_ms.size(); ++i)
+		{
+			csv << i << "," << cpu_ms[i] << "," << (i < gpu_ms.size() ? gpu_ms[i] : 0.0) << "\n";
+		}
+	}
+
+	glDeleteQueries(4, &timestamp_queries[0][0]);
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglTerminate(display);
+}
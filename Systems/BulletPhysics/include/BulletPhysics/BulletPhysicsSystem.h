@@ -4,6 +4,7 @@
 #include <memory>
 #include <Core/Reflection/Reflection.h>
 #include <Engine/Components/Gameplay/CCharacterController.h>
+#include <Resource/ResourceCache.h>
 #include "build.h"
 
 namespace sge
@@ -37,6 +38,11 @@ namespace sge
 
 			void reset();
 
+			/**
+			 * \brief Returns the memory used by static mesh colliders, and how many were loaded, reused and evicted.
+			 */
+			ResourceCacheStats collider_cache_stats() const;
+
         private:
 
 			void consume_events(Scene& scene);
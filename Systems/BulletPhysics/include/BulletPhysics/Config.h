@@ -34,6 +34,12 @@ namespace sge
         public:
 
             Vec3 global_gravity;
+
+            /**
+             * \brief The memory (in megabytes) kept by static mesh colliders no longer used by the scene, so that later scenes may reuse them.
+             * After a reset, the least recently used are destroyed until they fit. Unlimited if zero.
+             */
+            int collider_cache_budget_mb;
         };
     }
 }
@@ -3,6 +3,8 @@
 
 #include <map>
 #include <Engine/Component.h>
+#include <Resource/ResourceCache.h>
+#include <Resource/PathId.h>
 #include "../include/BulletPhysics/BulletPhysicsSystem.h"
 #include "PhysicsWorld.h"
 
@@ -45,10 +47,15 @@ namespace sge
 
             void post_remove_physics_entity_element(PhysicsEntity& phys_entity);
 
-			StaticMeshCollider* get_static_mesh_collider(const std::string& path);
+			StaticMeshCollider* get_static_mesh_collider(PathId path);
 
 			void release_static_mesh_collider(StaticMeshCollider& collider);
 
+			/**
+			 * \brief Destroys unused static mesh colliders (least recently used first) until they fit in the collider cache budget.
+			 */
+			void evict_static_mesh_colliders();
+
             //////////////////
             ///   Fields   ///
         public:
@@ -60,7 +67,14 @@ namespace sge
         	// Nodes that were transformed this frame (by the pysics system), and how they were transformed
         	std::vector<NodeId> frame_transformed_nodes;
 			std::vector<PhysTransformedNode> frame_transformed_node_transforms;
-			std::map<std::string, std::unique_ptr<StaticMeshCollider>> static_mesh_colliders;
+			/* Static mesh colliders, indexed by the interned id of their mesh path. */
+			std::vector<std::unique_ptr<StaticMeshCollider>> static_mesh_colliders;
+
+			/* Sizes and references of static mesh colliders (the only count of their uses). Unreferenced colliders are kept in 'static_mesh_colliders' until evicted. */
+			ResourceCache<PathId> static_mesh_collider_cache{ 1 };
+
+			/* Set on reset, so that colliders are evicted once the next scene has taken the ones it uses. */
+			bool evict_static_mesh_colliders_pending = false;
 
             /* NOTE: This must appear last, so that it is destroyed first. */
             PhysicsWorld phys_world;
@@ -36,11 +36,8 @@ namespace sge
 			///   Fields   ///
 		public:
 
-			/* Used to relocate the unique_ptr in the table when num_uses == 0 */
-			std::string path;
-
-			/* The number of uses of this collider. */
-			uint64 num_uses = 0;
+			/* Used to find this collider in the table, and its references in the collider cache, when it's released */
+			PathId path = NULL_PATH_ID;
 
 			/* The shape itself. */
 			btTriangleMesh mesh;
@@ -13,6 +13,7 @@
 #include <Engine/SystemFrame.h>
 #include <Engine/Scene.h>
 #include "../include/BulletPhysics/BulletPhysicsSystem.h"
+#include "../include/BulletPhysics/Config.h"
 #include "../private/BulletPhysicsSystemData.h"
 #include "../private/PhysicsEntity.h"
 #include "../private/DebugDrawer.h"
@@ -72,7 +73,7 @@ namespace sge
 			}
 		}
 
-        BulletPhysicsSystem::BulletPhysicsSystem(const Config& /*config*/)
+        BulletPhysicsSystem::BulletPhysicsSystem(const Config& config)
             : _node_world_transform_changed_channel(nullptr),
 			_new_rigid_body_channel(nullptr),
 			_modified_rigid_body_channel(nullptr),
@@ -127,6 +128,7 @@ namespace sge
 			_destroyed_spotlight_sid(EventChannel::INVALID_SID)
         {
             _data = std::make_unique<Data>();
+			_data->static_mesh_collider_cache.set_budget(0, std::size_t(config.collider_cache_budget_mb) * 1024 * 1024);
         }
 
         BulletPhysicsSystem::~BulletPhysicsSystem()
@@ -245,11 +247,22 @@ namespace sge
 					dynamics_world.removeAction(phys_ent.second->character_controller.get());
 					dynamics_world.removeCollisionObject(&phys_ent.second->character_controller->ghost_object);
 				}
+				if (phys_ent.second->static_mesh_collider)
+				{
+					auto* const base_collider = (StaticMeshCollider*)phys_ent.second->static_mesh_collider->getUserPointer();
+					_data->release_static_mesh_collider(*base_collider);
+				}
 			}
 
 			_data->physics_entities.clear();
 			_data->frame_transformed_nodes.clear();
 			_data->frame_transformed_node_transforms.clear();
+			_data->evict_static_mesh_colliders_pending = true;
+	    }
+
+	    ResourceCacheStats BulletPhysicsSystem::collider_cache_stats() const
+	    {
+			return _data->static_mesh_collider_cache.stats(0);
 	    }
 
 	    void BulletPhysicsSystem::consume_events(Scene& scene)
@@ -277,6 +290,13 @@ namespace sge
 			on_static_mesh_collider_modified(*_modified_static_mesh_collider_channel, _modified_static_mesh_collider_sid, *_data, scene);
 			on_static_mesh_collider_destroyed(*_destroyed_static_mesh_collider_channel, _destroyed_static_mesh_collider_sid, *_data);
 
+			// Now that the scene has taken the colliders it uses, destroy those left over from before the reset
+			if (_data->evict_static_mesh_colliders_pending)
+			{
+				_data->evict_static_mesh_colliders();
+				_data->evict_static_mesh_colliders_pending = false;
+			}
+
 			// Consume rigid body events
 			on_rigid_body_new(scene, *_new_rigid_body_channel, _new_rigid_body_sid, *_data);
 			on_rigid_body_modified(*_modified_rigid_body_channel, _modified_rigid_body_sid, *_data);
@@ -1,5 +1,7 @@
 // BulletPhysicsSystemData.cpp
 
+#include <algorithm>
+#include <BulletCollision/BroadphaseCollision/btQuantizedBvh.h>
 #include <Resource/Resources/StaticMesh.h>
 #include "../private/BulletPhysicsSystemData.h"
 #include "../private/PhysicsEntity.h"
@@ -10,7 +12,7 @@ namespace sge
 {
     namespace bullet_physics
 	{
-		static std::unique_ptr<StaticMeshCollider> create_static_mesh_collider_mesh(std::string path, const StaticMesh& mesh)
+		static std::unique_ptr<StaticMeshCollider> create_static_mesh_collider_mesh(PathId path, const StaticMesh& mesh)
 		{
 			const auto num_verts = mesh.num_verts();
 			const auto num_triangles = mesh.num_triangles();
@@ -19,7 +21,7 @@ namespace sge
 
 			// Build the mesh
 			auto bt_mesh = std::make_unique<StaticMeshCollider>();
-			bt_mesh->path = std::move(path);
+			bt_mesh->path = path;
 			bt_mesh->mesh.preallocateVertices((int)num_verts);
 			for (std::size_t i = 0; i < num_triangles; ++i)
 			{
@@ -137,19 +139,20 @@ namespace sge
             }
         }
 
-	    StaticMeshCollider* BulletPhysicsSystem::Data::get_static_mesh_collider(const std::string& path)
+	    StaticMeshCollider* BulletPhysicsSystem::Data::get_static_mesh_collider(PathId path)
 	    {
-			const auto iter = static_mesh_colliders.find(path);
-			if (iter != static_mesh_colliders.end())
+			static_mesh_collider_cache.request(path, 0);
+			if (path < static_mesh_colliders.size() && static_mesh_colliders[path])
 			{
-				auto* const ptr = iter->second.get();
-				ptr->num_uses += 1;
+				auto* const ptr = static_mesh_colliders[path].get();
+				static_mesh_collider_cache.add_ref(path);
 				return ptr;
 			}
 
-			// Load the mesh
+			// Load the mesh, preferring a cooked version
+			const auto& path_str = get_interned_path(path);
 			StaticMesh mesh;
-			if (!mesh.from_file(path.c_str()))
+			if (!mesh.from_file(StaticMesh::cooked_path(path_str.c_str()).c_str()) && !mesh.from_file(path_str.c_str()))
 			{
 				return nullptr;
 			}
@@ -158,23 +161,30 @@ namespace sge
 			auto collider = create_static_mesh_collider_mesh(path, mesh);
 			auto* const ptr = collider.get();
 
-			// Insert it into the table
-			static_mesh_colliders.insert(std::make_pair(path, std::move(collider)));
-			ptr->num_uses += 1;
+			// Insert it into the table (the triangle mesh stores three vertices and indices per triangle, and its BVH about two nodes per triangle)
+			if (path >= static_mesh_colliders.size())
+			{
+				static_mesh_colliders.resize(path + 1);
+			}
+			static_mesh_colliders[path] = std::move(collider);
+			static_mesh_collider_cache.set_resident(
+				path,
+				mesh.num_triangles() * (3 * sizeof(btVector3) + 3 * sizeof(int) + 2 * sizeof(btQuantizedBvhNode)));
+			static_mesh_collider_cache.add_ref(path);
 			return ptr;
 	    }
 
 	    void BulletPhysicsSystem::Data::release_static_mesh_collider(StaticMeshCollider& collider)
 	    {
-			collider.num_uses -= 1;
-			if (collider.num_uses > 0)
-			{
-				return;
-			}
+			// Unused colliders stay in the table, in case the next scene uses them too
+			static_mesh_collider_cache.release(collider.path);
+	    }
 
-			// Remove it from the table
-			const auto path = collider.path;
-			static_mesh_colliders.erase(path);
+	    void BulletPhysicsSystem::Data::evict_static_mesh_colliders()
+	    {
+			static_mesh_collider_cache.evict([this](PathId path, std::size_t /*size*/) {
+				static_mesh_colliders[path] = nullptr;
+			});
 	    }
     }
 }
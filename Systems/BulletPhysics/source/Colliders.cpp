@@ -322,7 +322,7 @@ namespace sge
 				for (int32 i = 0; i < num_events; ++i)
 				{
 					// Get the base collider
-					auto* const base_collider = phys_data.get_static_mesh_collider(components[i]->mesh());
+					auto* const base_collider = phys_data.get_static_mesh_collider(components[i]->mesh_id());
 					if (!base_collider)
 					{
 						std::cout << "WARNING, BulletPhysicsSystem: Cannot load static mesh '" << components[i]->mesh() << "'" << std::endl;
@@ -435,7 +435,7 @@ namespace sge
 					}
 
 					// Get the base collider
-					auto* const base_collider = phys_data.get_static_mesh_collider(components[i]->mesh());
+					auto* const base_collider = phys_data.get_static_mesh_collider(components[i]->mesh_id());
 					if (!base_collider)
 					{
 						// Loading failed, have to remove the current collider if it exists
@@ -13,18 +13,20 @@ namespace sge
     namespace bullet_physics
     {
         Config::Config()
-            : global_gravity{ 0, -10, 0 }
+            : global_gravity{ 0, -10, 0 },
+            collider_cache_budget_mb(64)
         {
         }
 
         bool Config::validate() const
         {
-            return true;
+            return collider_cache_budget_mb >= 0;
         }
 
         void Config::from_archive(ArchiveReader& reader)
         {
             reader.object_member("gravity", global_gravity);
+            reader.object_member("collider_cache_budget_mb", collider_cache_budget_mb);
         }
     }
 }
@@ -1,9 +1,12 @@
 // EditorOps.cpp
 
+#include <cstdio>
 #include <iostream>
 #include <chrono>
 #include <future>
+#include <algorithm>
 #include <Core/Memory/Functions.h>
+#include <Core/Parallelism/TaskPool.h>
 #include <Core/IO/ArchiveWriter.h>
 #include <Core/IO/ArchiveReader.h>
 #include <Core/Reflection/Reflection.h>
@@ -604,16 +607,19 @@ namespace sge
 					return;
 				}
 
-				// Create an output archive
-				JsonArchive output;
-				auto* writer = output.write_root();
+				// Save the scene straight to the file
+				auto* writer = JsonArchive::stream_to_file(path.c_str());
+				if (!writer)
+				{
+					std::cout << "Could not save scene to '" << path << "'" << std::endl;
+					return;
+				}
 
-				// Save the scene
 				scene.to_archive(*writer);
 				writer->pop();
 
-				// Save the archive to a file
-				output.to_file(path.c_str());
+				// The cooked scene no longer matches, so remove it rather than wait for the runtime to notice
+				std::remove(Scene::cooked_path(path.c_str()).c_str());
 				std::cout << "Saved scene to '" << path << "'" << std::endl;
 			}
 
@@ -972,6 +978,21 @@ namespace sge
                 // Clean up scene
                 free_lightmap_scene(lm_scene);
 
+				// Encode lightmaps into a GPU-ready format, so they're uploaded without any decoding at load time
+				std::string lightmap_format = "bc6h";
+				reader.object_member("lightmap_format", lightmap_format);
+				const auto encode_start = std::chrono::high_resolution_clock::now();
+				{
+					TaskPool pool{ std::max(std::thread::hardware_concurrency(), 1u) };
+					scene_lightmap.encode(lightmap_format == "rgb9e5" ? SceneLightmap::Format::RGB9E5 : SceneLightmap::Format::BC6H, &pool);
+				}
+				const auto encode_end = std::chrono::high_resolution_clock::now();
+
+				// Debug time
+				std::cout << "Encoded lightmaps in ";
+				std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(encode_end - encode_start).count();
+				std::cout << " milliseconds." << std::endl;
+
 				// Save lightmap to archive
 				BinaryArchive lightmap_out;
 				auto* lightmap_writer = lightmap_out.write_root();
@@ -981,6 +1002,7 @@ namespace sge
 				// Save archive to file
             	std::string lightmap_path;
 				reader.object_member("lightmap_path", lightmap_path);
+				lightmap_out.set_file_compression(true);
 				lightmap_out.to_file(lightmap_path.c_str());
 
 				// Assign lightmap to scene
@@ -49,6 +49,57 @@ namespace sge
 			std::string missing_material;
 
 			std::string missing_mesh;
+
+			/**
+			 * \brief Whether frames are prepared on a worker thread while the previous frame is submitted.
+			 * This adds a frame of latency, so may be disabled when the result must reflect the scene immediately.
+			 */
+			bool pipeline_render_prep;
+
+			/**
+			 * \brief Whether instances hidden behind occluders (lightmask occluders and large static meshes) are culled on the CPU.
+			 */
+			bool occlusion_culling;
+
+			/**
+			 * \brief Whether to use the compact gbuffer layout (about 24 bytes per pixel, rather than about 60).
+			 * Position is reconstructed from a single linear depth channel, normals are octahedral-encoded, and irradiance and HDR color use packed floats.
+			 */
+			bool compact_gbuffer;
+
+			/**
+			 * \brief Directory linked shader program binaries are cached in between runs (created if it doesn't exist).
+			 * Programs are always compiled from source if empty.
+			 */
+			std::string program_cache_dir;
+
+			/**
+			 * \brief Whether to measure the GPU and CPU time of each render pass (see 'GLRenderSystem::render_stats').
+			 */
+			bool profile_render_passes;
+
+			/**
+			 * \brief Whether to print the average cost of each render pass about once a second. Requires 'profile_render_passes'.
+			 */
+			bool print_render_stats;
+
+			/**
+			 * \brief Whether cooked textures and encoded lightmaps keep only the mip levels needed on screen resident, streaming finer levels in as objects get closer.
+			 */
+			bool texture_streaming;
+
+			/**
+			 * \brief The video memory (in megabytes) streamed textures may use. Every streamed texture drops levels evenly to fit. Unlimited if zero.
+			 */
+			int texture_budget_mb;
+
+			/**
+			 * \brief The memory (in megabytes) kept by resource caches for each kind of resource. After a level change, resources no longer used are evicted
+			 * (least recently used first) until each kind fits. Resources in use are never evicted. Unlimited if zero.
+			 */
+			int mesh_cache_budget_mb;
+			int material_cache_budget_mb;
+			int texture_cache_budget_mb;
 		};
 	}
 }
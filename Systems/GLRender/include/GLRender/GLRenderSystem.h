@@ -4,6 +4,7 @@
 #include <memory>
 #include <Core/Reflection/Reflection.h>
 #include <Engine/Scene.h>
+#include <Resource/ResourceCache.h>
 #include "build.h"
 
 namespace sge
@@ -14,6 +15,144 @@ namespace sge
 	{
 		struct Config;
 
+		/**
+		 * \brief Software occlusion culling results for a single frame.
+		 */
+		struct OcclusionStats
+		{
+			std::size_t num_occluders = 0;
+			std::size_t num_occluder_triangles = 0;
+
+			/**
+			 * \brief The number of instances tested against the occlusion buffer.
+			 */
+			std::size_t num_tested = 0;
+
+			/**
+			 * \brief The number of instances found to be hidden, and not drawn in the camera pass.
+			 */
+			std::size_t num_culled = 0;
+		};
+
+		/**
+		 * \brief Shader program creation results since startup, for measuring the program binary cache.
+		 */
+		struct ProgramCacheStats
+		{
+			/**
+			 * \brief The number of programs loaded from cached binaries, and the time spent loading them.
+			 */
+			std::size_t num_loaded = 0;
+			double load_ms = 0;
+
+			/**
+			 * \brief The number of programs compiled and linked from source, and the time spent doing so.
+			 */
+			std::size_t num_compiled = 0;
+			double compile_ms = 0;
+
+			/**
+			 * \brief The number of cached binaries the driver rejected (and were recompiled).
+			 */
+			std::size_t num_rejected = 0;
+		};
+
+		namespace RenderPass
+		{
+			/**
+			 * \brief The passes a frame is profiled in, in the order they're submitted.
+			 */
+			enum : std::size_t
+			{
+				SHADOW_MAPS,
+				GBUFFER,
+				LIGHTMASK,
+				SHADING,
+				POST_PROCESSING,
+				NUM_PASSES
+			};
+		}
+
+		/**
+		 * \brief Returns a printable name for the given pass (one of the 'RenderPass' values).
+		 */
+		SGE_GLRENDER_API const char* render_pass_name(
+			std::size_t pass);
+
+		/**
+		 * \brief The cost of a single pass of a frame.
+		 */
+		struct RenderPassStats
+		{
+			/**
+			 * \brief Time spent executing the pass on the GPU (from 'GL_TIME_ELAPSED' queries).
+			 */
+			double gpu_ms = 0;
+
+			/**
+			 * \brief Time spent issuing the pass on the CPU.
+			 */
+			double cpu_ms = 0;
+
+			std::size_t num_draw_calls = 0;
+			std::size_t num_triangles = 0;
+
+			/**
+			 * \brief The number of program, vertex array, texture, material parameter block and framebuffer bindings.
+			 */
+			std::size_t num_state_changes = 0;
+		};
+
+		/**
+		 * \brief The cost of each pass of a single frame.
+		 */
+		struct RenderFrameStats
+		{
+			RenderPassStats passes[RenderPass::NUM_PASSES];
+		};
+
+		/**
+		 * \brief Memory used by textures, and what texture residency streaming did in the last frame.
+		 */
+		struct TextureResidencyStats
+		{
+			/**
+			 * \brief Bytes of streamed textures (cooked textures and encoded lightmaps) currently resident, and with every level resident.
+			 */
+			std::size_t resident_bytes = 0;
+			std::size_t full_bytes = 0;
+
+			/**
+			 * \brief Bytes of textures that aren't streamed (uncooked textures and float lightmaps), which are always fully resident.
+			 */
+			std::size_t unmanaged_bytes = 0;
+
+			/**
+			 * \brief The budget streamed textures are kept under (unlimited if zero).
+			 */
+			std::size_t budget_bytes = 0;
+
+			std::size_t num_textures = 0;
+
+			/**
+			 * \brief The number of levels dropped from every streamed texture to fit in the budget.
+			 */
+			uint32 mip_bias = 0;
+
+			std::size_t uploaded_bytes = 0;
+			std::size_t num_evicted_levels = 0;
+		};
+
+		/**
+		 * \brief Memory kept by the mesh, material and texture caches, and how often each was hit.
+		 */
+		struct RenderResourceStats
+		{
+			ResourceCacheStats static_meshes;
+			ResourceCacheStats materials;
+			ResourceCacheStats textures;
+		};
+
 		struct SGE_GLRENDER_API GLRenderSystem
 		{
 			SGE_REFLECTED_TYPE;
@@ -38,6 +177,32 @@ namespace sge
 
 			void reset();
 
+			/**
+			 * \brief Returns the occlusion culling results for the last frame submitted.
+			 */
+			OcclusionStats occlusion_stats() const;
+
+			/**
+			 * \brief Returns the number of programs created from cached binaries and from source, and the time each took.
+			 */
+			ProgramCacheStats program_cache_stats() const;
+
+			/**
+			 * \brief Returns the per-pass cost of the most recent frame whose GPU timings are available.
+			 * GPU timings are read back two frames late so that reading them doesn't stall, so this lags the last frame submitted.
+			 */
+			RenderFrameStats render_stats() const;
+
+			/**
+			 * \brief Returns resident texture memory, and the texture levels streamed in and out in the last frame.
+			 */
+			TextureResidencyStats texture_residency_stats() const;
+
+			/**
+			 * \brief Returns the memory used by cached meshes, materials and textures, and how many were loaded, reused and evicted.
+			 */
+			RenderResourceStats resource_cache_stats() const;
+
 		private:
 
 			void render_scene(Scene& scene, SystemFrame& frame);
@@ -0,0 +1,54 @@
+// Culling.h
+#pragma once
+
+#include <Core/Math/Mat4.h>
+
+namespace sge
+{
+	namespace gl_render
+	{
+		struct BoundingSphere
+		{
+			Vec3 center;
+			float radius = 0.f;
+		};
+
+		/**
+		 * \brief Clip-space planes of a view frustum, stored as (a, b, c, d) where a point is inside when 'a*x + b*y + c*z + d >= 0'.
+		 */
+		struct Frustum
+		{
+			float planes[6][4];
+		};
+
+		/**
+		 * \brief Computes the bounding sphere of the given set of points.
+		 * \param points The points to compute the bounding sphere of.
+		 * \param num_points The number of points.
+		 * \return A sphere centered on the bounding box of the points.
+		 */
+		BoundingSphere compute_bounding_sphere(
+			const Vec3* points,
+			std::size_t num_points);
+
+		/**
+		 * \brief Transforms a local-space bounding sphere into world space, scaling the radius by the largest axis scale.
+		 */
+		BoundingSphere transform_bounding_sphere(
+			const Mat4& world_transform,
+			const BoundingSphere& local_sphere);
+
+		/**
+		 * \brief Extracts the frustum planes from the given combined view-projection matrix.
+		 */
+		Frustum extract_frustum(
+			const Mat4& view_proj_matrix);
+
+		/**
+		 * \brief Returns whether the given sphere is at least partially inside the given frustum.
+		 */
+		bool frustum_intersects_sphere(
+			const Frustum& frustum,
+			const BoundingSphere& sphere);
+	}
+}
@@ -1,6 +1,7 @@
 // GLMaterial.h
 #pragma once
 
+#include <vector>
 #include <Core/Math/Mat4.h>
 #include <Core/Math/Vec4.h>
 #include "Util.h"
@@ -14,18 +15,18 @@ namespace sge
 			constexpr GLint POSITION_ATTRIB_LOCATION = 0;
 			constexpr GLint NORMAL_ATTRIB_LOCATION = 1;
             constexpr GLint TANGENT_ATTRIB_LOCATION = 2;
-            constexpr GLint BITANGENT_SIGN_ATTRIB_LOCATION = 3;
 			constexpr GLint MATERIAL_TEXCOORD_ATTRIB_LOCATION = 4;
             constexpr GLint LIGHTMAP_TEXCOORD_ATTRIB_LOCATION = 5;
 			constexpr const char* POSITION_ATTRIB_NAME = "v_position";
 			constexpr const char* NORMAL_ATTRIB_NAME = "v_normal";
             constexpr const char* TANGENT_ATTRIB_NAME = "v_tangent";
-            constexpr const char* BITANGENT_SIGN_ATTRIB_NAME = "v_bitangent_sign";
 			constexpr const char* MATERIAL_TEXCOORD_ATTRIB_NAME = "v_mat_texcoord";
             constexpr const char* LIGHTMAP_TEXCOORD_ATTRIB_NAME = "v_lm_texcoord";
 			constexpr const char* MODEL_MATRIX_UNIFORM_NAME = "model";
 			constexpr const char* VIEW_MATRIX_UNIFORM_NAME = "view";
 			constexpr const char* PROJ_MATRIX_UNIFORM_NAME = "projection";
+			constexpr const char* POSITION_OFFSET_UNIFORM_NAME = "position_offset";
+			constexpr const char* POSITION_SCALE_UNIFORM_NAME = "position_scale";
             constexpr const char* BASE_MAT_UV_SCALE_UNIFORM_NAME = "base_mat_uv_scale";
 			constexpr const char* INST_MAT_UV_SCALE_UNIFORM_NAME = "inst_mat_uv_scale";
 			constexpr const char* LIGHTMAP_X_BASIS_UNIFORM_NAME = "lightmap_x_basis";
@@ -39,17 +40,47 @@ namespace sge
             constexpr GLenum LIGHTMAP_DIRECT_MASK_TEXTURE_SLOT = GL_TEXTURE3;
             constexpr GLenum FIRST_USER_TEXTURE_SLOT = GL_TEXTURE4;
 
+            constexpr const char* MATERIAL_PARAMS_BLOCK_NAME = "material_params";
+            constexpr GLuint MATERIAL_PARAMS_BLOCK_BINDING = 0;
+
             /**
-            * \brief Material parameters.
+             * \brief Texture parameter, bound to a fixed texture slot for the lifetime of the material.
+             */
+            struct MaterialTextureBinding
+            {
+                GLenum texture_slot = GL_TEXTURE0;
+                GLuint texture = 0;
+            };
+
+            /**
+            * \brief Material parameters, compiled into a range of the shared material parameter buffer plus a texture table.
             */
             struct MaterialParams
             {
-                std::map<GLint, GLint> int_params;
-                std::map<GLint, float> float_params;
-                std::map<GLint, Vec2> vec2_params;
-                std::map<GLint, Vec3> vec3_params;
-                std::map<GLint, Vec4> vec4_params;
-                std::map<GLint, GLuint> tex_params;
+                GLuint block_buffer = 0;
+                GLintptr block_offset = 0;
+                GLsizeiptr block_size = 0;
+                std::vector<MaterialTextureBinding> textures;
+            };
+
+            /**
+             * \brief Uniform buffer shared by all material parameter blocks. Each material owns an aligned range within it.
+             */
+            struct MaterialParamBuffer
+            {
+                struct FreeRange
+                {
+                    GLintptr offset = 0;
+                    GLsizeiptr size = 0;
+                };
+
+                GLuint buffer = 0;
+                GLint offset_alignment = 0;
+                GLsizeiptr capacity = 0;
+                std::vector<byte> data;
+
+                /* Ranges released by unloaded materials, which are reused before the buffer is grown. */
+                std::vector<FreeRange> free_ranges;
             };
 
 		    /**
@@ -60,6 +91,8 @@ namespace sge
                 GLint model_matrix_uniform = -1;
                 GLint view_matrix_uniform = -1;
                 GLint proj_matrix_uniform = -1;
+				GLint position_offset_uniform = -1;
+				GLint position_scale_uniform = -1;
                 GLint base_mat_uv_scale_uniform = -1;
 				GLint inst_mat_uv_scale_uniform = -1;
                 GLint lightmap_x_basis_uniform = -1;
@@ -80,13 +113,15 @@ namespace sge
             };
 
 		    /**
-             * \brief Creates a standard material shader program with the given vertex shader and fragment shader.
+             * \brief Links the given standard material shader program with the given vertex shader and fragment shader.
              * Binds standard vertex attribute locations as well.
+             * \param mat_id The program to link.
              * \param v_shader The vertex shader for this material.
              * \param f_shader The fragment shader for this material
-             * \return The id of the newly created shader program. The user is responsible for checking program link status.
+             * \note The user is responsible for checking program link status.
              */
-            GLuint new_standard_material_program(
+            void link_standard_material_program(
+				GLuint mat_id,
 				GLuint v_shader,
 				GLuint f_shader);
 
@@ -128,14 +163,101 @@ namespace sge
                 const MaterialStandardUniforms uniforms);
 
 			/**
-             * \brief Sets the given material parameters for the given material.
-             * \param mat_id The id of the material.
-             * \param next_active_texture The next texture slot to use for texture parameters.
-             * \param params The parameters for the material.
+             * \brief Returns the size of the material parameter block for the given material, binding it to 'MATERIAL_PARAMS_BLOCK_BINDING'.
+			 * \param mat_id The id of the material.
+			 * \return The size of the std140 material parameter block, or 0 if the material does not declare one.
              */
-            void set_material_params(
+            GLsizeiptr init_material_params_block(
+				const GLuint mat_id);
+
+			/**
+             * \brief Writes the default value of each standard parameter the material declares into its parameter block, since block members can't have GLSL initializers.
+			 * Materials' own parameters should be compiled after this, so that they replace the defaults.
+			 * \param mat_id The id of the material.
+			 * \param block_data The CPU copy of the material parameter block.
+             */
+            void compile_default_material_params(
 				const GLuint mat_id,
-				GLenum* const next_active_texture,
+				byte* block_data);
+
+			/**
+             * \brief Writes the given parameter into the material parameter block, if it's a member of the block.
+			 * Parameters in the default uniform block are uploaded to the program directly instead, since each material owns its program.
+			 * \param mat_id The id of the material.
+			 * \param name The name of the parameter.
+			 * \param block_data The CPU copy of the material parameter block.
+			 * \return Whether the parameter was found.
+             */
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				GLint value,
+				byte* block_data);
+
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				float value,
+				byte* block_data);
+
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				Vec2 value,
+				byte* block_data);
+
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				Vec3 value,
+				byte* block_data);
+
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				Vec4 value,
+				byte* block_data);
+
+			/**
+             * \brief Assigns the given texture to the next free user texture slot of the material.
+			 * \param mat_id The id of the material.
+			 * \param name The name of the sampler uniform.
+			 * \param texture The texture to bind to the sampler.
+			 * \param params The parameters to add the texture binding to.
+			 * \return Whether the sampler was found.
+             */
+            bool compile_material_texture_param(
+				const GLuint mat_id,
+				const char* name,
+				const GLuint texture,
+				MaterialParams& params);
+
+			/**
+             * \brief Places the given parameter block in a released range of the shared parameter buffer, or appends it (growing the buffer if necessary).
+			 * \param param_buffer The shared material parameter buffer.
+			 * \param block_data The parameter block to upload.
+			 * \param block_size The size of the parameter block.
+			 * \param params The parameters to assign the buffer range to.
+             */
+            void upload_material_params_block(
+				MaterialParamBuffer& param_buffer,
+				const byte* block_data,
+				const GLsizeiptr block_size,
+				MaterialParams& params);
+
+			/**
+             * \brief Releases the range of the shared parameter buffer assigned to the given parameters, so that it may be reused by another material.
+             */
+            void release_material_params_block(
+				MaterialParamBuffer& param_buffer,
+				const MaterialParams& params);
+
+			/**
+             * \brief Binds the parameter block range and texture table of the given material.
+             * \param params The parameters for the material.
+             * \return The number of buffer and texture bindings made.
+             */
+            std::size_t bind_material_params(
 				const MaterialParams& params);
 		}
 	}
@@ -1,6 +1,8 @@
 // GLRenderSystemState.h
 #pragma once
 
+#include <array>
+#include <Core/Parallelism/TaskPool.h>
 #include "../include/GLRender/GLRenderSystem.h"
 #include "GLShader.h"
 #include "GLStaticMesh.h"
@@ -8,6 +10,7 @@
 #include "DebugLine.h"
 #include "RenderScene.h"
 #include "RenderResource.h"
+#include "RenderProfiler.h"
 
 namespace sge
 {
@@ -35,6 +38,13 @@ namespace sge
         static constexpr GLenum GBUFFER_ROUGHNESS_METALLIC_ATTACHMENT = GL_COLOR_ATTACHMENT3;
         static constexpr GLenum GBUFFER_IRRADIANCE_ATTACHMENT = GL_COLOR_ATTACHMENT4;
         static constexpr GLenum POST_BUFFER_HDR_ATTACHMENT = GL_COLOR_ATTACHMENT0;
+        static constexpr GLenum GBUFFER_LAYER_ATTACHMENTS[GBufferLayer::NUM_LAYERS] = {
+            GBUFFER_DEPTH_STENCIL_ATTACHMENT,
+            GBUFFER_POSITION_ATTACHMENT,
+            GBUFFER_NORMAL_ATTACHMENT,
+            GBUFFER_ALBEDO_ATTACHMENT,
+            GBUFFER_ROUGHNESS_METALLIC_ATTACHMENT,
+            GBUFFER_IRRADIANCE_ATTACHMENT };
 
         /* These constants define the internal format for the gbuffer layers. */
         static constexpr GLenum GBUFFER_DEPTH_STENCIL_INTERNAL_FORMAT = GL_DEPTH24_STENCIL8;
@@ -62,13 +72,117 @@ namespace sge
         static constexpr GLenum POST_BUFFER_HDR_UPLOAD_FORMAT = GL_RGB;
         static constexpr GLenum POST_BUFFER_HDR_UPLOAD_TYPE = GL_FLOAT;
 
+        /* These constants define the compact gbuffer layout (see 'Config::compact_gbuffer'), where they differ from the above.
+        * Only linear view depth is stored in the position layer, and position is reconstructed from it (the depth buffer itself is reused by the lightmask pass).
+        * Normals are octahedral-encoded, and the direct light mask moves from the irradiance layer's alpha into the albedo layer's alpha. */
+        static constexpr GLenum COMPACT_GBUFFER_POSITION_INTERNAL_FORMAT = GL_R32F;
+        static constexpr GLenum COMPACT_GBUFFER_POSITION_UPLOAD_FORMAT = GL_RED;
+        static constexpr GLenum COMPACT_GBUFFER_POSITION_UPLOAD_TYPE = GL_FLOAT;
+        static constexpr GLenum COMPACT_GBUFFER_NORMAL_INTERNAL_FORMAT = GL_RG16_SNORM;
+        static constexpr GLenum COMPACT_GBUFFER_NORMAL_UPLOAD_FORMAT = GL_RG;
+        static constexpr GLenum COMPACT_GBUFFER_NORMAL_UPLOAD_TYPE = GL_FLOAT;
+        static constexpr GLenum COMPACT_GBUFFER_ALBEDO_INTERNAL_FORMAT = GL_RGBA8;
+        static constexpr GLenum COMPACT_GBUFFER_ALBEDO_UPLOAD_FORMAT = GL_RGBA;
+        static constexpr GLenum COMPACT_GBUFFER_ALBEDO_UPLOAD_TYPE = GL_UNSIGNED_BYTE;
+        static constexpr GLenum COMPACT_GBUFFER_IRRADIANCE_INTERNAL_FORMAT = GL_R11F_G11F_B10F;
+        static constexpr GLenum COMPACT_GBUFFER_IRRADIANCE_UPLOAD_FORMAT = GL_RGB;
+        static constexpr GLenum COMPACT_GBUFFER_IRRADIANCE_UPLOAD_TYPE = GL_FLOAT;
+        static constexpr GLenum COMPACT_POST_BUFFER_HDR_INTERNAL_FORMAT = GL_R11F_G11F_B10F;
+
+        /* Preprocessor definition prepended to all shaders when using the compact gbuffer layout. */
+        static constexpr const char* COMPACT_GBUFFER_SHADER_DEFINE = "#define SGE_COMPACT_GBUFFER 1\n";
+
+        /* Functions for writing and reading gbuffer layers, prepended to all shaders (after 'COMPACT_GBUFFER_SHADER_DEFINE', if it's used),
+        * so that material shaders and the shading pass can't disagree about the layout.
+        * Material shaders declare their position and normal outputs as 'gbuffer_position_t' and 'gbuffer_normal_t'. */
+        static constexpr const char* GBUFFER_ENCODING_SHADER_SOURCE =
+            "#ifdef SGE_COMPACT_GBUFFER\n"
+            "#define gbuffer_position_t float\n"
+            "#define gbuffer_normal_t vec2\n"
+            "// Only the distance in front of the camera is stored, zero (the clear value) means nothing was drawn\n"
+            "float encode_position(vec3 p)\n"
+            "{\n"
+            "    return -p.z;\n"
+            "}\n"
+            "// Scales the pixel's view ray (through the near plane) out to the stored distance\n"
+            "vec3 decode_position(vec4 texel, vec2 texcoord, mat4 inv_proj)\n"
+            "{\n"
+            "    vec4 near_pos = inv_proj * vec4(texcoord * 2.0f - 1.0f, -1.0f, 1.0f);\n"
+            "    vec3 ray = near_pos.xyz / near_pos.w;\n"
+            "    return ray * (texel.r / -ray.z);\n"
+            "}\n"
+            "bool is_gbuffer_background(vec4 position_texel)\n"
+            "{\n"
+            "    return position_texel.r <= 0.0f;\n"
+            "}\n"
+            "// Normals are octahedral-encoded into a two-channel target\n"
+            "vec2 encode_normal(vec3 n)\n"
+            "{\n"
+            "    n /= abs(n.x) + abs(n.y) + abs(n.z);\n"
+            "    vec2 wrapped = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);\n"
+            "    return n.z >= 0.0f ? n.xy : wrapped;\n"
+            "}\n"
+            "vec3 decode_normal(vec4 texel)\n"
+            "{\n"
+            "    vec3 n = vec3(texel.xy, 1.0f - abs(texel.x) - abs(texel.y));\n"
+            "    float t = max(-n.z, 0.0f);\n"
+            "    n.xy += vec2(n.x >= 0.0f ? -t : t, n.y >= 0.0f ? -t : t);\n"
+            "    return normalize(n);\n"
+            "}\n"
+            "#else\n"
+            "#define gbuffer_position_t vec3\n"
+            "#define gbuffer_normal_t vec3\n"
+            "vec3 encode_position(vec3 p)\n"
+            "{\n"
+            "    return p;\n"
+            "}\n"
+            "vec3 decode_position(vec4 texel, vec2 texcoord, mat4 inv_proj)\n"
+            "{\n"
+            "    return texel.xyz;\n"
+            "}\n"
+            "bool is_gbuffer_background(vec4 position_texel)\n"
+            "{\n"
+            "    return false;\n"
+            "}\n"
+            "vec3 encode_normal(vec3 n)\n"
+            "{\n"
+            "    return n;\n"
+            "}\n"
+            "vec3 decode_normal(vec4 texel)\n"
+            "{\n"
+            "    return texel.xyz;\n"
+            "}\n"
+            "#endif\n"
+            "#line 2\n";
+
+        /**
+         * \brief The formats a render target layer is allocated with. A layer with an internal format of 'GL_NONE' isn't allocated.
+         */
+        struct RenderTargetFormat
+        {
+            GLenum internal_format;
+            GLenum upload_format;
+            GLenum upload_type;
+        };
+
 		struct GLRenderSystem::State
 		{
+			/**
+			 * \brief Everything needed to submit a frame, captured when the frame was simulated.
+			 */
+			struct Frame
+			{
+				RenderScene_Frame scene;
+				std::vector<DebugLineVert> debug_lines;
+				float gamma = 1.f;
+				float brightness_boost = 1.f;
+			};
+
 			///////////////////
 			///   Methods   ///
 		public:
 
-			void gather_debug_lines(EventChannel& debug_line_channel, EventChannel::SubscriberId subscriber_id);
+			void gather_debug_lines(EventChannel& debug_line_channel, EventChannel::SubscriberId subscriber_id, std::vector<DebugLineVert>& out_lines);
 
 			//////////////////
 			///   Fields   ///
@@ -82,12 +196,18 @@ namespace sge
 			GLint default_framebuffer;
 
 			// Gbuffer
+			bool compact_gbuffer;
 			GLuint gbuffer_framebuffer;
 			std::array<GLuint, GBufferLayer::NUM_LAYERS> gbuffer_layers;
+			std::array<RenderTargetFormat, GBufferLayer::NUM_LAYERS> gbuffer_formats;
+
+			// The gbuffer's color draw buffers, with 'GL_NONE' in place of any layers that aren't allocated
+			std::array<GLenum, GBufferLayer::NUM_LAYERS - 1> gbuffer_draw_buffers;
 
             // Post-processing framebuffer
             GLuint post_framebuffer;
 		    GLuint post_buffer_hdr;
+			RenderTargetFormat post_buffer_hdr_format;
 
 			// Sprite quad
 			GLuint sprite_vao;
@@ -97,8 +217,13 @@ namespace sge
 			GLuint scene_shader_program;
             GLuint post_shader_program;
             GLint scene_program_view_uniform;
+			GLint scene_program_inv_proj_uniform;
 			GLint scene_program_light_dir_uniform;
 			GLint scene_program_light_intensity_uniform;
+			GLint scene_program_cluster_dims_uniform;
+			GLint scene_program_cluster_near_uniform;
+			GLint scene_program_cluster_slice_scale_uniform;
+			LightClusters_Buffers light_cluster_buffers;
 			GLint post_program_brightness_uniform;
 			GLint post_program_gamma_uniform;
 
@@ -111,9 +236,6 @@ namespace sge
             GLint debug_line_view_uniform;
             GLint debug_line_proj_uniform;
 
-            // Debug line buffer
-            std::vector<DebugLineVert> frame_debug_lines;
-
 			// Lightmask volume data
 			GLuint frustum_volume_ebo;
 
@@ -121,6 +243,25 @@ namespace sge
 			bool initialized_render_scene = false;
             RenderScene_Commands render_scene;
 			RenderResource resources;
+
+			// Double-buffered frames, so that one may be prepared while the other is submitted
+			std::array<Frame, 2> frames;
+			bool pipeline_render_prep = true;
+			int prepared_frame = -1;
+
+			// LODs chosen for each instance last frame, and the occlusion buffer, only touched by render prep
+			RenderScene_LodState lod_state;
+			RenderScene_Occlusion occlusion;
+
+			// Stats of the last frame submitted
+			OcclusionStats occlusion_stats;
+
+			// Per-pass timings, only touched on the context thread
+			RenderProfiler profiler;
+
+			// Render prep runs here (declared after 'frames', so that it's joined before they're destroyed)
+			TaskPool render_prep_pool{ 1 };
+			TaskGroup render_prep_tasks;
 		};
 	}
 }
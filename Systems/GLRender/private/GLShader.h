@@ -1,6 +1,7 @@
 // GLShader.h
 #pragma once
 
+#include <string>
 #include <Resource/Resources/Shader.h>
 #include "glew.h"
 
@@ -8,9 +9,20 @@ namespace sge
 {
 	namespace gl_render
 	{
+		/**
+		 * \brief Reads the source of the shader at the given path, inserting the given preprocessor definitions after its '#version' line.
+		 */
+		std::string read_shader_source(
+			const char* path,
+			const char* defines);
+
+		/**
+		 * \brief Loads and compiles the shader at the given path, inserting the given preprocessor definitions after its '#version' line.
+		 */
 		GLuint load_shader(
 			GLuint type,
-			const char* path);
+			const char* path,
+			const char* defines);
 
 		GLuint create_shader(
 			GLenum type,
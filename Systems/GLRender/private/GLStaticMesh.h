@@ -2,9 +2,14 @@
 #pragma once
 
 #include <array>
+#include <memory>
+#include <vector>
 #include <Core/Math/Vec3.h>
 #include <Core/Math/IVec3.h>
 #include <Core/Math/IVec2.h>
+#include <Resource/Misc/MeshOps.h>
+#include "Culling.h"
+#include "OcclusionBuffer.h"
 #include "glew.h"
 
 namespace sge
@@ -13,16 +18,23 @@ namespace sge
 	{
         namespace gl_static_mesh
         {
-            enum BufferIndex
+            /**
+             * \brief The maximum number of LODs (including the full detail mesh) kept for each mesh.
+             */
+            static constexpr std::size_t MAX_LODS = 4;
+
+            /**
+             * \brief A range of the element buffer drawing the mesh at a given level of detail.
+             */
+            struct MeshLod
             {
-                POSITION_BUFFER_INDEX,
-                NORMAL_BUFFER_INDEX,
-                TANGENT_BUFFER_INDEX,
-                BITANGENT_BUFFER_INDEX,
-                BITANGENT_SIGN_BUFFER_INDEX,
-                MATERIAL_UV_BUFFER_INDEX,
-                LIGHTMAP_UV_BUFFER_INDEX,
-                NUM_VERTEX_BUFFERS
+                GLuint start_element_index = 0;
+                GLsizei num_element_indices = 0;
+
+                /**
+                 * \brief The largest mesh-space distance from this LOD to the full detail mesh.
+                 */
+                float error = 0.f;
             };
 
             struct MeshSlice
@@ -37,30 +49,45 @@ namespace sge
                 GLuint vao = 0;
                 GLuint ebo = 0;
                 GLint num_total_elements = 0;
-                std::array<GLuint, NUM_VERTEX_BUFFERS> vertex_buffers;
+                BoundingSphere bounds;
+
+                /**
+                 * \brief The interleaved vertex buffer (see 'mesh_ops::PackedVertex').
+                 */
+                GLuint vbo = 0;
+
+                /**
+                 * \brief Vertex positions are quantized to the mesh bounds, and reconstructed as 'offset + scale * position'.
+                 */
+                Vec3 position_offset = Vec3::zero();
+                Vec3 position_scale = Vec3{ 1.f, 1.f, 1.f };
                 std::vector<MeshSlice> material_slices;
+
+                /**
+                 * \brief The element ranges of each LOD, in order of decreasing detail. The first is the full detail mesh.
+                 * All LODs share the vertex buffer, and their elements follow each other in the element buffer.
+                 */
+                std::array<MeshLod, MAX_LODS> lods;
+                std::size_t num_lods = 1;
+
+                /**
+                 * \brief Positions and elements of the coarsest LOD, rasterized when the mesh is used as an occluder.
+                 */
+                std::shared_ptr<const OccluderMesh> occluder;
             };
 
             /**
-             * \brief Uploads vertex data for the given static mesh.
+             * \brief Uploads vertex data for the given static mesh, and defines the vertex attributes of its VAO.
+             * \param vao The VAO of the mesh.
+             * \param vbo The buffer to store the vertices in.
              * \param num_vertices The number of vertices in the mesh.
-             * \param vertex_positions Array of vertex positions.
-             * \param vertex_normals Array of vertex normals.
-             * \param vertex_tangents Array of vertex tangents.
-             * \param vertex_bitangent_signs Array of bitangent signs.
-             * \param material_uv_coords Array of material UV coordinates.
-             * \param lightmap_uv_coords Array of lightmap UV coordaintes.
+             * \param vertices The interleaved vertices to upload (may be null, to only allocate storage).
              */
             void upload_static_mesh_vertex_data(
                 GLuint vao,
-                const GLuint vertex_buffers[],
+                GLuint vbo,
                 std::size_t num_vertices,
-                const Vec3* vertex_positions,
-                const HalfVec3* vertex_normals,
-                const HalfVec3* vertex_tangents,
-                const int8* vertex_bitangent_signs,
-                const UHalfVec2* material_uv_coords,
-                const UHalfVec2* lightmap_uv_coords);
+                const mesh_ops::PackedVertex* vertices);
 
             /**
              * \brief Uploads the given element buffer.
@@ -2,12 +2,19 @@
 #pragma once
 
 #include <Core/env.h>
+#include <Resource/Resources/CompressedTexture.h>
 #include "glew.h"
 
 namespace sge
 {
 	namespace gl_render
 	{
+        /**
+         * \brief Sets the wrapping and filtering parameters of the currently bound texture, sampling from levels 0 to 'max_level'.
+         */
+        void set_sampling_parameters(
+            GLint max_level);
+
         GLuint create_texture(
             int32 width,
             int32 height,
@@ -15,5 +22,34 @@ namespace sge
             GLenum internal_format,
             GLenum upload_format,
             GLenum upload_type);
+
+        /**
+         * \brief Sets up sampling parameters for the given texture, uploads its image and generates mipmaps.
+         * If a buffer is bound to GL_PIXEL_UNPACK_BUFFER, 'data' is an offset into that buffer.
+         */
+        void upload_texture(
+            GLuint id,
+            int32 width,
+            int32 height,
+            const void* data,
+            GLenum internal_format,
+            GLenum upload_format,
+            GLenum upload_type);
+
+        /**
+         * \brief Returns the internal format a cooked texture is uploaded with.
+         */
+        GLenum compressed_texture_format(
+            const CompressedTexture& texture);
+
+        /**
+         * \brief Sets up sampling parameters for the given texture, and uploads each mip level of a cooked texture.
+         * If a buffer is bound to GL_PIXEL_UNPACK_BUFFER, 'data' is an offset into that buffer.
+         * \param data The texture's blocks (laid out as in 'CompressedTexture::data').
+         */
+        void upload_compressed_texture(
+            GLuint id,
+            const CompressedTexture& texture,
+            const void* data);
 	}
 }
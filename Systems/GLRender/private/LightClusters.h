@@ -0,0 +1,120 @@
+// LightClusters.h
+#pragma once
+
+#include <vector>
+#include <Core/Math/Mat4.h>
+#include <Resource/Misc/Color.h>
+#include "glew.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* Dimensions of the cluster grid. The view is split into tiles on screen, and exponentially-spaced slices in depth. */
+		constexpr uint32 LIGHT_CLUSTER_TILES_X = 16;
+		constexpr uint32 LIGHT_CLUSTER_TILES_Y = 9;
+		constexpr uint32 LIGHT_CLUSTER_SLICES = 24;
+		constexpr uint32 NUM_LIGHT_CLUSTERS = LIGHT_CLUSTER_TILES_X * LIGHT_CLUSTER_TILES_Y * LIGHT_CLUSTER_SLICES;
+
+		/* The maximum number of lights shaded each frame. */
+		constexpr std::size_t MAX_CLUSTERED_LIGHTS = 4096;
+
+		/* Shader storage block bindings used by the scene shading program (see 'pbr_shading.frag'). */
+		constexpr GLuint LIGHT_BUFFER_BINDING = 0;
+		constexpr GLuint LIGHT_CLUSTER_BUFFER_BINDING = 1;
+		constexpr GLuint LIGHT_INDEX_BUFFER_BINDING = 2;
+
+		/**
+		 * \brief A point or spot light in world space, gathered from the scene each frame.
+		 */
+		struct LightClusters_Light
+		{
+			Vec3 position;
+			float radius = 0.f;
+			color::RGBF32 intensity;
+
+			/**
+			 * \brief The direction a spot light points in. Unused for point lights.
+			 */
+			Vec3 direction;
+
+			/**
+			 * \brief Cosines of the angles where a spot light begins to fade, and where it is fully faded.
+			 * Point lights use values below -1, so that every direction is fully lit.
+			 */
+			float cos_inner = -1.f;
+			float cos_outer = -2.f;
+		};
+
+		/**
+		 * \brief A light as laid out in the light buffer (std430 'Light' struct in the shading program), in view space.
+		 */
+		struct LightClusters_GPULight
+		{
+			float position[3];
+			float radius;
+			float intensity[3];
+			float cos_inner;
+			float direction[3];
+			float cos_outer;
+		};
+
+		/**
+		 * \brief The lights visible to a view, and the lights affecting each cluster of the view.
+		 */
+		struct LightClusters
+		{
+			std::vector<LightClusters_GPULight> lights;
+
+			/**
+			 * \brief Offset into 'light_indices' and number of lights, for each cluster.
+			 */
+			std::vector<uint32> cluster_ranges;
+
+			std::vector<uint32> light_indices;
+
+			/* Depth slicing parameters, 'slice = log(depth / near) * slice_scale'. */
+			float near = 0.f;
+			float slice_scale = 0.f;
+
+			/* View-space bounds of each cluster (structure of arrays), rebuilt when the projection changes. */
+			Mat4 cluster_proj_matrix;
+			std::vector<float> cluster_min[3];
+			std::vector<float> cluster_max[3];
+
+			/* Scratch (cluster, light) pairs found while assigning lights. */
+			std::vector<uint32> scratch_pairs;
+		};
+
+		/**
+		 * \brief GL buffers the light clusters are uploaded into.
+		 */
+		struct LightClusters_Buffers
+		{
+			GLuint light_buffer = 0;
+			GLuint cluster_buffer = 0;
+			GLuint index_buffer = 0;
+		};
+
+		/**
+		 * \brief Transforms the given lights into view space, and finds the lights whose spheres of influence intersect each cluster.
+		 * This does not touch GL, so may run on a worker thread.
+		 */
+		void LightClusters_assign(
+			LightClusters& clusters,
+			const Mat4& view_matrix,
+			const Mat4& proj_matrix,
+			const LightClusters_Light* lights,
+			std::size_t num_lights);
+
+		void LightClusters_init_buffers(
+			LightClusters_Buffers& buffers);
+
+		/**
+		 * \brief Uploads the given clusters, and binds the buffers to their shader storage bindings.
+		 */
+		void LightClusters_upload(
+			const LightClusters_Buffers& buffers,
+			const LightClusters& clusters);
+	}
+}
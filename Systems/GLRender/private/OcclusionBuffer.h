@@ -0,0 +1,93 @@
+// OcclusionBuffer.h
+#pragma once
+
+#include <vector>
+#include <Core/Math/Mat4.h>
+#include "Culling.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* Resolution of the software depth buffer occluders are rasterized into. The width must be a multiple of 4. */
+		constexpr int OCCLUSION_BUFFER_WIDTH = 256;
+		constexpr int OCCLUSION_BUFFER_HEIGHT = 128;
+
+		/**
+		 * \brief Simplified, position-only geometry of a mesh, rasterized on the CPU when the mesh is used as an occluder.
+		 */
+		struct OccluderMesh
+		{
+			std::vector<Vec3> positions;
+			std::vector<uint32> elements;
+		};
+
+		/**
+		 * \brief A low resolution depth buffer rasterized on the CPU, along with a hierarchical-Z pyramid built from it.
+		 * Depth is stored as 1/w (so larger is nearer, and empty pixels are 0), since that interpolates linearly in screen space.
+		 */
+		struct OcclusionBuffer
+		{
+			int width = 0;
+			int height = 0;
+
+			/**
+			 * \brief The nearest occluder depth at each pixel.
+			 */
+			std::vector<float> depth;
+
+			/**
+			 * \brief Mip levels of the depth buffer, each texel storing the farthest depth of the four below it.
+			 * Level 0 is half the resolution of 'depth'.
+			 */
+			std::vector<std::vector<float>> hiz;
+
+			/**
+			 * \brief The number of occluder triangles rasterized since the last clear.
+			 */
+			std::size_t num_triangles = 0;
+		};
+
+		/**
+		 * \brief Resizes the given buffer (if needed), and clears it to empty.
+		 */
+		void OcclusionBuffer_clear(
+			OcclusionBuffer& buffer,
+			int width,
+			int height);
+
+		/**
+		 * \brief Rasterizes the given occluder mesh into the depth buffer. Triangles are not backface culled.
+		 * \param buffer The buffer to rasterize into.
+		 * \param world_view_proj The combined transform from the occluder's local space into clip space.
+		 * \param mesh The occluder mesh to rasterize.
+		 */
+		void OcclusionBuffer_rasterize(
+			OcclusionBuffer& buffer,
+			const Mat4& world_view_proj,
+			const OccluderMesh& mesh);
+
+		/**
+		 * \brief Builds the hierarchical-Z pyramid, once all occluders have been rasterized.
+		 */
+		void OcclusionBuffer_build_hiz(
+			OcclusionBuffer& buffer);
+
+		/**
+		 * \brief Returns whether the given world-space sphere is entirely hidden behind the occluders in the buffer.
+		 * This is conservative, so spheres crossing the near plane or the edge of the screen are never reported as occluded.
+		 */
+		bool OcclusionBuffer_is_occluded(
+			const OcclusionBuffer& buffer,
+			const Mat4& view_proj,
+			const BoundingSphere& world_sphere);
+
+		/**
+		 * \brief Builds an occluder mesh from the given triangles, keeping only the referenced positions.
+		 */
+		OccluderMesh make_occluder_mesh(
+			const Vec3* positions,
+			const uint32* elements,
+			std::size_t num_elements);
+	}
+}
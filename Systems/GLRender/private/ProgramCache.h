@@ -0,0 +1,51 @@
+// ProgramCache.h
+#pragma once
+
+#include <string>
+#include <functional>
+#include "../include/GLRender/GLRenderSystem.h"
+#include "glew.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/**
+		 * \brief A persistent on-disk cache of linked program binaries, keyed by a hash of the program's shader sources (including
+		 * any inserted definitions) and the driver. Binaries the driver rejects are recompiled and replaced.
+		 */
+		struct ProgramCache
+		{
+			/**
+			 * \brief The directory binaries are stored in. The cache is disabled if empty, or if the driver supports no binary formats.
+			 */
+			std::string directory;
+			bool enabled = false;
+
+			/**
+			 * \brief Hash of the driver's vendor, renderer and version strings.
+			 */
+			uint64 driver_hash = 0;
+
+			ProgramCacheStats stats;
+		};
+
+		/**
+		 * \brief Initializes the given cache, creating its directory if it doesn't exist. Must be called on the context thread.
+		 */
+		void ProgramCache_init(
+			ProgramCache& cache,
+			const char* directory);
+
+		/**
+		 * \brief Creates a program from the given shader sources, loading its binary from the cache if possible.
+		 * Otherwise, 'link' is called to attach shaders, bind attributes and link the given program, and the result is cached.
+		 * \return The program. The caller is responsible for checking its link status.
+		 */
+		GLuint ProgramCache_get_program(
+			ProgramCache& cache,
+			const std::string* const* sources,
+			std::size_t num_sources,
+			const std::function<void(GLuint program)>& link);
+	}
+}
@@ -2,6 +2,8 @@
 #pragma once
 
 #include "GLMaterial.h"
+#include "Culling.h"
+#include "LightClusters.h"
 #include "../include/GLRender/GLRenderSystem.h"
 
 namespace sge
@@ -27,6 +29,17 @@ namespace sge
             GLuint start_element_index = 0;
             GLsizei num_element_indices = 0;
 			GLint base_vertex = 0;
+
+			/**
+			 * \brief Dequantization applied to vertex positions ('offset + scale * position').
+			 */
+			Vec3 position_offset = Vec3::zero();
+			Vec3 position_scale = Vec3{ 1.f, 1.f, 1.f };
+
+			/**
+			 * \brief Local-space bounds of the mesh, used for culling.
+			 */
+			BoundingSphere bounds;
         };
 
 		struct RenderCommand_Lines
@@ -35,6 +48,21 @@ namespace sge
 			GLsizei num_verts = 0;
 		};
 
+		/**
+		 * \brief Running totals of the work issued on the context thread, diffed by the profiler to attribute work to passes.
+		 */
+		struct RenderCommand_Counters
+		{
+			std::size_t num_draw_calls = 0;
+			std::size_t num_triangles = 0;
+			std::size_t num_state_changes = 0;
+		};
+
+		/**
+		 * \brief Returns the counters the render commands add to. Only for use on the context thread.
+		 */
+		RenderCommand_Counters& RenderCommand_counters();
+
         /**
          * \brief Sets up and clears the given GBuffer for rendering.
          */
@@ -46,11 +74,18 @@ namespace sge
 			const GLuint width,
 			const GLuint height);
 
+		/**
+		 * \brief Binds the given 2D texture to the given texture unit (eg, 'GL_TEXTURE0').
+		 */
+		void RenderCommand_bind_texture(
+			const GLenum texture_slot,
+			const GLuint texture);
+
 	    /**
 		 * \brief Command to bind the given material for rendering.
 		 * \param program_id The id of the material to bind.
 		 * \param uniforms Uniform locations for the material.
-		 * \param params Parameters to set for the material.
+		 * \param params Compiled parameters to bind for the material.
 		 * \param view_matrix The view matrix to set for the material.
 		 * \param proj_matrix Projection matrix to set for the material.
 		 */
@@ -83,9 +118,14 @@ namespace sge
 			const RenderCommand_Lines* lines,
 			std::size_t num_lines);
 
+        /**
+         * \brief Shades the GBuffer with the scene's directional light, and the clustered lights of the frame (which must be uploaded).
+         */
         void render_scene_shade_hdr(
             GLuint framebuffer,
             const GLRenderSystem::State& render_scene,
-            Mat4 view);
+            Mat4 view,
+            Mat4 proj,
+            const LightClusters& light_clusters);
     }
 }
@@ -0,0 +1,82 @@
+// RenderProfiler.h
+#pragma once
+
+#include <chrono>
+#include "../include/GLRender/GLRenderSystem.h"
+#include "RenderCommands.h"
+#include "glew.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* The number of frames of queries in flight. Results are read back this many frames after they were issued. */
+		constexpr std::size_t RENDER_PROFILER_LATENCY = 2;
+
+		/**
+		 * \brief Measures the GPU and CPU cost of each pass of a frame, along with the work issued in it.
+		 * Uses 'GL_TIME_ELAPSED' queries, so passes must not overlap.
+		 */
+		struct RenderProfiler
+		{
+			bool enabled = false;
+
+			/**
+			 * \brief Whether to periodically print the average cost of each pass.
+			 */
+			bool print_summary = false;
+
+			GLuint queries[RENDER_PROFILER_LATENCY][RenderPass::NUM_PASSES] = {};
+			bool issued[RENDER_PROFILER_LATENCY][RenderPass::NUM_PASSES] = {};
+
+			/**
+			 * \brief CPU timings and counters of the frames whose GPU timings are still in flight.
+			 */
+			RenderFrameStats pending[RENDER_PROFILER_LATENCY];
+			std::size_t frame_index = 0;
+
+			/* The pass currently being measured. */
+			std::size_t active_pass = RenderPass::NUM_PASSES;
+			std::chrono::high_resolution_clock::time_point pass_start;
+			RenderCommand_Counters pass_start_counters;
+
+			/**
+			 * \brief The most recent frame whose GPU timings have been read back.
+			 */
+			RenderFrameStats last_stats;
+
+			/* Totals since the summary was last printed. */
+			RenderFrameStats summary_totals;
+			std::size_t summary_frames = 0;
+			std::chrono::high_resolution_clock::time_point summary_start;
+		};
+
+		/**
+		 * \brief Creates the profiler's queries. Does nothing if the profiler is not enabled.
+		 */
+		void RenderProfiler_init(
+			RenderProfiler& profiler);
+
+		void RenderProfiler_free(
+			RenderProfiler& profiler);
+
+		/**
+		 * \brief Starts a new frame, collecting the results of the frame issued 'RENDER_PROFILER_LATENCY' frames ago into 'last_stats'.
+		 */
+		void RenderProfiler_begin_frame(
+			RenderProfiler& profiler);
+
+		void RenderProfiler_begin_pass(
+			RenderProfiler& profiler,
+			std::size_t pass);
+
+		void RenderProfiler_end_pass(
+			RenderProfiler& profiler);
+
+		/**
+		 * \brief Finishes the current frame, printing a summary if one is due.
+		 */
+		void RenderProfiler_end_frame(
+			RenderProfiler& profiler);
+	}
+}
@@ -1,22 +1,222 @@
 // RenderResource.h
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <Core/Parallelism/TaskPool.h>
+#include <Resource/ResourceCache.h>
+#include <Resource/PathId.h>
+#include <Resource/Resources/StaticMesh.h>
+#include <Resource/Resources/Material.h>
+#include <Resource/Resources/Texture.h>
+#include <Resource/Resources/CompressedTexture.h>
+#include <Resource/Resources/HDRImage.h>
 #include "GLMaterial.h"
 #include "GLShader.h"
 #include "GLStaticMesh.h"
+#include "ProgramCache.h"
+#include "TextureResidency.h"
 
 namespace sge
 {
 	namespace gl_render
 	{
+		/* The number of threads used to decode streamed resources. */
+		static constexpr std::size_t NUM_STREAMING_THREADS = 2;
+
+		/* The maximum number of bytes copied into GL buffer objects by streaming each frame. */
+		static constexpr std::size_t STREAMING_UPLOAD_BUDGET = 4 * 1024 * 1024;
+
+		/* Categories of resources in 'RenderResource::cache', each with its own budget. */
+		static constexpr std::size_t CACHE_STATIC_MESHES = 0;
+		static constexpr std::size_t CACHE_MATERIALS = 1;
+		static constexpr std::size_t CACHE_TEXTURES = 2;
+		static constexpr std::size_t NUM_CACHE_CATEGORIES = 3;
+
+		/**
+		 * \brief A region of decoded data waiting to be copied into a GL buffer object.
+		 */
+		struct RenderResource_Upload
+		{
+			GLuint buffer = 0;
+			const byte* data = nullptr;
+			std::size_t size = 0;
+
+			/**
+			 * \brief The number of bytes already copied.
+			 */
+			std::size_t offset = 0;
+		};
+
+		struct RenderResource_StreamingMesh
+		{
+			PathId id = NULL_PATH_ID;
+			std::string path;
+
+			/* Decoded on a streaming thread. */
+			StaticMesh mesh;
+			std::vector<mesh_ops::PackedVertex> packed_verts;
+
+			/* Elements of each LOD, one after the other. */
+			std::vector<uint32> elements;
+			bool loaded = false;
+
+			/* Created on the context thread once decoded. */
+			gl_static_mesh::StaticMesh gl_mesh;
+			std::vector<RenderResource_Upload> uploads;
+		};
+
+		struct RenderResource_StreamingTexture
+		{
+			PathId id = NULL_PATH_ID;
+			std::string path;
+			bool hdr = false;
+
+			/**
+			 * \brief The texture name handed out to materials, which the image is uploaded into once streamed.
+			 */
+			GLuint texture = 0;
+
+			/* Decoded on a streaming thread. The cooked texture is used instead of the image when one exists. */
+			Texture image;
+			HDRImage hdr_image;
+			CompressedTexture cooked;
+			bool is_cooked = false;
+			bool loaded = false;
+
+			/* Created on the context thread once decoded. */
+			GLuint pixel_buffer = 0;
+			RenderResource_Upload upload;
+		};
+
+		struct RenderResource_StreamingMaterial
+		{
+			PathId id = NULL_PATH_ID;
+			std::string path;
+
+			/* Decoded on a streaming thread. */
+			Material material;
+			bool loaded = false;
+
+			/* Created on the context thread once decoded, and published once all textures are resident. */
+			gl_material::Material gl_material;
+			std::vector<PathId> texture_ids;
+
+			/* The size of the material's program binary and parameter block. */
+			std::size_t size = 0;
+		};
+
+		/**
+		 * \brief Resources that have been requested, but are not resident yet.
+		 * Decoding happens on 'pool', and decoded resources are handed back to the context thread through the 'decoded_*' arrays.
+		 */
+		struct RenderResource_Streaming
+		{
+			TaskGroup tasks;
+
+			std::unordered_map<PathId, std::unique_ptr<RenderResource_StreamingMesh>> meshes;
+			std::unordered_map<PathId, std::unique_ptr<RenderResource_StreamingTexture>> textures;
+			std::unordered_map<PathId, std::unique_ptr<RenderResource_StreamingMaterial>> materials;
+
+			/* Decoded resources, waiting to be picked up by the context thread. Guarded by 'decoded_lock'. */
+			std::mutex decoded_lock;
+			std::vector<RenderResource_StreamingMesh*> decoded_meshes;
+			std::vector<RenderResource_StreamingTexture*> decoded_textures;
+			std::vector<RenderResource_StreamingMaterial*> decoded_materials;
+
+			/* Resources being uploaded, in request order. */
+			std::vector<RenderResource_StreamingMesh*> uploading_meshes;
+			std::vector<RenderResource_StreamingTexture*> uploading_textures;
+
+			/* Materials waiting on textures. */
+			std::vector<RenderResource_StreamingMaterial*> waiting_materials;
+
+			/* Declared last, so that decode tasks are finished before anything they write to is destroyed. */
+			TaskPool pool{ NUM_STREAMING_THREADS };
+		};
+
+		/**
+		 * \brief Resident resources of a single kind, indexed by the interned id of their path.
+		 */
+		template <typename T>
+		struct RenderResource_Table
+		{
+			std::vector<T> values;
+			std::vector<bool> resident;
+		};
+
+		template <typename T>
+		T* RenderResource_Table_find(
+			RenderResource_Table<T>& table,
+			PathId id)
+		{
+			return id < table.resident.size() && table.resident[id] ? &table.values[id] : nullptr;
+		}
+
+		template <typename T>
+		const T* RenderResource_Table_find(
+			const RenderResource_Table<T>& table,
+			PathId id)
+		{
+			return id < table.resident.size() && table.resident[id] ? &table.values[id] : nullptr;
+		}
+
+		template <typename T>
+		void RenderResource_Table_insert(
+			RenderResource_Table<T>& table,
+			PathId id,
+			T value)
+		{
+			if (id >= table.values.size())
+			{
+				// Grow only as far as this kind of resource needs (vectors grow geometrically, so this stays amortized)
+				table.values.resize(id + 1);
+				table.resident.resize(id + 1, false);
+			}
+
+			table.values[id] = std::move(value);
+			table.resident[id] = true;
+		}
+
+		template <typename T>
+		void RenderResource_Table_erase(
+			RenderResource_Table<T>& table,
+			PathId id)
+		{
+			table.values[id] = T{};
+			table.resident[id] = false;
+		}
+
 		struct RenderResource
 		{
-			/* Dynamically loaded resources. */
-			std::unordered_map<std::string, gl_material::Material> material_resources;
-			std::unordered_map<std::string, gl_static_mesh::StaticMesh> static_mesh_resources;
+			/* Resident resources. */
+			RenderResource_Table<gl_material::Material> material_resources;
+			RenderResource_Table<gl_static_mesh::StaticMesh> static_mesh_resources;
+			RenderResource_Table<GLuint> texture_2d_resources;
 			std::unordered_map<std::string, GLuint> shader_resources;
-			std::unordered_map<std::string, GLuint> texture_2d_resources;
+			std::unordered_map<std::string, std::string> shader_sources;
+
+			/* Resources being streamed in. */
+			RenderResource_Streaming streaming;
+
+			/* Sizes, references and use of meshes, materials and textures, for evicting those no longer used. */
+			ResourceCache<PathId> cache{ NUM_CACHE_CATEGORIES };
+
+			/* The textures each material holds references to, indexed by the material's id. */
+			std::vector<std::vector<PathId>> material_texture_ids;
+
+			/* Mip levels of cooked textures and encoded lightmaps resident on the GPU. */
+			TextureResidency residency;
+
+			/* Parameter blocks for all loaded materials. */
+			gl_material::MaterialParamBuffer material_param_buffer;
+
+			/* Preprocessor definitions and shared functions inserted after the '#version' line of every shader loaded. */
+			std::string shader_defines;
+
+			/* Cached binaries of linked material programs. */
+			ProgramCache program_cache;
 
 			/* Default resources. */
 			gl_material::Material missing_material;
@@ -27,21 +227,90 @@ namespace sge
 			GLuint frustum_ebo;
 		};
 
+		/**
+		 * \brief Returns the material at the given path if it is resident, otherwise begins streaming it and returns 'missing_material'.
+		 */
 		const gl_material::Material& RenderResource_get_material_resource(
 			RenderResource& resources,
-			const char* path);
+			PathId path);
 
+		/**
+		 * \brief Returns the mesh at the given path if it is resident, otherwise begins streaming it and returns 'missing_mesh'.
+		 */
 		const gl_static_mesh::StaticMesh& RenderResource_get_static_mesh_resource(
+			RenderResource& resources,
+			PathId path);
+
+		/**
+		 * \brief Returns the source of the shader at the given path (with 'shader_defines' inserted), reading it if needed.
+		 */
+		const std::string& RenderResource_get_shader_source(
 			RenderResource& resources,
 			const char* path);
 
+		/**
+		 * \brief Returns the compiled shader at the given path, compiling it if needed.
+		 */
 		GLuint RenderResource_get_shader_resource(
 			RenderResource& resources,
 			const char* path);
 
+		/**
+		 * \brief Returns the texture name for the given path. If the texture is being streamed, its image is uploaded into this name once ready.
+		 */
 		GLuint RenderResource_get_texture_2d_resource(
 			RenderResource& resources,
-			const char* path,
+			PathId path,
 			bool hdr);
+
+		/**
+		 * \brief Returns whether the given material has finished streaming (or failed to load).
+		 */
+		bool RenderResource_is_material_resident(
+			const RenderResource& resources,
+			PathId path);
+
+		/**
+		 * \brief Returns whether the given mesh has finished streaming (or failed to load).
+		 */
+		bool RenderResource_is_static_mesh_resident(
+			const RenderResource& resources,
+			PathId path);
+
+		/**
+		 * \brief Adds a reference to the requested mesh, material or texture at the given path, which keeps it from being evicted.
+		 */
+		void RenderResource_add_ref(
+			RenderResource& resources,
+			PathId path);
+
+		/**
+		 * \brief Removes a reference added with 'RenderResource_add_ref'.
+		 */
+		void RenderResource_release(
+			RenderResource& resources,
+			PathId path);
+
+		/**
+		 * \brief Destroys unreferenced resident meshes, materials and textures (least recently used first) until each kind fits in its cache budget.
+		 * Nothing may still refer to the GL objects of unreferenced resources, so this should only be called once the render scene has been rebuilt.
+		 * \return The number of resources destroyed.
+		 */
+		std::size_t RenderResource_evict_unused(
+			RenderResource& resources);
+
+		/**
+		 * \brief Creates GL objects for newly decoded resources, and continues uploads within the given byte budget.
+		 * \return The number of meshes and materials that became resident.
+		 */
+		std::size_t RenderResource_update_streaming(
+			RenderResource& resources,
+			std::size_t upload_budget);
+
+		/**
+		 * \brief Blocks until all requested resources are resident.
+		 */
+		void RenderResource_flush_streaming(
+			RenderResource& resources);
 	}
 }
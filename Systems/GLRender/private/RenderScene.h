@@ -1,8 +1,16 @@
 // RenderScene.h
 #pragma once
 
+#include <unordered_map>
+#include <Core/Parallelism/TaskPool.h>
 #include <Engine/Components/Display/CSpotlight.h>
+#include <Resource/PathId.h>
 #include "RenderCommands.h"
+#include "GLStaticMesh.h"
+#include "OcclusionBuffer.h"
+#include "LightClusters.h"
+#include "ShadowAtlas.h"
+#include "RenderProfiler.h"
 
 namespace sge
 {
@@ -12,12 +20,39 @@ namespace sge
 	{
 		struct RenderResource;
 
+		/**
+		 * \brief The projected error (as a fraction of screen height) a LOD may have before a more detailed one is used.
+		 */
+		static constexpr float LOD_SCREEN_ERROR = 0.001f;
+
+		/**
+		 * \brief How far (relative to 'LOD_SCREEN_ERROR') the projected error must move past the threshold before an instance switches LOD.
+		 */
+		static constexpr float LOD_HYSTERESIS = 0.25f;
+
+		/* The number of threads (besides the render prep thread) that test instances against the occlusion buffer. */
+		static constexpr std::size_t NUM_OCCLUSION_THREADS = 2;
+
+		/* The number of meshes whose instances are tested by each occlusion task. */
+		static constexpr std::size_t OCCLUSION_MESHES_PER_TASK = 16;
+
+		/* The maximum number of occluders rasterized each frame, chosen by size on screen. */
+		static constexpr std::size_t OCCLUSION_MAX_OCCLUDERS = 32;
+
+		/* Static mesh instances whose bounds cover at least this fraction of the screen height are used as occluders. */
+		static constexpr float OCCLUDER_MIN_SCREEN_SIZE = 0.1f;
+
 		struct RenderScene_Lightmap
 		{
 			GLuint x_basis_tex = 0;
 			GLuint y_basis_tex = 0;
 			GLuint z_basis_tex = 0;
 			GLuint direct_mask_tex = 0;
+
+			/**
+			 * \brief The size of each basis texture outside of texture streaming (only float lightmaps, which are always fully resident).
+			 */
+			std::size_t basis_unmanaged_size = 0;
 		};
 
 		struct RenderScene_Mesh
@@ -36,6 +71,17 @@ namespace sge
 			 * \brief Array symmetrical with 'instance_commands', stores the ids for each node.
 			 */
 			std::vector<NodeId> node_ids;
+
+			/**
+			 * \brief Element ranges for each LOD of the mesh (see 'gl_static_mesh::StaticMesh::lods').
+			 */
+			std::array<gl_static_mesh::MeshLod, gl_static_mesh::MAX_LODS> lods;
+			size_t num_lods = 1;
+
+			/**
+			 * \brief Geometry rasterized when instances of this mesh are large enough to be occluders.
+			 */
+			std::shared_ptr<const OccluderMesh> occluder;
 		};
 
 		struct RenderScene_Material
@@ -50,10 +96,36 @@ namespace sge
 			NodeId node_id;
 			Mat4 view_matrix;
 			Mat4 proj_matrix;
-			GLuint shadow_framebuffer = 0;
-			GLuint shadow_depthbuffer = 0;
-			GLuint shadow_width = 0;
-			GLuint shadow_height = 0;
+
+			/**
+			 * \brief World-space frustum of the light, used to cull shadow casters.
+			 */
+			Frustum frustum;
+
+			/**
+			 * \brief Sphere around the light's position, with the far clipping plane as its radius. Used to size the shadow tile.
+			 */
+			BoundingSphere light_bounds;
+
+			/**
+			 * \brief The largest shadow tile this light may be given (from the component's shadow map size).
+			 */
+			GLuint max_shadow_size = 0;
+
+			/**
+			 * \brief Region of the shadow atlas this light renders to.
+			 */
+			ShadowAtlasTile shadow_tile;
+
+			/**
+			 * \brief Whether the cached shadow depth is invalid, because the light or a caster inside its frustum changed.
+			 */
+			bool shadow_dirty = true;
+
+			/**
+			 * \brief Whether the shadow depth should be re-rendered this frame (set by 'RenderScene_update_shadow_tiles').
+			 */
+			bool redraw_shadow = false;
 		};
 
 		struct RenderScene_LightmaskVolume
@@ -72,12 +144,41 @@ namespace sge
 			gl_material::Material material;
 			RenderCommand_Mesh mesh;
 			RenderCommand_MeshInstance mesh_instance;
+
+			/**
+			 * \brief Geometry rasterized into the occlusion buffer, for lightmask occluders.
+			 */
+			std::shared_ptr<const OccluderMesh> occluder;
+		};
+
+		/**
+		 * \brief A static mesh that was inserted with placeholder resources, while its own were streamed in.
+		 */
+		struct RenderScene_PendingStaticMesh
+		{
+			NodeId node_id;
+			PathId mesh_path = NULL_PATH_ID;
+			PathId material_path = NULL_PATH_ID;
+		};
+
+		/**
+		 * \brief The resources a static mesh in the scene holds references to.
+		 */
+		struct RenderScene_StaticMeshResources
+		{
+			PathId mesh_path = NULL_PATH_ID;
+			PathId material_path = NULL_PATH_ID;
 		};
 
 		struct RenderScene_Commands
 		{
 			std::vector<RenderScene_Spotlight> spotlights;
 
+			/**
+			 * \brief Depth atlas shared by all shadow-casting spotlights.
+			 */
+			ShadowAtlas shadow_atlas;
+
 			/**
 			 * \brief Rendering commands for all standard path objects.
 			 */
@@ -91,6 +192,16 @@ namespace sge
 
 			std::vector<RenderScene_LightmaskObject> lightmask_occluder_mesh_instances;
 
+			/**
+			 * \brief Static meshes to re-insert once their resources are resident.
+			 */
+			std::vector<RenderScene_PendingStaticMesh> pending_static_meshes;
+
+			/**
+			 * \brief The resources referenced by each static mesh in the scene, released when it's removed.
+			 */
+			std::map<NodeId, RenderScene_StaticMeshResources> static_mesh_resources;
+
 			/**
 			 * \brief Mapping between objects and their lightmaps.
 			 */
@@ -101,12 +212,178 @@ namespace sge
 			color::RGBF32 light_intensity;
 		};
 
-		void RenderScene_render(
+		struct RenderScene_FrameMesh
+		{
+			/**
+			 * \brief Index of the material this mesh is rendered with, in 'RenderScene_Frame::materials'.
+			 */
+			size_t material_index = 0;
+
+			RenderCommand_Mesh mesh_command;
+
+			std::vector<RenderCommand_MeshInstance> instance_commands;
+
+			/**
+			 * \brief Array symmetrical with 'instance_commands', stores the ids for each node.
+			 */
+			std::vector<NodeId> node_ids;
+
+			std::array<gl_static_mesh::MeshLod, gl_static_mesh::MAX_LODS> lods;
+			size_t num_lods = 1;
+
+			/**
+			 * \brief Array symmetrical with 'instance_commands', the LOD each instance is drawn with (chosen by 'RenderScene_prepare_frame').
+			 */
+			std::vector<uint32> instance_lods;
+
+			std::shared_ptr<const OccluderMesh> occluder;
+
+			/**
+			 * \brief Array symmetrical with 'instance_commands', whether each instance is hidden from the camera by occluders.
+			 */
+			std::vector<uint8> instance_occluded;
+		};
+
+		/**
+		 * \brief A run of visible instances of a single mesh, rendered with a single material.
+		 */
+		struct RenderScene_FrameBatch
+		{
+			size_t material_index = 0;
+			RenderCommand_Mesh mesh_command;
+			size_t start_instance = 0;
+			size_t num_instances = 0;
+		};
+
+		/**
+		 * \brief The batches and lightmask receivers visible from a single view.
+		 */
+		struct RenderScene_FramePass
+		{
+			/**
+			 * \brief Index of the spotlight this pass renders the shadow for (unused for the camera pass).
+			 */
+			size_t spotlight_index = 0;
+			size_t start_batch = 0;
+			size_t num_batches = 0;
+			size_t start_receiver = 0;
+			size_t num_receivers = 0;
+		};
+
+		/**
+		 * \brief The LOD each instance was drawn with last frame, so that LOD changes can be damped.
+		 * Owned by whichever thread prepares frames.
+		 */
+		struct RenderScene_LodState
+		{
+			std::unordered_map<uint64, uint32> instance_lods;
+
+			/* Scratch map the current frame's LODs are written to, swapped with 'instance_lods' once done. */
+			std::unordered_map<uint64, uint32> next_instance_lods;
+		};
+
+		/**
+		 * \brief Software occlusion culling state, owned by whichever thread prepares frames.
+		 */
+		struct RenderScene_Occlusion
+		{
+			bool enabled = true;
+			OcclusionBuffer buffer;
+
+			/* Per-task culling counts, summed into the frame's stats. */
+			std::vector<OcclusionStats> task_stats;
+
+			TaskGroup tasks;
+
+			/* Declared last, so that tasks are finished before anything they write to is destroyed. */
+			TaskPool pool{ NUM_OCCLUSION_THREADS };
+		};
+
+		/**
+		 * \brief A snapshot of the render scene for a single frame, along with the draw lists built from it.
+		 * The snapshot is taken on the context thread with 'RenderScene_snapshot', the draw lists are built with 'RenderScene_prepare_frame'
+		 * (which makes no GL calls, so may run on a worker thread), and the result is submitted on the context thread with 'RenderScene_render'.
+		 */
+		struct RenderScene_Frame
+		{
+			/* Snapshot */
+			Mat4 view_matrix;
+			Mat4 proj_matrix;
+			std::vector<gl_material::Material> materials;
+			std::vector<RenderScene_FrameMesh> meshes;
+			std::vector<RenderScene_LightmaskVolume> lightmask_volumes;
+			std::vector<RenderScene_LightmaskObject> lightmask_receivers;
+			std::vector<RenderScene_LightmaskObject> lightmask_occluders;
+			std::vector<RenderScene_Spotlight> spotlights;
+			GLuint shadow_atlas_framebuffer = 0;
+
+			/**
+			 * \brief Point lights and non-shadowed spot lights, gathered from the scene when the frame was simulated.
+			 */
+			std::vector<LightClusters_Light> lights;
+
+			/* Draw lists */
+			RenderScene_FramePass camera_pass;
+			std::vector<RenderScene_FramePass> shadow_passes;
+			std::vector<RenderScene_FrameBatch> batches;
+			std::vector<RenderCommand_MeshInstance> instances;
+
+			/**
+			 * \brief Indices of visible lightmask receivers (into 'lightmask_receivers'), referenced by each pass.
+			 */
+			std::vector<size_t> receiver_indices;
+
+			OcclusionStats occlusion_stats;
+
+			/**
+			 * \brief The largest size (as a fraction of the screen height, scaled by UV tiling) each texture covers on any instance visible to the camera.
+			 * Used to choose which mip levels of each texture must be resident.
+			 */
+			std::unordered_map<GLuint, float> texture_demand;
+
+			/**
+			 * \brief The lights affecting each cluster of the camera's view.
+			 */
+			LightClusters light_clusters;
+		};
+
+		/**
+		 * \brief Copies the state of the render scene required to render a frame from the given view.
+		 * Storage in the frame object from previous frames is reused.
+		 */
+		void RenderScene_snapshot(
 			const RenderScene_Commands& commands,
+			const Mat4& view_matrix,
+			const Mat4& proj_matrix,
+			RenderScene_Frame& out_frame);
+
+		/**
+		 * \brief Selects the LOD of each instance from its projected size, culls the snapshot in the given frame against the camera
+		 * (and the occluders in front of it) and each spotlight that needs its shadow redrawn, fills the draw lists, assigns lights to clusters,
+		 * and gathers the size on screen of each texture the camera sees.
+		 * This does not touch GL or the render scene, so it is safe to run on a worker thread.
+		 */
+		void RenderScene_prepare_frame(
+			RenderScene_Frame& frame,
+			RenderScene_LodState& lod_state,
+			RenderScene_Occlusion& occlusion);
+
+		/**
+		 * \brief Submits the draw lists of a prepared frame.
+		 */
+		void RenderScene_render(
+			const RenderScene_Frame& frame,
 			const RenderResource& resources,
 			const GLuint gbuffer,
 			const GLuint gbuffer_width,
 			const GLuint gbuffer_height,
+			RenderProfiler& profiler);
+
+		/**
+		 * \brief Resizes each spotlight's shadow tile based on its screen coverage, and determines which shadows must be re-rendered this frame.
+		 */
+		void RenderScene_update_shadow_tiles(
+			RenderScene_Commands& commands,
 			const Mat4& view_matrix,
 			const Mat4& proj_matrix);
 
@@ -123,8 +400,18 @@ namespace sge
 			const CStaticMesh* const* const static_meshes,
 			const size_t num_static_meshes);
 
+		/**
+		 * \brief Finds static meshes that were inserted with placeholder resources whose own resources are now resident.
+		 * These are removed from the pending list, and should be removed and re-inserted by the caller.
+		 */
+		void RenderScene_take_streamed_static_meshes(
+			RenderScene_Commands& commands,
+			const RenderResource& resources,
+			std::vector<NodeId>& out_node_ids);
+
 		void RenderScene_remove_static_mesh_commands(
 			RenderScene_Commands& commands,
+			RenderResource& resources,
 			const NodeId* const node_ids,
 			const size_t num_nodes);
 
@@ -147,7 +434,11 @@ namespace sge
 			NodeId* const node_ids,
 			size_t num_nodes);
 
+		/**
+		 * \brief Removes everything from the scene, and releases the resources it referenced.
+		 */
 		void RenderScene_clear(
-			RenderScene_Commands& commands);
+			RenderScene_Commands& commands,
+			RenderResource& resources);
 	}
 }
@@ -0,0 +1,80 @@
+// ShadowAtlas.h
+#pragma once
+
+#include <vector>
+#include <Core/env.h>
+#include "glew.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* Size of the shadow atlas depth texture, and the smallest tile it may be split into. */
+		constexpr GLuint SHADOW_ATLAS_SIZE = 4096;
+		constexpr GLuint SHADOW_ATLAS_MIN_TILE_SIZE = 128;
+
+		struct ShadowAtlasTile
+		{
+			GLuint x = 0;
+			GLuint y = 0;
+			GLuint size = 0;
+		};
+
+		/**
+		 * \brief A single depth texture shared by all shadow-casting lights, split into power-of-two tiles.
+		 * Tiles are pooled in free lists per size class, and split from (or merged back into) larger tiles as needed.
+		 */
+		struct ShadowAtlas
+		{
+			GLuint depth_texture = 0;
+			GLuint framebuffer = 0;
+			GLuint size = 0;
+			GLuint min_tile_size = 0;
+
+			/**
+			 * \brief Free tiles for each size class, where class 'i' has tiles of size 'size >> i'.
+			 */
+			std::vector<std::vector<ShadowAtlasTile>> free_tiles;
+		};
+
+		/**
+		 * \brief Creates the depth texture and framebuffer for the given atlas, and resets its free lists.
+		 */
+		void ShadowAtlas_init(
+			ShadowAtlas& atlas,
+			GLuint size,
+			GLuint min_tile_size);
+
+		/**
+		 * \brief Returns every tile to the atlas.
+		 */
+		void ShadowAtlas_reset(
+			ShadowAtlas& atlas);
+
+		/**
+		 * \brief Rounds the given size to the tile size class the atlas would allocate for it.
+		 */
+		GLuint ShadowAtlas_tile_size_for(
+			const ShadowAtlas& atlas,
+			GLuint desired_size);
+
+		/**
+		 * \brief Allocates a tile of the given size, falling back to smaller tiles if the atlas is too full.
+		 * \param atlas The atlas to allocate from.
+		 * \param desired_size The desired tile size, which is rounded to a size class.
+		 * \param out_tile The allocated tile. Has a size of 0 if no tile could be allocated.
+		 * \return Whether a tile was allocated.
+		 */
+		bool ShadowAtlas_alloc_tile(
+			ShadowAtlas& atlas,
+			GLuint desired_size,
+			ShadowAtlasTile* out_tile);
+
+		/**
+		 * \brief Returns the given tile to the atlas, merging it with its siblings if they're all free.
+		 */
+		void ShadowAtlas_free_tile(
+			ShadowAtlas& atlas,
+			ShadowAtlasTile tile);
+	}
+}
@@ -0,0 +1,144 @@
+// TextureResidency.h
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "../include/GLRender/GLRenderSystem.h"
+#include "glew.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* Mip levels no larger than this (in either dimension) are always resident, so that there's something to sample while finer levels stream in. */
+		static constexpr int32 RESIDENCY_TAIL_SIZE = 64;
+
+		/* The number of frames a mip level must go unneeded before it's dropped (unless the budget requires it sooner). */
+		static constexpr uint32 RESIDENCY_EVICT_DELAY = 120;
+
+		/* The maximum number of bytes of mip levels uploaded by residency streaming each frame. At least one level is always uploaded if any are needed. */
+		static constexpr std::size_t RESIDENCY_UPLOAD_BUDGET = 4 * 1024 * 1024;
+
+		/**
+		 * \brief The location of a single mip level within a streamed texture's data.
+		 */
+		struct TextureResidency_Mip
+		{
+			int32 width = 0;
+			int32 height = 0;
+			std::size_t offset = 0;
+			std::size_t size = 0;
+		};
+
+		/**
+		 * \brief A texture whose full mip chain is kept in system memory, with only the levels needed on screen resident on the GPU.
+		 * GL level 'i' always holds mip 'i': 'GL_TEXTURE_BASE_LEVEL' is clamped to the finest resident level, and levels finer than that are reallocated to be empty.
+		 */
+		struct TextureResidency_Texture
+		{
+			GLenum internal_format = GL_NONE;
+
+			/* The format and type uncompressed levels are uploaded with (unused if 'compressed'). */
+			bool compressed = false;
+			GLenum upload_format = GL_NONE;
+			GLenum upload_type = GL_NONE;
+
+			std::vector<TextureResidency_Mip> mips;
+			std::vector<byte> data;
+
+			/* The finest level resident, and the finest level of the always-resident tail. */
+			uint32 resident_level = 0;
+			uint32 tail_level = 0;
+
+			/* The finest level requested this frame, and the largest size on screen it was requested at. */
+			uint32 requested_level = 0;
+			float requested_size = 0.f;
+			uint32 last_request_frame = 0;
+
+			/* The finest level needed over the last 'RESIDENCY_EVICT_DELAY' frames, and the frame it was last lowered. */
+			uint32 held_level = 0;
+			uint32 held_since_frame = 0;
+
+			/* The level residency is moving towards, after applying the budget. */
+			uint32 target_level = 0;
+		};
+
+		/**
+		 * \brief Tracks which mip levels of each streamed texture are needed on screen, and streams them in and out under a memory budget.
+		 * Only touched on the context thread.
+		 */
+		struct TextureResidency
+		{
+			bool enabled = true;
+
+			/**
+			 * \brief The number of bytes streamed textures may keep resident (unlimited if zero). The always-resident tail levels are kept regardless.
+			 */
+			std::size_t budget = 0;
+
+			std::unordered_map<GLuint, TextureResidency_Texture> textures;
+			uint32 frame = 1;
+
+			/* Bytes resident for each streamed texture's full chain, and for unstreamed textures. */
+			std::size_t resident_bytes = 0;
+			std::size_t full_bytes = 0;
+			std::size_t unmanaged_bytes = 0;
+
+			TextureResidencyStats stats;
+		};
+
+		/**
+		 * \brief Hands the given texture over to residency streaming, uploading only its always-resident tail levels.
+		 * If residency is disabled, every level is uploaded and the texture is tracked as unmanaged.
+		 * \param residency The residency manager.
+		 * \param texture The texture name (already generated) to upload levels into.
+		 * \param internal_format The internal format of the texture.
+		 * \param compressed Whether 'internal_format' is block-compressed, in which case levels are uploaded with 'glCompressedTexImage2D'.
+		 * \param upload_format The format uncompressed levels are uploaded with.
+		 * \param upload_type The type uncompressed levels are uploaded with.
+		 * \param mips The location of each mip level within 'data', starting from the largest.
+		 * \param data The levels of the texture, kept in system memory for as long as the texture is streamed.
+		 */
+		void TextureResidency_add(
+			TextureResidency& residency,
+			GLuint texture,
+			GLenum internal_format,
+			bool compressed,
+			GLenum upload_format,
+			GLenum upload_type,
+			std::vector<TextureResidency_Mip> mips,
+			std::vector<byte> data);
+
+		/**
+		 * \brief Records memory used by a texture that isn't streamed, for reporting.
+		 */
+		void TextureResidency_add_unmanaged(
+			TextureResidency& residency,
+			std::size_t size);
+
+		/**
+		 * \brief Stops tracking the given texture before it's deleted. If it isn't streamed, 'unmanaged_size' is subtracted from the unmanaged bytes instead.
+		 */
+		void TextureResidency_remove(
+			TextureResidency& residency,
+			GLuint texture,
+			std::size_t unmanaged_size);
+
+		/**
+		 * \brief Requests that the given texture be resident at the level needed to cover the given number of pixels on screen (along its largest dimension).
+		 * Does nothing if the texture isn't streamed.
+		 */
+		void TextureResidency_request(
+			TextureResidency& residency,
+			GLuint texture,
+			float screen_size);
+
+		/**
+		 * \brief Chooses the levels each texture should have resident this frame, fitting them in the budget by dropping the same number of levels from each,
+		 * then drops levels that are no longer needed and uploads needed levels within the given byte budget (most visible textures first).
+		 */
+		void TextureResidency_update(
+			TextureResidency& residency,
+			std::size_t upload_budget);
+	}
+}
@@ -14,7 +14,17 @@ namespace sge
 	{
 		Config::Config()
 			: viewport_width(0),
-			viewport_height(0)
+			viewport_height(0),
+			pipeline_render_prep(true),
+			occlusion_culling(true),
+			compact_gbuffer(false),
+			profile_render_passes(true),
+			print_render_stats(false),
+			texture_streaming(true),
+			texture_budget_mb(0),
+			mesh_cache_budget_mb(256),
+			material_cache_budget_mb(16),
+			texture_cache_budget_mb(512)
 		{
 		}
 
@@ -29,6 +39,17 @@ namespace sge
             reader.object_member("debug_line_frag_shader", debug_line_frag_shader);
 			reader.object_member("missing_material", missing_material);
 			reader.object_member("missing_mesh", missing_mesh);
+			reader.object_member("pipeline_render_prep", pipeline_render_prep);
+			reader.object_member("occlusion_culling", occlusion_culling);
+			reader.object_member("compact_gbuffer", compact_gbuffer);
+			reader.object_member("program_cache_dir", program_cache_dir);
+			reader.object_member("profile_render_passes", profile_render_passes);
+			reader.object_member("print_render_stats", print_render_stats);
+			reader.object_member("texture_streaming", texture_streaming);
+			reader.object_member("texture_budget_mb", texture_budget_mb);
+			reader.object_member("mesh_cache_budget_mb", mesh_cache_budget_mb);
+			reader.object_member("material_cache_budget_mb", material_cache_budget_mb);
+			reader.object_member("texture_cache_budget_mb", texture_cache_budget_mb);
 		}
 
 		bool Config::validate() const
@@ -69,6 +90,14 @@ namespace sge
 			{
 				return false;
 			}
+			if (texture_budget_mb < 0)
+			{
+				return false;
+			}
+			if (mesh_cache_budget_mb < 0 || material_cache_budget_mb < 0 || texture_cache_budget_mb < 0)
+			{
+				return false;
+			}
 
 			return true;
 		}
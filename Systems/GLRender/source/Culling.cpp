@@ -0,0 +1,109 @@
+// Culling.cpp
+
+#include <algorithm>
+#include <cmath>
+#include "../private/Culling.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		BoundingSphere compute_bounding_sphere(
+			const Vec3* const points,
+			const std::size_t num_points)
+		{
+			BoundingSphere result;
+			if (num_points == 0)
+			{
+				return result;
+			}
+
+			// Compute the bounding box
+			Vec3 min = points[0];
+			Vec3 max = points[0];
+			for (std::size_t i = 1; i < num_points; ++i)
+			{
+				min = Vec3{ std::min(min.x(), points[i].x()), std::min(min.y(), points[i].y()), std::min(min.z(), points[i].z()) };
+				max = Vec3{ std::max(max.x(), points[i].x()), std::max(max.y(), points[i].y()), std::max(max.z(), points[i].z()) };
+			}
+
+			// Center the sphere on the box, and expand it to contain every point
+			result.center = (min + max) * 0.5f;
+			float radius_sqr = 0.f;
+			for (std::size_t i = 0; i < num_points; ++i)
+			{
+				const auto offset = points[i] - result.center;
+				radius_sqr = std::max(radius_sqr, Vec3::dot(offset, offset));
+			}
+
+			result.radius = std::sqrt(radius_sqr);
+			return result;
+		}
+
+		BoundingSphere transform_bounding_sphere(
+			const Mat4& world_transform,
+			const BoundingSphere& local_sphere)
+		{
+			// Get the squared scale of each axis
+			float max_scale_sqr = 0.f;
+			for (uint32 col = 0; col < 3; ++col)
+			{
+				const Vec3 axis{ world_transform.get(col, 0), world_transform.get(col, 1), world_transform.get(col, 2) };
+				max_scale_sqr = std::max(max_scale_sqr, Vec3::dot(axis, axis));
+			}
+
+			BoundingSphere result;
+			result.center = world_transform * local_sphere.center;
+			result.radius = local_sphere.radius * std::sqrt(max_scale_sqr);
+			return result;
+		}
+
+		Frustum extract_frustum(
+			const Mat4& view_proj_matrix)
+		{
+			// Each plane is the sum or difference of the 'w' row with the 'x', 'y', or 'z' row
+			Frustum result;
+			for (uint32 plane = 0; plane < 6; ++plane)
+			{
+				const uint32 row = plane / 2;
+				const float sign = (plane % 2 == 0) ? 1.f : -1.f;
+				float length_sqr = 0.f;
+
+				for (uint32 col = 0; col < 4; ++col)
+				{
+					result.planes[plane][col] = view_proj_matrix.get(col, 3) + sign * view_proj_matrix.get(col, row);
+					if (col < 3)
+					{
+						length_sqr += result.planes[plane][col] * result.planes[plane][col];
+					}
+				}
+
+				// Normalize the plane, so that distances may be compared against sphere radii
+				const float inv_length = length_sqr > 0.f ? 1.f / std::sqrt(length_sqr) : 0.f;
+				for (uint32 col = 0; col < 4; ++col)
+				{
+					result.planes[plane][col] *= inv_length;
+				}
+			}
+
+			return result;
+		}
+
+		bool frustum_intersects_sphere(
+			const Frustum& frustum,
+			const BoundingSphere& sphere)
+		{
+			for (uint32 plane = 0; plane < 6; ++plane)
+			{
+				const float* const p = frustum.planes[plane];
+				const float dist = p[0] * sphere.center.x() + p[1] * sphere.center.y() + p[2] * sphere.center.z() + p[3];
+				if (dist < -sphere.radius)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
+}
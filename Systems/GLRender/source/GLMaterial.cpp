@@ -1,6 +1,9 @@
 // GLMaterial.cpp
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <utility>
 #include "../private/GLMaterial.h"
 
 namespace sge
@@ -9,12 +12,11 @@ namespace sge
 	{
         namespace gl_material
         {
-            GLuint new_standard_material_program(
+            void link_standard_material_program(
+				GLuint mat_id,
 				GLuint v_shader,
 				GLuint f_shader)
             {
-                const auto mat_id = glCreateProgram();
-
                 // Attach shaders
                 glAttachShader(mat_id, v_shader);
                 glAttachShader(mat_id, f_shader);
@@ -23,7 +25,6 @@ namespace sge
                 glBindAttribLocation(mat_id, POSITION_ATTRIB_LOCATION, POSITION_ATTRIB_NAME);
                 glBindAttribLocation(mat_id, NORMAL_ATTRIB_LOCATION, NORMAL_ATTRIB_NAME);
                 glBindAttribLocation(mat_id, TANGENT_ATTRIB_LOCATION, TANGENT_ATTRIB_NAME);
-                glBindAttribLocation(mat_id, BITANGENT_SIGN_ATTRIB_LOCATION, BITANGENT_SIGN_ATTRIB_NAME);
                 glBindAttribLocation(mat_id, MATERIAL_TEXCOORD_ATTRIB_LOCATION, MATERIAL_TEXCOORD_ATTRIB_NAME);
                 glBindAttribLocation(mat_id, LIGHTMAP_TEXCOORD_ATTRIB_LOCATION, LIGHTMAP_TEXCOORD_ATTRIB_NAME);
 
@@ -33,8 +34,6 @@ namespace sge
                 // Detach the shaders, so they may be deleted independently
                 glDetachShader(mat_id, v_shader);
                 glDetachShader(mat_id, f_shader);
-
-                return mat_id;
             }
 
             void free_standard_material_program(
@@ -50,6 +49,8 @@ namespace sge
                 out_uniforms->model_matrix_uniform = glGetUniformLocation(mat_id, MODEL_MATRIX_UNIFORM_NAME);
                 out_uniforms->view_matrix_uniform = glGetUniformLocation(mat_id, VIEW_MATRIX_UNIFORM_NAME);
                 out_uniforms->proj_matrix_uniform = glGetUniformLocation(mat_id, PROJ_MATRIX_UNIFORM_NAME);
+				out_uniforms->position_offset_uniform = glGetUniformLocation(mat_id, POSITION_OFFSET_UNIFORM_NAME);
+				out_uniforms->position_scale_uniform = glGetUniformLocation(mat_id, POSITION_SCALE_UNIFORM_NAME);
 				out_uniforms->base_mat_uv_scale_uniform = glGetUniformLocation(mat_id, BASE_MAT_UV_SCALE_UNIFORM_NAME);
 				out_uniforms->inst_mat_uv_scale_uniform = glGetUniformLocation(mat_id, INST_MAT_UV_SCALE_UNIFORM_NAME);
                 out_uniforms->lightmap_x_basis_uniform = glGetUniformLocation(mat_id, LIGHTMAP_X_BASIS_UNIFORM_NAME);
@@ -90,49 +91,371 @@ namespace sge
                 glProgramUniform1i(mat_id, uniforms.lightmap_direct_mask_uniform, LIGHTMAP_DIRECT_MASK_TEXTURE_SLOT - GL_TEXTURE0);
             }
 
-            void set_material_params(
+            GLsizeiptr init_material_params_block(
+				const GLuint mat_id)
+            {
+                const auto block_index = glGetUniformBlockIndex(mat_id, MATERIAL_PARAMS_BLOCK_NAME);
+                if (block_index == GL_INVALID_INDEX)
+                {
+                    return 0;
+                }
+
+                GLint block_size = 0;
+                glGetActiveUniformBlockiv(mat_id, block_index, GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
+                glUniformBlockBinding(mat_id, block_index, MATERIAL_PARAMS_BLOCK_BINDING);
+
+                return block_size;
+            }
+
+            /**
+             * \brief Finds where the given material parameter lives.
+             * \param out_location The location of the parameter, if it's in the default uniform block.
+             * \param out_block_offset The offset of the parameter within the material parameter block, if it's a block member.
+             * \return Whether the parameter was found.
+             */
+            static bool find_material_param(
+                const GLuint mat_id,
+                const char* name,
+                GLint* const out_location,
+                GLint* const out_block_offset)
+            {
+                *out_location = -1;
+                *out_block_offset = -1;
+
+                GLuint uniform_index = GL_INVALID_INDEX;
+                glGetUniformIndices(mat_id, 1, &name, &uniform_index);
+                if (uniform_index == GL_INVALID_INDEX)
+                {
+                    std::cout << "GLRenderSystem: could not locate shader uniform - '" << name << "'" << std::endl;
+                    return false;
+                }
+
+                GLint block_index = -1;
+                glGetActiveUniformsiv(mat_id, 1, &uniform_index, GL_UNIFORM_BLOCK_INDEX, &block_index);
+                if (block_index == -1)
+                {
+                    *out_location = glGetUniformLocation(mat_id, name);
+                    return true;
+                }
+
+                glGetActiveUniformsiv(mat_id, 1, &uniform_index, GL_UNIFORM_OFFSET, out_block_offset);
+                return true;
+            }
+
+            /**
+             * \brief Returns the offset of the given member of the material parameter block, or -1 if the program's block has no such member.
+             */
+            static GLint find_block_member_offset(
 				const GLuint mat_id,
-				GLenum* const next_active_texture,
-				const MaterialParams& params)
+				const char* name)
             {
-                // Bind int params
-                for (auto int_param : params.int_params)
+                GLuint uniform_index = GL_INVALID_INDEX;
+                glGetUniformIndices(mat_id, 1, &name, &uniform_index);
+                if (uniform_index == GL_INVALID_INDEX)
                 {
-                    glProgramUniform1i(mat_id, int_param.first, int_param.second);
+                    return -1;
                 }
 
-                // Bind float params
-                for (auto float_param : params.float_params)
+                GLint block_index = -1;
+                glGetActiveUniformsiv(mat_id, 1, &uniform_index, GL_UNIFORM_BLOCK_INDEX, &block_index);
+                if (block_index == -1)
                 {
-                    glProgramUniform1f(mat_id, float_param.first, float_param.second);
+                    return -1;
                 }
 
-                // Bind vec2 params
-                for (auto vec2_param : params.vec2_params)
+                GLint block_offset = -1;
+                glGetActiveUniformsiv(mat_id, 1, &uniform_index, GL_UNIFORM_OFFSET, &block_offset);
+                return block_offset;
+            }
+
+            void compile_default_material_params(
+				const GLuint mat_id,
+				byte* block_data)
+            {
+                // The values these parameters had as default-block uniforms in the bundled shaders (members not listed default to zero).
+                // Not every shader declares every member, so missing ones are skipped silently.
+                static const std::pair<const char*, float> float_defaults[] = {
+                    { "roughness_constant", 0.5f } };
+
+                for (const auto& param : float_defaults)
                 {
-                    glProgramUniform2fv(mat_id, vec2_param.first, 1, vec2_param.second.vec());
+                    const auto offset = find_block_member_offset(mat_id, param.first);
+                    if (offset == -1)
+                    {
+                        continue;
+                    }
+
+                    std::memcpy(block_data + offset, &param.second, sizeof(float));
                 }
 
-                // Bind vec3 params
-                for (auto vec3_param : params.vec3_params)
+                // 'base_mat_uv_scale' is a vec2, so both components default to one
+                const auto uv_scale_offset = find_block_member_offset(mat_id, BASE_MAT_UV_SCALE_UNIFORM_NAME);
+                if (uv_scale_offset != -1)
                 {
-                    glProgramUniform3fv(mat_id, vec3_param.first, 1, vec3_param.second.vec());
+                    const float uv_scale[2] = { 1.f, 1.f };
+                    std::memcpy(block_data + uv_scale_offset, uv_scale, sizeof(uv_scale));
                 }
+            }
 
-                // Bind vec4 params
-                for (auto vec4_param : params.vec4_params)
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				GLint value,
+				byte* block_data)
+            {
+                GLint location, block_offset;
+                if (!find_material_param(mat_id, name, &location, &block_offset))
                 {
-                    glProgramUniform4fv(mat_id, vec4_param.first, 1, vec4_param.second.vec());
+                    return false;
+                }
+
+                if (block_offset != -1)
+                {
+                    std::memcpy(block_data + block_offset, &value, sizeof(GLint));
+                }
+                else
+                {
+                    glProgramUniform1i(mat_id, location, value);
+                }
+
+                return true;
+            }
+
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				float value,
+				byte* block_data)
+            {
+                GLint location, block_offset;
+                if (!find_material_param(mat_id, name, &location, &block_offset))
+                {
+                    return false;
+                }
+
+                if (block_offset != -1)
+                {
+                    std::memcpy(block_data + block_offset, &value, sizeof(float));
+                }
+                else
+                {
+                    glProgramUniform1f(mat_id, location, value);
+                }
+
+                return true;
+            }
+
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				Vec2 value,
+				byte* block_data)
+            {
+                GLint location, block_offset;
+                if (!find_material_param(mat_id, name, &location, &block_offset))
+                {
+                    return false;
+                }
+
+                if (block_offset != -1)
+                {
+                    std::memcpy(block_data + block_offset, value.vec(), sizeof(float) * 2);
+                }
+                else
+                {
+                    glProgramUniform2fv(mat_id, location, 1, value.vec());
+                }
+
+                return true;
+            }
+
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				Vec3 value,
+				byte* block_data)
+            {
+                GLint location, block_offset;
+                if (!find_material_param(mat_id, name, &location, &block_offset))
+                {
+                    return false;
+                }
+
+                if (block_offset != -1)
+                {
+                    std::memcpy(block_data + block_offset, value.vec(), sizeof(float) * 3);
+                }
+                else
+                {
+                    glProgramUniform3fv(mat_id, location, 1, value.vec());
+                }
+
+                return true;
+            }
+
+            bool compile_material_param(
+				const GLuint mat_id,
+				const char* name,
+				Vec4 value,
+				byte* block_data)
+            {
+                GLint location, block_offset;
+                if (!find_material_param(mat_id, name, &location, &block_offset))
+                {
+                    return false;
+                }
+
+                if (block_offset != -1)
+                {
+                    std::memcpy(block_data + block_offset, value.vec(), sizeof(float) * 4);
+                }
+                else
+                {
+                    glProgramUniform4fv(mat_id, location, 1, value.vec());
+                }
+
+                return true;
+            }
+
+            bool compile_material_texture_param(
+				const GLuint mat_id,
+				const char* name,
+				const GLuint texture,
+				MaterialParams& params)
+            {
+                const auto location = get_uniform_location(mat_id, name);
+                if (location == -1)
+                {
+                    return false;
+                }
+
+                // Samplers are assigned a fixed slot, so binding the material only needs to bind the textures
+                MaterialTextureBinding binding;
+                binding.texture_slot = FIRST_USER_TEXTURE_SLOT + static_cast<GLenum>(params.textures.size());
+                binding.texture = texture;
+                glProgramUniform1i(mat_id, location, binding.texture_slot - GL_TEXTURE0);
+                params.textures.push_back(binding);
+
+                return true;
+            }
+
+            void upload_material_params_block(
+				MaterialParamBuffer& param_buffer,
+				const byte* block_data,
+				const GLsizeiptr block_size,
+				MaterialParams& params)
+            {
+                if (block_size == 0)
+                {
+                    return;
+                }
+
+                // Create the buffer, if this is the first material
+                if (param_buffer.buffer == 0)
+                {
+                    glGenBuffers(1, &param_buffer.buffer);
+                    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &param_buffer.offset_alignment);
+                }
+
+                // Reuse the first released range the block fits in
+                const GLsizeiptr alignment = param_buffer.offset_alignment;
+                auto& free_ranges = param_buffer.free_ranges;
+                const auto free_iter = std::find_if(free_ranges.begin(), free_ranges.end(), [=](const MaterialParamBuffer::FreeRange& range) {
+                    return range.size >= block_size;
+                });
+                if (free_iter != free_ranges.end())
+                {
+                    const GLintptr offset = free_iter->offset;
+                    const GLintptr end = free_iter->offset + free_iter->size;
+
+                    // Keep the rest of the range, if there's an aligned offset left in it
+                    const GLintptr rest_offset = (offset + block_size + alignment - 1) / alignment * alignment;
+                    if (rest_offset < end)
+                    {
+                        free_iter->offset = rest_offset;
+                        free_iter->size = end - rest_offset;
+                    }
+                    else
+                    {
+                        free_ranges.erase(free_iter);
+                    }
+
+                    std::memcpy(param_buffer.data.data() + offset, block_data, block_size);
+                    glBindBuffer(GL_UNIFORM_BUFFER, param_buffer.buffer);
+                    glBufferSubData(GL_UNIFORM_BUFFER, offset, block_size, block_data);
+                    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+                    params.block_buffer = param_buffer.buffer;
+                    params.block_offset = offset;
+                    params.block_size = block_size;
+                    return;
+                }
+
+                // Align the start of the block, so that it may be bound with 'glBindBufferRange'
+                const GLsizeiptr offset = (static_cast<GLsizeiptr>(param_buffer.data.size()) + alignment - 1) / alignment * alignment;
+                param_buffer.data.resize(offset + block_size, 0);
+                std::memcpy(param_buffer.data.data() + offset, block_data, block_size);
+
+                glBindBuffer(GL_UNIFORM_BUFFER, param_buffer.buffer);
+                if (static_cast<GLsizeiptr>(param_buffer.data.size()) > param_buffer.capacity)
+                {
+                    // Reallocate the buffer (the buffer name stays the same, so existing ranges remain valid)
+                    param_buffer.capacity = std::max<GLsizeiptr>(param_buffer.capacity * 2, param_buffer.data.size());
+                    glBufferData(GL_UNIFORM_BUFFER, param_buffer.capacity, nullptr, GL_STATIC_DRAW);
+                    glBufferSubData(GL_UNIFORM_BUFFER, 0, param_buffer.data.size(), param_buffer.data.data());
+                }
+                else
+                {
+                    glBufferSubData(GL_UNIFORM_BUFFER, offset, block_size, block_data);
+                }
+                glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+                params.block_buffer = param_buffer.buffer;
+                params.block_offset = offset;
+                params.block_size = block_size;
+            }
+
+            void release_material_params_block(
+				MaterialParamBuffer& param_buffer,
+				const MaterialParams& params)
+            {
+                if (params.block_size == 0 || params.block_buffer != param_buffer.buffer)
+                {
+                    return;
+                }
+
+                MaterialParamBuffer::FreeRange range;
+                range.offset = params.block_offset;
+                range.size = params.block_size;
+                param_buffer.free_ranges.push_back(range);
+            }
+
+            std::size_t bind_material_params(
+				const MaterialParams& params)
+            {
+                std::size_t num_bindings = 0;
+
+                // Bind the parameter block
+                if (params.block_size != 0)
+                {
+                    glBindBufferRange(
+                        GL_UNIFORM_BUFFER,
+                        MATERIAL_PARAMS_BLOCK_BINDING,
+                        params.block_buffer,
+                        params.block_offset,
+                        params.block_size);
+                    ++num_bindings;
                 }
 
                 // Bind texture params
-                for (auto tex_param : params.tex_params)
+                for (const auto& tex_binding : params.textures)
                 {
-                    glActiveTexture(*next_active_texture);
-                    glBindTexture(GL_TEXTURE_2D, tex_param.second);
-                    glProgramUniform1i(mat_id, tex_param.first, *next_active_texture - GL_TEXTURE0);
-                    *next_active_texture += 1;
+                    glActiveTexture(tex_binding.texture_slot);
+                    glBindTexture(GL_TEXTURE_2D, tex_binding.texture);
+                    ++num_bindings;
                 }
+
+                return num_bindings;
             }
         }
 	}
@@ -7,6 +7,7 @@
 #include <Resource/Misc/LightmaskVolume.h>
 #include <Engine/Components/Display/CStaticMesh.h>
 #include <Engine/Components/Display/CSpotlight.h>
+#include <Engine/Components/Display/CPointLight.h>
 #include <Engine/Components/Display/CCamera.h>
 #include <Engine/Scene.h>
 #include <Engine/SystemFrame.h>
@@ -88,6 +89,7 @@ namespace sge
 		static void on_static_mesh_destroy(
 			EventChannel& destroyed_static_mesh_channel,
 			EventChannel::SubscriberId subscriber_id,
+			RenderResource& resources,
 			RenderScene_Commands& commands)
 		{
 			// Get events
@@ -104,6 +106,7 @@ namespace sge
 				// Update render scene
 				RenderScene_remove_static_mesh_commands(
 					commands,
+					resources,
 					node_ids,
 					num_events);
 			}
@@ -201,15 +204,93 @@ namespace sge
 			}
 		}
 
+		static void on_static_mesh_resources_streamed(
+			Scene& scene,
+			RenderResource& resources,
+			RenderScene_Commands& commands)
+		{
+			// Find static meshes whose resources have become resident
+			std::vector<NodeId> node_ids;
+			RenderScene_take_streamed_static_meshes(commands, resources, node_ids);
+			if (node_ids.empty())
+			{
+				return;
+			}
+
+			// Get nodes and components
+			const auto num_nodes = node_ids.size();
+			std::vector<const Node*> nodes(num_nodes);
+			std::vector<CStaticMesh*> components(num_nodes);
+			scene.get_nodes(node_ids.data(), num_nodes, nodes.data());
+			scene.get_component_container(CStaticMesh::type_info)->get_instances(node_ids.data(), num_nodes, components.data());
+
+			// Replace the placeholder commands
+			RenderScene_remove_static_mesh_commands(
+				commands,
+				resources,
+				node_ids.data(),
+				num_nodes);
+			RenderScene_insert_static_mesh_commands(
+				commands,
+				resources,
+				nodes.data(),
+				components.data(),
+				num_nodes);
+		}
+
+        /**
+         * \brief Creates a texture from the encoded mip chain of a lightmap basis image, and hands it to residency streaming.
+         */
+        static GLuint create_encoded_lightmap_texture(
+            TextureResidency& residency,
+            const SceneLightmap::LightmapElement& element,
+            std::vector<byte>& data)
+        {
+            // Lay out the mip chain, stopping short if the data doesn't cover it
+            std::vector<TextureResidency_Mip> mips;
+            std::size_t offset = 0;
+            for (int32 level = 0, width = element.width, height = element.height; level < element.num_mips; ++level)
+            {
+                TextureResidency_Mip mip;
+                mip.width = width;
+                mip.height = height;
+                mip.offset = offset;
+                mip.size = SceneLightmap::encoded_level_size(element.format, width, height);
+                if (offset + mip.size > data.size())
+                {
+                    break;
+                }
+
+                mips.push_back(mip);
+                offset += mip.size;
+                width = std::max(width / 2, 1);
+                height = std::max(height / 2, 1);
+            }
+
+            GLuint id = 0;
+            glGenTextures(1, &id);
+            if (element.format == SceneLightmap::Format::BC6H)
+            {
+                TextureResidency_add(residency, id, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, true, GL_NONE, GL_NONE, std::move(mips), std::move(data));
+            }
+            else
+            {
+                TextureResidency_add(residency, id, GL_RGB9_E5, false, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, std::move(mips), std::move(data));
+            }
+
+            return id;
+        }
+
         static void initialize_render_scene(
 			RenderScene_Commands& render_scene,
+			RenderResource& resources,
 			Scene& scene)
         {
 			// Load the lightmap object
 			if (!scene.get_raw_scene_data().lightmap_data_path.empty())
 			{
 				BinaryArchive lightmap_archive;
-				lightmap_archive.from_file(scene.get_raw_scene_data().lightmap_data_path.c_str());
+				lightmap_archive.map_file(scene.get_raw_scene_data().lightmap_data_path.c_str());
 
 				SceneLightmap scene_lightmap;
 				lightmap_archive.deserialize_root(scene_lightmap);
@@ -219,30 +300,42 @@ namespace sge
 				render_scene.light_intensity = scene_lightmap.light_intensity;
 
 				// Load all lightmap components into textures
-				for (const auto& element : scene_lightmap.lightmap_elements)
+				for (auto& element : scene_lightmap.lightmap_elements)
 				{
 					RenderScene_Lightmap lightmap;
-					lightmap.x_basis_tex = create_texture(
-						element.second.width,
-						element.second.height,
-						element.second.basis_x_radiance.data(),
-						GL_RGB32F,
-						GL_RGB,
-						GL_FLOAT);
-					lightmap.y_basis_tex = create_texture(
-						element.second.width,
-						element.second.height,
-						element.second.basis_y_radiance.data(),
-						GL_RGB32F,
-						GL_RGB,
-						GL_FLOAT);
-					lightmap.z_basis_tex = create_texture(
-						element.second.width,
-						element.second.height,
-						element.second.basis_z_radiance.data(),
-						GL_RGB32F,
-						GL_RGB,
-						GL_FLOAT);
+					if (element.second.format != SceneLightmap::Format::RGBF32)
+					{
+						lightmap.x_basis_tex = create_encoded_lightmap_texture(resources.residency, element.second, element.second.basis_x_data);
+						lightmap.y_basis_tex = create_encoded_lightmap_texture(resources.residency, element.second, element.second.basis_y_data);
+						lightmap.z_basis_tex = create_encoded_lightmap_texture(resources.residency, element.second, element.second.basis_z_data);
+					}
+					else
+					{
+						// Float lightmaps have no mip chain to stream, so are always fully resident
+						lightmap.basis_unmanaged_size = std::size_t(element.second.width) * element.second.height * sizeof(color::RGBF32) * 4 / 3;
+						TextureResidency_add_unmanaged(resources.residency, lightmap.basis_unmanaged_size * 3);
+						lightmap.x_basis_tex = create_texture(
+							element.second.width,
+							element.second.height,
+							element.second.basis_x_radiance.data(),
+							GL_RGB32F,
+							GL_RGB,
+							GL_FLOAT);
+						lightmap.y_basis_tex = create_texture(
+							element.second.width,
+							element.second.height,
+							element.second.basis_y_radiance.data(),
+							GL_RGB32F,
+							GL_RGB,
+							GL_FLOAT);
+						lightmap.z_basis_tex = create_texture(
+							element.second.width,
+							element.second.height,
+							element.second.basis_z_radiance.data(),
+							GL_RGB32F,
+							GL_RGB,
+							GL_FLOAT);
+					}
 					lightmap.direct_mask_tex = create_texture(
 						element.second.width,
 						element.second.height,
@@ -266,11 +359,46 @@ namespace sge
         static void upload_render_target_data(
             GLsizei width,
             GLsizei height,
-            GLenum internal_format,
-            GLenum upload_format,
-            GLenum upload_type)
+            const RenderTargetFormat& format)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, width, height, 0, format.upload_format, format.upload_type, nullptr);
+        }
+
+        /**
+         * \brief Selects the gbuffer and post buffer formats for either the full or compact gbuffer layout.
+         */
+        static void select_render_target_formats(
+            GLRenderSystem::State& state,
+            bool compact_gbuffer)
         {
-            glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, upload_format, upload_type, nullptr);
+            state.compact_gbuffer = compact_gbuffer;
+            state.gbuffer_formats[GBufferLayer::DEPTH_STENCIL] = { GBUFFER_DEPTH_STENCIL_INTERNAL_FORMAT, GBUFFER_DEPTH_STENCIL_UPLOAD_FORMAT, GBUFFER_DEPTH_STENCIL_UPLOAD_TYPE };
+            state.gbuffer_formats[GBufferLayer::ROUGHNESS_METALLIC] = { GBUFFER_ROUGHNESS_METALLIC_INTERNAL_FORMAT, GBUFFER_ROUGHNESS_METALLIC_UPLOAD_FORMAT, GBUFFER_ROUGHNESS_METALLIC_UPLOAD_TYPE };
+
+            if (compact_gbuffer)
+            {
+                state.gbuffer_formats[GBufferLayer::POSITION] = { COMPACT_GBUFFER_POSITION_INTERNAL_FORMAT, COMPACT_GBUFFER_POSITION_UPLOAD_FORMAT, COMPACT_GBUFFER_POSITION_UPLOAD_TYPE };
+                state.gbuffer_formats[GBufferLayer::NORMAL] = { COMPACT_GBUFFER_NORMAL_INTERNAL_FORMAT, COMPACT_GBUFFER_NORMAL_UPLOAD_FORMAT, COMPACT_GBUFFER_NORMAL_UPLOAD_TYPE };
+                state.gbuffer_formats[GBufferLayer::ALBEDO] = { COMPACT_GBUFFER_ALBEDO_INTERNAL_FORMAT, COMPACT_GBUFFER_ALBEDO_UPLOAD_FORMAT, COMPACT_GBUFFER_ALBEDO_UPLOAD_TYPE };
+                state.gbuffer_formats[GBufferLayer::IRRADIANCE] = { COMPACT_GBUFFER_IRRADIANCE_INTERNAL_FORMAT, COMPACT_GBUFFER_IRRADIANCE_UPLOAD_FORMAT, COMPACT_GBUFFER_IRRADIANCE_UPLOAD_TYPE };
+                state.post_buffer_hdr_format = { COMPACT_POST_BUFFER_HDR_INTERNAL_FORMAT, POST_BUFFER_HDR_UPLOAD_FORMAT, POST_BUFFER_HDR_UPLOAD_TYPE };
+            }
+            else
+            {
+                state.gbuffer_formats[GBufferLayer::POSITION] = { GBUFFER_POSITION_INTERNAL_FORMAT, GBUFFER_POSITION_UPLOAD_FORMAT, GBUFFER_POSITION_UPLOAD_TYPE };
+                state.gbuffer_formats[GBufferLayer::NORMAL] = { GBUFFER_NORMAL_INTERNAL_FORMAT, GBUFFER_NORMAL_UPLOAD_FORMAT, GBUFFER_NORMAL_UPLOAD_TYPE };
+                state.gbuffer_formats[GBufferLayer::ALBEDO] = { GBUFFER_ALBEDO_INTERNAL_FORMAT, GBUFFER_ALBEDO_UPLOAD_FORMAT, GBUFFER_ALBEDO_UPLOAD_TYPE };
+                state.gbuffer_formats[GBufferLayer::IRRADIANCE] = { GBUFFER_IRRADIANCE_INTERNAL_FORMAT, GBUFFER_IRRADIANCE_UPLOAD_FORMAT, GBUFFER_IRRADIANCE_UPLOAD_TYPE };
+                state.post_buffer_hdr_format = { POST_BUFFER_HDR_INTERNAL_FORMAT, POST_BUFFER_HDR_UPLOAD_FORMAT, POST_BUFFER_HDR_UPLOAD_TYPE };
+            }
+
+            // Color layers that aren't allocated aren't drawn to
+            for (GLsizei layer = GBufferLayer::POSITION; layer < GBufferLayer::NUM_LAYERS; ++layer)
+            {
+                state.gbuffer_draw_buffers[layer - GBufferLayer::POSITION] = state.gbuffer_formats[layer].internal_format == GL_NONE
+                    ? GL_NONE
+                    : GBUFFER_LAYER_ATTACHMENTS[layer];
+            }
         }
 
 		static void attach_framebuffer_layer(
@@ -281,22 +409,30 @@ namespace sge
 		}
 
         static GLuint create_viewport_program(
-			GLuint v_shader,
-			GLuint f_shader)
+			ProgramCache& program_cache,
+			const std::string& v_source,
+			const std::string& f_source)
         {
-            // Create the program and attach shaders
-            const auto program = glCreateProgram();
-            glAttachShader(program, v_shader);
-            glAttachShader(program, f_shader);
-
-            // Bind vertex attributes
-            glBindAttribLocation(program, gl_material::POSITION_ATTRIB_LOCATION, gl_material::POSITION_ATTRIB_NAME);
-            glBindAttribLocation(program, gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION, gl_material::MATERIAL_TEXCOORD_ATTRIB_NAME);
-
-            // Link the program and detach shaders
-            glLinkProgram(program);
-            glDetachShader(program, v_shader);
-            glDetachShader(program, f_shader);
+            // Create the program from its cached binary, or compile it
+            const std::string* const sources[] = { &v_source, &f_source };
+            const auto program = ProgramCache_get_program(program_cache, sources, 2, [&v_source, &f_source](GLuint new_program) {
+                // Compile and attach shaders
+                const auto v_shader = create_shader(GL_VERTEX_SHADER, v_source.c_str());
+                const auto f_shader = create_shader(GL_FRAGMENT_SHADER, f_source.c_str());
+                glAttachShader(new_program, v_shader);
+                glAttachShader(new_program, f_shader);
+
+                // Bind vertex attributes
+                glBindAttribLocation(new_program, gl_material::POSITION_ATTRIB_LOCATION, gl_material::POSITION_ATTRIB_NAME);
+                glBindAttribLocation(new_program, gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION, gl_material::MATERIAL_TEXCOORD_ATTRIB_NAME);
+
+                // Link the program and free shaders
+                glLinkProgram(new_program);
+                glDetachShader(new_program, v_shader);
+                glDetachShader(new_program, f_shader);
+                free_shader(v_shader);
+                free_shader(f_shader);
+            });
 
             // Make sure the program compiled linked
             debug_program_status(program, GLDebugOutputMode::ONLY_ERROR);
@@ -314,6 +450,170 @@ namespace sge
             return program;
         }
 
+		/**
+		 * \brief Gathers the point lights, and the spot lights that don't cast shadows, to be shaded through the light clusters.
+		 */
+		static void gather_lights(
+			Scene& scene,
+			std::vector<LightClusters_Light>& out_lights)
+		{
+			out_lights.clear();
+
+			// Gather point lights
+			auto* const point_light_component = scene.get_component_container(CPointLight::type_info);
+			NodeId node_ids[32];
+			CPointLight* point_lights[32];
+			const Node* nodes[32];
+			std::size_t start = 0;
+			std::size_t num_instances;
+			while (point_light_component->get_instance_nodes(start, 32, &num_instances, node_ids))
+			{
+				start += 32;
+				point_light_component->get_instances(node_ids, num_instances, point_lights);
+				scene.get_nodes(node_ids, num_instances, nodes);
+
+				for (std::size_t i = 0; i < num_instances; ++i)
+				{
+					LightClusters_Light light;
+					light.position = nodes[i]->get_world_matrix() * Vec3::zero();
+					light.radius = point_lights[i]->radius();
+					light.intensity = point_lights[i]->intensity();
+					out_lights.push_back(light);
+				}
+			}
+
+			// Gather spot lights (shadowed spot lights are shaded with their shadow maps instead)
+			auto* const spotlight_component = scene.get_component_container(CSpotlight::type_info);
+			CSpotlight* spotlights[32];
+			start = 0;
+			while (spotlight_component->get_instance_nodes(start, 32, &num_instances, node_ids))
+			{
+				start += 32;
+				spotlight_component->get_instances(node_ids, num_instances, spotlights);
+				scene.get_nodes(node_ids, num_instances, nodes);
+
+				for (std::size_t i = 0; i < num_instances; ++i)
+				{
+					const auto& spotlight = *spotlights[i];
+					if (spotlight.casts_shadows())
+					{
+						continue;
+					}
+
+					const auto world = nodes[i]->get_world_matrix();
+					const float half_angle = (spotlight.shape() == CSpotlight::Shape::CONE
+						? spotlight.cone_angle().radians()
+						: std::max(spotlight.frustum_horiz_angle().radians(), spotlight.frustum_vert_angle().radians())) / 2;
+
+					LightClusters_Light light;
+					light.position = world * Vec3::zero();
+					light.direction = (world * Vec3{ 0, 0, -1 } - light.position).normalized();
+					light.radius = spotlight.far_clipping_plane();
+					light.intensity = spotlight.intensity();
+					light.cos_outer = std::cos(half_angle);
+					light.cos_inner = std::cos(half_angle * 0.8f);
+					out_lights.push_back(light);
+				}
+			}
+		}
+
+		static void submit_frame(
+			GLRenderSystem::State& state,
+			const GLRenderSystem::State::Frame& frame)
+		{
+			const auto& view = frame.scene.view_matrix;
+			const auto& proj = frame.scene.proj_matrix;
+
+			state.occlusion_stats = frame.scene.occlusion_stats;
+			RenderProfiler_begin_frame(state.profiler);
+
+			// Stream texture levels in and out for what the camera sees this frame
+			for (const auto& demand : frame.scene.texture_demand)
+			{
+				TextureResidency_request(state.resources.residency, demand.first, demand.second * state.height);
+			}
+			TextureResidency_update(state.resources.residency, RESIDENCY_UPLOAD_BUDGET);
+
+            // Render the scene
+			RenderScene_render(
+				frame.scene,
+				state.resources,
+				state.gbuffer_framebuffer,
+				state.width,
+				state.height,
+				state.profiler);
+
+            // Draw debug lines (only allow irradiance output)
+			glDisable(GL_STENCIL_TEST);
+			glDisable(GL_DEPTH_TEST);
+			std::array<GLenum, 5> draw_buffers = {
+				GL_NONE,
+				GL_NONE,
+				GL_NONE,
+				GL_NONE,
+				GBUFFER_IRRADIANCE_ATTACHMENT };
+			if (state.compact_gbuffer)
+			{
+				// The direct light mask lives in albedo's alpha in the compact layout
+				draw_buffers[GBufferLayer::ALBEDO - GBufferLayer::POSITION] = GBUFFER_ALBEDO_ATTACHMENT;
+			}
+			glDrawBuffers((GLsizei)draw_buffers.size(), draw_buffers.data());
+
+			if (!frame.debug_lines.empty())
+            {
+                glBindVertexArray(state.debug_line_vao);
+                glUseProgram(state.debug_line_program);
+                glBindBuffer(GL_ARRAY_BUFFER, state.debug_line_vbo);
+                glBufferData(
+                    GL_ARRAY_BUFFER,
+                    frame.debug_lines.size() * sizeof(DebugLineVert),
+                    frame.debug_lines.data(),
+                    GL_DYNAMIC_DRAW);
+                glUniformMatrix4fv(state.debug_line_view_uniform, 1, GL_FALSE, view.vec());
+                glUniformMatrix4fv(state.debug_line_proj_uniform, 1, GL_FALSE, proj.vec());
+                glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(frame.debug_lines.size()));
+            }
+
+			// Reset output buffers
+			glDrawBuffers((GLsizei)state.gbuffer_draw_buffers.size(), state.gbuffer_draw_buffers.data());
+
+			// Upload the lights, and shade
+			RenderProfiler_begin_pass(state.profiler, RenderPass::SHADING);
+			LightClusters_upload(state.light_cluster_buffers, frame.scene.light_clusters);
+			render_scene_shade_hdr(state.post_framebuffer, state, view, proj, frame.scene.light_clusters);
+			RenderProfiler_end_pass(state.profiler);
+
+            /*---------------------------*/
+            /*---   POST-PROCESSING   ---*/
+
+			RenderProfiler_begin_pass(state.profiler, RenderPass::POST_PROCESSING);
+
+			auto& counters = RenderCommand_counters();
+
+            // Bind the post-buffer for reading
+            RenderCommand_bind_texture(GL_TEXTURE5, state.post_buffer_hdr);
+
+			// Bind the default framebuffer for drawing
+			glBindFramebuffer(GL_FRAMEBUFFER, state.default_framebuffer);
+			++counters.num_state_changes;
+
+            // Bind the post-processing shader program
+            glUseProgram(state.post_shader_program);
+			++counters.num_state_changes;
+
+			// Upload gamma and brightness uniforms
+			glProgramUniform1f(state.post_shader_program, state.post_program_gamma_uniform, frame.gamma);
+			glProgramUniform1f(state.post_shader_program, state.post_program_brightness_uniform, frame.brightness_boost);
+
+			// Draw the screen quad
+			glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+			counters.num_draw_calls += 1;
+			counters.num_triangles += 2;
+			RenderProfiler_end_pass(state.profiler);
+			RenderProfiler_end_frame(state.profiler);
+		}
+
 		////////////////////////
 		///   Constructors   ///
 
@@ -325,24 +625,53 @@ namespace sge
             _state = std::make_unique<GLRenderSystem::State>();
             _state->width = config.viewport_width;
             _state->height = config.viewport_height;
+			_state->pipeline_render_prep = config.pipeline_render_prep;
+			_state->occlusion.enabled = config.occlusion_culling;
+			_state->profiler.enabled = config.profile_render_passes;
+			_state->profiler.print_summary = config.print_render_stats;
+			_state->resources.residency.enabled = config.texture_streaming;
+			_state->resources.residency.budget = std::size_t(config.texture_budget_mb) * 1024 * 1024;
+			_state->resources.cache.set_budget(CACHE_STATIC_MESHES, std::size_t(config.mesh_cache_budget_mb) * 1024 * 1024);
+			_state->resources.cache.set_budget(CACHE_MATERIALS, std::size_t(config.material_cache_budget_mb) * 1024 * 1024);
+			_state->resources.cache.set_budget(CACHE_TEXTURES, std::size_t(config.texture_cache_budget_mb) * 1024 * 1024);
+			select_render_target_formats(*_state, config.compact_gbuffer);
+			_state->resources.shader_defines = std::string{ config.compact_gbuffer ? COMPACT_GBUFFER_SHADER_DEFINE : "" } + GBUFFER_ENCODING_SHADER_SOURCE;
 
             // Initialize GLEW
             glewExperimental = GL_TRUE;
-            if (glewInit() != GLEW_OK)
+            const auto glew_result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+            // Contexts created through EGL (eg, headless) have no GLX display, but core GL entry points still load
+            if (glew_result != GLEW_OK && glew_result != GLEW_ERROR_NO_GLX_DISPLAY)
+#else
+            if (glew_result != GLEW_OK)
+#endif
             {
 				printf("ERROR: GLRenderSystem: Could not initialize GLEW\n");
             }
             glGetError(); // Sometimes GLEW initialization generates an error, pop it off the stack.
 
-            // Create default mesh resource
+			// Open the program binary cache before creating any programs
+			ProgramCache_init(_state->resources.program_cache, config.program_cache_dir.c_str());
+			RenderProfiler_init(_state->profiler);
+
+            // Load the default mesh and material resources up front, since they stand in for everything else while it streams
+			const auto missing_mesh_path = intern_path(config.missing_mesh);
+			const auto missing_material_path = intern_path(config.missing_material);
+			RenderResource_get_static_mesh_resource(_state->resources, missing_mesh_path);
+			RenderResource_get_material_resource(_state->resources, missing_material_path);
+			RenderResource_flush_streaming(_state->resources);
+
 			_state->resources.missing_mesh = RenderResource_get_static_mesh_resource(
 				_state->resources,
-				config.missing_mesh.c_str());
-
-            // Create the default material resource
+				missing_mesh_path);
 			_state->resources.missing_material = RenderResource_get_material_resource(
 				_state->resources,
-				config.missing_material.c_str());
+				missing_material_path);
+
+			// The default resources are never evicted
+			RenderResource_add_ref(_state->resources, missing_mesh_path);
+			RenderResource_add_ref(_state->resources, missing_material_path);
 
 			// Initialize lightmap volume resources
 			_state->resources.lightmask_volume_material = _state->resources.missing_material;
@@ -374,92 +703,26 @@ namespace sge
             glBindFramebuffer(GL_FRAMEBUFFER, _state->gbuffer_framebuffer);
             glGenTextures(GBufferLayer::NUM_LAYERS, _state->gbuffer_layers.data());
 
-            // Create gbuffer depth layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::DEPTH_STENCIL]);
-            upload_render_target_data(
-                _state->width,
-                _state->height,
-                GBUFFER_DEPTH_STENCIL_INTERNAL_FORMAT,
-                GBUFFER_DEPTH_STENCIL_UPLOAD_FORMAT,
-                GBUFFER_DEPTH_STENCIL_UPLOAD_TYPE);
-            set_render_target_params();
-            attach_framebuffer_layer(
-                _state->gbuffer_layers[GBufferLayer::DEPTH_STENCIL],
-                GBUFFER_DEPTH_STENCIL_ATTACHMENT);
-
-            // Create gbuffer position layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::POSITION]);
-            upload_render_target_data(
-                _state->width,
-                _state->height,
-                GBUFFER_POSITION_INTERNAL_FORMAT,
-                GBUFFER_POSITION_UPLOAD_FORMAT,
-                GBUFFER_POSITION_UPLOAD_TYPE);
-            set_render_target_params();
-            attach_framebuffer_layer(
-                _state->gbuffer_layers[GBufferLayer::POSITION],
-                GBUFFER_POSITION_ATTACHMENT);
-
-            // Create gbuffer normal layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::NORMAL]);
-            upload_render_target_data(
-                _state->width,
-                _state->height,
-                GBUFFER_NORMAL_INTERNAL_FORMAT,
-                GBUFFER_NORMAL_UPLOAD_FORMAT,
-                GBUFFER_NORMAL_UPLOAD_TYPE);
-            set_render_target_params();
-            attach_framebuffer_layer(
-                _state->gbuffer_layers[GBufferLayer::NORMAL],
-                GBUFFER_NORMAL_ATTACHMENT);
-
-			// Create gbuffer albedo layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::ALBEDO]);
-            upload_render_target_data(
-                _state->width,
-                _state->height,
-                GBUFFER_ALBEDO_INTERNAL_FORMAT,
-                GBUFFER_ALBEDO_UPLOAD_FORMAT,
-                GBUFFER_ALBEDO_UPLOAD_TYPE);
-            set_render_target_params();
-            attach_framebuffer_layer(
-                _state->gbuffer_layers[GBufferLayer::ALBEDO],
-                GBUFFER_ALBEDO_ATTACHMENT);
+            // Create gbuffer layers
+            for (GLsizei layer = 0; layer < GBufferLayer::NUM_LAYERS; ++layer)
+            {
+                if (_state->gbuffer_formats[layer].internal_format == GL_NONE)
+                {
+                    continue;
+                }
+
+                glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[layer]);
+                upload_render_target_data(
+                    _state->width,
+                    _state->height,
+                    _state->gbuffer_formats[layer]);
+                set_render_target_params();
+                attach_framebuffer_layer(
+                    _state->gbuffer_layers[layer],
+                    GBUFFER_LAYER_ATTACHMENTS[layer]);
+            }
 
-            // Create gbuffer roughness/metallic layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::ROUGHNESS_METALLIC]);
-            upload_render_target_data(
-                _state->width,
-                _state->height,
-                GBUFFER_ROUGHNESS_METALLIC_INTERNAL_FORMAT,
-                GBUFFER_ROUGHNESS_METALLIC_UPLOAD_FORMAT,
-                GBUFFER_ROUGHNESS_METALLIC_UPLOAD_TYPE);
-            set_render_target_params();
-            attach_framebuffer_layer(
-                _state->gbuffer_layers[GBufferLayer::ROUGHNESS_METALLIC],
-                GBUFFER_ROUGHNESS_METALLIC_ATTACHMENT);
-
-            // Create gbuffer irradiance layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::IRRADIANCE]);
-            upload_render_target_data(
-                _state->width,
-                _state->height,
-                GBUFFER_IRRADIANCE_INTERNAL_FORMAT,
-                GBUFFER_IRRADIANCE_UPLOAD_FORMAT,
-                GBUFFER_IRRADIANCE_UPLOAD_TYPE);
-            set_render_target_params();
-            attach_framebuffer_layer(
-                _state->gbuffer_layers[GBufferLayer::IRRADIANCE],
-                GBUFFER_IRRADIANCE_ATTACHMENT);
-
-			constexpr GLenum GBUFFER_DRAW_BUFFERS[] = {
-				GBUFFER_POSITION_ATTACHMENT,
-				GBUFFER_NORMAL_ATTACHMENT,
-				GBUFFER_ALBEDO_ATTACHMENT,
-				GBUFFER_ROUGHNESS_METALLIC_ATTACHMENT,
-				GBUFFER_IRRADIANCE_ATTACHMENT };
-			constexpr GLsizei NUM_GBUFFER_DRAW_BUFFERS = sizeof(GBUFFER_DRAW_BUFFERS) / sizeof(GLenum);
-			glDrawBuffers(NUM_GBUFFER_DRAW_BUFFERS, GBUFFER_DRAW_BUFFERS);
+			glDrawBuffers((GLsizei)_state->gbuffer_draw_buffers.size(), _state->gbuffer_draw_buffers.data());
 
 			// Make sure the GBuffer was constructed successfully
 			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
@@ -477,9 +740,7 @@ namespace sge
             upload_render_target_data(
                 _state->width,
                 _state->height,
-                POST_BUFFER_HDR_INTERNAL_FORMAT,
-                POST_BUFFER_HDR_UPLOAD_FORMAT,
-                POST_BUFFER_HDR_UPLOAD_TYPE);
+                _state->post_buffer_hdr_format);
             set_render_target_params();
             attach_framebuffer_layer(
                 _state->post_buffer_hdr,
@@ -514,18 +775,24 @@ namespace sge
 			glVertexAttribPointer(gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4, (void*)(sizeof(float) * 2));
 
 			// Create screen shaders
-			const GLuint viewport_v_shader = load_shader(GL_VERTEX_SHADER, config.viewport_vert_shader.c_str());
-			const GLuint scene_f_shader = load_shader(GL_FRAGMENT_SHADER, config.scene_shader.c_str());
-			const GLuint post_f_shader = load_shader(GL_FRAGMENT_SHADER, config.post_shader.c_str());
+			auto& resources = _state->resources;
+			const auto& viewport_v_source = RenderResource_get_shader_source(resources, config.viewport_vert_shader.c_str());
+			const auto& scene_f_source = RenderResource_get_shader_source(resources, config.scene_shader.c_str());
+			const auto& post_f_source = RenderResource_get_shader_source(resources, config.post_shader.c_str());
 
 		    // Create the scene shader program
-            _state->scene_shader_program = create_viewport_program(viewport_v_shader, scene_f_shader);
+            _state->scene_shader_program = create_viewport_program(resources.program_cache, viewport_v_source, scene_f_source);
             _state->scene_program_view_uniform = glGetUniformLocation(_state->scene_shader_program, "view");
+			_state->scene_program_inv_proj_uniform = glGetUniformLocation(_state->scene_shader_program, "inv_proj");
 			_state->scene_program_light_dir_uniform = glGetUniformLocation(_state->scene_shader_program, "light_dir");
 			_state->scene_program_light_intensity_uniform = glGetUniformLocation(_state->scene_shader_program, "light_intensity");
+			_state->scene_program_cluster_dims_uniform = glGetUniformLocation(_state->scene_shader_program, "cluster_dims");
+			_state->scene_program_cluster_near_uniform = glGetUniformLocation(_state->scene_shader_program, "cluster_near");
+			_state->scene_program_cluster_slice_scale_uniform = glGetUniformLocation(_state->scene_shader_program, "cluster_slice_scale");
+			LightClusters_init_buffers(_state->light_cluster_buffers);
 
             // Create the post-processing shader program
-            _state->post_shader_program = create_viewport_program(viewport_v_shader, post_f_shader);
+            _state->post_shader_program = create_viewport_program(resources.program_cache, viewport_v_source, post_f_source);
             glProgramUniform1i(_state->post_shader_program, glGetUniformLocation(_state->post_shader_program, "hdr_buffer"), 5);
 			_state->post_program_gamma_uniform = glGetUniformLocation(_state->post_shader_program, "gamma");
 			_state->post_program_brightness_uniform = glGetUniformLocation(_state->post_shader_program, "brightness_boost");
@@ -557,20 +824,24 @@ namespace sge
                 (void*)offsetof(DebugLineVert, color_rgb));
 
             // Create debug line program
-			const GLuint debug_line_v_shader = load_shader(GL_VERTEX_SHADER, config.debug_line_vert_shader.c_str());
-			const GLuint debug_line_f_shader = load_shader(GL_FRAGMENT_SHADER, config.debug_line_frag_shader.c_str());
-			_state->debug_line_program = glCreateProgram();
-			glAttachShader(_state->debug_line_program, debug_line_v_shader);
-            glAttachShader(_state->debug_line_program, debug_line_f_shader);
-
-            // Bind vertex attributes
-            glBindAttribLocation(_state->debug_line_program, DEBUG_LINE_POSITION_ATTRIB_LOCATION, DEBUG_LINE_POSITION_ATTRIB_NAME);
-            glBindAttribLocation(_state->debug_line_program, DEBUG_LINE_COLOR_ATTRIB_LOCATION, DEBUG_LINE_COLOR_ATTRIB_NAME);
-
-            // Link the program and detach shaders
-            glLinkProgram(_state->debug_line_program);
-            glDetachShader(_state->debug_line_program, debug_line_v_shader);
-            glDetachShader(_state->debug_line_program, debug_line_f_shader);
+			const auto& debug_line_v_source = RenderResource_get_shader_source(resources, config.debug_line_vert_shader.c_str());
+			const auto& debug_line_f_source = RenderResource_get_shader_source(resources, config.debug_line_frag_shader.c_str());
+			const std::string* const debug_line_sources[] = { &debug_line_v_source, &debug_line_f_source };
+			_state->debug_line_program = ProgramCache_get_program(resources.program_cache, debug_line_sources, 2, [&resources, &config](GLuint program) {
+				const auto debug_line_v_shader = RenderResource_get_shader_resource(resources, config.debug_line_vert_shader.c_str());
+				const auto debug_line_f_shader = RenderResource_get_shader_resource(resources, config.debug_line_frag_shader.c_str());
+				glAttachShader(program, debug_line_v_shader);
+				glAttachShader(program, debug_line_f_shader);
+
+				// Bind vertex attributes
+				glBindAttribLocation(program, DEBUG_LINE_POSITION_ATTRIB_LOCATION, DEBUG_LINE_POSITION_ATTRIB_NAME);
+				glBindAttribLocation(program, DEBUG_LINE_COLOR_ATTRIB_LOCATION, DEBUG_LINE_COLOR_ATTRIB_NAME);
+
+				// Link the program and detach shaders
+				glLinkProgram(program);
+				glDetachShader(program, debug_line_v_shader);
+				glDetachShader(program, debug_line_f_shader);
+			});
 
             // Make sure the program linked sucessfully
             debug_program_status(_state->debug_line_program, GLDebugOutputMode::ONLY_ERROR);
@@ -584,11 +855,17 @@ namespace sge
 			{
 				std::cerr << "GLRenderSystem: An error occurred during startup - " << error << std::endl;
 			}
+
+			const auto& program_stats = resources.program_cache.stats;
+			std::cout << "GLRenderSystem: Created " << program_stats.num_loaded << " programs from cache in " << program_stats.load_ms << "ms, compiled "
+				<< program_stats.num_compiled << " in " << program_stats.compile_ms << "ms (" << program_stats.num_rejected << " cached binaries rejected)" << std::endl;
 		}
 
 		GLRenderSystem::~GLRenderSystem()
 		{
-			// Todo
+			// Don't destroy the frames out from under the prep job
+			_state->render_prep_pool.wait(_state->render_prep_tasks);
+			RenderProfiler_free(_state->profiler);
 		}
 
 		///////////////////
@@ -627,95 +904,98 @@ namespace sge
             _state->width = width;
             _state->height = height;
 
-            // Resize depth layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::DEPTH_STENCIL]);
-            upload_render_target_data(
-                width,
-                height,
-                GBUFFER_DEPTH_STENCIL_INTERNAL_FORMAT,
-                GBUFFER_DEPTH_STENCIL_UPLOAD_FORMAT,
-                GBUFFER_DEPTH_STENCIL_UPLOAD_TYPE);
-
-            // Resize position layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::POSITION]);
-            upload_render_target_data(
-                width,
-                height,
-                GBUFFER_POSITION_INTERNAL_FORMAT,
-                GBUFFER_POSITION_UPLOAD_FORMAT,
-                GBUFFER_POSITION_UPLOAD_TYPE);
-
-            // Resize normal layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::NORMAL]);
-            upload_render_target_data(
-                width,
-                height,
-                GBUFFER_NORMAL_INTERNAL_FORMAT,
-                GBUFFER_NORMAL_UPLOAD_FORMAT,
-                GBUFFER_NORMAL_UPLOAD_TYPE);
-
-            // Resize albedo layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::ALBEDO]);
-            upload_render_target_data(
-                width,
-                height,
-                GBUFFER_ALBEDO_INTERNAL_FORMAT,
-                GBUFFER_ALBEDO_UPLOAD_FORMAT,
-                GBUFFER_ALBEDO_UPLOAD_TYPE);
-
-            // Resize rougness/metallic layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::ROUGHNESS_METALLIC]);
-            upload_render_target_data(
-                width,
-                height,
-                GBUFFER_ROUGHNESS_METALLIC_INTERNAL_FORMAT,
-                GBUFFER_ROUGHNESS_METALLIC_UPLOAD_FORMAT,
-                GBUFFER_ROUGHNESS_METALLIC_UPLOAD_TYPE);
-
-            // Resize irradiance layer
-            glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[GBufferLayer::IRRADIANCE]);
-            upload_render_target_data(
-                width,
-                height,
-                GBUFFER_IRRADIANCE_INTERNAL_FORMAT,
-                GBUFFER_IRRADIANCE_UPLOAD_FORMAT,
-                GBUFFER_IRRADIANCE_UPLOAD_TYPE);
+            // Resize gbuffer layers
+            for (GLsizei layer = 0; layer < GBufferLayer::NUM_LAYERS; ++layer)
+            {
+                if (_state->gbuffer_formats[layer].internal_format == GL_NONE)
+                {
+                    continue;
+                }
+
+                glBindTexture(GL_TEXTURE_2D, _state->gbuffer_layers[layer]);
+                upload_render_target_data(width, height, _state->gbuffer_formats[layer]);
+            }
 
             // Resize post buffer
             glBindTexture(GL_TEXTURE_2D, _state->post_buffer_hdr);
-            upload_render_target_data(
-                width,
-                height,
-                POST_BUFFER_HDR_INTERNAL_FORMAT,
-                POST_BUFFER_HDR_UPLOAD_FORMAT,
-                POST_BUFFER_HDR_UPLOAD_TYPE);
+            upload_render_target_data(width, height, _state->post_buffer_hdr_format);
 	    }
 
 		void GLRenderSystem::reset()
 		{
-			RenderScene_clear(_state->render_scene);
+			// Drop the frame in flight, since it references objects about to be destroyed
+			_state->render_prep_pool.wait(_state->render_prep_tasks);
+			_state->prepared_frame = -1;
+
+			RenderScene_clear(_state->render_scene, _state->resources);
 			_state->initialized_render_scene = false;
 		}
 
+		OcclusionStats GLRenderSystem::occlusion_stats() const
+		{
+			return _state->occlusion_stats;
+		}
+
+		ProgramCacheStats GLRenderSystem::program_cache_stats() const
+		{
+			return _state->resources.program_cache.stats;
+		}
+
+		RenderFrameStats GLRenderSystem::render_stats() const
+		{
+			return _state->profiler.last_stats;
+		}
+
+		TextureResidencyStats GLRenderSystem::texture_residency_stats() const
+		{
+			return _state->resources.residency.stats;
+		}
+
+		RenderResourceStats GLRenderSystem::resource_cache_stats() const
+		{
+			const auto& cache = _state->resources.cache;
+			RenderResourceStats stats;
+			stats.static_meshes = cache.stats(CACHE_STATIC_MESHES);
+			stats.materials = cache.stats(CACHE_MATERIALS);
+			stats.textures = cache.stats(CACHE_TEXTURES);
+			return stats;
+		}
+
 		void GLRenderSystem::render_scene(Scene& scene, SystemFrame& /*frame*/)
 		{
             // Initialize the render scene data structure, if we haven't already
             if (!_state->initialized_render_scene)
             {
-                initialize_render_scene(_state->render_scene, scene);
+                initialize_render_scene(_state->render_scene, _state->resources, scene);
                 _state->initialized_render_scene = true;
+
+				// Resources only the previous scene used are unreferenced now, so free those over budget
+				RenderResource_evict_unused(_state->resources);
             }
 
-			_state->gather_debug_lines(*_debug_draw_line_channel, _debug_draw_line_sid);
+			// Wait for the previous frame to finish preparing, and pick the other frame to prepare into
+			_state->render_prep_pool.wait(_state->render_prep_tasks);
+			const int submit_frame_index = _state->prepared_frame;
+			const int prep_frame_index = submit_frame_index == 0 ? 1 : 0;
+			auto& prep_frame = _state->frames[prep_frame_index];
+			_state->prepared_frame = -1;
+
+			_state->gather_debug_lines(*_debug_draw_line_channel, _debug_draw_line_sid, prep_frame.debug_lines);
 
 			// Consume events
 			on_static_mesh_new(scene, *_new_static_mesh_channel, _new_static_mesh_sid, _state->resources, _state->render_scene);
-			on_static_mesh_destroy(*_destroyed_static_mesh_channel, _destroyed_static_mesh_sid, _state->render_scene);
+			on_static_mesh_destroy(*_destroyed_static_mesh_channel, _destroyed_static_mesh_sid, _state->resources, _state->render_scene);
 			on_spotlight_new(scene, *_new_spotlight_channel, _new_spotlight_sid, _state->resources, _state->render_scene);
 			on_spotlight_modified(scene, *_modified_spotlight_channel, _modified_spotlight_sid, _state->resources, _state->render_scene);
 			on_spotlight_destroy(*_destroyed_spotlight_channel, _destroyed_spotlight_sid, _state->render_scene);
 			on_node_transform_update(*_modified_node_transform_channel, _modified_node_transform_sid, _state->render_scene);
 
+			// Continue streaming resources, and swap out placeholders for any that have finished
+			if (RenderResource_update_streaming(_state->resources, STREAMING_UPLOAD_BUDGET) != 0)
+			{
+				on_static_mesh_resources_streamed(scene, _state->resources, _state->render_scene);
+			}
+
 			// Create camera matrices
 			NodeId cam_node;
 			CPerspectiveCamera* cam_instance;
@@ -725,9 +1005,13 @@ namespace sge
 			auto* cam_component = scene.get_component_container(CPerspectiveCamera::type_info);
 			cam_component->get_instance_nodes(0, 1, &num_cameras, &cam_node);
 
-			// If no camera was found, return
+			// If no camera was found, just flush the previous frame
 			if (num_cameras == 0)
 			{
+				if (submit_frame_index >= 0)
+				{
+					submit_frame(*_state, _state->frames[submit_frame_index]);
+				}
 				return;
 			}
 
@@ -737,73 +1021,35 @@ namespace sge
 			const Mat4 view = cam_node_instance->get_world_matrix().inverse();
 			const Mat4 proj = cam_instance->get_projection_matrix((float)this->_state->width / this->_state->height);
 
-            // Render the scene
-			RenderScene_render(
-				_state->render_scene,
-				_state->resources,
-				_state->gbuffer_framebuffer,
-				_state->width,
-				_state->height,
-				view,
-				proj);
-
-            // Draw debug lines (only allow irradiance output)
-			glDisable(GL_STENCIL_TEST);
-			glDisable(GL_DEPTH_TEST);
-			std::array<GLenum, 5> draw_buffers = {
-				GL_NONE,
-				GL_NONE,
-				GL_NONE,
-				GL_NONE,
-				GBUFFER_IRRADIANCE_ATTACHMENT };
-			glDrawBuffers((GLsizei)draw_buffers.size(), draw_buffers.data());
-
-			if (!_state->frame_debug_lines.empty())
-            {
-                glBindVertexArray(_state->debug_line_vao);
-                glUseProgram(_state->debug_line_program);
-                glBindBuffer(GL_ARRAY_BUFFER, _state->debug_line_vbo);
-                glBufferData(
-                    GL_ARRAY_BUFFER,
-                    _state->frame_debug_lines.size() * sizeof(DebugLineVert),
-                    _state->frame_debug_lines.data(),
-                    GL_DYNAMIC_DRAW);
-                glUniformMatrix4fv(_state->debug_line_view_uniform, 1, GL_FALSE, view.vec());
-                glUniformMatrix4fv(_state->debug_line_proj_uniform, 1, GL_FALSE, proj.vec());
-                glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(_state->frame_debug_lines.size()));
-                _state->frame_debug_lines.clear();
-            }
-
-			// Reset output buffers
-			draw_buffers = {
-				GBUFFER_POSITION_ATTACHMENT,
-				GBUFFER_NORMAL_ATTACHMENT,
-				GBUFFER_ALBEDO_ATTACHMENT,
-				GBUFFER_ROUGHNESS_METALLIC_ATTACHMENT,
-				GBUFFER_IRRADIANCE_ATTACHMENT };
-			glDrawBuffers((GLsizei)draw_buffers.size(), draw_buffers.data());
-
-			render_scene_shade_hdr(_state->post_framebuffer, *_state, view);
-
-            /*---------------------------*/
-            /*---   POST-PROCESSING   ---*/
-
-            // Bind the post-buffer for reading
-            glActiveTexture(GL_TEXTURE5);
-            glBindTexture(GL_TEXTURE_2D, _state->post_buffer_hdr);
-
-			// Bind the default framebuffer for drawing
-			glBindFramebuffer(GL_FRAMEBUFFER, _state->default_framebuffer);
-
-            // Bind the post-processing shader program
-            glUseProgram(_state->post_shader_program);
-
-			// Upload gamma and brightness uniforms
-			glProgramUniform1f(_state->post_shader_program, _state->post_program_gamma_uniform, scene.get_raw_scene_data().scene_gamma);
-			glProgramUniform1f(_state->post_shader_program, _state->post_program_brightness_uniform, scene.get_raw_scene_data().scene_brightness_boost);
+            // Assign shadow atlas space based on how much of the screen each light covers
+			RenderScene_update_shadow_tiles(_state->render_scene, view, proj);
+
+			// Snapshot the scene, and build the draw lists on the prep thread
+			RenderScene_snapshot(_state->render_scene, view, proj, prep_frame.scene);
+			gather_lights(scene, prep_frame.scene.lights);
+			prep_frame.gamma = scene.get_raw_scene_data().scene_gamma;
+			prep_frame.brightness_boost = scene.get_raw_scene_data().scene_brightness_boost;
+			auto* const prep_scene = &prep_frame.scene;
+			auto* const lod_state = &_state->lod_state;
+			auto* const occlusion = &_state->occlusion;
+			_state->render_prep_pool.submit(_state->render_prep_tasks, [prep_scene, lod_state, occlusion]() {
+				RenderScene_prepare_frame(*prep_scene, *lod_state, *occlusion);
+			});
+
+			// If not pipelining, submit this frame right away
+			if (!_state->pipeline_render_prep)
+			{
+				_state->render_prep_pool.wait(_state->render_prep_tasks);
+				submit_frame(*_state, prep_frame);
+				return;
+			}
 
-			// Draw the screen quad
-			glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+			// Otherwise submit the previous frame while this one is prepared (and the next one simulated)
+			_state->prepared_frame = prep_frame_index;
+			if (submit_frame_index >= 0)
+			{
+				submit_frame(*_state, _state->frames[submit_frame_index]);
+			}
 		}
 	}
 }
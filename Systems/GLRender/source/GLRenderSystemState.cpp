@@ -7,10 +7,10 @@ namespace sge
 {
 	namespace gl_render
 	{
-		void GLRenderSystem::State::gather_debug_lines(EventChannel& debug_line_channel, EventChannel::SubscriberId subscriber_id)
+		void GLRenderSystem::State::gather_debug_lines(EventChannel& debug_line_channel, EventChannel::SubscriberId subscriber_id, std::vector<DebugLineVert>& out_lines)
 		{
 			// Clear current lines
-			frame_debug_lines.clear();
+			out_lines.clear();
 
 			DebugLine lines[64];
 			int32 num_lines;
@@ -27,7 +27,7 @@ namespace sge
 				}
 
 				// Add them to the buffer
-				frame_debug_lines.insert(frame_debug_lines.end(), &verts[0], &verts[0] + num_lines * 2);
+				out_lines.insert(out_lines.end(), &verts[0], &verts[0] + num_lines * 2);
 			}
 		}
 	}
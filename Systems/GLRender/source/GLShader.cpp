@@ -22,9 +22,9 @@ namespace sge
 			return id;
 		}
 
-		GLuint load_shader(
-			GLenum type,
-			const char* path)
+		std::string read_shader_source(
+			const char* path,
+			const char* defines)
 		{
 			// Open a file containing the shader source code
 			std::ifstream file{ path };
@@ -38,7 +38,23 @@ namespace sge
 			std::string source(len, ' ');
 			file.read(&source[0], len);
 
-			// Compile the shader
+			// Insert definitions after the version directive, which must come first
+			if (defines != nullptr && defines[0] != '\0')
+			{
+				const auto version_pos = source.find("#version");
+				const auto insert_pos = version_pos == std::string::npos ? 0 : source.find('\n', version_pos);
+				source.insert(insert_pos == std::string::npos ? source.size() : insert_pos + 1, defines);
+			}
+
+			return source;
+		}
+
+		GLuint load_shader(
+			GLenum type,
+			const char* path,
+			const char* defines)
+		{
+			const auto source = read_shader_source(path, defines);
 			return create_shader(type, source.c_str());
 		}
 
@@ -1,5 +1,6 @@
 // GLStaticMesh.cpp
 
+#include <cstddef>
 #include "../private/GLStaticMesh.h"
 #include "../private/GLMaterial.h"
 
@@ -11,65 +12,43 @@ namespace sge
         {
             void upload_static_mesh_vertex_data(
                 GLuint vao,
-                const GLuint vertex_buffers[],
+                GLuint vbo,
                 std::size_t num_vertices,
-                const Vec3* vertex_positions,
-                const HalfVec3* vertex_normals,
-                const HalfVec3* vertex_tangents,
-                const int8* vertex_bitangent_signs,
-                const UHalfVec2* material_uv_coords,
-                const UHalfVec2* lightmap_uv_coords)
+                const mesh_ops::PackedVertex* vertices)
             {
+                constexpr GLsizei stride = sizeof(mesh_ops::PackedVertex);
+
                 // Bind VAO
                 glBindVertexArray(vao);
 
-                // Upload vertex position data
-                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[POSITION_BUFFER_INDEX]);
-                glBufferData(GL_ARRAY_BUFFER, num_vertices * sizeof(Vec3), vertex_positions, GL_STATIC_DRAW);
+                // Upload interleaved vertex data
+                glBindBuffer(GL_ARRAY_BUFFER, vbo);
+                glBufferData(GL_ARRAY_BUFFER, num_vertices * stride, vertices, GL_STATIC_DRAW);
 
-                // Define vertex position specification
+                // Define vertex position specification (quantized to the mesh bounds)
                 glEnableVertexAttribArray(gl_material::POSITION_ATTRIB_LOCATION);
-                glVertexAttribPointer(gl_material::POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), nullptr);
-
-                // Upload normal buffer
-                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[NORMAL_BUFFER_INDEX]);
-                glBufferData(GL_ARRAY_BUFFER, num_vertices * sizeof(HalfVec3), vertex_normals, GL_STATIC_DRAW);
+                glVertexAttribPointer(gl_material::POSITION_ATTRIB_LOCATION, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                    reinterpret_cast<const void*>(offsetof(mesh_ops::PackedVertex, position)));
 
-                // Define vertex normal specification
+                // Define vertex normal specification (bitangent sign is stored in 'w')
                 glEnableVertexAttribArray(gl_material::NORMAL_ATTRIB_LOCATION);
-                glVertexAttribPointer(gl_material::NORMAL_ATTRIB_LOCATION, 3, GL_SHORT, GL_TRUE, sizeof(HalfVec3), nullptr);
-
-                // Upload tangent buffer
-                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[TANGENT_BUFFER_INDEX]);
-                glBufferData(GL_ARRAY_BUFFER, num_vertices * sizeof(HalfVec3), vertex_tangents, GL_STATIC_DRAW);
+                glVertexAttribPointer(gl_material::NORMAL_ATTRIB_LOCATION, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                    reinterpret_cast<const void*>(offsetof(mesh_ops::PackedVertex, normal)));
 
                 // Define vertex tangent specification
                 glEnableVertexAttribArray(gl_material::TANGENT_ATTRIB_LOCATION);
-                glVertexAttribPointer(gl_material::TANGENT_ATTRIB_LOCATION, 3, GL_SHORT, GL_TRUE, sizeof(HalfVec3), nullptr);
-
-                // Upload bitangent sign buffer
-                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[BITANGENT_SIGN_BUFFER_INDEX]);
-                glBufferData(GL_ARRAY_BUFFER, num_vertices, vertex_bitangent_signs, GL_STATIC_DRAW);
-
-                // Define bitangent specification
-                glEnableVertexAttribArray(gl_material::BITANGENT_SIGN_ATTRIB_LOCATION);
-                glVertexAttribPointer(gl_material::BITANGENT_SIGN_ATTRIB_LOCATION, 1, GL_BYTE, GL_FALSE, 1, nullptr);
-
-                // Upload material uv data
-                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[MATERIAL_UV_BUFFER_INDEX]);
-                glBufferData(GL_ARRAY_BUFFER, num_vertices * sizeof(UHalfVec2), material_uv_coords, GL_STATIC_DRAW);
+                glVertexAttribPointer(gl_material::TANGENT_ATTRIB_LOCATION, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                    reinterpret_cast<const void*>(offsetof(mesh_ops::PackedVertex, tangent)));
 
                 // Define vertex material uv specification
                 glEnableVertexAttribArray(gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION);
-                glVertexAttribPointer(gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(UHalfVec2), nullptr);
-
-                // Upload lightmap uv data
-                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[LIGHTMAP_UV_BUFFER_INDEX]);
-                glBufferData(GL_ARRAY_BUFFER, num_vertices * sizeof(UHalfVec2), lightmap_uv_coords, GL_STATIC_DRAW);
+                glVertexAttribPointer(gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                    reinterpret_cast<const void*>(offsetof(mesh_ops::PackedVertex, material_uv)));
 
                 // Define vertex lightmap uv specification
                 glEnableVertexAttribArray(gl_material::LIGHTMAP_TEXCOORD_ATTRIB_LOCATION);
-                glVertexAttribPointer(gl_material::LIGHTMAP_TEXCOORD_ATTRIB_LOCATION, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(UHalfVec2), nullptr);
+                glVertexAttribPointer(gl_material::LIGHTMAP_TEXCOORD_ATTRIB_LOCATION, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                    reinterpret_cast<const void*>(offsetof(mesh_ops::PackedVertex, lightmap_uv)));
 
                 // Unbind
                 glBindVertexArray(0);
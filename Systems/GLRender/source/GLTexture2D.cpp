@@ -6,6 +6,21 @@ namespace sge
 {
 	namespace gl_render
 	{
+        void set_sampling_parameters(
+            GLint max_level)
+        {
+			// Set wrapping parameters to repeat
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+			// Set sampling parameters
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 8.f);
+        }
+
         GLuint create_texture(
             int32 width,
             int32 height,
@@ -14,21 +29,25 @@ namespace sge
             GLenum upload_format,
             GLenum upload_type)
 		{
-			// Create and bind the buffer
+			// Create the texture
             GLuint id = 0;
 			glGenTextures(1, &id);
-			glBindTexture(GL_TEXTURE_2D, id);
+			upload_texture(id, width, height, data, internal_format, upload_format, upload_type);
 
-			// Set wrapping parameters to repeat
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            return id;
+		}
 
-			// Set sampling parameters
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 8);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 8.f);
+        void upload_texture(
+            GLuint id,
+            int32 width,
+            int32 height,
+            const void* data,
+            GLenum internal_format,
+            GLenum upload_format,
+            GLenum upload_type)
+		{
+			glBindTexture(GL_TEXTURE_2D, id);
+			set_sampling_parameters(8);
 
 			// Load the image
 			glTexImage2D(
@@ -44,8 +63,54 @@ namespace sge
 
             // Generate mipmaps
 			glGenerateMipmap(GL_TEXTURE_2D);
-
-            return id;
 		}
+
+        GLenum compressed_texture_format(
+            const CompressedTexture& texture)
+        {
+            const bool srgb = texture.color_space() == Texture::ColorSpace::S_RGB;
+            switch (texture.format())
+            {
+            case texture_compression::BlockFormat::BC1:
+                return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+            case texture_compression::BlockFormat::BC3:
+                return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+            case texture_compression::BlockFormat::BC5:
+                return GL_COMPRESSED_RG_RGTC2;
+
+            case texture_compression::BlockFormat::BC7:
+                return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+
+            default:
+                return GL_NONE;
+            }
+        }
+
+        void upload_compressed_texture(
+            GLuint id,
+            const CompressedTexture& texture,
+            const void* data)
+        {
+            glBindTexture(GL_TEXTURE_2D, id);
+            set_sampling_parameters(static_cast<GLint>(texture.num_mips()) - 1);
+
+            // Upload each level of the mip chain as-is, instead of generating it
+            const auto internal_format = compressed_texture_format(texture);
+            for (std::size_t level = 0; level < texture.num_mips(); ++level)
+            {
+                const auto& mip = texture.mip(level);
+                glCompressedTexImage2D(
+                    GL_TEXTURE_2D,
+                    static_cast<GLint>(level),
+                    internal_format,
+                    mip.width,
+                    mip.height,
+                    0,
+                    static_cast<GLsizei>(mip.size),
+                    static_cast<const byte*>(data) + mip.offset);
+            }
+        }
 	}
 }
@@ -0,0 +1,269 @@
+// LightClusters.cpp
+
+#include <algorithm>
+#include <cmath>
+#include "../private/LightClusters.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SGE_LIGHT_CLUSTERS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace sge
+{
+	namespace gl_render
+	{
+		static constexpr uint32 CLUSTERS_PER_SLICE = LIGHT_CLUSTER_TILES_X * LIGHT_CLUSTER_TILES_Y;
+
+		static_assert(CLUSTERS_PER_SLICE % 4 == 0, "Clusters are tested four at a time");
+
+		static float slice_depth(
+			const LightClusters& clusters,
+			uint32 slice)
+		{
+			return clusters.near * std::exp(slice / clusters.slice_scale);
+		}
+
+		static uint32 depth_slice(
+			const LightClusters& clusters,
+			float depth)
+		{
+			const float slice = std::log(std::max(depth, clusters.near) / clusters.near) * clusters.slice_scale;
+			return std::min(static_cast<uint32>(std::max(slice, 0.f)), LIGHT_CLUSTER_SLICES - 1);
+		}
+
+		static void build_cluster_bounds(
+			LightClusters& clusters,
+			const Mat4& proj_matrix)
+		{
+			// Recover the clipping planes from the projection matrix
+			const float p22 = proj_matrix.get(2, 2);
+			const float p32 = proj_matrix.get(3, 2);
+			const float near = p32 / (p22 - 1.f);
+			const float far = p32 / (p22 + 1.f);
+
+			clusters.cluster_proj_matrix = proj_matrix;
+			clusters.near = near;
+			clusters.slice_scale = LIGHT_CLUSTER_SLICES / std::log(far / near);
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				clusters.cluster_min[axis].resize(NUM_LIGHT_CLUSTERS);
+				clusters.cluster_max[axis].resize(NUM_LIGHT_CLUSTERS);
+			}
+
+			// View-space 'x' at distance 'd' along the view is '(ndc + p20) * d / p00' (and similarly for 'y')
+			const float p00 = proj_matrix.get(0, 0);
+			const float p11 = proj_matrix.get(1, 1);
+			const float p20 = proj_matrix.get(2, 0);
+			const float p21 = proj_matrix.get(2, 1);
+
+			for (uint32 slice = 0; slice < LIGHT_CLUSTER_SLICES; ++slice)
+			{
+				const float depth_near = slice_depth(clusters, slice);
+				const float depth_far = slice_depth(clusters, slice + 1);
+
+				for (uint32 tile_y = 0; tile_y < LIGHT_CLUSTER_TILES_Y; ++tile_y)
+				{
+					const float ndc_y0 = -1.f + 2.f * tile_y / LIGHT_CLUSTER_TILES_Y + p21;
+					const float ndc_y1 = -1.f + 2.f * (tile_y + 1) / LIGHT_CLUSTER_TILES_Y + p21;
+
+					for (uint32 tile_x = 0; tile_x < LIGHT_CLUSTER_TILES_X; ++tile_x)
+					{
+						const float ndc_x0 = -1.f + 2.f * tile_x / LIGHT_CLUSTER_TILES_X + p20;
+						const float ndc_x1 = -1.f + 2.f * (tile_x + 1) / LIGHT_CLUSTER_TILES_X + p20;
+						const auto cluster = (slice * LIGHT_CLUSTER_TILES_Y + tile_y) * LIGHT_CLUSTER_TILES_X + tile_x;
+
+						clusters.cluster_min[0][cluster] = std::min(ndc_x0 * depth_near, ndc_x0 * depth_far) / p00;
+						clusters.cluster_max[0][cluster] = std::max(ndc_x1 * depth_near, ndc_x1 * depth_far) / p00;
+						clusters.cluster_min[1][cluster] = std::min(ndc_y0 * depth_near, ndc_y0 * depth_far) / p11;
+						clusters.cluster_max[1][cluster] = std::max(ndc_y1 * depth_near, ndc_y1 * depth_far) / p11;
+						clusters.cluster_min[2][cluster] = -depth_far;
+						clusters.cluster_max[2][cluster] = -depth_near;
+					}
+				}
+			}
+		}
+
+		/**
+		 * \brief Appends a (cluster, light) pair for each cluster in the given range that intersects the given view-space sphere.
+		 */
+		static void find_intersecting_clusters(
+			LightClusters& clusters,
+			uint32 start_cluster,
+			uint32 end_cluster,
+			const Vec3& center,
+			float radius,
+			uint32 light_index)
+		{
+			const float* const min_x = clusters.cluster_min[0].data();
+			const float* const min_y = clusters.cluster_min[1].data();
+			const float* const min_z = clusters.cluster_min[2].data();
+			const float* const max_x = clusters.cluster_max[0].data();
+			const float* const max_y = clusters.cluster_max[1].data();
+			const float* const max_z = clusters.cluster_max[2].data();
+
+#if SGE_LIGHT_CLUSTERS_SSE2
+			const __m128 cx = _mm_set1_ps(center.x());
+			const __m128 cy = _mm_set1_ps(center.y());
+			const __m128 cz = _mm_set1_ps(center.z());
+			const __m128 radius_sqr = _mm_set1_ps(radius * radius);
+			const __m128 zero = _mm_setzero_ps();
+
+			for (uint32 cluster = start_cluster; cluster < end_cluster; cluster += 4)
+			{
+				// Distance from the sphere's center to each box, per axis
+				const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(min_x + cluster), cx), _mm_sub_ps(cx, _mm_loadu_ps(max_x + cluster))), zero);
+				const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(min_y + cluster), cy), _mm_sub_ps(cy, _mm_loadu_ps(max_y + cluster))), zero);
+				const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(min_z + cluster), cz), _mm_sub_ps(cz, _mm_loadu_ps(max_z + cluster))), zero);
+				const __m128 dist_sqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+				int mask = _mm_movemask_ps(_mm_cmple_ps(dist_sqr, radius_sqr));
+				for (uint32 i = 0; mask != 0; ++i, mask >>= 1)
+				{
+					if (mask & 1)
+					{
+						clusters.scratch_pairs.push_back(cluster + i);
+						clusters.scratch_pairs.push_back(light_index);
+					}
+				}
+			}
+#else
+			for (uint32 cluster = start_cluster; cluster < end_cluster; ++cluster)
+			{
+				const float dx = std::max(std::max(min_x[cluster] - center.x(), center.x() - max_x[cluster]), 0.f);
+				const float dy = std::max(std::max(min_y[cluster] - center.y(), center.y() - max_y[cluster]), 0.f);
+				const float dz = std::max(std::max(min_z[cluster] - center.z(), center.z() - max_z[cluster]), 0.f);
+				if (dx * dx + dy * dy + dz * dz <= radius * radius)
+				{
+					clusters.scratch_pairs.push_back(cluster);
+					clusters.scratch_pairs.push_back(light_index);
+				}
+			}
+#endif
+		}
+
+		void LightClusters_assign(
+			LightClusters& clusters,
+			const Mat4& view_matrix,
+			const Mat4& proj_matrix,
+			const LightClusters_Light* const lights,
+			const std::size_t num_lights)
+		{
+			if (clusters.cluster_min[0].empty() || clusters.cluster_proj_matrix != proj_matrix)
+			{
+				build_cluster_bounds(clusters, proj_matrix);
+			}
+
+			clusters.lights.clear();
+			clusters.scratch_pairs.clear();
+			const float far = slice_depth(clusters, LIGHT_CLUSTER_SLICES);
+
+			for (std::size_t i = 0; i < num_lights && clusters.lights.size() < MAX_CLUSTERED_LIGHTS; ++i)
+			{
+				const auto& light = lights[i];
+				const auto center = view_matrix * light.position;
+				const float depth = -center.z();
+				if (light.radius <= 0.f || depth + light.radius < clusters.near || depth - light.radius > far)
+				{
+					continue;
+				}
+
+				// Test the clusters in the slices the light's sphere overlaps
+				const auto light_index = static_cast<uint32>(clusters.lights.size());
+				const auto num_pairs = clusters.scratch_pairs.size();
+				const auto start_slice = depth_slice(clusters, depth - light.radius);
+				const auto end_slice = depth_slice(clusters, depth + light.radius) + 1;
+				find_intersecting_clusters(
+					clusters,
+					start_slice * CLUSTERS_PER_SLICE,
+					end_slice * CLUSTERS_PER_SLICE,
+					center,
+					light.radius,
+					light_index);
+
+				// Skip lights outside the view
+				if (clusters.scratch_pairs.size() == num_pairs)
+				{
+					continue;
+				}
+
+				const auto direction = (view_matrix * (light.position + light.direction) - center).normalized();
+				LightClusters_GPULight gpu_light;
+				gpu_light.position[0] = center.x();
+				gpu_light.position[1] = center.y();
+				gpu_light.position[2] = center.z();
+				gpu_light.radius = light.radius;
+				gpu_light.intensity[0] = light.intensity.red();
+				gpu_light.intensity[1] = light.intensity.green();
+				gpu_light.intensity[2] = light.intensity.blue();
+				gpu_light.cos_inner = light.cos_inner;
+				gpu_light.direction[0] = direction.x();
+				gpu_light.direction[1] = direction.y();
+				gpu_light.direction[2] = direction.z();
+				gpu_light.cos_outer = light.cos_outer;
+				clusters.lights.push_back(gpu_light);
+			}
+
+			// Count the lights in each cluster
+			clusters.cluster_ranges.assign(NUM_LIGHT_CLUSTERS * 2, 0);
+			const auto num_pairs = clusters.scratch_pairs.size() / 2;
+			for (std::size_t i = 0; i < num_pairs; ++i)
+			{
+				clusters.cluster_ranges[clusters.scratch_pairs[i * 2] * 2 + 1] += 1;
+			}
+
+			// Compute offsets, then scatter light indices into each cluster's range
+			uint32 offset = 0;
+			for (uint32 cluster = 0; cluster < NUM_LIGHT_CLUSTERS; ++cluster)
+			{
+				clusters.cluster_ranges[cluster * 2] = offset;
+				offset += clusters.cluster_ranges[cluster * 2 + 1];
+				clusters.cluster_ranges[cluster * 2 + 1] = 0;
+			}
+
+			clusters.light_indices.resize(num_pairs);
+			for (std::size_t i = 0; i < num_pairs; ++i)
+			{
+				const auto cluster = clusters.scratch_pairs[i * 2];
+				auto& count = clusters.cluster_ranges[cluster * 2 + 1];
+				clusters.light_indices[clusters.cluster_ranges[cluster * 2] + count] = clusters.scratch_pairs[i * 2 + 1];
+				count += 1;
+			}
+		}
+
+		void LightClusters_init_buffers(
+			LightClusters_Buffers& buffers)
+		{
+			glGenBuffers(1, &buffers.light_buffer);
+			glGenBuffers(1, &buffers.cluster_buffer);
+			glGenBuffers(1, &buffers.index_buffer);
+		}
+
+		template <typename T>
+		static void upload_storage_buffer(
+			GLuint buffer,
+			GLuint binding,
+			const std::vector<T>& data)
+		{
+			// Buffers are never empty, so that they may always be bound
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<std::size_t>(data.size(), 1) * sizeof(T), nullptr, GL_STREAM_DRAW);
+			if (!data.empty())
+			{
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, data.size() * sizeof(T), data.data());
+			}
+
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+		}
+
+		void LightClusters_upload(
+			const LightClusters_Buffers& buffers,
+			const LightClusters& clusters)
+		{
+			upload_storage_buffer(buffers.light_buffer, LIGHT_BUFFER_BINDING, clusters.lights);
+			upload_storage_buffer(buffers.cluster_buffer, LIGHT_CLUSTER_BUFFER_BINDING, clusters.cluster_ranges);
+			upload_storage_buffer(buffers.index_buffer, LIGHT_INDEX_BUFFER_BINDING, clusters.light_indices);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+	}
+}
@@ -0,0 +1,376 @@
+// OcclusionBuffer.cpp
+
+#include <algorithm>
+#include <cmath>
+#include "../private/OcclusionBuffer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SGE_OCCLUSION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* Occluder triangles are clipped against this 'w', to avoid dividing by zero. */
+		static constexpr float OCCLUSION_NEAR_W = 1e-3f;
+
+		/* How many texels of a hierarchical-Z level a sphere may cover on each axis before a coarser level is used. */
+		static constexpr int OCCLUSION_MAX_TEST_TEXELS = 4;
+
+		struct ClipVert
+		{
+			float x;
+			float y;
+			float w;
+		};
+
+		struct ScreenVert
+		{
+			float x;
+			float y;
+
+			/* 1/w */
+			float depth;
+		};
+
+		static ClipVert transform_clip(
+			const Mat4& m,
+			const Vec3& p)
+		{
+			ClipVert result;
+			result.x = m.get(0, 0) * p.x() + m.get(1, 0) * p.y() + m.get(2, 0) * p.z() + m.get(3, 0);
+			result.y = m.get(0, 1) * p.x() + m.get(1, 1) * p.y() + m.get(2, 1) * p.z() + m.get(3, 1);
+			result.w = m.get(0, 3) * p.x() + m.get(1, 3) * p.y() + m.get(2, 3) * p.z() + m.get(3, 3);
+			return result;
+		}
+
+		static ScreenVert to_screen(
+			const ClipVert& v,
+			int width,
+			int height)
+		{
+			const float inv_w = 1.f / v.w;
+
+			ScreenVert result;
+			result.x = (v.x * inv_w * 0.5f + 0.5f) * width;
+			result.y = (v.y * inv_w * 0.5f + 0.5f) * height;
+			result.depth = inv_w;
+			return result;
+		}
+
+		static int hiz_level_size(
+			int size,
+			std::size_t level)
+		{
+			for (std::size_t i = 0; i <= level; ++i)
+			{
+				size = (size + 1) / 2;
+			}
+
+			return size;
+		}
+
+		static void rasterize_triangle(
+			OcclusionBuffer& buffer,
+			ScreenVert v0,
+			ScreenVert v1,
+			ScreenVert v2)
+		{
+			// Make the winding counter-clockwise, so that the inside of every edge is positive
+			float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+			if (std::abs(area) < 1e-8f)
+			{
+				return;
+			}
+			if (area < 0.f)
+			{
+				std::swap(v1, v2);
+				area = -area;
+			}
+
+			// Get the bounds of the triangle on screen, aligning the start to a group of four pixels
+			const int min_x = std::max(0, static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x })))) & ~3;
+			const int max_x = std::min(buffer.width - 1, static_cast<int>(std::ceil(std::max({ v0.x, v1.x, v2.x }))));
+			const int min_y = std::max(0, static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))));
+			const int max_y = std::min(buffer.height - 1, static_cast<int>(std::ceil(std::max({ v0.y, v1.y, v2.y }))));
+			if (min_x > max_x || min_y > max_y)
+			{
+				return;
+			}
+
+			// Set up edge functions (edge 'i' is opposite vertex 'i')
+			const ScreenVert verts[3] = { v0, v1, v2 };
+			float edge_a[3], edge_b[3], edge_c[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				const auto& a = verts[(i + 1) % 3];
+				const auto& b = verts[(i + 2) % 3];
+				edge_a[i] = a.y - b.y;
+				edge_b[i] = b.x - a.x;
+				edge_c[i] = -(edge_a[i] * a.x + edge_b[i] * a.y);
+			}
+
+			// Depth is a plane in screen space, since it's interpolated through the (normalized) edge functions
+			const float inv_area = 1.f / area;
+			const float depth_dx = (edge_a[0] * v0.depth + edge_a[1] * v1.depth + edge_a[2] * v2.depth) * inv_area;
+			const float depth_dy = (edge_b[0] * v0.depth + edge_b[1] * v1.depth + edge_b[2] * v2.depth) * inv_area;
+			const float depth_c = (edge_c[0] * v0.depth + edge_c[1] * v1.depth + edge_c[2] * v2.depth) * inv_area;
+
+#if SGE_OCCLUSION_SSE2
+			const __m128 pixel_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 a0 = _mm_set1_ps(edge_a[0]), a1 = _mm_set1_ps(edge_a[1]), a2 = _mm_set1_ps(edge_a[2]);
+			const __m128 dx = _mm_set1_ps(depth_dx);
+
+			for (int y = min_y; y <= max_y; ++y)
+			{
+				const float py = y + 0.5f;
+				const __m128 row0 = _mm_set1_ps(edge_b[0] * py + edge_c[0]);
+				const __m128 row1 = _mm_set1_ps(edge_b[1] * py + edge_c[1]);
+				const __m128 row2 = _mm_set1_ps(edge_b[2] * py + edge_c[2]);
+				const __m128 row_depth = _mm_set1_ps(depth_dy * py + depth_c);
+				float* const row = buffer.depth.data() + y * buffer.width;
+
+				for (int x = min_x; x <= max_x; x += 4)
+				{
+					const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixel_offsets);
+					const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), row0);
+					const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), row1);
+					const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), row2);
+					const __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+					if (_mm_movemask_ps(inside) == 0)
+					{
+						continue;
+					}
+
+					// Keep the nearest depth of the pixels inside the triangle
+					const __m128 depth = _mm_add_ps(_mm_mul_ps(dx, px), row_depth);
+					const __m128 old_depth = _mm_loadu_ps(row + x);
+					const __m128 new_depth = _mm_max_ps(old_depth, depth);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, new_depth), _mm_andnot_ps(inside, old_depth)));
+				}
+			}
+#else
+			for (int y = min_y; y <= max_y; ++y)
+			{
+				const float py = y + 0.5f;
+				float* const row = buffer.depth.data() + y * buffer.width;
+
+				for (int x = min_x; x <= max_x; ++x)
+				{
+					const float px = x + 0.5f;
+					if (edge_a[0] * px + edge_b[0] * py + edge_c[0] < 0.f ||
+						edge_a[1] * px + edge_b[1] * py + edge_c[1] < 0.f ||
+						edge_a[2] * px + edge_b[2] * py + edge_c[2] < 0.f)
+					{
+						continue;
+					}
+
+					row[x] = std::max(row[x], depth_dx * px + depth_dy * py + depth_c);
+				}
+			}
+#endif
+
+			buffer.num_triangles += 1;
+		}
+
+		void OcclusionBuffer_clear(
+			OcclusionBuffer& buffer,
+			const int width,
+			const int height)
+		{
+			buffer.width = width;
+			buffer.height = height;
+			buffer.depth.assign(width * height, 0.f);
+			buffer.hiz.clear();
+			buffer.num_triangles = 0;
+		}
+
+		void OcclusionBuffer_rasterize(
+			OcclusionBuffer& buffer,
+			const Mat4& world_view_proj,
+			const OccluderMesh& mesh)
+		{
+			const auto num_elements = mesh.elements.size() / 3 * 3;
+			for (std::size_t i = 0; i < num_elements; i += 3)
+			{
+				const ClipVert tri[3] = {
+					transform_clip(world_view_proj, mesh.positions[mesh.elements[i]]),
+					transform_clip(world_view_proj, mesh.positions[mesh.elements[i + 1]]),
+					transform_clip(world_view_proj, mesh.positions[mesh.elements[i + 2]]) };
+
+				// Clip against the near plane, which may turn the triangle into a quad
+				ClipVert poly[4];
+				int num_poly = 0;
+				for (int v = 0; v < 3; ++v)
+				{
+					const auto& cur = tri[v];
+					const auto& next = tri[(v + 1) % 3];
+					const bool cur_inside = cur.w >= OCCLUSION_NEAR_W;
+					const bool next_inside = next.w >= OCCLUSION_NEAR_W;
+
+					if (cur_inside)
+					{
+						poly[num_poly++] = cur;
+					}
+					if (cur_inside != next_inside)
+					{
+						const float t = (OCCLUSION_NEAR_W - cur.w) / (next.w - cur.w);
+						poly[num_poly++] = ClipVert{ cur.x + (next.x - cur.x) * t, cur.y + (next.y - cur.y) * t, OCCLUSION_NEAR_W };
+					}
+				}
+
+				if (num_poly < 3)
+				{
+					continue;
+				}
+
+				const auto s0 = to_screen(poly[0], buffer.width, buffer.height);
+				auto prev = to_screen(poly[1], buffer.width, buffer.height);
+				for (int v = 2; v < num_poly; ++v)
+				{
+					const auto cur = to_screen(poly[v], buffer.width, buffer.height);
+					rasterize_triangle(buffer, s0, prev, cur);
+					prev = cur;
+				}
+			}
+		}
+
+		void OcclusionBuffer_build_hiz(
+			OcclusionBuffer& buffer)
+		{
+			buffer.hiz.clear();
+
+			const float* src = buffer.depth.data();
+			int src_width = buffer.width;
+			int src_height = buffer.height;
+			while (src_width > 1 || src_height > 1)
+			{
+				const int dst_width = (src_width + 1) / 2;
+				const int dst_height = (src_height + 1) / 2;
+				buffer.hiz.emplace_back(dst_width * dst_height);
+				auto& dst = buffer.hiz.back();
+
+				// Each texel keeps the farthest depth of the texels it covers
+				for (int y = 0; y < dst_height; ++y)
+				{
+					const int y0 = y * 2;
+					const int y1 = std::min(y0 + 1, src_height - 1);
+					for (int x = 0; x < dst_width; ++x)
+					{
+						const int x0 = x * 2;
+						const int x1 = std::min(x0 + 1, src_width - 1);
+						dst[y * dst_width + x] = std::min(
+							std::min(src[y0 * src_width + x0], src[y0 * src_width + x1]),
+							std::min(src[y1 * src_width + x0], src[y1 * src_width + x1]));
+					}
+				}
+
+				src = dst.data();
+				src_width = dst_width;
+				src_height = dst_height;
+			}
+		}
+
+		bool OcclusionBuffer_is_occluded(
+			const OcclusionBuffer& buffer,
+			const Mat4& view_proj,
+			const BoundingSphere& world_sphere)
+		{
+			if (buffer.hiz.empty())
+			{
+				return false;
+			}
+
+			// Project the corners of the sphere's bounding box, which bound the sphere on screen
+			float min_x = 1.f, max_x = -1.f, min_y = 1.f, max_y = -1.f;
+			float nearest_depth = 0.f;
+			for (int i = 0; i < 8; ++i)
+			{
+				const Vec3 offset{
+					(i & 1) ? world_sphere.radius : -world_sphere.radius,
+					(i & 2) ? world_sphere.radius : -world_sphere.radius,
+					(i & 4) ? world_sphere.radius : -world_sphere.radius };
+				const auto clip = transform_clip(view_proj, world_sphere.center + offset);
+				if (clip.w < OCCLUSION_NEAR_W)
+				{
+					// Crosses the near plane
+					return false;
+				}
+
+				const float inv_w = 1.f / clip.w;
+				min_x = std::min(min_x, clip.x * inv_w);
+				max_x = std::max(max_x, clip.x * inv_w);
+				min_y = std::min(min_y, clip.y * inv_w);
+				max_y = std::max(max_y, clip.y * inv_w);
+				nearest_depth = std::max(nearest_depth, inv_w);
+			}
+
+			// Get the covered pixels, leaving spheres that are entirely off screen to frustum culling
+			const int x0 = std::max(0, static_cast<int>((min_x * 0.5f + 0.5f) * buffer.width));
+			const int x1 = std::min(buffer.width - 1, static_cast<int>((max_x * 0.5f + 0.5f) * buffer.width));
+			const int y0 = std::max(0, static_cast<int>((min_y * 0.5f + 0.5f) * buffer.height));
+			const int y1 = std::min(buffer.height - 1, static_cast<int>((max_y * 0.5f + 0.5f) * buffer.height));
+			if (x0 > x1 || y0 > y1)
+			{
+				return false;
+			}
+
+			// Pick the finest level where the sphere covers only a few texels
+			std::size_t level = 0;
+			const int size = std::max(x1 - x0, y1 - y0) + 1;
+			while (level + 1 < buffer.hiz.size() && (size >> (level + 1)) >= OCCLUSION_MAX_TEST_TEXELS)
+			{
+				level += 1;
+			}
+
+			// The sphere is occluded if it's behind the farthest occluder in every texel it covers
+			const auto& texels = buffer.hiz[level];
+			const int level_width = hiz_level_size(buffer.width, level);
+			const int shift = static_cast<int>(level) + 1;
+			for (int y = y0 >> shift; y <= (y1 >> shift); ++y)
+			{
+				for (int x = x0 >> shift; x <= (x1 >> shift); ++x)
+				{
+					if (texels[y * level_width + x] <= nearest_depth)
+					{
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		OccluderMesh make_occluder_mesh(
+			const Vec3* const positions,
+			const uint32* const elements,
+			const std::size_t num_elements)
+		{
+			OccluderMesh result;
+			result.elements.reserve(num_elements);
+
+			// Only keep positions the triangles reference
+			std::vector<uint32> remap;
+			for (std::size_t i = 0; i < num_elements; ++i)
+			{
+				const auto elem = elements[i];
+				if (elem >= remap.size())
+				{
+					remap.resize(elem + 1, ~uint32{ 0 });
+				}
+				if (remap[elem] == ~uint32{ 0 })
+				{
+					remap[elem] = static_cast<uint32>(result.positions.size());
+					result.positions.push_back(positions[elem]);
+				}
+
+				result.elements.push_back(remap[elem]);
+			}
+
+			return result;
+		}
+	}
+}
@@ -0,0 +1,226 @@
+// ProgramCache.cpp
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "../private/ProgramCache.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* Identifies program cache files, and the version of their layout. */
+		static constexpr uint32 PROGRAM_CACHE_MAGIC = 0x42504753; // 'SGPB'
+		static constexpr uint32 PROGRAM_CACHE_VERSION = 1;
+
+		/**
+		 * \brief Header at the start of each program cache file, followed by the program binary.
+		 */
+		struct ProgramCacheHeader
+		{
+			uint32 magic;
+			uint32 version;
+			uint64 key;
+			uint32 binary_format;
+			uint32 binary_length;
+		};
+
+		static constexpr uint64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+		static constexpr uint64 FNV_PRIME = 1099511628211ull;
+
+		static uint64 hash_bytes(
+			uint64 hash,
+			const void* data,
+			std::size_t size)
+		{
+			const auto* const bytes = static_cast<const byte*>(data);
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				hash = (hash ^ bytes[i]) * FNV_PRIME;
+			}
+			return hash;
+		}
+
+		static uint64 hash_gl_string(
+			uint64 hash,
+			GLenum name)
+		{
+			const auto* const str = reinterpret_cast<const char*>(glGetString(name));
+			return str ? hash_bytes(hash, str, std::strlen(str) + 1) : hash;
+		}
+
+		static double elapsed_ms(
+			std::chrono::high_resolution_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+		static std::string cache_file_path(
+			const ProgramCache& cache,
+			uint64 key)
+		{
+			char name[32];
+			std::snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(key));
+			return cache.directory + name;
+		}
+
+		/**
+		 * \brief Attempts to load the binary for the given key into the given program.
+		 */
+		static bool load_program_binary(
+			ProgramCache& cache,
+			uint64 key,
+			GLuint program)
+		{
+			std::ifstream file{ cache_file_path(cache, key), std::ios::binary };
+			if (!file)
+			{
+				return false;
+			}
+
+			ProgramCacheHeader header;
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+				|| header.magic != PROGRAM_CACHE_MAGIC
+				|| header.version != PROGRAM_CACHE_VERSION
+				|| header.key != key)
+			{
+				++cache.stats.num_rejected;
+				return false;
+			}
+
+			std::vector<char> binary(header.binary_length);
+			if (!file.read(binary.data(), binary.size()))
+			{
+				++cache.stats.num_rejected;
+				return false;
+			}
+
+			// The driver may still reject the binary (eg, after an update that kept its version string)
+			glProgramBinary(program, header.binary_format, binary.data(), static_cast<GLsizei>(binary.size()));
+			GLint linked = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &linked);
+			if (linked != GL_TRUE)
+			{
+				++cache.stats.num_rejected;
+				return false;
+			}
+
+			return true;
+		}
+
+		static void store_program_binary(
+			const ProgramCache& cache,
+			uint64 key,
+			GLuint program)
+		{
+			GLint length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0)
+			{
+				return;
+			}
+
+			std::vector<char> binary(static_cast<std::size_t>(length));
+			GLenum binary_format = 0;
+			glGetProgramBinary(program, length, &length, &binary_format, binary.data());
+
+			ProgramCacheHeader header;
+			header.magic = PROGRAM_CACHE_MAGIC;
+			header.version = PROGRAM_CACHE_VERSION;
+			header.key = key;
+			header.binary_format = binary_format;
+			header.binary_length = static_cast<uint32>(length);
+
+			// Failing to write just means the program gets compiled again next time
+			std::ofstream file{ cache_file_path(cache, key), std::ios::binary | std::ios::trunc };
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(binary.data(), length);
+		}
+
+		void ProgramCache_init(
+			ProgramCache& cache,
+			const char* directory)
+		{
+			cache.directory = directory;
+			cache.enabled = false;
+			if (cache.directory.empty())
+			{
+				return;
+			}
+
+			GLint num_formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+			if (num_formats <= 0)
+			{
+				return;
+			}
+
+#ifdef _WIN32
+			_mkdir(directory);
+#else
+			mkdir(directory, 0755);
+#endif
+
+			uint64 hash = FNV_OFFSET_BASIS;
+			hash = hash_gl_string(hash, GL_VENDOR);
+			hash = hash_gl_string(hash, GL_RENDERER);
+			hash = hash_gl_string(hash, GL_VERSION);
+			cache.driver_hash = hash;
+			cache.enabled = true;
+		}
+
+		GLuint ProgramCache_get_program(
+			ProgramCache& cache,
+			const std::string* const* sources,
+			std::size_t num_sources,
+			const std::function<void(GLuint program)>& link)
+		{
+			const auto program = glCreateProgram();
+
+			// Try loading the program from the cache
+			uint64 key = 0;
+			if (cache.enabled)
+			{
+				const auto load_start = std::chrono::high_resolution_clock::now();
+				key = hash_bytes(cache.driver_hash, &PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION));
+				for (std::size_t i = 0; i < num_sources; ++i)
+				{
+					key = hash_bytes(key, sources[i]->c_str(), sources[i]->size() + 1);
+				}
+
+				if (load_program_binary(cache, key, program))
+				{
+					++cache.stats.num_loaded;
+					cache.stats.load_ms += elapsed_ms(load_start);
+					return program;
+				}
+			}
+
+			// Compile and link it from source
+			const auto compile_start = std::chrono::high_resolution_clock::now();
+			if (cache.enabled)
+			{
+				glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			}
+			link(program);
+
+			GLint linked = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &linked);
+			if (cache.enabled && linked == GL_TRUE)
+			{
+				store_program_binary(cache, key, program);
+			}
+
+			++cache.stats.num_compiled;
+			cache.stats.compile_ms += elapsed_ms(compile_start);
+			return program;
+		}
+	}
+}
@@ -7,9 +7,17 @@ namespace sge
 {
     namespace gl_render
     {
+		static RenderCommand_Counters counters;
+
+		RenderCommand_Counters& RenderCommand_counters()
+		{
+			return counters;
+		}
+
         void render_scene_prepare_gbuffer(GLuint gbuffer)
         {
             glBindFramebuffer(GL_FRAMEBUFFER, gbuffer);
+            ++counters.num_state_changes;
 
             // Clear the GBuffer
             glEnable(GL_STENCIL_TEST);
@@ -29,8 +37,18 @@ namespace sge
 	    {
 			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 			glViewport(0, 0, width, height);
+			++counters.num_state_changes;
 	    }
 
+		void RenderCommand_bind_texture(
+			const GLenum texture_slot,
+			const GLuint texture)
+		{
+			glActiveTexture(texture_slot);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			++counters.num_state_changes;
+		}
+
 	    void RenderCommand_bind_material(
 			const GLuint program_id,
 			const gl_material::MaterialStandardUniforms uniforms,
@@ -39,9 +57,8 @@ namespace sge
 			const Mat4& proj_matrix)
 	    {
 			glUseProgram(program_id);
-
-			GLenum next_active_texture = gl_material::FIRST_USER_TEXTURE_SLOT;
-			gl_material::set_material_params(program_id, &next_active_texture, params);
+			++counters.num_state_changes;
+			counters.num_state_changes += gl_material::bind_material_params(params);
 
 			glProgramUniformMatrix4fv(program_id, uniforms.view_matrix_uniform, 1, GL_FALSE, view_matrix.vec());
 			glProgramUniformMatrix4fv(program_id, uniforms.proj_matrix_uniform, 1, GL_FALSE, proj_matrix.vec());
@@ -55,18 +72,17 @@ namespace sge
         {
             // Bind the mesh
             glBindVertexArray(mesh.vao);
+            ++counters.num_state_changes;
+            glUniform3fv(uniforms.position_offset_uniform, 1, mesh.position_offset.vec());
+            glUniform3fv(uniforms.position_scale_uniform, 1, mesh.position_scale.vec());
 
             for (std::size_t i = 0; i < num_instances; ++i)
             {
                 // Set lightmap parameters
-                glActiveTexture(gl_material::LIGHTMAP_X_BASIS_TEXTURE_SLOT);
-                glBindTexture(GL_TEXTURE_2D, instances[i].lightmap_x_basis);
-                glActiveTexture(gl_material::LIGHTMAP_Y_BASIS_TEXTURE_SLOT);
-                glBindTexture(GL_TEXTURE_2D, instances[i].lightmap_y_basis);
-                glActiveTexture(gl_material::LIGHTMAP_Z_BASIS_TEXTURE_SLOT);
-                glBindTexture(GL_TEXTURE_2D, instances[i].lightmap_z_basis);
-                glActiveTexture(gl_material::LIGHTMAP_DIRECT_MASK_TEXTURE_SLOT);
-                glBindTexture(GL_TEXTURE_2D, instances[i].lightmap_direct_mask);
+                RenderCommand_bind_texture(gl_material::LIGHTMAP_X_BASIS_TEXTURE_SLOT, instances[i].lightmap_x_basis);
+                RenderCommand_bind_texture(gl_material::LIGHTMAP_Y_BASIS_TEXTURE_SLOT, instances[i].lightmap_y_basis);
+                RenderCommand_bind_texture(gl_material::LIGHTMAP_Z_BASIS_TEXTURE_SLOT, instances[i].lightmap_z_basis);
+                RenderCommand_bind_texture(gl_material::LIGHTMAP_DIRECT_MASK_TEXTURE_SLOT, instances[i].lightmap_direct_mask);
                 glUniform1i(uniforms.use_lightmap_uniform, instances[i].lightmap_x_basis == 0 ? 0 : 1);
 
                 // Set model matrix
@@ -91,6 +107,9 @@ namespace sge
                     GL_UNSIGNED_INT,
                     nullptr);
             }
+
+            counters.num_draw_calls += num_instances;
+            counters.num_triangles += num_instances * (mesh.num_element_indices / 3);
         }
 
 	    void RenderCommand_render_lines(
@@ -100,14 +119,19 @@ namespace sge
 			for (std::size_t i = 0; i < num_line_sets; ++i)
 			{
 				glBindVertexArray(line_sets[i].vao);
+				++counters.num_state_changes;
 				glDrawArrays(GL_LINES, 0, line_sets[i].num_verts);
 			}
+
+			counters.num_draw_calls += num_line_sets;
 	    }
 
 	    void render_scene_shade_hdr(
             GLuint framebuffer,
             const GLRenderSystem::State& render_state,
-            Mat4 view)
+            Mat4 view,
+            Mat4 proj,
+            const LightClusters& light_clusters)
         {
             glDisable(GL_CULL_FACE);
             glDisable(GL_DEPTH_TEST);
@@ -115,38 +139,46 @@ namespace sge
 
             // Bind the screen quad for rasterization (in use for remainder of rendering)
             glBindVertexArray(render_state.sprite_vao);
+            ++counters.num_state_changes;
 
             // Bind the GBuffer's sub-buffers as textures for reading (in use for remainder of rendering)
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, render_state.gbuffer_layers[GBufferLayer::DEPTH_STENCIL]);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, render_state.gbuffer_layers[GBufferLayer::POSITION]);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, render_state.gbuffer_layers[GBufferLayer::NORMAL]);
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, render_state.gbuffer_layers[GBufferLayer::ALBEDO]);
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, render_state.gbuffer_layers[GBufferLayer::ROUGHNESS_METALLIC]);
-            glActiveTexture(GL_TEXTURE5);
-            glBindTexture(GL_TEXTURE_2D, render_state.gbuffer_layers[GBufferLayer::IRRADIANCE]);
+            RenderCommand_bind_texture(GL_TEXTURE0, render_state.gbuffer_layers[GBufferLayer::DEPTH_STENCIL]);
+            RenderCommand_bind_texture(GL_TEXTURE1, render_state.gbuffer_layers[GBufferLayer::POSITION]);
+            RenderCommand_bind_texture(GL_TEXTURE2, render_state.gbuffer_layers[GBufferLayer::NORMAL]);
+            RenderCommand_bind_texture(GL_TEXTURE3, render_state.gbuffer_layers[GBufferLayer::ALBEDO]);
+            RenderCommand_bind_texture(GL_TEXTURE4, render_state.gbuffer_layers[GBufferLayer::ROUGHNESS_METALLIC]);
+            RenderCommand_bind_texture(GL_TEXTURE5, render_state.gbuffer_layers[GBufferLayer::IRRADIANCE]);
 
             // Bind the given framebuffer for drawing
             const GLenum draw_buffer = GL_COLOR_ATTACHMENT0;
             glBindFramebuffer(GL_FRAMEBUFFER, render_state.post_framebuffer);
+            ++counters.num_state_changes;
             glDrawBuffers(1, &draw_buffer);
 
             // Bind the scene shading program
             glUseProgram(render_state.scene_shader_program);
+            ++counters.num_state_changes;
 
             // Upload view matrix
             glUniformMatrix4fv(render_state.scene_program_view_uniform, 1, GL_FALSE, view.vec());
 
+            // Upload inverse projection matrix (for reconstructing position from depth)
+            glUniformMatrix4fv(render_state.scene_program_inv_proj_uniform, 1, GL_FALSE, proj.inverse().vec());
+
 			// Upload light uniforms
 			glUniform3fv(render_state.scene_program_light_dir_uniform, 1, render_state.render_scene.light_dir.vec());
 			glUniform3fv(render_state.scene_program_light_intensity_uniform, 1, render_state.render_scene.light_intensity.vec());
 
+			// Upload cluster parameters (the light buffers are already bound)
+			glUniform3ui(render_state.scene_program_cluster_dims_uniform, LIGHT_CLUSTER_TILES_X, LIGHT_CLUSTER_TILES_Y, LIGHT_CLUSTER_SLICES);
+			glUniform1f(render_state.scene_program_cluster_near_uniform, light_clusters.near);
+			glUniform1f(render_state.scene_program_cluster_slice_scale_uniform, light_clusters.slice_scale);
+
             // Draw the screen quad
             glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+            counters.num_draw_calls += 1;
+            counters.num_triangles += 2;
         }
     }
 }
@@ -0,0 +1,194 @@
+// RenderProfiler.cpp
+
+#include <cstdio>
+#include "../private/RenderProfiler.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* How often the summary is printed, in seconds. */
+		static constexpr double RENDER_PROFILER_SUMMARY_INTERVAL = 1.0;
+
+		static double elapsed_ms(
+			std::chrono::high_resolution_clock::time_point start,
+			std::chrono::high_resolution_clock::time_point end)
+		{
+			return std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		static void print_summary(
+			const RenderFrameStats& totals,
+			const std::size_t num_frames)
+		{
+			std::printf("GLRender: average over %u frames\n", static_cast<unsigned>(num_frames));
+			for (std::size_t pass = 0; pass < RenderPass::NUM_PASSES; ++pass)
+			{
+				const auto& stats = totals.passes[pass];
+				std::printf("  %-16s gpu %7.3fms  cpu %7.3fms  draws %6u  tris %9u  state changes %6u\n",
+					render_pass_name(pass),
+					stats.gpu_ms / num_frames,
+					stats.cpu_ms / num_frames,
+					static_cast<unsigned>(stats.num_draw_calls / num_frames),
+					static_cast<unsigned>(stats.num_triangles / num_frames),
+					static_cast<unsigned>(stats.num_state_changes / num_frames));
+			}
+		}
+
+		const char* render_pass_name(
+			const std::size_t pass)
+		{
+			switch (pass)
+			{
+			case RenderPass::SHADOW_MAPS:
+				return "shadow maps";
+			case RenderPass::GBUFFER:
+				return "gbuffer";
+			case RenderPass::LIGHTMASK:
+				return "lightmask";
+			case RenderPass::SHADING:
+				return "shading";
+			case RenderPass::POST_PROCESSING:
+				return "post-processing";
+			default:
+				return "unknown";
+			}
+		}
+
+		void RenderProfiler_init(
+			RenderProfiler& profiler)
+		{
+			if (!profiler.enabled)
+			{
+				return;
+			}
+
+			glGenQueries(RENDER_PROFILER_LATENCY * RenderPass::NUM_PASSES, &profiler.queries[0][0]);
+			profiler.summary_start = std::chrono::high_resolution_clock::now();
+		}
+
+		void RenderProfiler_free(
+			RenderProfiler& profiler)
+		{
+			if (!profiler.enabled)
+			{
+				return;
+			}
+
+			glDeleteQueries(RENDER_PROFILER_LATENCY * RenderPass::NUM_PASSES, &profiler.queries[0][0]);
+		}
+
+		void RenderProfiler_begin_frame(
+			RenderProfiler& profiler)
+		{
+			if (!profiler.enabled)
+			{
+				return;
+			}
+
+			// The queries in this slot were issued 'RENDER_PROFILER_LATENCY' frames ago, so should be available without stalling
+			const auto slot = profiler.frame_index % RENDER_PROFILER_LATENCY;
+			auto& frame = profiler.pending[slot];
+			bool any_issued = false;
+
+			for (std::size_t pass = 0; pass < RenderPass::NUM_PASSES; ++pass)
+			{
+				if (!profiler.issued[slot][pass])
+				{
+					continue;
+				}
+
+				GLuint64 elapsed_ns = 0;
+				glGetQueryObjectui64v(profiler.queries[slot][pass], GL_QUERY_RESULT, &elapsed_ns);
+				frame.passes[pass].gpu_ms = elapsed_ns / 1000000.0;
+				profiler.issued[slot][pass] = false;
+				any_issued = true;
+			}
+
+			if (any_issued)
+			{
+				profiler.last_stats = frame;
+				for (std::size_t pass = 0; pass < RenderPass::NUM_PASSES; ++pass)
+				{
+					auto& total = profiler.summary_totals.passes[pass];
+					const auto& stats = frame.passes[pass];
+					total.gpu_ms += stats.gpu_ms;
+					total.cpu_ms += stats.cpu_ms;
+					total.num_draw_calls += stats.num_draw_calls;
+					total.num_triangles += stats.num_triangles;
+					total.num_state_changes += stats.num_state_changes;
+				}
+				++profiler.summary_frames;
+			}
+
+			frame = RenderFrameStats{};
+		}
+
+		void RenderProfiler_begin_pass(
+			RenderProfiler& profiler,
+			const std::size_t pass)
+		{
+			if (!profiler.enabled)
+			{
+				return;
+			}
+
+			const auto slot = profiler.frame_index % RENDER_PROFILER_LATENCY;
+			glBeginQuery(GL_TIME_ELAPSED, profiler.queries[slot][pass]);
+			profiler.issued[slot][pass] = true;
+
+			profiler.active_pass = pass;
+			profiler.pass_start_counters = RenderCommand_counters();
+			profiler.pass_start = std::chrono::high_resolution_clock::now();
+		}
+
+		void RenderProfiler_end_pass(
+			RenderProfiler& profiler)
+		{
+			if (!profiler.enabled)
+			{
+				return;
+			}
+
+			const auto end = std::chrono::high_resolution_clock::now();
+			glEndQuery(GL_TIME_ELAPSED);
+
+			const auto slot = profiler.frame_index % RENDER_PROFILER_LATENCY;
+			const auto& counters = RenderCommand_counters();
+			const auto& start_counters = profiler.pass_start_counters;
+			auto& stats = profiler.pending[slot].passes[profiler.active_pass];
+			stats.cpu_ms += elapsed_ms(profiler.pass_start, end);
+			stats.num_draw_calls += counters.num_draw_calls - start_counters.num_draw_calls;
+			stats.num_triangles += counters.num_triangles - start_counters.num_triangles;
+			stats.num_state_changes += counters.num_state_changes - start_counters.num_state_changes;
+			profiler.active_pass = RenderPass::NUM_PASSES;
+		}
+
+		void RenderProfiler_end_frame(
+			RenderProfiler& profiler)
+		{
+			if (!profiler.enabled)
+			{
+				return;
+			}
+
+			++profiler.frame_index;
+
+			if (!profiler.print_summary || profiler.summary_frames == 0)
+			{
+				return;
+			}
+
+			const auto now = std::chrono::high_resolution_clock::now();
+			if (elapsed_ms(profiler.summary_start, now) < RENDER_PROFILER_SUMMARY_INTERVAL * 1000.0)
+			{
+				return;
+			}
+
+			print_summary(profiler.summary_totals, profiler.summary_frames);
+			profiler.summary_totals = RenderFrameStats{};
+			profiler.summary_frames = 0;
+			profiler.summary_start = now;
+		}
+	}
+}
@@ -1,11 +1,8 @@
 // RenderResource.cpp
 
+#include <algorithm>
 #include <cstdio>
-#include <Resource/Resources/StaticMesh.h>
-#include <Resource/Resources/Material.h>
-#include <Resource/Resources/Texture.h>
 #include <Resource/Resources/Shader.h>
-#include <Resource/Resources/HDRImage.h>
 #include "../private/RenderResource.h"
 #include "../private/GLTexture2D.h"
 
@@ -13,180 +10,561 @@ namespace sge
 {
 	namespace gl_render
 	{
-		const gl_material::Material& RenderResource_get_material_resource(
+		static void decode_material(
+			RenderResource_Streaming* streaming,
+			RenderResource_StreamingMaterial* entry)
+		{
+			// Prefer a cooked version of the material, which needs no parsing
+			entry->loaded = entry->material.from_file(Material::cooked_path(entry->path.c_str()).c_str())
+				|| entry->material.from_file(entry->path.c_str());
+
+			std::lock_guard<std::mutex> lock{ streaming->decoded_lock };
+			streaming->decoded_materials.push_back(entry);
+		}
+
+		static void decode_static_mesh(
+			RenderResource_Streaming* streaming,
+			RenderResource_StreamingMesh* entry)
+		{
+			// Prefer a cooked version of the mesh, which already has LODs and is optimized.
+			// Large vertex streams are compressed in chunks, which are decompressed across the streaming threads.
+			entry->loaded = entry->mesh.from_file(StaticMesh::cooked_path(entry->path.c_str()).c_str(), &streaming->pool)
+				|| entry->mesh.from_file(entry->path.c_str(), &streaming->pool);
+			if (entry->loaded)
+			{
+				const auto& mesh = entry->mesh;
+				entry->gl_mesh.bounds = compute_bounding_sphere(mesh.vertex_positions(), mesh.num_verts());
+
+				// Pack vertices into the interleaved format
+				entry->packed_verts.resize(mesh.num_verts());
+				mesh_ops::pack_vertices(
+					mesh.num_verts(),
+					mesh.vertex_positions(),
+					mesh.vertex_normals(),
+					mesh.vertex_tangents(),
+					mesh.bitangent_signs(),
+					mesh.material_uv(),
+					mesh.lightmap_uv(),
+					&entry->gl_mesh.position_offset,
+					&entry->gl_mesh.position_scale,
+					entry->packed_verts.data());
+
+				// Concatenate the elements of each LOD
+				auto& gl_mesh = entry->gl_mesh;
+				entry->elements.assign(mesh.triangle_elements(), mesh.triangle_elements() + mesh.num_triangle_elements());
+				gl_mesh.lods[0].start_element_index = 0;
+				gl_mesh.lods[0].num_element_indices = static_cast<GLsizei>(mesh.num_triangle_elements());
+				gl_mesh.lods[0].error = 0.f;
+				gl_mesh.num_lods = 1;
+
+				for (std::size_t i = 0; i < mesh.num_lods() && gl_mesh.num_lods < gl_static_mesh::MAX_LODS; ++i)
+				{
+					const auto& lod = mesh.lods()[i];
+					auto& gl_lod = gl_mesh.lods[gl_mesh.num_lods];
+					gl_lod.start_element_index = static_cast<GLuint>(entry->elements.size());
+					gl_lod.num_element_indices = static_cast<GLsizei>(lod.num_triangle_elements());
+					gl_lod.error = lod.error();
+					entry->elements.insert(entry->elements.end(), lod.triangle_elements(), lod.triangle_elements() + lod.num_triangle_elements());
+					gl_mesh.num_lods += 1;
+				}
+
+				// The coarsest LOD is used for occlusion
+				const auto& occluder_lod = gl_mesh.lods[gl_mesh.num_lods - 1];
+				gl_mesh.occluder = std::make_shared<OccluderMesh>(make_occluder_mesh(
+					mesh.vertex_positions(),
+					entry->elements.data() + occluder_lod.start_element_index,
+					occluder_lod.num_element_indices));
+			}
+
+			std::lock_guard<std::mutex> lock{ streaming->decoded_lock };
+			streaming->decoded_meshes.push_back(entry);
+		}
+
+		static void decode_texture(
+			RenderResource_Streaming* streaming,
+			RenderResource_StreamingTexture* entry)
+		{
+			if (!entry->hdr)
+			{
+				// Prefer a cooked version of the texture, which needs no mip generation
+				entry->is_cooked = entry->cooked.from_file(CompressedTexture::cooked_path(entry->path.c_str()).c_str());
+				entry->loaded = entry->is_cooked || entry->image.from_file(entry->path.c_str());
+			}
+			else
+			{
+				entry->loaded = entry->hdr_image.from_file(entry->path.c_str());
+			}
+
+			std::lock_guard<std::mutex> lock{ streaming->decoded_lock };
+			streaming->decoded_textures.push_back(entry);
+		}
+
+		/**
+		 * \brief Copies as much of the given upload into its buffer as the budget allows.
+		 * \return Whether the upload has finished.
+		 */
+		static bool continue_upload(
+			RenderResource_Upload& upload,
+			std::size_t& budget)
+		{
+			const auto num_bytes = std::min(budget, upload.size - upload.offset);
+			if (num_bytes != 0)
+			{
+				// Use the copy target, so as not to disturb vertex array or unpack state
+				glBindBuffer(GL_COPY_WRITE_BUFFER, upload.buffer);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, upload.offset, num_bytes, upload.data + upload.offset);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			}
+
+			upload.offset += num_bytes;
+			budget -= num_bytes;
+			return upload.offset == upload.size;
+		}
+
+		static RenderResource_Upload make_upload(
+			GLuint buffer,
+			const void* data,
+			std::size_t size)
+		{
+			RenderResource_Upload upload;
+			upload.buffer = buffer;
+			upload.data = static_cast<const byte*>(data);
+			upload.size = size;
+			return upload;
+		}
+
+		static void create_streamed_material(
 			RenderResource& resources,
-			const char* path)
+			RenderResource_StreamingMaterial& entry)
 		{
-			auto iter = resources.material_resources.find(path);
-			if (iter == resources.material_resources.end())
+			const auto& material = entry.material;
+			auto& gl_mat = entry.gl_material;
+
+			// Create the material program from its cached binary, or compile the shaders it requires if it's not cached
+			const std::string* const sources[] = {
+				&RenderResource_get_shader_source(resources, material.vertex_shader().c_str()),
+				&RenderResource_get_shader_source(resources, material.pixel_shader().c_str()) };
+			gl_mat.program_id = ProgramCache_get_program(
+				resources.program_cache,
+				sources,
+				2,
+				[&resources, &material](GLuint program) {
+					const auto v_shader = RenderResource_get_shader_resource(resources, material.vertex_shader().c_str());
+					const auto f_shader = RenderResource_get_shader_resource(resources, material.pixel_shader().c_str());
+					gl_material::link_standard_material_program(program, v_shader, f_shader);
+				});
+			debug_program_status(gl_mat.program_id, GLDebugOutputMode::ONLY_ERROR);
+
+			// Get standard uniforms for the material program
+			gl_material::get_material_standard_uniforms(gl_mat.program_id, &gl_mat.uniforms);
+
+			// Set constant uniform parameters
+			glProgramUniform1i(gl_mat.program_id, gl_mat.uniforms.lightmap_x_basis_uniform, 0);
+			glProgramUniform1i(gl_mat.program_id, gl_mat.uniforms.lightmap_y_basis_uniform, 1);
+			glProgramUniform1i(gl_mat.program_id, gl_mat.uniforms.lightmap_z_basis_uniform, 2);
+			glProgramUniform1i(gl_mat.program_id, gl_mat.uniforms.lightmap_direct_mask_uniform, 3);
+
+			// Compile parameters into the material's parameter block (or the program itself, for non-block uniforms)
+			const auto block_size = gl_material::init_material_params_block(gl_mat.program_id);
+			std::vector<byte> block_data(block_size, 0);
+			gl_material::compile_default_material_params(gl_mat.program_id, block_data.data());
+			gl_material::compile_material_param(
+				gl_mat.program_id,
+				gl_material::BASE_MAT_UV_SCALE_UNIFORM_NAME,
+				material.base_uv_scale(),
+				block_data.data());
+
+			// Get all of the default int parameters for this material
+			for (const auto& int_param : material.param_table().bool_params)
 			{
-				// Create the material from the archive
-				Material material;
-				const auto loaded = material.from_file(path);
+				gl_material::compile_material_param(
+					gl_mat.program_id,
+					int_param.first.c_str(),
+					int_param.second ? GLint{ 1 } : GLint{ 0 },
+					block_data.data());
+			}
 
-				// If the material could not be loaded, return missing material
-				if (!loaded)
-				{
-					if (strlen(path) != 0)
-					{
-						printf("WARNING: GLRenderSystem could not load material '%s'\n", path);
-					}
+			// Get all default float parameters
+			for (const auto& float_param : material.param_table().float_params)
+			{
+				gl_material::compile_material_param(
+					gl_mat.program_id,
+					float_param.first.c_str(),
+					float_param.second,
+					block_data.data());
+			}
 
-					return resources.missing_material;
-				}
+			// Get all default Vec2 parameters
+			for (const auto& vec2_param : material.param_table().vec2_params)
+			{
+				gl_material::compile_material_param(
+					gl_mat.program_id,
+					vec2_param.first.c_str(),
+					vec2_param.second,
+					block_data.data());
+			}
 
-				// Load shaders required by this material
-				const auto v_shader = RenderResource_get_shader_resource(resources, material.vertex_shader().c_str());
-				const auto f_shader = RenderResource_get_shader_resource(resources, material.pixel_shader().c_str());
-
-				// Create the material
-				gl_material::Material gl_mat;
-				gl_mat.program_id = gl_material::new_standard_material_program(v_shader, f_shader);
-				debug_program_status(gl_mat.program_id, GLDebugOutputMode::ONLY_ERROR);
-
-				// Get standard uniforms for the material program
-				gl_material::get_material_standard_uniforms(gl_mat.program_id, &gl_mat.uniforms);
-
-				// Set constant uniform parameters
-				glUseProgram(gl_mat.program_id);
-				glUniform1i(gl_mat.uniforms.lightmap_x_basis_uniform, 0);
-				glUniform1i(gl_mat.uniforms.lightmap_y_basis_uniform, 1);
-				glUniform1i(gl_mat.uniforms.lightmap_z_basis_uniform, 2);
-				glUniform1i(gl_mat.uniforms.lightmap_direct_mask_uniform, 3);
-				glUniform2fv(gl_mat.uniforms.base_mat_uv_scale_uniform, 1, material.base_uv_scale().vec());
-				glUseProgram(0);
-
-				// Get all of the default int parameters for this material
-				for (const auto& int_param : material.param_table().bool_params)
-				{
-					const auto uniform_loc = gl_material::get_uniform_location(gl_mat.program_id, int_param.first.c_str());
-					if (uniform_loc != -1)
-					{
-						gl_mat.params.int_params[uniform_loc] = int_param.second ? 1 : 0;
-					}
-				}
+			// Get all default Vec3 parameters
+			for (const auto& vec3_param : material.param_table().vec3_params)
+			{
+				gl_material::compile_material_param(
+					gl_mat.program_id,
+					vec3_param.first.c_str(),
+					vec3_param.second,
+					block_data.data());
+			}
 
-				// Get all default float parameters
-				for (const auto& float_param : material.param_table().float_params)
-				{
-					const auto uniform_loc = gl_material::get_uniform_location(gl_mat.program_id, float_param.first.c_str());
-					if (uniform_loc != -1)
-					{
-						gl_mat.params.float_params[uniform_loc] = float_param.second;
-					}
-				}
+			// Get all default Vec4 parameters
+			for (const auto& vec4_param : material.param_table().vec4_params)
+			{
+				gl_material::compile_material_param(
+					gl_mat.program_id,
+					vec4_param.first.c_str(),
+					vec4_param.second,
+					block_data.data());
+			}
 
-				// Get all default Vec2 parameters
-				for (const auto& vec2_param : material.param_table().vec2_params)
+			// Get all texture parameters (the material holds a reference to each of its textures, for as long as it's loaded)
+			if (entry.id >= resources.material_texture_ids.size())
+			{
+				resources.material_texture_ids.resize(entry.id + 1);
+			}
+			auto& texture_refs = resources.material_texture_ids[entry.id];
+			texture_refs.clear();
+			for (const auto& tex_param : material.param_table().texture_params)
+			{
+				// Get the texture resource
+				const auto tex_path = intern_path(tex_param.second);
+				const auto tex_id = RenderResource_get_texture_2d_resource(
+					resources,
+					tex_path,
+					false);
+				gl_material::compile_material_texture_param(
+					gl_mat.program_id,
+					tex_param.first.c_str(),
+					tex_id,
+					gl_mat.params);
+				RenderResource_add_ref(resources, tex_path);
+				texture_refs.push_back(tex_path);
+
+				// The material isn't published until its textures are resident
+				if (!RenderResource_Table_find(resources.texture_2d_resources, tex_path))
 				{
-					const auto uniform_loc = gl_material::get_uniform_location(gl_mat.program_id, vec2_param.first.c_str());
-					if (uniform_loc != -1)
-					{
-						gl_mat.params.vec2_params[uniform_loc] = vec2_param.second;
-					}
+					entry.texture_ids.push_back(tex_path);
 				}
+			}
+
+			// Upload the parameter block
+			gl_material::upload_material_params_block(
+				resources.material_param_buffer,
+				block_data.data(),
+				block_size,
+				gl_mat.params);
+
+			GLint binary_length = 0;
+			glGetProgramiv(gl_mat.program_id, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+			entry.size = static_cast<std::size_t>(binary_length) + static_cast<std::size_t>(block_size);
+		}
+
+		static void begin_static_mesh_upload(
+			RenderResource& resources,
+			RenderResource_StreamingMesh& entry)
+		{
+			const auto& static_mesh = entry.mesh;
+			auto& gl_mesh = entry.gl_mesh;
+
+			// Create GL objects, and allocate storage for the data to be streamed into
+			glGenVertexArrays(1, &gl_mesh.vao);
+			glGenBuffers(1, &gl_mesh.ebo);
+			glGenBuffers(1, &gl_mesh.vbo);
+			gl_static_mesh::upload_static_mesh_vertex_data(
+				gl_mesh.vao,
+				gl_mesh.vbo,
+				static_mesh.num_verts(),
+				nullptr);
+			gl_static_mesh::upload_static_mesh_elements(
+				gl_mesh.vao,
+				gl_mesh.ebo,
+				entry.elements.size(),
+				nullptr);
+			gl_mesh.num_total_elements = static_cast<GLint>(static_mesh.num_triangle_elements());
+
+			// Queue uploads for each buffer
+			entry.uploads.push_back(make_upload(gl_mesh.vbo, entry.packed_verts.data(), entry.packed_verts.size() * sizeof(mesh_ops::PackedVertex)));
+			entry.uploads.push_back(make_upload(gl_mesh.ebo, entry.elements.data(), entry.elements.size() * sizeof(uint32)));
+
+			// Create each material slice for the mesh (this also starts streaming the mesh's materials)
+			for (std::size_t i = 0; i < static_mesh.num_materials(); ++i)
+			{
+				// Get the material
+				const auto& mat = static_mesh.materials()[i];
+				const auto& gl_mat = RenderResource_get_material_resource(resources, intern_path(mat.path()));
+
+				// Create the slice
+				gl_static_mesh::MeshSlice slice;
+				slice.material = gl_mat.program_id;
+				slice.start_element_index = mat.start_elem_index();
+				slice.num_element_indices = mat.num_elem_indices();
+				gl_mesh.material_slices.push_back(slice);
+			}
+		}
+
+		static bool begin_texture_upload(
+			RenderResource_StreamingTexture& entry)
+		{
+			// Figure out the size and format of the image
+			const void* data;
+			std::size_t size;
+			if (entry.is_cooked)
+			{
+				data = entry.cooked.data();
+				size = entry.cooked.data_size();
+			}
+			else if (!entry.hdr)
+			{
+				data = entry.image.image.get_bitmap();
+				size = std::size_t{ entry.image.image.get_width() } * entry.image.image.get_height() * 4;
+			}
+			else
+			{
+				data = entry.hdr_image.get_bits();
+				size = std::size_t(entry.hdr_image.get_width()) * entry.hdr_image.get_height() * entry.hdr_image.get_num_channels() * sizeof(float);
+			}
+
+			if (size == 0)
+			{
+				return false;
+			}
+
+			// Create a pixel buffer to stream the image through
+			glGenBuffers(1, &entry.pixel_buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, entry.pixel_buffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			entry.upload = make_upload(entry.pixel_buffer, data, size);
+			return true;
+		}
+
+		static void add_resident_cooked_texture(
+			TextureResidency& residency,
+			const RenderResource_StreamingTexture& entry)
+		{
+			const auto& cooked = entry.cooked;
+			std::vector<TextureResidency_Mip> mips(cooked.num_mips());
+			for (std::size_t level = 0; level < mips.size(); ++level)
+			{
+				const auto& mip = cooked.mip(level);
+				mips[level].width = mip.width;
+				mips[level].height = mip.height;
+				mips[level].offset = mip.offset;
+				mips[level].size = mip.size;
+			}
+
+			TextureResidency_add(
+				residency,
+				entry.texture,
+				compressed_texture_format(cooked),
+				true,
+				GL_NONE,
+				GL_NONE,
+				std::move(mips),
+				std::vector<byte>(cooked.data(), cooked.data() + cooked.data_size()));
+		}
+
+		/**
+		 * \brief Specifies the given texture from its pixel buffer once the upload has finished.
+		 * \return The number of bytes of video memory the texture uses.
+		 */
+		static std::size_t finish_texture_upload(
+			TextureResidency& residency,
+			RenderResource_StreamingTexture& entry)
+		{
+			if (entry.is_cooked)
+			{
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, entry.pixel_buffer);
+				upload_compressed_texture(entry.texture, entry.cooked, nullptr);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				glDeleteBuffers(1, &entry.pixel_buffer);
+				TextureResidency_add_unmanaged(residency, entry.cooked.data_size());
+				return entry.cooked.data_size();
+			}
 
-				// Get all default Vec3 parameters
-				for (const auto& vec3_param : material.param_table().vec3_params)
+			// Figure out which internal and upload format to use
+			GLenum internal_format;
+			GLenum upload_format;
+			GLenum upload_type;
+			int32 width;
+			int32 height;
+			if (!entry.hdr)
+			{
+				switch (entry.image.color_space())
 				{
-					const auto uniform_loc = gl_material::get_uniform_location(gl_mat.program_id, vec3_param.first.c_str());
-					if (uniform_loc != -1)
-					{
-						gl_mat.params.vec3_params[uniform_loc] = vec3_param.second;
-					}
+				case Texture::ColorSpace::RGB:
+					internal_format = GL_RGBA8;
+					break;
+
+				case Texture::ColorSpace::S_RGB:
+					internal_format = GL_SRGB8_ALPHA8;
+					break;
+
+				default:
+					assert(false);
+					return 0;
 				}
 
-				// Get all default Vec4 parameters
-				for (const auto& vec4_param : material.param_table().vec4_params)
+				upload_format = GL_RGBA;
+				upload_type = GL_UNSIGNED_BYTE;
+				width = static_cast<int32>(entry.image.image.get_width());
+				height = static_cast<int32>(entry.image.image.get_height());
+			}
+			else
+			{
+				switch (entry.hdr_image.get_num_channels())
 				{
-					const auto uniform_loc = gl_material::get_uniform_location(gl_mat.program_id, vec4_param.first.c_str());
-					if (uniform_loc != -1)
-					{
-						gl_mat.params.vec4_params[uniform_loc] = vec4_param.second;
-					}
+				case 3:
+					internal_format = GL_RGB32F;
+					upload_format = GL_RGB;
+					break;
+
+				case 4:
+					internal_format = GL_RGBA32F;
+					upload_format = GL_RGBA;
+					break;
+
+				default:
+					assert(false);
+					return 0;
 				}
 
-				// Get all texture parameters
-				for (const auto& tex_param : material.param_table().texture_params)
+				upload_type = GL_FLOAT;
+				width = entry.hdr_image.get_width();
+				height = entry.hdr_image.get_height();
+			}
+
+			// Specify the texture from the pixel buffer (the driver may complete this asynchronously)
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, entry.pixel_buffer);
+			upload_texture(
+				entry.texture,
+				width,
+				height,
+				nullptr,
+				internal_format,
+				upload_format,
+				upload_type);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &entry.pixel_buffer);
+
+			// Include the generated mip chain (about a third extra)
+			const auto size = entry.upload.size * 4 / 3;
+			TextureResidency_add_unmanaged(residency, size);
+			return size;
+		}
+
+		static void free_static_mesh(
+			const RenderResource& resources,
+			gl_static_mesh::StaticMesh& mesh)
+		{
+			// Meshes that failed to load share the missing mesh's objects
+			if (mesh.vao == resources.missing_mesh.vao)
+			{
+				return;
+			}
+
+			glDeleteVertexArrays(1, &mesh.vao);
+			glDeleteBuffers(1, &mesh.vbo);
+			glDeleteBuffers(1, &mesh.ebo);
+		}
+
+		static void free_material(
+			RenderResource& resources,
+			PathId path,
+			gl_material::Material& material)
+		{
+			// Materials that failed to load share the missing material's program and parameters
+			if (material.program_id != resources.missing_material.program_id)
+			{
+				gl_material::free_standard_material_program(material.program_id);
+				gl_material::release_material_params_block(resources.material_param_buffer, material.params);
+			}
+
+			// Let go of its textures
+			if (path < resources.material_texture_ids.size())
+			{
+				auto texture_ids = std::move(resources.material_texture_ids[path]);
+				resources.material_texture_ids[path].clear();
+				for (const auto texture_id : texture_ids)
 				{
-					const auto uniform_loc = gl_material::get_uniform_location(gl_mat.program_id, tex_param.first.c_str());
-					if (uniform_loc != -1)
-					{
-						// Get the texture resource
-						const auto tex_id = RenderResource_get_texture_2d_resource(
-							resources,
-							tex_param.second.c_str(),
-							false);
-						gl_mat.params.tex_params[uniform_loc] = tex_id;
-					}
+					RenderResource_release(resources, texture_id);
 				}
+			}
+		}
 
-				// Put it into the resource table
-				iter = resources.material_resources.insert(std::make_pair(path, std::move(gl_mat))).first;
+		const gl_material::Material& RenderResource_get_material_resource(
+			RenderResource& resources,
+			PathId path)
+		{
+			resources.cache.request(path, CACHE_MATERIALS);
+			if (const auto* const material = RenderResource_Table_find(resources.material_resources, path))
+			{
+				return *material;
 			}
 
-			return iter->second;
+			// Begin streaming it, if we haven't already
+			auto& streaming = resources.streaming;
+			auto& entry = streaming.materials[path];
+			if (!entry)
+			{
+				entry = std::make_unique<RenderResource_StreamingMaterial>();
+				entry->id = path;
+				entry->path = get_interned_path(path);
+				auto* const streaming_ptr = &streaming;
+				auto* const entry_ptr = entry.get();
+				streaming.pool.submit(streaming.tasks, [streaming_ptr, entry_ptr]() {
+					decode_material(streaming_ptr, entry_ptr);
+				});
+			}
+
+			return resources.missing_material;
 		}
 
 		const gl_static_mesh::StaticMesh& RenderResource_get_static_mesh_resource(
 			RenderResource& resources,
-			const char* path)
+			PathId path)
 		{
-			auto iter = resources.static_mesh_resources.find(path);
-			if (iter == resources.static_mesh_resources.end())
+			resources.cache.request(path, CACHE_STATIC_MESHES);
+			if (const auto* const mesh = RenderResource_Table_find(resources.static_mesh_resources, path))
 			{
-				// Load the mesh from the file
-				StaticMesh static_mesh;
-				const bool loaded = static_mesh.from_file(path);
+				return *mesh;
+			}
 
-				// If the mesh could not be loaded, return the missing mesh object
-				if (!loaded)
-				{
-					printf("WARNING: GLRenderSystem could not load mesh '%s'\n", path);
-					return resources.missing_mesh;
-				}
+			// Begin streaming it, if we haven't already
+			auto& streaming = resources.streaming;
+			auto& entry = streaming.meshes[path];
+			if (!entry)
+			{
+				entry = std::make_unique<RenderResource_StreamingMesh>();
+				entry->id = path;
+				entry->path = get_interned_path(path);
+				auto* const streaming_ptr = &streaming;
+				auto* const entry_ptr = entry.get();
+				streaming.pool.submit(streaming.tasks, [streaming_ptr, entry_ptr]() {
+					decode_static_mesh(streaming_ptr, entry_ptr);
+				});
+			}
 
-				// Create a GLStaticMesh from the loaded mesh object
-				gl_static_mesh::StaticMesh gl_mesh;
-				glGenVertexArrays(1, &gl_mesh.vao);
-				glGenBuffers(1, &gl_mesh.ebo);
-				glGenBuffers(gl_static_mesh::NUM_VERTEX_BUFFERS, gl_mesh.vertex_buffers.data());
-
-				// Upload data
-				gl_static_mesh::upload_static_mesh_vertex_data(
-					gl_mesh.vao,
-					gl_mesh.vertex_buffers.data(),
-					static_mesh.num_verts(),
-					static_mesh.vertex_positions(),
-					static_mesh.vertex_normals(),
-					static_mesh.vertex_tangents(),
-					static_mesh.bitangent_signs(),
-					static_mesh.material_uv(),
-					static_mesh.lightmap_uv());
-				gl_static_mesh::upload_static_mesh_elements(
-					gl_mesh.vao,
-					gl_mesh.ebo,
-					static_mesh.num_triangle_elements(),
-					static_mesh.triangle_elements());
-				gl_mesh.num_total_elements = static_cast<GLint>(static_mesh.num_triangle_elements());
-
-				// Create each material slice for the mesh
-				for (std::size_t i = 0; i < static_mesh.num_materials(); ++i)
-				{
-					// Get the material
-					const auto& mat = static_mesh.materials()[i];
-					const auto& gl_mat = RenderResource_get_material_resource(resources, mat.path().c_str());
-
-					// Create the slice
-					gl_static_mesh::MeshSlice slice;
-					slice.material = gl_mat.program_id;
-					slice.start_element_index = mat.start_elem_index();
-					slice.num_element_indices = mat.num_elem_indices();
-					gl_mesh.material_slices.push_back(slice);
-				}
+			return resources.missing_mesh;
+		}
 
-				// Insert it into the resource table
-				iter = resources.static_mesh_resources.insert(std::make_pair(path, std::move(gl_mesh))).first;
+		const std::string& RenderResource_get_shader_source(
+			RenderResource& resources,
+			const char* path)
+		{
+			auto iter = resources.shader_sources.find(path);
+			if (iter == resources.shader_sources.end())
+			{
+				iter = resources.shader_sources.insert(std::make_pair(
+					path,
+					read_shader_source(path, resources.shader_defines.c_str()))).first;
 			}
 
 			return iter->second;
@@ -216,7 +594,7 @@ namespace sge
 				}
 
 				// Create the shader
-				const auto id = load_shader(type, path);
+				const auto id = create_shader(type, RenderResource_get_shader_source(resources, path).c_str());
 
 				// Put it into the resource table
 				resources.shader_resources.insert(std::make_pair(path, std::move(id)));
@@ -230,98 +608,251 @@ namespace sge
 
 		GLuint RenderResource_get_texture_2d_resource(
 			RenderResource& resources,
-			const char* path,
+			PathId path,
 			bool hdr)
 		{
-			auto iter = resources.texture_2d_resources.find(path);
-			if (iter == resources.texture_2d_resources.end())
+			resources.cache.request(path, CACHE_TEXTURES);
+			if (const auto* const texture = RenderResource_Table_find(resources.texture_2d_resources, path))
+			{
+				return *texture;
+			}
+
+			// Begin streaming it, if we haven't already
+			auto& streaming = resources.streaming;
+			auto& entry = streaming.textures[path];
+			if (!entry)
+			{
+				entry = std::make_unique<RenderResource_StreamingTexture>();
+				entry->id = path;
+				entry->path = get_interned_path(path);
+				entry->hdr = hdr;
+				glGenTextures(1, &entry->texture);
+				auto* const streaming_ptr = &streaming;
+				auto* const entry_ptr = entry.get();
+				streaming.pool.submit(streaming.tasks, [streaming_ptr, entry_ptr]() {
+					decode_texture(streaming_ptr, entry_ptr);
+				});
+			}
+
+			return entry->texture;
+		}
+
+		bool RenderResource_is_material_resident(
+			const RenderResource& resources,
+			PathId path)
+		{
+			return RenderResource_Table_find(resources.material_resources, path) != nullptr;
+		}
+
+		bool RenderResource_is_static_mesh_resident(
+			const RenderResource& resources,
+			PathId path)
+		{
+			return RenderResource_Table_find(resources.static_mesh_resources, path) != nullptr;
+		}
+
+		std::size_t RenderResource_update_streaming(
+			RenderResource& resources,
+			std::size_t upload_budget)
+		{
+			auto& streaming = resources.streaming;
+			std::size_t num_resident = 0;
+
+			// Pick up resources that have finished decoding
+			std::vector<RenderResource_StreamingMesh*> decoded_meshes;
+			std::vector<RenderResource_StreamingTexture*> decoded_textures;
+			std::vector<RenderResource_StreamingMaterial*> decoded_materials;
+			{
+				std::lock_guard<std::mutex> lock{ streaming.decoded_lock };
+				decoded_meshes.swap(streaming.decoded_meshes);
+				decoded_textures.swap(streaming.decoded_textures);
+				decoded_materials.swap(streaming.decoded_materials);
+			}
+
+			for (auto* const entry : decoded_textures)
+			{
+				// Cooked textures are handed to residency streaming, which uploads just the levels needed on screen
+				if (entry->loaded && entry->is_cooked && resources.residency.enabled)
+				{
+					add_resident_cooked_texture(resources.residency, *entry);
+					resources.cache.set_resident(entry->id, entry->cooked.data_size());
+					RenderResource_Table_insert(resources.texture_2d_resources, entry->id, entry->texture);
+					streaming.textures.erase(entry->id);
+					continue;
+				}
+
+				if (!entry->loaded || !begin_texture_upload(*entry))
+				{
+					// Leave the texture without an image, and stop trying to load it
+					printf("WARNING: GLRenderSystem could not load texture '%s'\n", entry->path.c_str());
+					resources.cache.set_resident(entry->id, 0);
+					RenderResource_Table_insert(resources.texture_2d_resources, entry->id, entry->texture);
+					streaming.textures.erase(entry->id);
+					continue;
+				}
+
+				streaming.uploading_textures.push_back(entry);
+			}
+
+			for (auto* const entry : decoded_materials)
 			{
-				if (!hdr)
+				if (!entry->loaded)
 				{
-					// Load the texture from the file
-					Texture texture;
-					const auto loaded = texture.from_file(path);
-					if (!loaded)
+					if (!entry->path.empty())
 					{
-						printf("WARNING: GLRenderSystem could not load texture '%s'\n", path);
+						printf("WARNING: GLRenderSystem could not load material '%s'\n", entry->path.c_str());
 					}
 
-					// Figure out the color format of the image
-					GLenum format;
-					switch (texture.color_space())
-					{
-					case Texture::ColorSpace::RGB:
-						format = GL_RGBA8;
-						break;
+					// Use the missing material in its place from now on
+					resources.cache.set_resident(entry->id, 0);
+					RenderResource_Table_insert(resources.material_resources, entry->id, resources.missing_material);
+					streaming.materials.erase(entry->id);
+					num_resident += 1;
+					continue;
+				}
 
-					case Texture::ColorSpace::S_RGB:
-						format = GL_SRGB8_ALPHA8;
-						break;
+				create_streamed_material(resources, *entry);
+				streaming.waiting_materials.push_back(entry);
+			}
 
-					default:
-						assert(false);
-						return 0;
-					}
+			for (auto* const entry : decoded_meshes)
+			{
+				if (!entry->loaded)
+				{
+					printf("WARNING: GLRenderSystem could not load mesh '%s'\n", entry->path.c_str());
+
+					// Use the missing mesh in its place from now on
+					resources.cache.set_resident(entry->id, 0);
+					RenderResource_Table_insert(resources.static_mesh_resources, entry->id, resources.missing_mesh);
+					streaming.meshes.erase(entry->id);
+					num_resident += 1;
+					continue;
+				}
 
-					// Create an opengl texture from the texture object
-					const auto gl_tex = create_texture(
-						texture.image.get_width(),
-						texture.image.get_height(),
-						texture.image.get_bitmap(),
-						format,
-						GL_RGBA,
-						GL_UNSIGNED_BYTE);
-
-					// Add it to the resource table
-					resources.texture_2d_resources.insert(std::make_pair(path, gl_tex));
-					return gl_tex;
+				begin_static_mesh_upload(resources, *entry);
+				streaming.uploading_meshes.push_back(entry);
+			}
+
+			// Continue mesh uploads in request order, until the budget runs out
+			auto& uploading_meshes = streaming.uploading_meshes;
+			std::size_t num_finished_meshes = 0;
+			for (; num_finished_meshes < uploading_meshes.size() && upload_budget != 0; ++num_finished_meshes)
+			{
+				auto* const entry = uploading_meshes[num_finished_meshes];
+				bool finished = true;
+				for (auto& upload : entry->uploads)
+				{
+					finished = continue_upload(upload, upload_budget) && finished;
 				}
-				else
+
+				if (!finished)
 				{
-					HDRImage image;
-					const auto loaded = image.from_file(path);
-					if (!loaded)
-					{
-						printf("WARNING: GLRenderSystem could not load texture '%s'\n", path);
-					}
+					break;
+				}
 
-					// Figure out which internal and upload format to use
-					GLenum internal_format;
-					GLenum upload_format;
-					switch (image.get_num_channels())
-					{
-					case 3:
-						internal_format = GL_RGB32F;
-						upload_format = GL_RGB;
-						break;
-
-					case 4:
-						internal_format = GL_RGBA32F;
-						upload_format = GL_RGBA;
-						break;
-
-					default:
-						assert(false);
-						return 0;
-					}
+				// Publish the mesh, and release the decoded data
+				resources.cache.set_resident(
+					entry->id,
+					entry->packed_verts.size() * sizeof(mesh_ops::PackedVertex) + entry->elements.size() * sizeof(uint32));
+				RenderResource_Table_insert(resources.static_mesh_resources, entry->id, std::move(entry->gl_mesh));
+				streaming.meshes.erase(entry->id);
+				num_resident += 1;
+			}
+			uploading_meshes.erase(uploading_meshes.begin(), uploading_meshes.begin() + num_finished_meshes);
 
-					// Create an opengl texture for this image
-					const auto gl_tex = create_texture(
-						image.get_width(),
-						image.get_height(),
-						image.get_bits(),
-						internal_format,
-						upload_format,
-						GL_FLOAT);
-
-					// Add it to the resource table
-					resources.texture_2d_resources.insert(std::make_pair(path, gl_tex));
-					return gl_tex;
+			// Continue texture uploads
+			auto& uploading_textures = streaming.uploading_textures;
+			std::size_t num_finished_textures = 0;
+			for (; num_finished_textures < uploading_textures.size() && upload_budget != 0; ++num_finished_textures)
+			{
+				auto* const entry = uploading_textures[num_finished_textures];
+				if (!continue_upload(entry->upload, upload_budget))
+				{
+					break;
 				}
+
+				resources.cache.set_resident(entry->id, finish_texture_upload(resources.residency, *entry));
+				RenderResource_Table_insert(resources.texture_2d_resources, entry->id, entry->texture);
+				streaming.textures.erase(entry->id);
 			}
-			else
+			uploading_textures.erase(uploading_textures.begin(), uploading_textures.begin() + num_finished_textures);
+
+			// Publish materials whose textures are all resident
+			auto& waiting_materials = streaming.waiting_materials;
+			for (std::size_t i = 0; i < waiting_materials.size();)
 			{
-				return iter->second;
+				auto* const entry = waiting_materials[i];
+				const bool textures_resident = std::all_of(
+					entry->texture_ids.begin(),
+					entry->texture_ids.end(),
+					[&resources](PathId texture_id) { return RenderResource_Table_find(resources.texture_2d_resources, texture_id) != nullptr; });
+				if (!textures_resident)
+				{
+					i += 1;
+					continue;
+				}
+
+				resources.cache.set_resident(entry->id, entry->size);
+				RenderResource_Table_insert(resources.material_resources, entry->id, std::move(entry->gl_material));
+				streaming.materials.erase(entry->id);
+				waiting_materials[i] = waiting_materials.back();
+				waiting_materials.pop_back();
+				num_resident += 1;
+			}
+
+			return num_resident;
+		}
+
+		void RenderResource_add_ref(
+			RenderResource& resources,
+			PathId path)
+		{
+			resources.cache.add_ref(path);
+		}
+
+		void RenderResource_release(
+			RenderResource& resources,
+			PathId path)
+		{
+			resources.cache.release(path);
+		}
+
+		std::size_t RenderResource_evict_unused(
+			RenderResource& resources)
+		{
+			return resources.cache.evict([&resources](PathId path, std::size_t size) {
+				if (auto* const mesh = RenderResource_Table_find(resources.static_mesh_resources, path))
+				{
+					free_static_mesh(resources, *mesh);
+					RenderResource_Table_erase(resources.static_mesh_resources, path);
+					return;
+				}
+
+				// This may release the material's textures, which are then evicted after it
+				if (auto* const material = RenderResource_Table_find(resources.material_resources, path))
+				{
+					free_material(resources, path, *material);
+					RenderResource_Table_erase(resources.material_resources, path);
+					return;
+				}
+
+				if (auto* const texture = RenderResource_Table_find(resources.texture_2d_resources, path))
+				{
+					TextureResidency_remove(resources.residency, *texture, size);
+					glDeleteTextures(1, texture);
+					RenderResource_Table_erase(resources.texture_2d_resources, path);
+				}
+			});
+		}
+
+		void RenderResource_flush_streaming(
+			RenderResource& resources)
+		{
+			auto& streaming = resources.streaming;
+			while (!streaming.meshes.empty() || !streaming.textures.empty() || !streaming.materials.empty())
+			{
+				streaming.pool.wait(streaming.tasks);
+				RenderResource_update_streaming(resources, SIZE_MAX);
 			}
 		}
 	}
@@ -1,5 +1,7 @@
 // RenderScene.cpp
 
+#include <algorithm>
+#include <cmath>
 #include <Resource/Misc/LightmaskVolume.h>
 #include <Engine/Components/Display/CStaticMesh.h>
 #include "../private/RenderScene.h"
@@ -10,19 +12,17 @@ namespace sge
 	namespace gl_render
 	{
 		static void render_lightmask_volumes(
-			const RenderScene_Commands& commands,
-			const RenderResource& resources,
-			const Mat4& view_matrix,
-			const Mat4& proj_matrix)
+			const RenderScene_Frame& frame,
+			const RenderResource& resources)
 		{
 			RenderCommand_bind_material(
 				resources.lightmask_volume_material.program_id,
 				resources.lightmask_volume_material.uniforms,
 				resources.lightmask_volume_material.params,
-				view_matrix,
-				proj_matrix);
+				frame.view_matrix,
+				frame.proj_matrix);
 
-			for (const auto& lightmask_volume : commands.lightmask_volume_mesh_instances)
+			for (const auto& lightmask_volume : frame.lightmask_volumes)
 			{
 				RenderCommand_render_meshes(
 					resources.lightmask_volume_material.uniforms,
@@ -32,90 +32,567 @@ namespace sge
 			}
 		}
 
-		static void render_lightmask_objects(
-			const RenderScene_LightmaskObject* lightmask_objects,
-			const size_t num_lightmask_objects,
+		static void render_lightmask_receivers(
+			const RenderScene_Frame& frame,
+			const RenderScene_FramePass& pass,
 			const Mat4& view_matrix,
 			const Mat4& proj_matrix)
 		{
-			for (size_t i = 0; i < num_lightmask_objects; ++i)
+			for (size_t i = 0; i < pass.num_receivers; ++i)
 			{
+				const auto& receiver = frame.lightmask_receivers[frame.receiver_indices[pass.start_receiver + i]];
+
 				RenderCommand_bind_material(
-					lightmask_objects[i].material.program_id,
-					lightmask_objects[i].material.uniforms,
-					lightmask_objects[i].material.params,
+					receiver.material.program_id,
+					receiver.material.uniforms,
+					receiver.material.params,
 					view_matrix,
 					proj_matrix);
 
 				RenderCommand_render_meshes(
-					lightmask_objects[i].material.uniforms,
-					lightmask_objects[i].mesh,
-					&lightmask_objects[i].mesh_instance,
+					receiver.material.uniforms,
+					receiver.mesh,
+					&receiver.mesh_instance,
 					1);
 			}
 		}
 
+		static void render_batches(
+			const RenderScene_Frame& frame,
+			const RenderScene_FramePass& pass,
+			const Mat4& view_matrix,
+			const Mat4& proj_matrix)
+		{
+			// Batches are grouped by material, so only bind when it changes
+			const gl_material::Material* bound_material = nullptr;
+			for (size_t i = 0; i < pass.num_batches; ++i)
+			{
+				const auto& batch = frame.batches[pass.start_batch + i];
+				const auto& material = frame.materials[batch.material_index];
+				if (&material != bound_material)
+				{
+					RenderCommand_bind_material(
+						material.program_id,
+						material.uniforms,
+						material.params,
+						view_matrix,
+						proj_matrix);
+					bound_material = &material;
+				}
+
+				RenderCommand_render_meshes(
+					material.uniforms,
+					batch.mesh_command,
+					frame.instances.data() + batch.start_instance,
+					batch.num_instances);
+			}
+		}
 
 		static void render_spotlight_shadowmaps(
-			const RenderScene_Commands& commands)
+			const RenderScene_Frame& frame)
 		{
+			// Only lights whose cached shadow depth was invalidated have a pass
+			if (frame.shadow_passes.empty())
+			{
+				return;
+			}
+
 			glDepthMask(GL_TRUE);
 			glCullFace(GL_FRONT);
 			glStencilFunc(GL_ALWAYS, 0, 0xFF);
 			glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 			glDepthFunc(GL_LEQUAL);
 
-			// Set rendering parameters
-			for (const auto& spotlight : commands.spotlights)
-			{
-				RenderCommand_bind_framebuffer(
-					spotlight.shadow_framebuffer,
-					spotlight.shadow_width,
-					spotlight.shadow_height);
+			// Bind the atlas, and restrict clears to each light's tile
+			glBindFramebuffer(GL_FRAMEBUFFER, frame.shadow_atlas_framebuffer);
+			++RenderCommand_counters().num_state_changes;
+			glEnable(GL_SCISSOR_TEST);
+			glClearDepth(1.f);
 
-				glClearDepth(1.f);
+			for (const auto& pass : frame.shadow_passes)
+			{
+				const auto& spotlight = frame.spotlights[pass.spotlight_index];
+				const auto& tile = spotlight.shadow_tile;
+				glViewport(tile.x, tile.y, tile.size, tile.size);
+				glScissor(tile.x, tile.y, tile.size, tile.size);
 				glClear(GL_DEPTH_BUFFER_BIT);
 
-				// Render normal material instances
-				for (const auto& material_instance : commands.standard_path_material_instances)
+				render_batches(frame, pass, spotlight.view_matrix, spotlight.proj_matrix);
+				render_lightmask_receivers(frame, pass, spotlight.view_matrix, spotlight.proj_matrix);
+			}
+
+			glDisable(GL_SCISSOR_TEST);
+		}
+
+		static void update_spotlight_transform(
+			RenderScene_Spotlight& spotlight,
+			const Mat4& world_transform)
+		{
+			spotlight.view_matrix = world_transform.inverse();
+			spotlight.frustum = extract_frustum(spotlight.proj_matrix * spotlight.view_matrix);
+			spotlight.light_bounds.center = world_transform * Vec3::zero();
+			spotlight.shadow_dirty = true;
+		}
+
+		static void set_spotlight_shadow_params(
+			RenderScene_Spotlight& spotlight,
+			const Node& node,
+			const CSpotlight& component)
+		{
+			spotlight.node_id = node.get_id();
+			spotlight.proj_matrix = Mat4::perspective_projection(
+				component.frustum_horiz_angle(),
+				component.frustum_vert_angle(),
+				component.near_clipping_plane(),
+				component.far_clipping_plane());
+			spotlight.light_bounds.radius = component.far_clipping_plane();
+			spotlight.max_shadow_size = std::max(component.shadow_map_width(), component.shadow_map_height());
+			update_spotlight_transform(spotlight, node.get_world_matrix());
+		}
+
+		static void invalidate_spotlight_shadows(
+			std::vector<RenderScene_Spotlight>& spotlights,
+			const BoundingSphere& caster_bounds)
+		{
+			for (auto& spotlight : spotlights)
+			{
+				if (!spotlight.shadow_dirty && frustum_intersects_sphere(spotlight.frustum, caster_bounds))
 				{
-					RenderCommand_bind_material(
-						material_instance.material.program_id,
-						material_instance.material.uniforms,
-						material_instance.material.params,
-						spotlight.view_matrix,
-						spotlight.proj_matrix);
+					spotlight.shadow_dirty = true;
+				}
+			}
+		}
 
-					for (const auto& mesh : material_instance.mesh_instances)
+		void RenderScene_update_shadow_tiles(
+			RenderScene_Commands& commands,
+			const Mat4& view_matrix,
+			const Mat4& proj_matrix)
+		{
+			// Scale from view-space size at unit distance to NDC size
+			const float proj_scale = proj_matrix.get(1, 1);
+
+			for (auto& spotlight : commands.spotlights)
+			{
+				// Estimate the fraction of the screen covered by the light's area of influence
+				const auto view_center = view_matrix * spotlight.light_bounds.center;
+				const float dist = -view_center.z();
+				float coverage = 1.f;
+				if (dist > spotlight.light_bounds.radius)
+				{
+					coverage = std::min(1.f, spotlight.light_bounds.radius * proj_scale / dist);
+				}
+
+				// Pick a tile size class for the light
+				const auto max_size = ShadowAtlas_tile_size_for(commands.shadow_atlas, spotlight.max_shadow_size);
+				const auto desired_size = std::min(max_size, ShadowAtlas_tile_size_for(
+					commands.shadow_atlas,
+					static_cast<GLuint>(spotlight.max_shadow_size * coverage)));
+
+				// Grow immediately, but only shrink once the light covers a quarter of the tile (to avoid thrashing the atlas)
+				const auto current_size = spotlight.shadow_tile.size;
+				if (current_size == 0 || desired_size > current_size || desired_size * 4 <= current_size)
+				{
+					ShadowAtlas_free_tile(commands.shadow_atlas, spotlight.shadow_tile);
+					spotlight.shadow_tile = ShadowAtlasTile{};
+					ShadowAtlas_alloc_tile(commands.shadow_atlas, desired_size, &spotlight.shadow_tile);
+					spotlight.shadow_dirty = true;
+				}
+
+				spotlight.redraw_shadow = spotlight.shadow_dirty && spotlight.shadow_tile.size != 0;
+				if (spotlight.redraw_shadow)
+				{
+					spotlight.shadow_dirty = false;
+				}
+			}
+		}
+
+		/**
+		 * \brief Chooses the coarsest LOD of each instance whose error projects to less than 'LOD_SCREEN_ERROR' of the screen height.
+		 * Instances only move away from the LOD they used last frame once the projected error is past the threshold by 'LOD_HYSTERESIS'.
+		 */
+		static void select_instance_lods(
+			RenderScene_Frame& frame,
+			RenderScene_LodState& lod_state)
+		{
+			// Scale from view-space size at unit distance to screen heights
+			const float proj_scale = frame.proj_matrix.get(1, 1) * 0.5f;
+			const float refine_threshold = LOD_SCREEN_ERROR * (1.f + LOD_HYSTERESIS);
+			const float coarsen_threshold = LOD_SCREEN_ERROR * (1.f - LOD_HYSTERESIS);
+
+			lod_state.next_instance_lods.clear();
+			for (auto& mesh : frame.meshes)
+			{
+				const auto num_instances = mesh.instance_commands.size();
+				mesh.instance_lods.assign(num_instances, 0);
+				if (mesh.num_lods <= 1 || mesh.mesh_command.bounds.radius <= 0.f)
+				{
+					continue;
+				}
+
+				for (size_t i = 0; i < num_instances; ++i)
+				{
+					// Scale mesh-space error to the fraction of the screen it covers at the nearest point of the instance
+					const auto bounds = transform_bounding_sphere(mesh.instance_commands[i].world_transform, mesh.mesh_command.bounds);
+					const auto view_center = frame.view_matrix * bounds.center;
+					const float dist = std::max(view_center.length() - bounds.radius, 1e-3f);
+					const float error_scale = (bounds.radius / mesh.mesh_command.bounds.radius) * proj_scale / dist;
+
+					// Start from the LOD used last frame
+					const auto node_id = mesh.node_ids[i].to_u64();
+					const auto prev_iter = lod_state.instance_lods.find(node_id);
+					uint32 lod = prev_iter != lod_state.instance_lods.end() ? prev_iter->second : 0;
+					lod = std::min(lod, static_cast<uint32>(mesh.num_lods - 1));
+
+					while (lod > 0 && mesh.lods[lod].error * error_scale > refine_threshold)
+					{
+						lod -= 1;
+					}
+					while (lod + 1 < mesh.num_lods && mesh.lods[lod + 1].error * error_scale < coarsen_threshold)
 					{
-						RenderCommand_render_meshes(
-							material_instance.material.uniforms,
-							mesh.mesh_command,
-							mesh.instance_commands.data(),
-							mesh.instance_commands.size());
+						lod += 1;
 					}
+
+					mesh.instance_lods[i] = lod;
+					lod_state.next_instance_lods[node_id] = lod;
 				}
+			}
+
+			// Instances that weren't drawn this frame are forgotten
+			std::swap(lod_state.instance_lods, lod_state.next_instance_lods);
+		}
 
-				// Render lightmask receivers
-				render_lightmask_objects(
-					commands.lightmask_receiver_mesh_instances.data(),
-					commands.lightmask_receiver_mesh_instances.size(),
-					spotlight.view_matrix,
-					spotlight.proj_matrix);
+		struct OccluderCandidate
+		{
+			const OccluderMesh* mesh;
+			const Mat4* world_transform;
+			float screen_size;
+		};
+
+		/**
+		 * \brief Rasterizes the largest occluders in front of the camera, and marks the instances they hide.
+		 * Instances are tested on the occlusion pool, a few meshes per task.
+		 */
+		static void cull_occluded_instances(
+			RenderScene_Frame& frame,
+			RenderScene_Occlusion& occlusion)
+		{
+			frame.occlusion_stats = OcclusionStats{};
+			for (auto& mesh : frame.meshes)
+			{
+				mesh.instance_occluded.assign(mesh.instance_commands.size(), 0);
+			}
+
+			if (!occlusion.enabled)
+			{
+				return;
+			}
+
+			// Estimate the fraction of the screen height covered by a world-space sphere
+			const float proj_scale = frame.proj_matrix.get(1, 1) * 0.5f;
+			const auto screen_size = [&frame, proj_scale](const BoundingSphere& bounds) -> float
+			{
+				const auto view_center = frame.view_matrix * bounds.center;
+				const float dist = view_center.length() - bounds.radius;
+				return dist <= 0.f ? 1.f : bounds.radius * proj_scale / dist;
+			};
+
+			// Gather lightmask occluders, and static meshes large enough to hide things
+			std::vector<OccluderCandidate> candidates;
+			for (const auto& occluder : frame.lightmask_occluders)
+			{
+				if (occluder.occluder)
+				{
+					const auto bounds = transform_bounding_sphere(occluder.mesh_instance.world_transform, occluder.mesh.bounds);
+					candidates.push_back(OccluderCandidate{ occluder.occluder.get(), &occluder.mesh_instance.world_transform, screen_size(bounds) });
+				}
+			}
+			for (const auto& mesh : frame.meshes)
+			{
+				if (!mesh.occluder)
+				{
+					continue;
+				}
+
+				for (const auto& instance : mesh.instance_commands)
+				{
+					const auto size = screen_size(transform_bounding_sphere(instance.world_transform, mesh.mesh_command.bounds));
+					if (size >= OCCLUDER_MIN_SCREEN_SIZE)
+					{
+						candidates.push_back(OccluderCandidate{ mesh.occluder.get(), &instance.world_transform, size });
+					}
+				}
+			}
+
+			if (candidates.empty())
+			{
+				return;
+			}
+
+			// Rasterize the largest occluders
+			const auto num_occluders = std::min(candidates.size(), OCCLUSION_MAX_OCCLUDERS);
+			std::partial_sort(candidates.begin(), candidates.begin() + num_occluders, candidates.end(),
+				[](const OccluderCandidate& lhs, const OccluderCandidate& rhs) { return lhs.screen_size > rhs.screen_size; });
+
+			const auto view_proj = frame.proj_matrix * frame.view_matrix;
+			OcclusionBuffer_clear(occlusion.buffer, OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_HEIGHT);
+			for (size_t i = 0; i < num_occluders; ++i)
+			{
+				OcclusionBuffer_rasterize(occlusion.buffer, view_proj * *candidates[i].world_transform, *candidates[i].mesh);
+			}
+			OcclusionBuffer_build_hiz(occlusion.buffer);
+
+			// Test instances in parallel
+			const auto num_tasks = (frame.meshes.size() + OCCLUSION_MESHES_PER_TASK - 1) / OCCLUSION_MESHES_PER_TASK;
+			occlusion.task_stats.assign(num_tasks, OcclusionStats{});
+			for (size_t task_i = 0; task_i < num_tasks; ++task_i)
+			{
+				auto* const meshes = frame.meshes.data() + task_i * OCCLUSION_MESHES_PER_TASK;
+				const auto num_meshes = std::min(OCCLUSION_MESHES_PER_TASK, frame.meshes.size() - task_i * OCCLUSION_MESHES_PER_TASK);
+				auto* const stats = &occlusion.task_stats[task_i];
+				const auto* const buffer = &occlusion.buffer;
+
+				occlusion.pool.submit(occlusion.tasks, [meshes, num_meshes, stats, buffer, view_proj]()
+				{
+					for (size_t mesh_i = 0; mesh_i < num_meshes; ++mesh_i)
+					{
+						auto& mesh = meshes[mesh_i];
+						for (size_t i = 0; i < mesh.instance_commands.size(); ++i)
+						{
+							const auto bounds = transform_bounding_sphere(mesh.instance_commands[i].world_transform, mesh.mesh_command.bounds);
+							mesh.instance_occluded[i] = OcclusionBuffer_is_occluded(*buffer, view_proj, bounds) ? 1 : 0;
+							stats->num_culled += mesh.instance_occluded[i];
+						}
+
+						stats->num_tested += mesh.instance_commands.size();
+					}
+				});
+			}
+			occlusion.pool.wait(occlusion.tasks);
+
+			// Gather stats
+			frame.occlusion_stats.num_occluders = num_occluders;
+			frame.occlusion_stats.num_occluder_triangles = occlusion.buffer.num_triangles;
+			for (const auto& stats : occlusion.task_stats)
+			{
+				frame.occlusion_stats.num_tested += stats.num_tested;
+				frame.occlusion_stats.num_culled += stats.num_culled;
 			}
 		}
 
-		void RenderScene_render(
+		static void add_texture_demand(
+			std::unordered_map<GLuint, float>& demand,
+			const GLuint texture,
+			const float size)
+		{
+			if (texture == 0)
+			{
+				return;
+			}
+
+			auto& texture_size = demand[texture];
+			texture_size = std::max(texture_size, size);
+		}
+
+		/**
+		 * \brief Estimates how large each texture used by the camera pass appears on screen, from the projected diameter of the instances using it.
+		 * Assumes UVs span each mesh once, so material textures are scaled by the instance's UV scale, and lightmaps are not.
+		 */
+		static void gather_texture_demand(
+			RenderScene_Frame& frame)
+		{
+			frame.texture_demand.clear();
+			const float proj_scale = frame.proj_matrix.get(1, 1) * 0.5f;
+
+			const auto& pass = frame.camera_pass;
+			for (size_t b = pass.start_batch; b < pass.start_batch + pass.num_batches; ++b)
+			{
+				const auto& batch = frame.batches[b];
+				const auto& material = frame.materials[batch.material_index];
+				for (size_t i = batch.start_instance; i < batch.start_instance + batch.num_instances; ++i)
+				{
+					const auto& instance = frame.instances[i];
+					const auto bounds = transform_bounding_sphere(instance.world_transform, batch.mesh_command.bounds);
+					const auto view_center = frame.view_matrix * bounds.center;
+					const float dist = view_center.length() - bounds.radius;
+					const float size = dist <= 0.f ? 2.f : 2.f * bounds.radius * proj_scale / dist;
+
+					const float uv_scale = std::max(std::abs(instance.mat_uv_scale.x()), std::abs(instance.mat_uv_scale.y()));
+					for (const auto& binding : material.params.textures)
+					{
+						add_texture_demand(frame.texture_demand, binding.texture, size * uv_scale);
+					}
+
+					add_texture_demand(frame.texture_demand, instance.lightmap_x_basis, size);
+					add_texture_demand(frame.texture_demand, instance.lightmap_y_basis, size);
+					add_texture_demand(frame.texture_demand, instance.lightmap_z_basis, size);
+				}
+			}
+		}
+
+		static RenderScene_FramePass cull_pass(
+			RenderScene_Frame& frame,
+			const Frustum& frustum,
+			const bool occlusion_culled)
+		{
+			RenderScene_FramePass pass;
+			pass.start_batch = frame.batches.size();
+			pass.start_receiver = frame.receiver_indices.size();
+
+			// Cull standard path instances, emitting a batch for each LOD of each mesh
+			for (const auto& mesh : frame.meshes)
+			{
+				for (size_t lod = 0; lod < mesh.num_lods; ++lod)
+				{
+					const auto start_instance = frame.instances.size();
+					for (size_t i = 0; i < mesh.instance_commands.size(); ++i)
+					{
+						if (mesh.instance_lods[i] != lod || (occlusion_culled && mesh.instance_occluded[i]))
+						{
+							continue;
+						}
+
+						const auto& instance = mesh.instance_commands[i];
+						const auto bounds = transform_bounding_sphere(instance.world_transform, mesh.mesh_command.bounds);
+						if (frustum_intersects_sphere(frustum, bounds))
+						{
+							frame.instances.push_back(instance);
+						}
+					}
+
+					// Only emit a batch if something survived
+					if (frame.instances.size() == start_instance)
+					{
+						continue;
+					}
+
+					RenderScene_FrameBatch batch;
+					batch.material_index = mesh.material_index;
+					batch.mesh_command = mesh.mesh_command;
+					batch.mesh_command.start_element_index = mesh.lods[lod].start_element_index;
+					batch.mesh_command.num_element_indices = mesh.lods[lod].num_element_indices;
+					batch.start_instance = start_instance;
+					batch.num_instances = frame.instances.size() - start_instance;
+					frame.batches.push_back(batch);
+				}
+			}
+
+			// Cull lightmask receivers
+			for (size_t i = 0; i < frame.lightmask_receivers.size(); ++i)
+			{
+				const auto& receiver = frame.lightmask_receivers[i];
+				const auto bounds = transform_bounding_sphere(receiver.mesh_instance.world_transform, receiver.mesh.bounds);
+				if (frustum_intersects_sphere(frustum, bounds))
+				{
+					frame.receiver_indices.push_back(i);
+				}
+			}
+
+			pass.num_batches = frame.batches.size() - pass.start_batch;
+			pass.num_receivers = frame.receiver_indices.size() - pass.start_receiver;
+			return pass;
+		}
+
+		void RenderScene_snapshot(
 			const RenderScene_Commands& commands,
+			const Mat4& view_matrix,
+			const Mat4& proj_matrix,
+			RenderScene_Frame& out_frame)
+		{
+			out_frame.view_matrix = view_matrix;
+			out_frame.proj_matrix = proj_matrix;
+
+			// Flatten materials and meshes, reusing the instance arrays from previous frames
+			out_frame.materials.clear();
+			size_t num_meshes = 0;
+			for (const auto& material_instance : commands.standard_path_material_instances)
+			{
+				const auto material_index = out_frame.materials.size();
+				out_frame.materials.push_back(material_instance.material);
+
+				for (const auto& mesh : material_instance.mesh_instances)
+				{
+					if (num_meshes == out_frame.meshes.size())
+					{
+						out_frame.meshes.emplace_back();
+					}
+
+					auto& frame_mesh = out_frame.meshes[num_meshes];
+					frame_mesh.material_index = material_index;
+					frame_mesh.mesh_command = mesh.mesh_command;
+					frame_mesh.instance_commands.assign(mesh.instance_commands.begin(), mesh.instance_commands.end());
+					frame_mesh.node_ids.assign(mesh.node_ids.begin(), mesh.node_ids.end());
+					frame_mesh.lods = mesh.lods;
+					frame_mesh.num_lods = mesh.num_lods;
+					frame_mesh.occluder = mesh.occluder;
+					num_meshes += 1;
+				}
+			}
+			out_frame.meshes.resize(num_meshes);
+
+			out_frame.lightmask_volumes.assign(commands.lightmask_volume_mesh_instances.begin(), commands.lightmask_volume_mesh_instances.end());
+			out_frame.lightmask_receivers.assign(commands.lightmask_receiver_mesh_instances.begin(), commands.lightmask_receiver_mesh_instances.end());
+			out_frame.lightmask_occluders.assign(commands.lightmask_occluder_mesh_instances.begin(), commands.lightmask_occluder_mesh_instances.end());
+			out_frame.spotlights.assign(commands.spotlights.begin(), commands.spotlights.end());
+			out_frame.shadow_atlas_framebuffer = commands.shadow_atlas.framebuffer;
+		}
+
+		void RenderScene_prepare_frame(
+			RenderScene_Frame& frame,
+			RenderScene_LodState& lod_state,
+			RenderScene_Occlusion& occlusion)
+		{
+			frame.shadow_passes.clear();
+			frame.batches.clear();
+			frame.instances.clear();
+			frame.receiver_indices.clear();
+
+			// Choose LODs from the camera, shadows use the same LOD so that they match what's on screen
+			select_instance_lods(frame, lod_state);
+
+			// Cull against the camera, skipping instances hidden by occluders
+			cull_occluded_instances(frame, occlusion);
+			frame.camera_pass = cull_pass(frame, extract_frustum(frame.proj_matrix * frame.view_matrix), true);
+			gather_texture_demand(frame);
+
+			// Cull against each light that needs its shadow redrawn
+			for (size_t i = 0; i < frame.spotlights.size(); ++i)
+			{
+				if (!frame.spotlights[i].redraw_shadow)
+				{
+					continue;
+				}
+
+				auto pass = cull_pass(frame, frame.spotlights[i].frustum, false);
+				pass.spotlight_index = i;
+				frame.shadow_passes.push_back(pass);
+			}
+
+			// Assign lights to the camera's clusters
+			LightClusters_assign(
+				frame.light_clusters,
+				frame.view_matrix,
+				frame.proj_matrix,
+				frame.lights.data(),
+				frame.lights.size());
+		}
+
+		void RenderScene_render(
+			const RenderScene_Frame& frame,
 			const RenderResource& resources,
 			const GLuint gbuffer,
 			const GLuint gbuffer_width,
 			const GLuint gbuffer_height,
-			const Mat4& view_matrix,
-			const Mat4& proj_matrix)
+			RenderProfiler& profiler)
 		{
+			const auto& view_matrix = frame.view_matrix;
+			const auto& proj_matrix = frame.proj_matrix;
+
 			// Render spotlights
-			render_spotlight_shadowmaps(commands);
+			RenderProfiler_begin_pass(profiler, RenderPass::SHADOW_MAPS);
+			render_spotlight_shadowmaps(frame);
+			RenderProfiler_end_pass(profiler);
+
+			RenderProfiler_begin_pass(profiler, RenderPass::GBUFFER);
 
 			// Set standard rendering parameters
 			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
@@ -129,26 +606,11 @@ namespace sge
 			render_scene_prepare_gbuffer(gbuffer);
 			glViewport(0, 0, gbuffer_width, gbuffer_height);
 
-			// Render standard material instances
-			for (const auto& material_instance : commands.standard_path_material_instances)
-			{
-				// Bind the material
-				RenderCommand_bind_material(
-					material_instance.material.program_id,
-					material_instance.material.uniforms,
-					material_instance.material.params,
-					view_matrix,
-					proj_matrix);
+			// Render visible standard material instances
+			render_batches(frame, frame.camera_pass, view_matrix, proj_matrix);
+			RenderProfiler_end_pass(profiler);
 
-				for (const auto& mesh : material_instance.mesh_instances)
-				{
-					RenderCommand_render_meshes(
-						material_instance.material.uniforms,
-						mesh.mesh_command,
-						mesh.instance_commands.data(),
-						mesh.instance_commands.size());
-				}
-			}
+			RenderProfiler_begin_pass(profiler, RenderPass::LIGHTMASK);
 
 			/*--- DRAW ONLY DEPTH BACKFACES, INCREMENT STENCIL WHERE DRAWN ---*/
 
@@ -159,18 +621,10 @@ namespace sge
 			glCullFace(GL_FRONT);
 
 			glStencilMask(1 << 0);
-			render_lightmask_volumes(
-				commands,
-				resources,
-				view_matrix,
-				proj_matrix);
+			render_lightmask_volumes(frame, resources);
 
 			glStencilMask(1 << 1);
-			render_lightmask_objects(
-				commands.lightmask_receiver_mesh_instances.data(),
-				commands.lightmask_receiver_mesh_instances.size(),
-				view_matrix,
-				proj_matrix);
+			render_lightmask_receivers(frame, frame.camera_pass, view_matrix, proj_matrix);
 
 			/*--- DISABLE DEPTH DRAWING, FRONTFACES, CLEAR STENCIL WHERE DEPTH FAIL ---*/
 
@@ -181,15 +635,8 @@ namespace sge
 			glCullFace(GL_BACK);
 			glStencilMask(0xF);
 
-			render_lightmask_volumes(
-				commands,
-				resources,
-				view_matrix,
-				proj_matrix);
-			render_lightmask_objects(commands.lightmask_receiver_mesh_instances.data(),
-				commands.lightmask_receiver_mesh_instances.size(),
-				view_matrix,
-				proj_matrix);
+			render_lightmask_volumes(frame, resources);
+			render_lightmask_receivers(frame, frame.camera_pass, view_matrix, proj_matrix);
 
 			/*--- RESET DEPTH ---*/
 
@@ -206,16 +653,9 @@ namespace sge
 			glCullFace(GL_BACK);
 			glDepthFunc(GL_GEQUAL);
 
-			render_lightmask_volumes(
-				commands,
-				resources,
-				view_matrix,
-				proj_matrix);
-			render_lightmask_objects(
-				commands.lightmask_receiver_mesh_instances.data(),
-				commands.lightmask_receiver_mesh_instances.size(),
-				view_matrix,
-				proj_matrix);
+			render_lightmask_volumes(frame, resources);
+			render_lightmask_receivers(frame, frame.camera_pass, view_matrix, proj_matrix);
+			RenderProfiler_end_pass(profiler);
 		}
 
 		void RenderScene_update_matrices(
@@ -238,7 +678,10 @@ namespace sge
 						{
 							if (mesh_node_ids[i] == node_ids[search_i])
 							{
+								// Shadows that saw this instance before or after the move must be redrawn
+								invalidate_spotlight_shadows(commands.spotlights, transform_bounding_sphere(mesh_instances[i].world_transform, mesh.mesh_command.bounds));
 								mesh_instances[i].world_transform = matrices[search_i];
+								invalidate_spotlight_shadows(commands.spotlights, transform_bounding_sphere(mesh_instances[i].world_transform, mesh.mesh_command.bounds));
 								break;
 							}
 						}
@@ -264,7 +707,21 @@ namespace sge
 				{
 					if (node_ids[search_i] == receiver_instance.node_id)
 					{
+						invalidate_spotlight_shadows(commands.spotlights, transform_bounding_sphere(receiver_instance.mesh_instance.world_transform, receiver_instance.mesh.bounds));
 						receiver_instance.mesh_instance.world_transform = matrices[search_i];
+						invalidate_spotlight_shadows(commands.spotlights, transform_bounding_sphere(receiver_instance.mesh_instance.world_transform, receiver_instance.mesh.bounds));
+						break;
+					}
+				}
+			}
+
+			for (auto& spotlight : commands.spotlights)
+			{
+				for (size_t search_i = 0; search_i < num_nodes; ++search_i)
+				{
+					if (node_ids[search_i] == spotlight.node_id)
+					{
+						update_spotlight_transform(spotlight, matrices[search_i]);
 						break;
 					}
 				}
@@ -272,6 +729,7 @@ namespace sge
 		}
 
 		static void remove_mesh_commands(
+			std::vector<RenderScene_Spotlight>& spotlights,
 			RenderScene_Mesh& mesh_command_set,
 			const NodeId* const SGE_RESTRICT target_node_ids,
 			const size_t num_target_node_ids)
@@ -303,6 +761,7 @@ namespace sge
 				}
 
 				// Remove this instance
+				invalidate_spotlight_shadows(spotlights, transform_bounding_sphere(mesh_commands[command_i].world_transform, mesh_command_set.mesh_command.bounds));
 				num_mesh_commands -= 1;
 				if (command_i == num_mesh_commands)
 				{
@@ -339,19 +798,47 @@ namespace sge
 				const Node* const node = nodes[i];
 				const CStaticMesh* const static_mesh = static_meshes[i];
 
-				// Get the static mesh resource for this instance
+				// Get the static mesh resource for this instance (by interned path, so no strings are hashed)
+				const auto mesh_path = static_mesh->mesh_id();
 				const auto& mesh_resource = RenderResource_get_static_mesh_resource(
 					resources,
-					static_mesh->mesh().c_str());
+					mesh_path);
 
 				// Get the material resource for this instance
+				const auto material_path = static_mesh->material_id();
 				const auto& material_resource = RenderResource_get_material_resource(
 					resources,
-					static_mesh->material().c_str());
+					material_path);
+
+				// Hold references to the resources, so that they aren't evicted while this instance uses them
+				RenderResource_add_ref(resources, mesh_path);
+				RenderResource_add_ref(resources, material_path);
+				const auto existing_iter = commands.static_mesh_resources.find(node->get_id());
+				if (existing_iter != commands.static_mesh_resources.end())
+				{
+					RenderResource_release(resources, existing_iter->second.mesh_path);
+					RenderResource_release(resources, existing_iter->second.material_path);
+				}
+				auto& instance_resources = commands.static_mesh_resources[node->get_id()];
+				instance_resources.mesh_path = mesh_path;
+				instance_resources.material_path = material_path;
+
+				// If either resource is still streaming in, the placeholder is used until it's resident
+				if (&mesh_resource == &resources.missing_mesh || &material_resource == &resources.missing_material)
+				{
+					RenderScene_PendingStaticMesh pending;
+					pending.node_id = node->get_id();
+					pending.mesh_path = mesh_path;
+					pending.material_path = material_path;
+					commands.pending_static_meshes.push_back(std::move(pending));
+				}
 
 				// Get the lightmap for this instance
 				const auto lightmap = get_lightmap(commands, node->get_id());
 
+				// Redraw any shadows this instance falls into
+				invalidate_spotlight_shadows(commands.spotlights, transform_bounding_sphere(node->get_world_matrix(), mesh_resource.bounds));
+
 				// If it's a a lightmask object, add it to the path for that
 				if (static_mesh->lightmask_mode() != CStaticMesh::LightmaskMode::NONE)
 				{
@@ -363,6 +850,10 @@ namespace sge
 					command.mesh.start_element_index = 0;
 					command.mesh.num_element_indices = mesh_resource.num_total_elements;
 					command.mesh.base_vertex = 0;
+					command.mesh.position_offset = mesh_resource.position_offset;
+					command.mesh.position_scale = mesh_resource.position_scale;
+					command.mesh.bounds = mesh_resource.bounds;
+					command.occluder = mesh_resource.occluder;
 					command.mesh_instance.world_transform = node->get_world_matrix();
 					command.mesh_instance.mat_uv_scale = static_mesh->uv_scale();
 					command.mesh_instance.lightmap_x_basis = lightmap.x_basis_tex;
@@ -399,6 +890,12 @@ namespace sge
 					mesh_command_set.mesh_command.start_element_index = 0;
 					mesh_command_set.mesh_command.num_element_indices = mesh_resource.num_total_elements;
 					mesh_command_set.mesh_command.base_vertex = 0;
+					mesh_command_set.mesh_command.position_offset = mesh_resource.position_offset;
+					mesh_command_set.mesh_command.position_scale = mesh_resource.position_scale;
+					mesh_command_set.mesh_command.bounds = mesh_resource.bounds;
+					mesh_command_set.lods = mesh_resource.lods;
+					mesh_command_set.num_lods = mesh_resource.num_lods;
+					mesh_command_set.occluder = mesh_resource.occluder;
 
 					// Create the mesh instance object
 					RenderCommand_MeshInstance instance;
@@ -434,6 +931,12 @@ namespace sge
 					mesh_command_set.mesh_command.start_element_index = 0;
 					mesh_command_set.mesh_command.num_element_indices = mesh_resource.num_total_elements;
 					mesh_command_set.mesh_command.base_vertex = 0;
+					mesh_command_set.mesh_command.position_offset = mesh_resource.position_offset;
+					mesh_command_set.mesh_command.position_scale = mesh_resource.position_scale;
+					mesh_command_set.mesh_command.bounds = mesh_resource.bounds;
+					mesh_command_set.lods = mesh_resource.lods;
+					mesh_command_set.num_lods = mesh_resource.num_lods;
+					mesh_command_set.occluder = mesh_resource.occluder;
 
 					// Create the mesh instance object
 					RenderCommand_MeshInstance instance;
@@ -461,36 +964,51 @@ namespace sge
 				instance.lightmap_direct_mask = lightmap.direct_mask_tex;
 
 				// Insert it into the command set
-				material.mesh_instances[mesh_iter->second].instance_commands.push_back(instance);
+				auto& mesh_command_set = material.mesh_instances[mesh_iter->second];
+				mesh_command_set.instance_commands.push_back(instance);
+				mesh_command_set.node_ids.push_back(node->get_id());
 			}
 		}
 
-		void RenderScene_remove_static_mesh_commands(
+		void RenderScene_take_streamed_static_meshes(
 			RenderScene_Commands& commands,
-			const NodeId* const target_node_ids,
-			const size_t num_target_node_ids)
+			const RenderResource& resources,
+			std::vector<NodeId>& out_node_ids)
 		{
-			// Check standard path instances
-			for (auto& material_instance : commands.standard_path_material_instances)
+			auto& pending = commands.pending_static_meshes;
+			for (size_t i = 0; i < pending.size();)
 			{
-				for (auto& mesh : material_instance.mesh_instances)
+				if (!RenderResource_is_static_mesh_resident(resources, pending[i].mesh_path) ||
+					!RenderResource_is_material_resident(resources, pending[i].material_path))
 				{
-					remove_mesh_commands(mesh, target_node_ids, num_target_node_ids);
+					i += 1;
+					continue;
 				}
+
+				out_node_ids.push_back(pending[i].node_id);
+				pending[i] = std::move(pending.back());
+				pending.pop_back();
 			}
+		}
 
-			// Check lightmask receiver instances
-			size_t num_lightmask_receivers = commands.lightmask_receiver_mesh_instances.size();
-			auto* const lightmask_receivers = commands.lightmask_receiver_mesh_instances.data();
-			for (size_t i = 0; i < num_lightmask_receivers;)
+		static void remove_lightmask_objects(
+			std::vector<RenderScene_Spotlight>& spotlights,
+			std::vector<RenderScene_LightmaskObject>& lightmask_objects,
+			const NodeId* const target_node_ids,
+			const size_t num_target_node_ids)
+		{
+			size_t num_objects = lightmask_objects.size();
+			auto* const objects = lightmask_objects.data();
+			for (size_t i = 0; i < num_objects;)
 			{
 				int incr = 1;
 				for (size_t search_i = 0; search_i < num_target_node_ids; ++search_i)
 				{
-					if (target_node_ids[search_i] == lightmask_receivers[i].node_id)
+					if (target_node_ids[search_i] == objects[i].node_id)
 					{
-						num_lightmask_receivers -= 1;
-						lightmask_receivers[search_i] = std::move(lightmask_receivers[num_lightmask_receivers]);
+						invalidate_spotlight_shadows(spotlights, transform_bounding_sphere(objects[i].mesh_instance.world_transform, objects[i].mesh.bounds));
+						num_objects -= 1;
+						objects[i] = std::move(objects[num_objects]);
 						incr = 0;
 						break;
 					}
@@ -499,7 +1017,146 @@ namespace sge
 				i += incr;
 			}
 
-			commands.lightmask_receiver_mesh_instances.resize(num_lightmask_receivers);
+			lightmask_objects.resize(num_objects);
+		}
+
+		void RenderScene_remove_static_mesh_commands(
+			RenderScene_Commands& commands,
+			RenderResource& resources,
+			const NodeId* const target_node_ids,
+			const size_t num_target_node_ids)
+		{
+			// Check standard path instances
+			for (auto& material_instance : commands.standard_path_material_instances)
+			{
+				for (auto& mesh : material_instance.mesh_instances)
+				{
+					remove_mesh_commands(commands.spotlights, mesh, target_node_ids, num_target_node_ids);
+				}
+			}
+
+			// Check lightmask instances
+			remove_lightmask_objects(commands.spotlights, commands.lightmask_receiver_mesh_instances, target_node_ids, num_target_node_ids);
+			remove_lightmask_objects(commands.spotlights, commands.lightmask_occluder_mesh_instances, target_node_ids, num_target_node_ids);
+
+			// Stop waiting on resources for removed instances
+			auto& pending = commands.pending_static_meshes;
+			pending.erase(
+				std::remove_if(pending.begin(), pending.end(), [=](const RenderScene_PendingStaticMesh& pending_mesh) {
+					return std::find(target_node_ids, target_node_ids + num_target_node_ids, pending_mesh.node_id) != target_node_ids + num_target_node_ids;
+				}),
+				pending.end());
+
+			// Release their resources
+			for (size_t i = 0; i < num_target_node_ids; ++i)
+			{
+				const auto iter = commands.static_mesh_resources.find(target_node_ids[i]);
+				if (iter == commands.static_mesh_resources.end())
+				{
+					continue;
+				}
+
+				RenderResource_release(resources, iter->second.mesh_path);
+				RenderResource_release(resources, iter->second.material_path);
+				commands.static_mesh_resources.erase(iter);
+			}
+		}
+
+		static void insert_spotlight_shadow(
+			RenderScene_Commands& commands,
+			const Node& node,
+			const CSpotlight& spotlight)
+		{
+			// Shadow depth for all spotlights is stored in a shared atlas
+			if (commands.shadow_atlas.depth_texture == 0)
+			{
+				ShadowAtlas_init(commands.shadow_atlas, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_MIN_TILE_SIZE);
+			}
+
+			// The atlas tile is assigned in 'RenderScene_update_shadow_tiles'
+			RenderScene_Spotlight spotlight_shadow;
+			set_spotlight_shadow_params(spotlight_shadow, node, spotlight);
+			commands.spotlights.push_back(spotlight_shadow);
+		}
+
+		static void insert_lightmask_volume(
+			RenderScene_Commands& commands,
+			RenderResource& resources,
+			const Node& node,
+			const CSpotlight& spotlight)
+		{
+			// Create the VAO for this volume
+			GLuint volume_vao;
+			glGenVertexArrays(1, &volume_vao);
+			glBindVertexArray(volume_vao);
+
+			// Bind the EBO for this mesh
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resources.frustum_ebo);
+
+			// Create the frustum for this volume
+			Vec3 frustum_vert_positions[NUM_FRUSTUM_VERTS];
+			Vec3 frustum_vert_normals[NUM_FRUSTUM_VERTS];
+			Vec2 frustum_vert_texcoords[NUM_FRUSTUM_VERTS];
+			create_lightmask_volume_frustum_positions(
+				spotlight.near_clipping_plane(),
+				spotlight.far_clipping_plane(),
+				spotlight.frustum_horiz_angle().radians(),
+				spotlight.frustum_vert_angle().radians(),
+				frustum_vert_positions);
+			create_lightmask_volume_frustum_normals(
+				spotlight.frustum_horiz_angle().radians(),
+				spotlight.frustum_vert_angle().radians(),
+				frustum_vert_normals);
+			create_lightmask_volume_frustum_texcoords(
+				spotlight.near_clipping_plane(),
+				spotlight.far_clipping_plane(),
+				spotlight.frustum_horiz_angle().radians(),
+				spotlight.frustum_vert_angle().radians(),
+				frustum_vert_texcoords);
+
+			// Upload data and set vertex position attribute
+			GLuint volume_pos_buffer;
+			glGenBuffers(1, &volume_pos_buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, volume_pos_buffer);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(frustum_vert_positions), frustum_vert_positions, GL_DYNAMIC_DRAW);
+			glEnableVertexAttribArray(gl_material::POSITION_ATTRIB_LOCATION);
+			glVertexAttribPointer(gl_material::POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), nullptr);
+
+			// Upload data and set vertex normal attribute
+			GLuint volume_normal_buffer;
+			glGenBuffers(1, &volume_normal_buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, volume_normal_buffer);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(frustum_vert_normals), frustum_vert_normals, GL_DYNAMIC_DRAW);
+			glEnableVertexAttribArray(gl_material::NORMAL_ATTRIB_LOCATION);
+			glVertexAttribPointer(gl_material::NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), nullptr);
+
+			// Upload data and set vertex texcoord attribute
+			GLuint volume_texcoord_buffer;
+			glGenBuffers(1, &volume_texcoord_buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, volume_texcoord_buffer);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(frustum_vert_texcoords), frustum_vert_texcoords, GL_DYNAMIC_DRAW);
+			glEnableVertexAttribArray(gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION);
+			glVertexAttribPointer(gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2), nullptr);
+
+			// Create a LightmaskVolume command
+			RenderScene_LightmaskVolume volume_command;
+			volume_command.node_id = node.get_id();
+			volume_command.pos_buffer = volume_pos_buffer;
+			volume_command.texcoord_buffer = volume_texcoord_buffer;
+			volume_command.volume_mesh.vao = volume_vao;
+			volume_command.volume_mesh.start_element_index = 0;
+			volume_command.volume_mesh.num_element_indices = NUM_FRUSTUM_ELEMS;
+			volume_command.volume_mesh.base_vertex = 0;
+			volume_command.mesh_instance.world_transform = node.get_world_matrix();
+			volume_command.mesh_instance.mat_uv_scale = Vec2{ 1.f, 1.f };
+			volume_command.mesh_instance.lightmap_x_basis = 0;
+			volume_command.mesh_instance.lightmap_y_basis = 0;
+			volume_command.mesh_instance.lightmap_z_basis = 0;
+			volume_command.mesh_instance.lightmap_direct_mask = 0;
+
+			// Add it to the command buffer
+			commands.lightmask_volume_mesh_instances.push_back(volume_command);
+			glBindVertexArray(0);
 		}
 
 		void RenderScene_insert_spotlight_commands(
@@ -513,47 +1170,7 @@ namespace sge
 			{
 				if (spotlights[i]->casts_shadows())
 				{
-					// Create a shadow map object
-					RenderScene_Spotlight spotlight_shadow_map;
-					spotlight_shadow_map.node_id = nodes[i]->get_id();
-					spotlight_shadow_map.view_matrix = nodes[i]->get_world_matrix().inverse();
-					spotlight_shadow_map.proj_matrix = Mat4::perspective_projection(
-						spotlights[i]->frustum_horiz_angle(),
-						spotlights[i]->frustum_vert_angle(),
-						spotlights[i]->near_clipping_plane(),
-						spotlights[i]->far_clipping_plane());
-					spotlight_shadow_map.shadow_width = spotlights[i]->shadow_map_width(),
-					spotlight_shadow_map.shadow_height = spotlights[i]->shadow_map_height();
-
-					GLuint shadow_depth_map;
-					glGenTextures(1, &shadow_depth_map);
-					glBindTexture(GL_TEXTURE_2D, shadow_depth_map);
-					glTexImage2D(
-						GL_TEXTURE_2D,
-						0,
-						GL_DEPTH_COMPONENT,
-						spotlight_shadow_map.shadow_width,
-						spotlight_shadow_map.shadow_height,
-						0,
-						GL_DEPTH_COMPONENT,
-						GL_FLOAT,
-						nullptr);
-					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-					// Create the framebuffer for the shadow map
-					GLuint shadow_framebuffer;
-					glGenFramebuffers(1, &shadow_framebuffer);
-					glBindFramebuffer(GL_FRAMEBUFFER, shadow_framebuffer);
-					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadow_depth_map, 0);
-					glDrawBuffer(GL_NONE);
-					glReadBuffer(GL_NONE);
-
-					spotlight_shadow_map.shadow_framebuffer = shadow_framebuffer;
-					spotlight_shadow_map.shadow_depthbuffer = shadow_depth_map;
-					commands.spotlights.push_back(spotlight_shadow_map);
+					insert_spotlight_shadow(commands, *nodes[i], *spotlights[i]);
 				}
 
 				if (!spotlights[i]->is_lightmask_volume() || spotlights[i]->shape() != CSpotlight::Shape::FRUSTUM)
@@ -561,78 +1178,41 @@ namespace sge
 					continue;
 				}
 
-				// Create the VAO for this volume
-				GLuint volume_vao;
-				glGenVertexArrays(1, &volume_vao);
-				glBindVertexArray(volume_vao);
-
-				// Bind the EBO for this mesh
-				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resources.frustum_ebo);
-
-				// Create the frustum for this volume
-				Vec3 frustum_vert_positions[NUM_FRUSTUM_VERTS];
-				Vec3 frustum_vert_normals[NUM_FRUSTUM_VERTS];
-				Vec2 frustum_vert_texcoords[NUM_FRUSTUM_VERTS];
-				create_lightmask_volume_frustum_positions(
-					spotlights[i]->near_clipping_plane(),
-					spotlights[i]->far_clipping_plane(),
-					spotlights[i]->frustum_horiz_angle().radians(),
-					spotlights[i]->frustum_vert_angle().radians(),
-					frustum_vert_positions);
-				create_lightmask_volume_frustum_normals(
-					spotlights[i]->frustum_horiz_angle().radians(),
-					spotlights[i]->frustum_vert_angle().radians(),
-					frustum_vert_normals);
-				create_lightmask_volume_frustum_texcoords(
-					spotlights[i]->near_clipping_plane(),
-					spotlights[i]->far_clipping_plane(),
-					spotlights[i]->frustum_horiz_angle().radians(),
-					spotlights[i]->frustum_vert_angle().radians(),
-					frustum_vert_texcoords);
-
-				// Upload data and set vertex position attribute
-				GLuint volume_pos_buffer;
-				glGenBuffers(1, &volume_pos_buffer);
-				glBindBuffer(GL_ARRAY_BUFFER, volume_pos_buffer);
-				glBufferData(GL_ARRAY_BUFFER, sizeof(frustum_vert_positions), frustum_vert_positions, GL_DYNAMIC_DRAW);
-				glEnableVertexAttribArray(gl_material::POSITION_ATTRIB_LOCATION);
-				glVertexAttribPointer(gl_material::POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), nullptr);
-
-				// Upload data and set vertex normal attribute
-				GLuint volume_normal_buffer;
-				glGenBuffers(1, &volume_normal_buffer);
-				glBindBuffer(GL_ARRAY_BUFFER, volume_normal_buffer);
-				glBufferData(GL_ARRAY_BUFFER, sizeof(frustum_vert_normals), frustum_vert_normals, GL_DYNAMIC_DRAW);
-				glEnableVertexAttribArray(gl_material::NORMAL_ATTRIB_LOCATION);
-				glVertexAttribPointer(gl_material::NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), nullptr);
-
-				// Upload data and set vertex texcoord attribute
-				GLuint volume_texcoord_buffer;
-				glGenBuffers(1, &volume_texcoord_buffer);
-				glBindBuffer(GL_ARRAY_BUFFER, volume_texcoord_buffer);
-				glBufferData(GL_ARRAY_BUFFER, sizeof(frustum_vert_texcoords), frustum_vert_texcoords, GL_DYNAMIC_DRAW);
-				glEnableVertexAttribArray(gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION);
-				glVertexAttribPointer(gl_material::MATERIAL_TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2), nullptr);
-
-				// Create a LightmaskVolume command
-				RenderScene_LightmaskVolume volume_command;
-				volume_command.node_id = nodes[i]->get_id();
-				volume_command.pos_buffer = volume_pos_buffer;
-				volume_command.texcoord_buffer = volume_texcoord_buffer;
-				volume_command.volume_mesh.vao = volume_vao;
-				volume_command.volume_mesh.start_element_index = 0;
-				volume_command.volume_mesh.num_element_indices = NUM_FRUSTUM_ELEMS;
-				volume_command.volume_mesh.base_vertex = 0;
-				volume_command.mesh_instance.world_transform = nodes[i]->get_world_matrix();
-				volume_command.mesh_instance.mat_uv_scale = Vec2{ 1.f, 1.f };
-				volume_command.mesh_instance.lightmap_x_basis = 0;
-				volume_command.mesh_instance.lightmap_y_basis = 0;
-				volume_command.mesh_instance.lightmap_z_basis = 0;
-				volume_command.mesh_instance.lightmap_direct_mask = 0;
-
-				// Add it to the command buffer
-				commands.lightmask_volume_mesh_instances.push_back(volume_command);
-				glBindVertexArray(0);
+				insert_lightmask_volume(commands, resources, *nodes[i], *spotlights[i]);
+			}
+		}
+
+		static void update_spotlight_shadow(
+			RenderScene_Commands& commands,
+			const Node& node,
+			const CSpotlight& spotlight)
+		{
+			// Search for the existing shadow for this spotlight
+			const auto num_shadows = commands.spotlights.size();
+			auto* const shadows = commands.spotlights.data();
+			for (size_t shadow_i = 0; shadow_i < num_shadows; ++shadow_i)
+			{
+				if (shadows[shadow_i].node_id != node.get_id())
+				{
+					continue;
+				}
+
+				// Check if they've disabled shadows on this spotlight
+				if (!spotlight.casts_shadows())
+				{
+					ShadowAtlas_free_tile(commands.shadow_atlas, shadows[shadow_i].shadow_tile);
+					shadows[shadow_i] = shadows[num_shadows - 1];
+					commands.spotlights.resize(num_shadows - 1);
+					return;
+				}
+
+				set_spotlight_shadow_params(shadows[shadow_i], node, spotlight);
+				return;
+			}
+
+			if (spotlight.casts_shadows())
+			{
+				insert_spotlight_shadow(commands, node, spotlight);
 			}
 		}
 
@@ -645,6 +1225,8 @@ namespace sge
 		{
 			for (size_t i = 0; i < num_spotlights; ++i)
 			{
+				update_spotlight_shadow(commands, *nodes[i], *spotlights[i]);
+
 				const auto num_lightmasks = commands.lightmask_volume_mesh_instances.size();
 				auto* const lightmasks = commands.lightmask_volume_mesh_instances.data();
 
@@ -700,9 +1282,9 @@ namespace sge
 				}
 
 				// If this spotlight wasn't already a lightmask and lightmasking was enabled, add it to the array
-				if (!found)
+				if (!found && spotlights[i]->is_lightmask_volume() && spotlights[i]->shape() == CSpotlight::Shape::FRUSTUM)
 				{
-					RenderScene_insert_spotlight_commands(commands, resources, nodes + i, spotlights + i, 1);
+					insert_lightmask_volume(commands, resources, *nodes[i], *spotlights[i]);
 				}
 			}
 		}
@@ -712,6 +1294,24 @@ namespace sge
 			NodeId* const node_ids,
 			size_t num_nodes)
 		{
+			// Remove shadows, and release their atlas tiles
+			size_t num_shadows = commands.spotlights.size();
+			auto* const shadows = commands.spotlights.data();
+			for (size_t i = 0; i < num_shadows;)
+			{
+				if (std::find(node_ids, node_ids + num_nodes, shadows[i].node_id) == node_ids + num_nodes)
+				{
+					i += 1;
+					continue;
+				}
+
+				ShadowAtlas_free_tile(commands.shadow_atlas, shadows[i].shadow_tile);
+				num_shadows -= 1;
+				shadows[i] = shadows[num_shadows];
+			}
+
+			commands.spotlights.resize(num_shadows);
+
 			size_t num_lightmasks = commands.lightmask_volume_mesh_instances.size();
 			auto* const lightmasks = commands.lightmask_volume_mesh_instances.data();
 
@@ -742,15 +1342,29 @@ namespace sge
 		}
 
 		void RenderScene_clear(
-			RenderScene_Commands& commands)
+			RenderScene_Commands& commands,
+			RenderResource& resources)
 		{
+			for (const auto& instance_resources : commands.static_mesh_resources)
+			{
+				RenderResource_release(resources, instance_resources.second.mesh_path);
+				RenderResource_release(resources, instance_resources.second.material_path);
+			}
+			commands.static_mesh_resources.clear();
+
 			commands.lightmask_occluder_mesh_instances.clear();
 			commands.lightmask_receiver_mesh_instances.clear();
 			commands.lightmask_volume_mesh_instances.clear();
+			commands.pending_static_meshes.clear();
 			commands.standard_path_material_indices.clear();
 			commands.standard_path_material_instances.clear();
 			commands.spotlights.clear();
 
+			if (commands.shadow_atlas.depth_texture != 0)
+			{
+				ShadowAtlas_reset(commands.shadow_atlas);
+			}
+
 			for (auto node : commands.node_lightmaps)
 			{
 				GLuint textures[] = {
@@ -759,6 +1373,11 @@ namespace sge
 					node.second.z_basis_tex,
 					node.second.direct_mask_tex
 				};
+
+				// Give the basis textures' memory back to the residency budget (the direct mask was never counted)
+				TextureResidency_remove(resources.residency, node.second.x_basis_tex, node.second.basis_unmanaged_size);
+				TextureResidency_remove(resources.residency, node.second.y_basis_tex, node.second.basis_unmanaged_size);
+				TextureResidency_remove(resources.residency, node.second.z_basis_tex, node.second.basis_unmanaged_size);
 				glDeleteTextures(4, textures);
 			}
 
@@ -0,0 +1,157 @@
+// ShadowAtlas.cpp
+
+#include <algorithm>
+#include "../private/ShadowAtlas.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		static std::size_t get_size_class(
+			const ShadowAtlas& atlas,
+			const GLuint tile_size)
+		{
+			std::size_t size_class = 0;
+			for (GLuint size = atlas.size; size > tile_size; size /= 2)
+			{
+				size_class += 1;
+			}
+
+			return size_class;
+		}
+
+		void ShadowAtlas_init(
+			ShadowAtlas& atlas,
+			const GLuint size,
+			const GLuint min_tile_size)
+		{
+			atlas.size = size;
+			atlas.min_tile_size = min_tile_size;
+
+			// Create the depth texture
+			glGenTextures(1, &atlas.depth_texture);
+			glBindTexture(GL_TEXTURE_2D, atlas.depth_texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+			// Create the framebuffer for the atlas
+			glGenFramebuffers(1, &atlas.framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, atlas.framebuffer);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, atlas.depth_texture, 0);
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+
+			ShadowAtlas_reset(atlas);
+		}
+
+		void ShadowAtlas_reset(
+			ShadowAtlas& atlas)
+		{
+			atlas.free_tiles.clear();
+			atlas.free_tiles.resize(get_size_class(atlas, atlas.min_tile_size) + 1);
+
+			ShadowAtlasTile root;
+			root.size = atlas.size;
+			atlas.free_tiles[0].push_back(root);
+		}
+
+		GLuint ShadowAtlas_tile_size_for(
+			const ShadowAtlas& atlas,
+			const GLuint desired_size)
+		{
+			GLuint tile_size = atlas.min_tile_size;
+			while (tile_size < desired_size && tile_size < atlas.size)
+			{
+				tile_size *= 2;
+			}
+
+			return tile_size;
+		}
+
+		bool ShadowAtlas_alloc_tile(
+			ShadowAtlas& atlas,
+			const GLuint desired_size,
+			ShadowAtlasTile* const out_tile)
+		{
+			*out_tile = ShadowAtlasTile{};
+			if (atlas.free_tiles.empty())
+			{
+				return false;
+			}
+
+			// Try the desired size class first, then fall back to smaller ones
+			const auto num_classes = atlas.free_tiles.size();
+			for (auto size_class = get_size_class(atlas, ShadowAtlas_tile_size_for(atlas, desired_size)); size_class < num_classes; ++size_class)
+			{
+				// Find the closest larger size class with a free tile
+				auto source_class = size_class + 1;
+				while (source_class > 0 && atlas.free_tiles[source_class - 1].empty())
+				{
+					source_class -= 1;
+				}
+				if (source_class == 0)
+				{
+					continue;
+				}
+				source_class -= 1;
+
+				// Split it down until it's the right size
+				ShadowAtlasTile tile = atlas.free_tiles[source_class].back();
+				atlas.free_tiles[source_class].pop_back();
+				for (; source_class < size_class; ++source_class)
+				{
+					tile.size /= 2;
+
+					// Keep the first quadrant, and put the other three in the free list
+					atlas.free_tiles[source_class + 1].push_back(ShadowAtlasTile{ tile.x + tile.size, tile.y, tile.size });
+					atlas.free_tiles[source_class + 1].push_back(ShadowAtlasTile{ tile.x, tile.y + tile.size, tile.size });
+					atlas.free_tiles[source_class + 1].push_back(ShadowAtlasTile{ tile.x + tile.size, tile.y + tile.size, tile.size });
+				}
+
+				*out_tile = tile;
+				return true;
+			}
+
+			return false;
+		}
+
+		void ShadowAtlas_free_tile(
+			ShadowAtlas& atlas,
+			ShadowAtlasTile tile)
+		{
+			if (tile.size == 0)
+			{
+				return;
+			}
+
+			auto size_class = get_size_class(atlas, tile.size);
+			while (size_class > 0)
+			{
+				// Find the siblings of this tile
+				auto& free_list = atlas.free_tiles[size_class];
+				const GLuint parent_size = tile.size * 2;
+				const GLuint parent_x = tile.x / parent_size * parent_size;
+				const GLuint parent_y = tile.y / parent_size * parent_size;
+				const auto is_sibling = [&](const ShadowAtlasTile& other)
+				{
+					return other.x / parent_size * parent_size == parent_x && other.y / parent_size * parent_size == parent_y;
+				};
+
+				// If all three siblings are free, merge them into the parent
+				if (std::count_if(free_list.begin(), free_list.end(), is_sibling) != 3)
+				{
+					break;
+				}
+
+				free_list.erase(std::remove_if(free_list.begin(), free_list.end(), is_sibling), free_list.end());
+				tile = ShadowAtlasTile{ parent_x, parent_y, parent_size };
+				size_class -= 1;
+			}
+
+			atlas.free_tiles[size_class].push_back(tile);
+		}
+	}
+}
@@ -0,0 +1,317 @@
+// TextureResidency.cpp
+
+#include <algorithm>
+#include <cmath>
+#include "../private/TextureResidency.h"
+#include "../private/GLTexture2D.h"
+
+namespace sge
+{
+	namespace gl_render
+	{
+		/* The most levels the budget may drop from every texture. */
+		static constexpr uint32 RESIDENCY_MAX_MIP_BIAS = 16;
+
+		/**
+		 * \brief Returns the size (in bytes) of the given texture's mip chain, starting at the given level.
+		 */
+		static std::size_t chain_size(
+			const TextureResidency_Texture& texture,
+			const uint32 level)
+		{
+			std::size_t size = 0;
+			for (auto i = level; i < texture.mips.size(); ++i)
+			{
+				size += texture.mips[i].size;
+			}
+
+			return size;
+		}
+
+		static void upload_level(
+			const TextureResidency_Texture& texture,
+			const uint32 level)
+		{
+			const auto& mip = texture.mips[level];
+			if (texture.compressed)
+			{
+				glCompressedTexImage2D(
+					GL_TEXTURE_2D,
+					static_cast<GLint>(level),
+					texture.internal_format,
+					mip.width,
+					mip.height,
+					0,
+					static_cast<GLsizei>(mip.size),
+					texture.data.data() + mip.offset);
+			}
+			else
+			{
+				glTexImage2D(
+					GL_TEXTURE_2D,
+					static_cast<GLint>(level),
+					texture.internal_format,
+					mip.width,
+					mip.height,
+					0,
+					texture.upload_format,
+					texture.upload_type,
+					texture.data.data() + mip.offset);
+			}
+		}
+
+		/**
+		 * \brief Releases the storage of a single level, by reallocating it as empty.
+		 */
+		static void free_level(
+			const TextureResidency_Texture& texture,
+			const uint32 level)
+		{
+			if (texture.compressed)
+			{
+				glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), texture.internal_format, 0, 0, 0, 0, nullptr);
+			}
+			else
+			{
+				glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), texture.internal_format, 0, 0, 0, texture.upload_format, texture.upload_type, nullptr);
+			}
+		}
+
+		void TextureResidency_add(
+			TextureResidency& residency,
+			const GLuint texture,
+			const GLenum internal_format,
+			const bool compressed,
+			const GLenum upload_format,
+			const GLenum upload_type,
+			std::vector<TextureResidency_Mip> mips,
+			std::vector<byte> data)
+		{
+			if (mips.empty())
+			{
+				return;
+			}
+
+			TextureResidency_Texture entry;
+			entry.internal_format = internal_format;
+			entry.compressed = compressed;
+			entry.upload_format = upload_format;
+			entry.upload_type = upload_type;
+			entry.mips = std::move(mips);
+			entry.data = std::move(data);
+
+			const auto num_levels = static_cast<uint32>(entry.mips.size());
+			const auto full_size = chain_size(entry, 0);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			set_sampling_parameters(static_cast<GLint>(num_levels) - 1);
+
+			// Without residency, everything stays resident
+			if (!residency.enabled)
+			{
+				for (uint32 level = 0; level < num_levels; ++level)
+				{
+					upload_level(entry, level);
+				}
+
+				residency.unmanaged_bytes += full_size;
+				return;
+			}
+
+			// Find the first level of the tail
+			entry.tail_level = num_levels - 1;
+			while (entry.tail_level > 0 && std::max(entry.mips[entry.tail_level - 1].width, entry.mips[entry.tail_level - 1].height) <= RESIDENCY_TAIL_SIZE)
+			{
+				entry.tail_level -= 1;
+			}
+
+			// Upload just the tail, and only sample from it
+			for (auto level = num_levels; level > entry.tail_level; --level)
+			{
+				upload_level(entry, level - 1);
+			}
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(entry.tail_level));
+
+			entry.resident_level = entry.tail_level;
+			entry.requested_level = entry.tail_level;
+			entry.held_level = entry.tail_level;
+			entry.target_level = entry.tail_level;
+			residency.resident_bytes += chain_size(entry, entry.tail_level);
+			residency.full_bytes += full_size;
+			residency.textures[texture] = std::move(entry);
+		}
+
+		void TextureResidency_add_unmanaged(
+			TextureResidency& residency,
+			const std::size_t size)
+		{
+			residency.unmanaged_bytes += size;
+		}
+
+		void TextureResidency_remove(
+			TextureResidency& residency,
+			const GLuint texture,
+			const std::size_t unmanaged_size)
+		{
+			const auto iter = residency.textures.find(texture);
+			if (iter == residency.textures.end())
+			{
+				residency.unmanaged_bytes -= std::min(unmanaged_size, residency.unmanaged_bytes);
+				return;
+			}
+
+			residency.resident_bytes -= chain_size(iter->second, iter->second.resident_level);
+			residency.full_bytes -= chain_size(iter->second, 0);
+			residency.textures.erase(iter);
+		}
+
+		void TextureResidency_request(
+			TextureResidency& residency,
+			const GLuint texture,
+			const float screen_size)
+		{
+			const auto iter = residency.textures.find(texture);
+			if (iter == residency.textures.end())
+			{
+				return;
+			}
+
+			// Pick the coarsest level that still has at least as many texels as pixels it covers
+			auto& entry = iter->second;
+			const auto& top = entry.mips.front();
+			const auto top_size = static_cast<float>(std::max(top.width, top.height));
+			uint32 level = entry.tail_level;
+			if (screen_size >= top_size)
+			{
+				level = 0;
+			}
+			else if (screen_size > 0.f)
+			{
+				level = std::min(static_cast<uint32>(std::log2(top_size / screen_size)), entry.tail_level);
+			}
+
+			if (entry.last_request_frame != residency.frame)
+			{
+				entry.last_request_frame = residency.frame;
+				entry.requested_level = level;
+				entry.requested_size = screen_size;
+			}
+			else
+			{
+				entry.requested_level = std::min(entry.requested_level, level);
+				entry.requested_size = std::max(entry.requested_size, screen_size);
+			}
+		}
+
+		void TextureResidency_update(
+			TextureResidency& residency,
+			std::size_t upload_budget)
+		{
+			auto& stats = residency.stats;
+			stats.uploaded_bytes = 0;
+			stats.num_evicted_levels = 0;
+			const auto frame = residency.frame;
+			residency.frame += 1;
+
+			if (!residency.enabled)
+			{
+				stats.unmanaged_bytes = residency.unmanaged_bytes;
+				return;
+			}
+
+			// Hold on to the finest level needed recently, so that textures at the edge of a threshold don't thrash
+			for (auto& entry : residency.textures)
+			{
+				auto& texture = entry.second;
+				const auto needed_level = texture.last_request_frame == frame ? texture.requested_level : texture.tail_level;
+				if (needed_level <= texture.held_level || frame - texture.held_since_frame >= RESIDENCY_EVICT_DELAY)
+				{
+					texture.held_level = needed_level;
+					texture.held_since_frame = frame;
+				}
+			}
+
+			// Find the fewest levels to drop from every texture for what's held to fit in the budget
+			uint32 mip_bias = 0;
+			if (residency.budget != 0)
+			{
+				for (; mip_bias < RESIDENCY_MAX_MIP_BIAS; ++mip_bias)
+				{
+					std::size_t total_size = 0;
+					for (const auto& entry : residency.textures)
+					{
+						total_size += chain_size(entry.second, std::min(entry.second.held_level + mip_bias, entry.second.tail_level));
+					}
+
+					if (total_size <= residency.budget)
+					{
+						break;
+					}
+				}
+			}
+
+			// Drop levels that are no longer needed right away, and gather textures that need levels streamed in
+			std::vector<std::pair<GLuint, TextureResidency_Texture*>> streaming_in;
+			for (auto& entry : residency.textures)
+			{
+				auto& texture = entry.second;
+				texture.target_level = std::min(texture.held_level + mip_bias, texture.tail_level);
+				if (texture.target_level < texture.resident_level)
+				{
+					streaming_in.push_back(std::make_pair(entry.first, &texture));
+					continue;
+				}
+
+				if (texture.target_level == texture.resident_level)
+				{
+					continue;
+				}
+
+				// Stop sampling from the levels before releasing them
+				glBindTexture(GL_TEXTURE_2D, entry.first);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(texture.target_level));
+				for (auto level = texture.resident_level; level < texture.target_level; ++level)
+				{
+					free_level(texture, level);
+					residency.resident_bytes -= texture.mips[level].size;
+					stats.num_evicted_levels += 1;
+				}
+				texture.resident_level = texture.target_level;
+			}
+
+			// Stream in levels for the largest textures on screen first, one level at a time from coarse to fine
+			std::sort(streaming_in.begin(), streaming_in.end(),
+				[](const std::pair<GLuint, TextureResidency_Texture*>& lhs, const std::pair<GLuint, TextureResidency_Texture*>& rhs)
+				{
+					return lhs.second->requested_size > rhs.second->requested_size;
+				});
+			for (auto& entry : streaming_in)
+			{
+				if (upload_budget == 0)
+				{
+					break;
+				}
+
+				auto& texture = *entry.second;
+				glBindTexture(GL_TEXTURE_2D, entry.first);
+				while (texture.resident_level > texture.target_level && upload_budget != 0)
+				{
+					const auto level = texture.resident_level - 1;
+					const auto size = texture.mips[level].size;
+					upload_level(texture, level);
+					texture.resident_level = level;
+					residency.resident_bytes += size;
+					stats.uploaded_bytes += size;
+					upload_budget -= std::min(size, upload_budget);
+				}
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(texture.resident_level));
+			}
+
+			stats.resident_bytes = residency.resident_bytes;
+			stats.full_bytes = residency.full_bytes;
+			stats.unmanaged_bytes = residency.unmanaged_bytes;
+			stats.budget_bytes = residency.budget;
+			stats.num_textures = residency.textures.size();
+			stats.mip_bias = mip_bias;
+		}
+	}
+}
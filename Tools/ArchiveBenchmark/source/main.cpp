@@ -0,0 +1,482 @@
+// main.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Core/Parallelism/TaskPool.h>
+#include <Resource/Archives/BinaryArchive.h>
+#include <Resource/Archives/JsonArchive.h>
+
+using Clock = std::chrono::high_resolution_clock;
+using sge::BinaryArchive;
+
+static double elapsed_ms(
+	Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * \brief Writes an archive shaped like a large scene: a table of nodes with a name, root, and transform, and some mesh-sized arrays. Pops the root.
+ */
+static void build_scene_archive(
+	sge::ArchiveWriter& writer,
+	std::size_t num_nodes)
+{
+	const char lightmap_path[] = "Content/Lightmaps/scene.sbin";
+	writer.push_object_member("next_node_id");
+	writer.number(sge::uint64{ num_nodes + 1 });
+	writer.pop();
+	writer.push_object_member("lightmap_data_path");
+	writer.string(lightmap_path, sizeof(lightmap_path) - 1);
+	writer.pop();
+
+	writer.push_object_member("nodes");
+	for (std::size_t i = 0; i < num_nodes; ++i)
+	{
+		const auto id_str = std::to_string(i + 1);
+		writer.push_object_member(id_str.c_str());
+
+		const auto name = "Node " + id_str;
+		const float pos[3] = { float(i % 100), 0.f, float(i / 100) };
+		const float scale[3] = { 1.f, 1.f, 1.f };
+		const float rot[4] = { 0.f, 0.f, 0.f, 1.f };
+		writer.push_object_member("name");
+		writer.string(name.c_str(), name.size());
+		writer.pop();
+		writer.push_object_member("root");
+		writer.number(sge::uint64{ i / 10 });
+		writer.pop();
+		writer.push_object_member("lpos");
+		writer.typed_array(pos, 3);
+		writer.pop();
+		writer.push_object_member("lscale");
+		writer.typed_array(scale, 3);
+		writer.pop();
+		writer.push_object_member("lrot");
+		writer.typed_array(rot, 4);
+		writer.pop();
+		writer.pop();
+	}
+	writer.pop();
+
+	// Vertex and element data, about the size of a detailed mesh
+	std::vector<float> positions(num_nodes * 3);
+	std::vector<sge::uint32> elements(num_nodes * 6);
+	for (std::size_t i = 0; i < positions.size(); ++i)
+	{
+		positions[i] = float(i) * 0.01f;
+	}
+	for (std::size_t i = 0; i < elements.size(); ++i)
+	{
+		elements[i] = static_cast<sge::uint32>(i % (num_nodes == 0 ? 1 : num_nodes));
+	}
+	writer.push_object_member("vpos");
+	writer.typed_array(positions.data(), positions.size());
+	writer.pop();
+	writer.push_object_member("elem");
+	writer.typed_array(elements.data(), elements.size());
+	writer.pop();
+
+	writer.pop();
+}
+
+template <typename T>
+static bool visit_typed_array(
+	const sge::ArchiveReader& reader,
+	std::size_t size,
+	std::vector<char>& scratch,
+	double& sum)
+{
+	// Prefer viewing the array in place, as loading code does
+	const T* view = nullptr;
+	std::size_t view_size = 0;
+	if (reader.typed_array_view(view, view_size))
+	{
+		sum += view_size != 0 ? double(view[view_size - 1]) : 0.0;
+		return true;
+	}
+
+	scratch.resize(size * sizeof(T));
+	if (reader.typed_array(reinterpret_cast<T*>(scratch.data()), size) != size)
+	{
+		return false;
+	}
+
+	sum += size != 0 ? double(reinterpret_cast<const T*>(scratch.data())[size - 1]) : 0.0;
+	return true;
+}
+
+template <typename T>
+static bool visit_number(
+	const sge::ArchiveReader& reader,
+	double& sum)
+{
+	T value;
+	if (reader.number(value))
+	{
+		sum += double(value);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * \brief Reads every value in the archive, looking up each object member by name (as 'from_archive' functions do).
+ */
+static void visit(
+	sge::ArchiveReader& reader,
+	std::vector<char>& scratch,
+	double& sum)
+{
+	std::size_t size = 0;
+	if (reader.object_size(size))
+	{
+		std::vector<const char*> names;
+		names.reserve(size);
+		reader.enumerate_object_members([&names](const char* name)
+		{
+			names.push_back(name);
+		});
+
+		for (const auto* name : names)
+		{
+			if (reader.pull_object_member(name))
+			{
+				visit(reader, scratch, sum);
+				reader.pop();
+			}
+		}
+	}
+	else if (reader.array_size(size))
+	{
+		if (visit_typed_array<float>(reader, size, scratch, sum) || visit_typed_array<double>(reader, size, scratch, sum)
+			|| visit_typed_array<sge::int8>(reader, size, scratch, sum) || visit_typed_array<sge::uint8>(reader, size, scratch, sum)
+			|| visit_typed_array<sge::int16>(reader, size, scratch, sum) || visit_typed_array<sge::uint16>(reader, size, scratch, sum)
+			|| visit_typed_array<sge::int32>(reader, size, scratch, sum) || visit_typed_array<sge::uint32>(reader, size, scratch, sum)
+			|| visit_typed_array<sge::int64>(reader, size, scratch, sum) || visit_typed_array<sge::uint64>(reader, size, scratch, sum))
+		{
+			return;
+		}
+
+		reader.enumerate_array_elements([&reader, &scratch, &sum](std::size_t /*i*/)
+		{
+			visit(reader, scratch, sum);
+		});
+	}
+	else if (reader.string_size(size))
+	{
+		sum += double(size);
+	}
+	else
+	{
+		bool value = false;
+		if (reader.boolean(value))
+		{
+			sum += value ? 1.0 : 0.0;
+			return;
+		}
+
+		visit_number<float>(reader, sum) || visit_number<double>(reader, sum)
+			|| visit_number<sge::int8>(reader, sum) || visit_number<sge::uint8>(reader, sum)
+			|| visit_number<sge::int16>(reader, sum) || visit_number<sge::uint16>(reader, sum)
+			|| visit_number<sge::int32>(reader, sum) || visit_number<sge::uint32>(reader, sum)
+			|| visit_number<sge::int64>(reader, sum) || visit_number<sge::uint64>(reader, sum);
+	}
+}
+
+/**
+ * \brief Writes the given archive in the given version (compressed, if requested), maps it back in, and times reading all of it
+ * (decompressing on the given pool, if any). Returns the file size.
+ */
+static std::size_t benchmark_version(
+	const BinaryArchive& source,
+	BinaryArchive::Version version,
+	bool compress,
+	sge::TaskPool* pool,
+	const char* path,
+	int iterations,
+	double& out_read_ms,
+	double& out_checksum)
+{
+	std::vector<char> scratch;
+	BinaryArchive file_archive = source;
+	file_archive.set_file_version(version);
+	file_archive.set_file_compression(compress);
+	if (!file_archive.to_file(path))
+	{
+		return 0;
+	}
+
+	BinaryArchive mapped;
+	if (!mapped.map_file(path))
+	{
+		std::remove(path);
+		return 0;
+	}
+	mapped.set_task_pool(pool);
+
+	out_read_ms = 0.0;
+	for (int i = 0; i < iterations; ++i)
+	{
+		out_checksum = 0.0;
+		const auto start = Clock::now();
+		auto* reader = mapped.read_root();
+		visit(*reader, scratch, out_checksum);
+		reader->pop();
+		out_read_ms += elapsed_ms(start);
+	}
+	out_read_ms /= iterations;
+
+	const auto size = mapped.size();
+	mapped = BinaryArchive{};
+	std::remove(path);
+	return size;
+}
+
+static int benchmark(
+	const char* label,
+	const BinaryArchive& archive,
+	int iterations)
+{
+	// Time encoding from the in-memory (version 1) representation
+	std::vector<sge::byte> encoded;
+	auto start = Clock::now();
+	archive.encode(BinaryArchive::Version::V2, encoded);
+	const auto encode_ms = elapsed_ms(start);
+	start = Clock::now();
+	archive.encode(BinaryArchive::Version::V2, encoded, true);
+	const auto compress_ms = elapsed_ms(start);
+
+	const auto num_threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	sge::TaskPool pool{ num_threads };
+
+	double v1_read_ms = 0.0;
+	double v2_read_ms = 0.0;
+	double v2c_read_ms = 0.0;
+	double v2c_pool_read_ms = 0.0;
+	double v1_checksum = 0.0;
+	double v2_checksum = 0.0;
+	double v2c_checksum = 0.0;
+	double v2c_pool_checksum = 0.0;
+	const auto v1_size = benchmark_version(archive, BinaryArchive::Version::V1, false, nullptr, "ArchiveBenchmark.v1.sbin", iterations, v1_read_ms, v1_checksum);
+	const auto v2_size = benchmark_version(archive, BinaryArchive::Version::V2, false, nullptr, "ArchiveBenchmark.v2.sbin", iterations, v2_read_ms, v2_checksum);
+	const auto v2c_size = benchmark_version(archive, BinaryArchive::Version::V2, true, nullptr, "ArchiveBenchmark.v2c.sbin", iterations, v2c_read_ms, v2c_checksum);
+	benchmark_version(archive, BinaryArchive::Version::V2, true, &pool, "ArchiveBenchmark.v2c.sbin", iterations, v2c_pool_read_ms, v2c_pool_checksum);
+	if (v1_size == 0 || v2_size == 0 || v2c_size == 0)
+	{
+		std::cout << "ArchiveBenchmark: could not write temporary archives" << std::endl;
+		return 1;
+	}
+
+	const auto mb_per_s = [](std::size_t size, double ms)
+	{
+		return ms > 0.0 ? double(size) / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+	};
+
+	std::cout << label << std::endl;
+	std::cout << "    v1: " << v1_size << " bytes, read in " << v1_read_ms << "ms (" << mb_per_s(v1_size, v1_read_ms) << " MB/s)" << std::endl;
+	std::cout << "    v2: " << v2_size << " bytes (" << 100.0 * double(v2_size) / double(v1_size) << "% of v1), encoded in " << encode_ms << "ms, read in "
+		<< v2_read_ms << "ms (" << mb_per_s(v2_size, v2_read_ms) << " MB/s)" << std::endl;
+	std::cout << "    v2 compressed: " << v2c_size << " bytes (" << 100.0 * double(v2c_size) / double(v1_size) << "% of v1), encoded in " << compress_ms << "ms, read in "
+		<< v2c_read_ms << "ms (" << mb_per_s(v2c_size, v2c_read_ms) << " MB/s), " << v2c_pool_read_ms << "ms with " << num_threads << " more threads" << std::endl;
+	if (v1_checksum != v2_checksum || v1_checksum != v2c_checksum || v1_checksum != v2c_pool_checksum)
+	{
+		std::cout << "    MISMATCH: the versions read back different values" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * \brief Reads every value in the archive in a single pass, enumerating objects rather than pulling their members (so streaming readers can read all of it).
+ */
+static void visit_one_pass(
+	sge::ArchiveReader& reader,
+	double& sum)
+{
+	if (reader.is_object())
+	{
+		reader.enumerate_object_members([&reader, &sum](const char* /*name*/)
+		{
+			visit_one_pass(reader, sum);
+		});
+		return;
+	}
+
+	if (reader.is_array())
+	{
+		reader.enumerate_array_elements([&reader, &sum](std::size_t /*i*/)
+		{
+			visit_one_pass(reader, sum);
+		});
+		return;
+	}
+
+	std::size_t size = 0;
+	bool value = false;
+	if (reader.string_size(size))
+	{
+		sum += double(size);
+	}
+	else if (reader.boolean(value))
+	{
+		sum += value ? 1.0 : 0.0;
+	}
+	else
+	{
+		visit_number<double>(reader, sum) || visit_number<sge::int64>(reader, sum) || visit_number<sge::uint64>(reader, sum);
+	}
+}
+
+/**
+ * \brief Compares writing and reading the generated scene as JSON through a document, with streaming it.
+ */
+static int benchmark_json(
+	std::size_t num_nodes,
+	int iterations)
+{
+	const char dom_path[] = "ArchiveBenchmark.dom.json";
+	const char stream_path[] = "ArchiveBenchmark.stream.json";
+
+	double dom_write_ms = 0.0;
+	double stream_write_ms = 0.0;
+	double dom_read_ms = 0.0;
+	double stream_read_ms = 0.0;
+	double dom_checksum = 0.0;
+	double stream_checksum = 0.0;
+	for (int i = 0; i < iterations; ++i)
+	{
+		// Build a document, then write it out
+		auto start = Clock::now();
+		{
+			sge::JsonArchive archive;
+			build_scene_archive(*archive.write_root(), num_nodes);
+			archive.to_file(dom_path);
+		}
+		dom_write_ms += elapsed_ms(start);
+
+		// Write straight to the file
+		start = Clock::now();
+		auto* writer = sge::JsonArchive::stream_to_file(stream_path);
+		if (!writer)
+		{
+			std::cout << "ArchiveBenchmark: could not write temporary JSON files" << std::endl;
+			return 1;
+		}
+		build_scene_archive(*writer, num_nodes);
+		stream_write_ms += elapsed_ms(start);
+
+		// Parse a document, then read it (each path reads the file written by the other)
+		start = Clock::now();
+		{
+			dom_checksum = 0.0;
+			sge::JsonArchive archive;
+			archive.from_file(stream_path);
+			auto* reader = archive.read_root();
+			visit_one_pass(*reader, dom_checksum);
+			reader->pop();
+		}
+		dom_read_ms += elapsed_ms(start);
+
+		// Read while parsing
+		start = Clock::now();
+		{
+			stream_checksum = 0.0;
+			auto* reader = sge::JsonArchive::stream_from_file(dom_path);
+			visit_one_pass(*reader, stream_checksum);
+			reader->pop();
+		}
+		stream_read_ms += elapsed_ms(start);
+	}
+	std::remove(dom_path);
+	std::remove(stream_path);
+
+	std::cout << "JSON (" << num_nodes << " nodes)" << std::endl;
+	std::cout << "    document: written in " << dom_write_ms / iterations << "ms, read in " << dom_read_ms / iterations << "ms" << std::endl;
+	std::cout << "    streamed: written in " << stream_write_ms / iterations << "ms, read in " << stream_read_ms / iterations << "ms" << std::endl;
+	if (dom_checksum != stream_checksum)
+	{
+		std::cout << "    MISMATCH: the document and streamed paths read back different values" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	// Parse arguments
+	std::size_t num_nodes = 100000;
+	int iterations = 5;
+	bool json = false;
+	std::vector<const char*> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--nodes") == 0 && i + 1 < argc)
+		{
+			num_nodes = static_cast<std::size_t>(std::atoll(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+		{
+			iterations = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (std::strcmp(argv[i], "--json") == 0)
+		{
+			json = true;
+		}
+		else if (std::strcmp(argv[i], "--help") == 0)
+		{
+			std::cout << "Usage: ArchiveBenchmark [--nodes <n>] [--iterations <n>] [--json] [<archive.sbin>...]" << std::endl;
+			std::cout << "Compares the size and read speed of binary archives in each format version, with and without compression." << std::endl;
+			std::cout << "Without any archives, a scene-like archive with the given number of nodes is generated." << std::endl;
+			std::cout << "With '--json', the generated archive is also written and read as JSON, through a document and streamed." << std::endl;
+			return 0;
+		}
+		else
+		{
+			paths.push_back(argv[i]);
+		}
+	}
+
+	if (paths.empty())
+	{
+		BinaryArchive archive;
+		const auto start = Clock::now();
+		build_scene_archive(*archive.write_root(), num_nodes);
+		const auto build_ms = elapsed_ms(start);
+
+		const auto label = "generated scene (" + std::to_string(num_nodes) + " nodes, written in " + std::to_string(build_ms) + "ms)";
+		auto result = benchmark(label.c_str(), archive, iterations);
+		if (json)
+		{
+			result |= benchmark_json(num_nodes, iterations);
+		}
+
+		return result;
+	}
+
+	int result = 0;
+	for (const auto* path : paths)
+	{
+		BinaryArchive archive;
+		if (!archive.from_file(path))
+		{
+			std::cout << "ArchiveBenchmark: could not load '" << path << "'" << std::endl;
+			result = 1;
+			continue;
+		}
+
+		result |= benchmark(path, archive, iterations);
+	}
+
+	return result;
+}
@@ -0,0 +1,687 @@
+// main.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/stat.h>
+#include <Core/env.h>
+#if defined SGE_OS_WINDOWS
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <windows.h>
+#else
+#   include <dirent.h>
+#endif
+#include <Core/Parallelism/TaskPool.h>
+#include <Core/Util/StringUtils.h>
+#include <Resource/Archives/BinaryArchive.h>
+#include <Resource/Archives/JsonArchive.h>
+#include <Resource/Resources/CompressedTexture.h>
+#include <Resource/Resources/Material.h>
+#include <Resource/Resources/StaticMesh.h>
+
+using Clock = std::chrono::high_resolution_clock;
+
+/* Part of every cook key, so that changing what a cook produces can invalidate everything cooked before. */
+static constexpr sge::uint64 COOK_VERSION = 1;
+
+/* The number of LODs generated below the full detail mesh (as MeshOptimizer does). */
+static constexpr std::size_t NUM_MESH_LODS = 3;
+
+/* Textures bound to material parameters with this name are cooked as normal maps. */
+static constexpr const char NORMAL_MAP_PARAM[] = "normal_map";
+
+/* The file (within the cache directory) that records what was cooked from each source file. */
+static constexpr const char MANIFEST_NAME[] = "manifest.sbin";
+
+/* Extensions of images that are cooked as textures. HDR images are loaded as-is by the renderer, so they're not cooked. */
+static const char* const TEXTURE_EXTENSIONS[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".tif" };
+
+/* Extensions of files written by cooking (which aren't cooked themselves). */
+static const char* const COOKED_EXTENSIONS[] = { ".ctex.sbin", ".cmesh.sbin", ".cmat.sbin", ".cscene.sbin" };
+
+enum class AssetKind
+{
+	TEXTURE,
+	MESH,
+	MATERIAL,
+};
+
+enum class CookStatus : sge::uint64
+{
+	/* The asset was cooked, and its cooked version installed. */
+	COOKED,
+
+	/* The file turned out not to be an asset of its kind (such as a JSON file that isn't a material), so nothing was cooked. */
+	NOT_AN_ASSET,
+
+	/* Cooking failed, and will be tried again next time. */
+	FAILED,
+};
+
+/**
+ * \brief What was last cooked from a source file. Stored in the manifest as an array of five numbers, under the source path.
+ */
+struct ManifestEntry
+{
+	/* The size and modification time of the source file, so that unchanged files needn't be hashed again.
+	 * Modification times only have a resolution of a second, so files modified during a cook are recorded with a time of 0 (and hashed again next time). */
+	sge::uint64 size = 0;
+	sge::uint64 mtime = 0;
+
+	sge::uint64 content_hash = 0;
+
+	/* The hash of everything the cooked version depends on, which is also its name in the cache. */
+	sge::uint64 key = 0;
+
+	CookStatus status = CookStatus::FAILED;
+};
+
+struct Asset
+{
+	std::string path;
+	AssetKind kind;
+	ManifestEntry entry;
+
+	/* The parameters the asset is cooked with, which are part of its key. */
+	std::string params;
+};
+
+static double elapsed_ms(
+	Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * \brief Continues a 64-bit FNV-1a hash over the given bytes.
+ */
+static sge::uint64 hash_bytes(
+	sge::uint64 hash,
+	const void* data,
+	std::size_t size)
+{
+	const auto* const bytes = static_cast<const sge::byte*>(data);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static constexpr sge::uint64 HASH_SEED = 14695981039346656037ull;
+
+static bool hash_file(
+	const std::string& path,
+	sge::uint64& out_hash)
+{
+	auto* const file = std::fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	out_hash = HASH_SEED;
+	std::vector<char> buffer(64 * 1024);
+	std::size_t read = 0;
+	while ((read = std::fread(buffer.data(), 1, buffer.size(), file)) != 0)
+	{
+		out_hash = hash_bytes(out_hash, buffer.data(), read);
+	}
+
+	std::fclose(file);
+	return true;
+}
+
+static bool copy_file(
+	const std::string& from,
+	const std::string& to)
+{
+	auto* const in = std::fopen(from.c_str(), "rb");
+	if (!in)
+	{
+		return false;
+	}
+
+	auto* const out = std::fopen(to.c_str(), "wb");
+	if (!out)
+	{
+		std::fclose(in);
+		return false;
+	}
+
+	std::vector<char> buffer(64 * 1024);
+	std::size_t read = 0;
+	bool succeeded = true;
+	while ((read = std::fread(buffer.data(), 1, buffer.size(), in)) != 0)
+	{
+		succeeded &= std::fwrite(buffer.data(), 1, read, out) == read;
+	}
+
+	std::fclose(in);
+	return std::fclose(out) == 0 && succeeded;
+}
+
+static bool file_exists(
+	const std::string& path)
+{
+	struct stat file_stats;
+	return stat(path.c_str(), &file_stats) == 0;
+}
+
+static bool make_directory(
+	const std::string& path)
+{
+#if defined SGE_OS_WINDOWS
+	return CreateDirectoryA(path.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	return mkdir(path.c_str(), 0755) == 0 || file_exists(path);
+#endif
+}
+
+/**
+ * \brief Adds the path of every file under the given directory to the given list, skipping hidden files and directories (including the cache).
+ */
+static void list_files(
+	const std::string& dir,
+	std::vector<std::string>& out_paths)
+{
+	std::vector<std::string> subdirs;
+
+#if defined SGE_OS_WINDOWS
+	WIN32_FIND_DATAA find_data;
+	const HANDLE find = FindFirstFileA((dir + "/*").c_str(), &find_data);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	do
+	{
+		if (find_data.cFileName[0] == '.')
+		{
+			continue;
+		}
+
+		auto path = dir + "/" + find_data.cFileName;
+		if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			subdirs.push_back(std::move(path));
+		}
+		else
+		{
+			out_paths.push_back(std::move(path));
+		}
+	} while (FindNextFileA(find, &find_data));
+	FindClose(find);
+#else
+	auto* const handle = opendir(dir.c_str());
+	if (!handle)
+	{
+		return;
+	}
+
+	while (const auto* const dir_entry = readdir(handle))
+	{
+		if (dir_entry->d_name[0] == '.')
+		{
+			continue;
+		}
+
+		auto path = dir + "/" + dir_entry->d_name;
+		struct stat file_stats;
+		if (stat(path.c_str(), &file_stats) != 0)
+		{
+			continue;
+		}
+
+		if (S_ISDIR(file_stats.st_mode))
+		{
+			subdirs.push_back(std::move(path));
+		}
+		else if (S_ISREG(file_stats.st_mode))
+		{
+			out_paths.push_back(std::move(path));
+		}
+	}
+	closedir(handle);
+#endif
+
+	for (const auto& subdir : subdirs)
+	{
+		list_files(subdir, out_paths);
+	}
+}
+
+/**
+ * \brief Figures out what kind of asset the file at the given path is by its extension. Returns false if it isn't one.
+ * Meshes share their extension with other binary archives (such as lightmaps), and materials with other JSON files, so those are confirmed when cooked.
+ */
+static bool classify(
+	const std::string& path,
+	AssetKind& out_kind)
+{
+	for (const auto* extension : COOKED_EXTENSIONS)
+	{
+		if (sge::string_ends_with(path.c_str(), extension))
+		{
+			return false;
+		}
+	}
+
+	for (const auto* extension : TEXTURE_EXTENSIONS)
+	{
+		if (sge::string_ends_with(path.c_str(), extension))
+		{
+			out_kind = AssetKind::TEXTURE;
+			return true;
+		}
+	}
+
+	if (sge::string_ends_with(path.c_str(), ".sbin"))
+	{
+		out_kind = AssetKind::MESH;
+		return true;
+	}
+
+	if (sge::string_ends_with(path.c_str(), ".json"))
+	{
+		out_kind = AssetKind::MATERIAL;
+		return true;
+	}
+
+	return false;
+}
+
+static std::string cooked_path(
+	const Asset& asset)
+{
+	switch (asset.kind)
+	{
+	case AssetKind::TEXTURE:
+		return sge::CompressedTexture::cooked_path(asset.path.c_str());
+
+	case AssetKind::MESH:
+		return sge::StaticMesh::cooked_path(asset.path.c_str());
+
+	default:
+		return sge::Material::cooked_path(asset.path.c_str());
+	}
+}
+
+static std::string cache_path(
+	const std::string& cache_dir,
+	sge::uint64 key)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.sbin", static_cast<unsigned long long>(key));
+	return cache_dir + "/" + name;
+}
+
+/**
+ * \brief Loads the given JSON file as a material. Returns false if it doesn't name any shaders, since then it's some other kind of JSON file.
+ */
+static bool load_material(
+	const std::string& path,
+	sge::Material& out_material)
+{
+	return out_material.from_file(path.c_str()) && (!out_material.vertex_shader().empty() || !out_material.pixel_shader().empty());
+}
+
+static void load_manifest(
+	const std::string& path,
+	std::unordered_map<std::string, ManifestEntry>& out_manifest)
+{
+	sge::BinaryArchive archive;
+	if (!archive.map_file(path.c_str()))
+	{
+		return;
+	}
+
+	auto* const reader = archive.read_root();
+	reader->enumerate_object_members([reader, &out_manifest](const char* source_path)
+	{
+		sge::uint64 values[5];
+		if (reader->typed_array(values, 5) != 5)
+		{
+			return;
+		}
+
+		ManifestEntry entry;
+		entry.size = values[0];
+		entry.mtime = values[1];
+		entry.content_hash = values[2];
+		entry.key = values[3];
+		entry.status = static_cast<CookStatus>(values[4]);
+		out_manifest[source_path] = entry;
+	});
+	reader->pop();
+}
+
+static bool save_manifest(
+	const std::string& path,
+	const std::vector<Asset>& assets,
+	std::time_t cook_start_time)
+{
+	sge::BinaryArchive archive;
+	auto* const writer = archive.write_root();
+	writer->as_object();
+	for (const auto& asset : assets)
+	{
+		if (asset.entry.status == CookStatus::FAILED)
+		{
+			continue;
+		}
+
+		const auto mtime = asset.entry.mtime < static_cast<sge::uint64>(cook_start_time) ? asset.entry.mtime : 0;
+		const sge::uint64 values[5] = { asset.entry.size, mtime, asset.entry.content_hash, asset.entry.key, static_cast<sge::uint64>(asset.entry.status) };
+		writer->push_object_member(asset.path.c_str());
+		writer->typed_array(values, 5);
+		writer->pop();
+	}
+	writer->pop();
+
+	return archive.to_file(path.c_str());
+}
+
+/**
+ * \brief Cooks the given asset into the given file. Returns the status of the cook.
+ */
+static CookStatus cook(
+	const Asset& asset,
+	const std::string& out_path,
+	sge::TaskPool& pool)
+{
+	switch (asset.kind)
+	{
+	case AssetKind::TEXTURE:
+	{
+		sge::Texture texture;
+		if (!texture.from_file(asset.path.c_str()) || texture.image.get_width() == 0)
+		{
+			return CookStatus::FAILED;
+		}
+
+		const auto is_normal_map = asset.params.find(NORMAL_MAP_PARAM) != std::string::npos;
+		const auto format = is_normal_map ? sge::texture_compression::BlockFormat::BC5 : sge::CompressedTexture::default_format(texture);
+		sge::CompressedTexture cooked;
+		cooked.cook(texture, format, &pool);
+		return cooked.to_file(out_path.c_str()) ? CookStatus::COOKED : CookStatus::FAILED;
+	}
+
+	case AssetKind::MESH:
+	{
+		sge::StaticMesh mesh;
+		if (!mesh.from_file(asset.path.c_str(), &pool) || mesh.num_verts() == 0)
+		{
+			return CookStatus::NOT_AN_ASSET;
+		}
+
+		mesh.generate_lods(NUM_MESH_LODS);
+		mesh.optimize();
+		return mesh.to_file(out_path.c_str()) ? CookStatus::COOKED : CookStatus::FAILED;
+	}
+
+	default:
+	{
+		sge::Material material;
+		if (!load_material(asset.path, material))
+		{
+			return CookStatus::NOT_AN_ASSET;
+		}
+
+		return material.to_file(out_path.c_str()) ? CookStatus::COOKED : CookStatus::FAILED;
+	}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// Parse arguments
+	std::size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::string cache_dir;
+	std::string content_dir;
+	bool force = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			num_threads = static_cast<std::size_t>(std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+		{
+			cache_dir = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--force") == 0)
+		{
+			force = true;
+		}
+		else
+		{
+			content_dir = argv[i];
+		}
+	}
+
+	if (content_dir.empty())
+	{
+		std::cout << "Usage: AssetCooker [--threads <n>] [--cache <dir>] [--force] <content dir>" << std::endl;
+		std::cout << "Cooks every texture, mesh and material under the content directory, writing each next to its source" << std::endl;
+		std::cout << "(as '<image>.ctex.sbin', '<mesh>.cmesh.sbin' and '<material>.cmat.sbin'), where the runtimes load them in place of the source." << std::endl;
+		std::cout << "Cooked assets are kept in a cache (by default '<content dir>/.cook_cache') named by the hash of their inputs and cook parameters," << std::endl;
+		std::cout << "so only assets whose inputs changed are cooked again. Run this from the directory the runtimes are run from, so that paths match." << std::endl;
+		return 1;
+	}
+
+	while (content_dir.size() > 1 && (content_dir.back() == '/' || content_dir.back() == '\\'))
+	{
+		content_dir.pop_back();
+	}
+	if (cache_dir.empty())
+	{
+		cache_dir = content_dir + "/.cook_cache";
+	}
+	if (!make_directory(cache_dir))
+	{
+		std::cout << "AssetCooker: could not create '" << cache_dir << "'" << std::endl;
+		return 1;
+	}
+
+	const auto start = Clock::now();
+	const auto start_time = std::time(nullptr);
+	const auto manifest_path = cache_dir + "/" + MANIFEST_NAME;
+	std::unordered_map<std::string, ManifestEntry> manifest;
+	load_manifest(manifest_path, manifest);
+
+	// Find every asset, and hash the ones that have changed since the last cook
+	std::vector<std::string> paths;
+	list_files(content_dir, paths);
+	std::sort(paths.begin(), paths.end());
+
+	std::vector<Asset> assets;
+	int result = 0;
+	for (auto& path : paths)
+	{
+		Asset asset;
+		if (!classify(path, asset.kind))
+		{
+			continue;
+		}
+
+		struct stat file_stats;
+		if (stat(path.c_str(), &file_stats) != 0)
+		{
+			continue;
+		}
+		asset.entry.size = static_cast<sge::uint64>(file_stats.st_size);
+		asset.entry.mtime = static_cast<sge::uint64>(file_stats.st_mtime);
+
+		const auto iter = manifest.find(path);
+		if (iter != manifest.end() && iter->second.size == asset.entry.size && iter->second.mtime == asset.entry.mtime)
+		{
+			asset.entry.content_hash = iter->second.content_hash;
+		}
+		else if (!hash_file(path, asset.entry.content_hash))
+		{
+			std::cout << "AssetCooker: could not read '" << path << "'" << std::endl;
+			result = 1;
+			continue;
+		}
+
+		asset.path = std::move(path);
+		assets.push_back(std::move(asset));
+	}
+
+	// Textures are cooked differently depending on how materials use them, so find that out first
+	std::unordered_set<std::string> normal_maps;
+	for (const auto& asset : assets)
+	{
+		sge::Material material;
+		if (asset.kind != AssetKind::MATERIAL || !load_material(asset.path, material))
+		{
+			continue;
+		}
+
+		const auto& texture_params = material.param_table().texture_params;
+		const auto normal_map = texture_params.find(NORMAL_MAP_PARAM);
+		if (normal_map != texture_params.end())
+		{
+			normal_maps.insert(normal_map->second);
+		}
+	}
+
+	// Compute the key of each asset, and figure out what needs to be done with it
+	std::vector<Asset*> to_install;
+	std::vector<Asset*> to_cook;
+	std::size_t num_up_to_date = 0;
+	for (auto& asset : assets)
+	{
+		switch (asset.kind)
+		{
+		case AssetKind::TEXTURE:
+			asset.params = normal_maps.count(asset.path) ? "texture " + std::string{ NORMAL_MAP_PARAM } : "texture";
+			break;
+
+		case AssetKind::MESH:
+			asset.params = "mesh lods=" + std::to_string(NUM_MESH_LODS);
+			break;
+
+		case AssetKind::MATERIAL:
+			asset.params = "material";
+			break;
+		}
+
+		auto key = hash_bytes(HASH_SEED, &COOK_VERSION, sizeof(COOK_VERSION));
+		key = hash_bytes(key, &asset.entry.content_hash, sizeof(asset.entry.content_hash));
+		key = hash_bytes(key, asset.params.c_str(), asset.params.size());
+		asset.entry.key = key;
+
+		// Skip assets whose key hasn't changed since they were last cooked (or found not to be assets)
+		const auto iter = manifest.find(asset.path);
+		if (!force && iter != manifest.end() && iter->second.key == key)
+		{
+			if (iter->second.status == CookStatus::NOT_AN_ASSET || (iter->second.status == CookStatus::COOKED && file_exists(cooked_path(asset))))
+			{
+				asset.entry.status = iter->second.status;
+				num_up_to_date += 1;
+				continue;
+			}
+		}
+
+		// Anything cooked before with the same key only needs to be installed
+		if (!force && file_exists(cache_path(cache_dir, key)))
+		{
+			asset.entry.status = CookStatus::COOKED;
+			to_install.push_back(&asset);
+		}
+		else
+		{
+			to_cook.push_back(&asset);
+		}
+	}
+
+	// Cook everything else in parallel, into the cache. Files are written under a temporary name first, so that a cook that's interrupted isn't mistaken for a finished one.
+	const auto num_from_cache = to_install.size();
+	std::size_t num_cooked = 0;
+	sge::TaskPool pool{ num_threads };
+	sge::TaskGroup cook_tasks;
+	std::mutex output_lock;
+	for (auto* asset : to_cook)
+	{
+		pool.submit(cook_tasks, [asset, &cache_dir, &pool, &output_lock, &to_install, &num_cooked]()
+		{
+			const auto cook_start = Clock::now();
+			const auto out_path = cache_path(cache_dir, asset->entry.key);
+			const auto temp_path = out_path + ".tmp.sbin";
+			asset->entry.status = cook(*asset, temp_path, pool);
+			if (asset->entry.status == CookStatus::COOKED)
+			{
+				std::remove(out_path.c_str());
+				if (std::rename(temp_path.c_str(), out_path.c_str()) != 0)
+				{
+					asset->entry.status = CookStatus::FAILED;
+				}
+			}
+			std::remove(temp_path.c_str());
+
+			std::lock_guard<std::mutex> lock{ output_lock };
+			switch (asset->entry.status)
+			{
+			case CookStatus::COOKED:
+				std::cout << asset->path << ": cooked in " << elapsed_ms(cook_start) << "ms" << std::endl;
+				to_install.push_back(asset);
+				num_cooked += 1;
+				break;
+
+			case CookStatus::NOT_AN_ASSET:
+				break;
+
+			case CookStatus::FAILED:
+				std::cout << "AssetCooker: could not cook '" << asset->path << "'" << std::endl;
+				break;
+			}
+		});
+	}
+	pool.wait(cook_tasks);
+
+	// Install cooked assets next to their sources
+	for (auto* asset : to_install)
+	{
+		const auto installed_path = cooked_path(*asset);
+		if (!copy_file(cache_path(cache_dir, asset->entry.key), installed_path))
+		{
+			std::cout << "AssetCooker: could not write '" << installed_path << "'" << std::endl;
+			asset->entry.status = CookStatus::FAILED;
+		}
+	}
+
+	std::size_t num_failed = 0;
+	for (const auto& asset : assets)
+	{
+		if (asset.entry.status == CookStatus::FAILED)
+		{
+			num_failed += 1;
+			result = 1;
+		}
+	}
+
+	if (!save_manifest(manifest_path, assets, start_time))
+	{
+		std::cout << "AssetCooker: could not write '" << manifest_path << "'" << std::endl;
+		result = 1;
+	}
+
+	std::cout << assets.size() << " files: " << num_cooked << " cooked, "
+		<< num_from_cache << " from the cache, " << num_up_to_date << " up to date, " << num_failed << " failed, in " << elapsed_ms(start) << "ms" << std::endl;
+	return result;
+}
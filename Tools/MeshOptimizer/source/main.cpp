@@ -0,0 +1,120 @@
+// main.cpp
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <Resource/Resources/StaticMesh.h>
+#include <Resource/Misc/MeshOps.h>
+
+/* Size of each vertex as uploaded before packing: float positions, and a separate buffer for each attribute. */
+static constexpr std::size_t UNPACKED_VERTEX_SIZE =
+	sizeof(sge::Vec3) +			// Position
+	sizeof(sge::HalfVec3) * 2 +	// Normal, tangent
+	sizeof(sge::int8) +			// Bitangent sign
+	sizeof(sge::UHalfVec2) * 2;	// Material and lightmap UVs
+
+/* The number of LODs generated below the full detail mesh. */
+static constexpr std::size_t NUM_LODS = 3;
+
+struct MeshStats
+{
+	std::size_t num_verts = 0;
+	std::size_t num_triangles = 0;
+	float acmr = 0.f;
+	float atvr = 0.f;
+};
+
+static MeshStats compute_stats(
+	const sge::StaticMesh& mesh)
+{
+	MeshStats stats;
+	stats.num_verts = mesh.num_verts();
+	stats.num_triangles = mesh.num_triangles();
+	stats.acmr = sge::mesh_ops::compute_acmr(
+		mesh.triangle_elements(),
+		mesh.num_triangle_elements(),
+		mesh.num_verts(),
+		sge::mesh_ops::VERTEX_CACHE_SIZE);
+	stats.atvr = stats.num_verts == 0 ? 0.f : stats.acmr * stats.num_triangles / stats.num_verts;
+	return stats;
+}
+
+static void print_stats(
+	const char* label,
+	const MeshStats& stats,
+	std::size_t vertex_size)
+{
+	std::cout << "    " << label
+		<< ": " << stats.num_verts << " verts, "
+		<< stats.num_triangles << " tris, "
+		<< "ACMR " << stats.acmr << ", "
+		<< "ATVR " << stats.atvr << ", "
+		<< vertex_size << " bytes/vertex ("
+		<< stats.num_verts * vertex_size << " bytes)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	// Parse arguments
+	bool dry_run = false;
+	std::vector<const char*> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--dry-run") == 0)
+		{
+			dry_run = true;
+		}
+		else
+		{
+			paths.push_back(argv[i]);
+		}
+	}
+
+	if (paths.empty())
+	{
+		std::cout << "Usage: MeshOptimizer [--dry-run] <mesh.sbin>..." << std::endl;
+		std::cout << "Generates LODs for static meshes and optimizes them in place for vertex cache, overdraw and vertex fetch, and reports ACMR and vertex size before and after." << std::endl;
+		return 1;
+	}
+
+	int result = 0;
+	for (const auto* path : paths)
+	{
+		sge::StaticMesh mesh;
+		if (!mesh.from_file(path))
+		{
+			std::cout << "MeshOptimizer: could not load '" << path << "'" << std::endl;
+			result = 1;
+			continue;
+		}
+
+		std::cout << path << std::endl;
+		const auto before = compute_stats(mesh);
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		mesh.generate_lods(NUM_LODS);
+		mesh.optimize();
+		const auto end = std::chrono::high_resolution_clock::now();
+
+		const auto after = compute_stats(mesh);
+		print_stats("before", before, UNPACKED_VERTEX_SIZE);
+		print_stats("after ", after, sizeof(sge::mesh_ops::PackedVertex));
+		for (std::size_t i = 0; i < mesh.num_lods(); ++i)
+		{
+			const auto& lod = mesh.lods()[i];
+			std::cout << "    LOD " << i + 1 << ": "
+				<< lod.num_triangle_elements() / 3 << " tris, "
+				<< "error " << lod.error() << std::endl;
+		}
+		std::cout << "    optimized in " << std::chrono::duration<double, std::milli>(end - start).count() << "ms" << std::endl;
+
+		if (!dry_run && !mesh.to_file(path))
+		{
+			std::cout << "MeshOptimizer: could not write '" << path << "'" << std::endl;
+			result = 1;
+		}
+	}
+
+	return result;
+}
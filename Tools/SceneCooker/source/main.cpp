@@ -0,0 +1,113 @@
+// main.cpp
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Core/Math/Quat.h>
+#include <Core/Reflection/TypeDB.h>
+#include <Resource/Archives/BinaryArchive.h>
+#include <Resource/Archives/JsonArchive.h>
+#include <Engine/Scene.h>
+#include <Engine/Component.h>
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double elapsed_ms(
+	Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * \brief Cooks the JSON scene at the given path, writing the result next to it. Returns whether it succeeded.
+ */
+static bool cook_scene(
+	sge::Scene& scene,
+	const char* path)
+{
+	// Load the source scene (which also validates it)
+	auto start = Clock::now();
+	sge::JsonArchive source;
+	if (!source.from_file(path))
+	{
+		std::cout << "SceneCooker: could not load '" << path << "'" << std::endl;
+		return false;
+	}
+	source.deserialize_root(scene);
+	const auto json_ms = elapsed_ms(start);
+
+	// Write the cooked scene
+	const auto cooked_path = sge::Scene::cooked_path(path);
+	{
+		sge::BinaryArchive cooked;
+		auto* writer = cooked.write_root();
+		scene.to_cooked_archive(*writer, path);
+		writer->pop();
+
+		if (!cooked.to_file(cooked_path.c_str()))
+		{
+			std::cout << "SceneCooker: could not write '" << cooked_path << "'" << std::endl;
+			return false;
+		}
+	}
+
+	// Make sure it loads, and time it
+	start = Clock::now();
+	sge::BinaryArchive cooked;
+	bool loaded = cooked.map_file(cooked_path.c_str());
+	if (loaded)
+	{
+		auto* reader = cooked.read_root();
+		loaded = scene.from_cooked_archive(*reader);
+		reader->pop();
+	}
+	const auto cooked_ms = elapsed_ms(start);
+	if (!loaded)
+	{
+		std::cout << "SceneCooker: could not load back '" << cooked_path << "'" << std::endl;
+		return false;
+	}
+
+	std::cout << path << std::endl;
+	std::cout << "    " << scene.get_raw_scene_data().nodes.size() << " nodes, " << cooked.size() << " bytes" << std::endl;
+	std::cout << "    loaded in " << json_ms << "ms from JSON, " << cooked_ms << "ms cooked" << std::endl;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<const char*> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		paths.push_back(argv[i]);
+	}
+
+	if (paths.empty() || std::strcmp(paths.front(), "--help") == 0)
+	{
+		std::cout << "Usage: SceneCooker <scene.json>..." << std::endl;
+		std::cout << "Converts each JSON scene to the cooked scene format, writing the result next to the scene (as '<scene>.cscene.sbin')." << std::endl;
+		std::cout << "Cooked scenes are loaded in place of their source scene until the source changes, after which the source is loaded until it's cooked again." << std::endl;
+		return 1;
+	}
+
+	// Create a scene with the same component types as the runtimes
+	sge::TypeDB type_db;
+	type_db.new_type<sge::Vec3>();
+	type_db.new_type<sge::Quat>();
+	type_db.new_type<float>();
+	sge::Scene scene{ type_db };
+	sge::register_builtin_components(scene);
+
+	int result = 0;
+	for (const auto* path : paths)
+	{
+		if (!cook_scene(scene, path))
+		{
+			result = 1;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,137 @@
+// main.cpp
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Core/Parallelism/TaskPool.h>
+#include <Resource/Resources/CompressedTexture.h>
+
+using sge::texture_compression::BlockFormat;
+
+static const char* format_name(
+	BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		return "BC1";
+	case BlockFormat::BC3:
+		return "BC3";
+	case BlockFormat::BC5:
+		return "BC5";
+	case BlockFormat::BC7:
+		return "BC7";
+	default:
+		return "unknown";
+	}
+}
+
+static bool parse_format(
+	const char* name,
+	BlockFormat& out_format)
+{
+	std::string upper_name = name;
+	for (auto& c : upper_name)
+	{
+		c = static_cast<char>(std::toupper(c));
+	}
+
+	const BlockFormat formats[] = { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC5, BlockFormat::BC7 };
+	for (auto format : formats)
+	{
+		if (upper_name == format_name(format))
+		{
+			out_format = format;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	// Parse arguments
+	bool has_format = false;
+	BlockFormat format = BlockFormat::BC1;
+	std::size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<const char*> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+		{
+			if (!parse_format(argv[++i], format))
+			{
+				std::cout << "TextureCooker: unknown format '" << argv[i] << "'" << std::endl;
+				return 1;
+			}
+			has_format = true;
+		}
+		else if (std::strcmp(argv[i], "--normal-map") == 0)
+		{
+			format = BlockFormat::BC5;
+			has_format = true;
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			num_threads = static_cast<std::size_t>(std::atoi(argv[++i]));
+		}
+		else
+		{
+			paths.push_back(argv[i]);
+		}
+	}
+
+	if (paths.empty())
+	{
+		std::cout << "Usage: TextureCooker [--format bc1|bc3|bc5|bc7] [--normal-map] [--threads <n>] <image>..." << std::endl;
+		std::cout << "Generates a mip chain for each image and block-compresses it, writing the result next to the image (as '<image>.ctex.sbin')." << std::endl;
+		std::cout << "Opaque images default to BC1 and images with alpha to BC7. Normal maps are stored as BC5, and have Z reconstructed when sampled." << std::endl;
+		return 1;
+	}
+
+	sge::TaskPool pool{ num_threads };
+
+	int result = 0;
+	for (const auto* path : paths)
+	{
+		sge::Texture texture;
+		if (!texture.from_file(path) || texture.image.get_width() == 0)
+		{
+			std::cout << "TextureCooker: could not load '" << path << "'" << std::endl;
+			result = 1;
+			continue;
+		}
+
+		const auto texture_format = has_format ? format : sge::CompressedTexture::default_format(texture);
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		sge::CompressedTexture cooked;
+		cooked.cook(texture, texture_format, &pool);
+		const auto end = std::chrono::high_resolution_clock::now();
+
+		// Uncompressed size includes the mip chain the renderer would otherwise generate (about a third extra)
+		const std::size_t source_size = std::size_t(texture.image.get_width()) * texture.image.get_height() * 4 * 4 / 3;
+		std::cout << path << std::endl;
+		std::cout << "    " << texture.image.get_width() << "x" << texture.image.get_height() << ", "
+			<< format_name(texture_format) << ", "
+			<< cooked.num_mips() << " mips, "
+			<< source_size << " -> " << cooked.data_size() << " bytes" << std::endl;
+		std::cout << "    cooked in " << std::chrono::duration<double, std::milli>(end - start).count() << "ms" << std::endl;
+
+		const auto cooked_path = sge::CompressedTexture::cooked_path(path);
+		if (!cooked.to_file(cooked_path.c_str()))
+		{
+			std::cout << "TextureCooker: could not write '" << cooked_path << "'" << std::endl;
+			result = 1;
+		}
+	}
+
+	return result;
+}